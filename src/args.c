@@ -62,6 +62,7 @@ static struct option long_opts[] = {
 	{ "delimiter",    required_argument, .flag = NULL, .val = 'd' },
 	{ "on-choose",    required_argument, .flag = NULL, .val = 'o' },
 	{ "plugins-dir",  required_argument, .flag = NULL, .val = 'p' },
+	{ "startup-profile", required_argument, .flag = NULL, .val = 'P' },
 
 #ifdef ENABLE_REMOTE_CMDS
 	{ "server-list",  no_argument,       .flag = NULL, .val = 'L' },
@@ -119,7 +120,8 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 				done = 1;
 				break;
 			case 'R': /* --remote-expr <expr> */
-				args->remote_expr = optarg;
+				args->nremote_exprs = add_to_string_array(&args->remote_exprs,
+						args->nremote_exprs, optarg);
 				break;
 
 			case 'h': /* -h, --help */
@@ -145,6 +147,9 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 				args->nplugins_dirs = add_to_string_array(&args->plugins_dirs,
 						args->nplugins_dirs, path_buf);
 				break;
+			case 'P': /* --startup-profile <path> */
+				parse_path(dir, optarg, args->startup_profile);
+				break;
 			case 'l': /* --logging */
 				args->logging = 1;
 				if(!is_null_or_empty(optarg))
@@ -196,7 +201,7 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 		}
 	}
 
-	if(args->remote_cmds != NULL || args->remote_expr != NULL)
+	if(args->remote_cmds != NULL || args->nremote_exprs != 0)
 	{
 		args->target_name = args->server_name;
 		args->server_name = NULL;
@@ -428,6 +433,9 @@ show_help_msg(const char wrong_arg[])
 	puts("    permissions allow to open it for writing, then logging of early");
 	puts("    initialization (before configuration directories are determined)");
 	puts("    is put there.\n");
+	puts("  vifm --startup-profile <path>");
+	puts("    write timings of startup phases, sourced files, their lines,");
+	puts("    plugins and startup commands to the file in Chrome trace format.\n");
 
 #ifdef ENABLE_REMOTE_CMDS
 	puts("  vifm --server-list");
@@ -437,7 +445,8 @@ show_help_msg(const char wrong_arg[])
 	puts("  vifm --remote");
 	puts("    passes all arguments that left in command line to vifm server.\n");
 	puts("  vifm --remote-expr <expr>");
-	puts("    passes expression to vifm server and prints result.\n");
+	puts("    passes expression to vifm server and prints result (can appear");
+	puts("    multiple times).\n");
 #endif
 	puts("  vifm -c <command> | +<command>");
 	puts("    run command-line mode <command> on startup.\n");
@@ -472,7 +481,7 @@ show_version_msg(void)
 static void
 process_ipc_args(args_t *args, ipc_t *ipc)
 {
-	if(args->remote_cmds != NULL && args->remote_expr != NULL)
+	if(args->remote_cmds != NULL && args->nremote_exprs != 0)
 	{
 		fprintf(stderr, "%s\n", "--remote and --remote-expr can't be combined.");
 		quit_on_arg_parsing(EXIT_FAILURE);
@@ -489,19 +498,35 @@ process_ipc_args(args_t *args, ipc_t *ipc)
 			quit_on_arg_parsing(EXIT_SUCCESS);
 		}
 	}
-	else if(args->remote_expr != NULL)
+	else if(args->nremote_exprs != 0)
 	{
-		char *const result = ipc_eval(ipc, args->target_name, args->remote_expr);
-		if(result == NULL)
+		/* All expressions are sent at once to not wait for each reply. */
+		char **results = reallocarray(NULL, args->nremote_exprs, sizeof(*results));
+		if(results == NULL)
 		{
-			fprintf(stderr, "%s\n", "Evaluating expression remotely failed.");
+			fprintf(stderr, "%s\n", "Not enough memory.");
 			quit_on_arg_parsing(EXIT_FAILURE);
+			return;
 		}
-		else
+
+		const int failed = ipc_eval_batch(ipc, args->target_name,
+				args->remote_exprs, args->nremote_exprs, results);
+
+		size_t i;
+		for(i = 0U; i < args->nremote_exprs; ++i)
 		{
-			fprintf(stdout, "%s\n", result);
-			quit_on_arg_parsing(EXIT_SUCCESS);
+			if(results[i] == NULL)
+			{
+				fprintf(stderr, "%s\n", "Evaluating expression remotely failed.");
+			}
+			else
+			{
+				fprintf(stdout, "%s\n", results[i]);
+			}
 		}
+
+		free_string_array(results, args->nremote_exprs);
+		quit_on_arg_parsing(failed ? EXIT_FAILURE : EXIT_SUCCESS);
 	}
 }
 
@@ -573,6 +598,10 @@ args_free(args_t *args)
 		args->plugins_dirs = NULL;
 		args->nplugins_dirs = 0;
 
+		free_string_array(args->remote_exprs, args->nremote_exprs);
+		args->remote_exprs = NULL;
+		args->nremote_exprs = 0;
+
 		update_string(&args->startup_log_path, NULL);
 	}
 }
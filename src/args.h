@@ -43,6 +43,8 @@ typedef struct
 	int logging;            /* Enable logging. */
 	char *startup_log_path; /* Path for startup log (during initialization). */
 
+	char startup_profile[PATH_MAX + 1]; /* Output for startup trace or empty. */
+
 	int no_configs;  /* Skip reading configuration files. */
 	int file_picker; /* Use predefined $VIFM/vimfiles for list of files. */
 
@@ -54,7 +56,8 @@ typedef struct
 	const char *server_name; /* Name of this server. */
 	const char *target_name; /* Name of target server. */
 	char **remote_cmds;      /* Arguments to pass to server instance. */
-	char *remote_expr;       /* Expression to evaluate remotely. */
+	char **remote_exprs;     /* Expressions to evaluate remotely. */
+	size_t nremote_exprs;    /* Number of expressions to evaluate remotely. */
 
 	char lwin_path[PATH_MAX + 1]; /* Chosen path of the left pane. */
 	char rwin_path[PATH_MAX + 1]; /* Chosen path of the right pane. */
@@ -30,21 +30,23 @@
 #include <sys/wait.h> /* waitpid() */
 #endif
 #include <signal.h> /* SIG* kill() */
-#include <unistd.h> /* execve() fork() setsid() usleep() */
+#include <unistd.h> /* chdir() close() read() usleep() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
 #include <stddef.h> /* NULL wchar_t */
 #include <stdint.h> /* uintptr_t */
-#include <stdlib.h> /* EXIT_FAILURE _Exit() free() malloc() */
+#include <stdlib.h> /* calloc() free() malloc() */
 #include <string.h> /* strdup() */
 
 #include "cfg/config.h"
+#include "compat/fs_limits.h"
 #include "compat/pthread.h"
 #include "engine/var.h"
 #include "engine/variables.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/cancellation.h"
+#include "ui/statusbar.h"
 #include "ui/statusline.h"
 #include "ui/ui.h"
 #include "utils/cancellation.h"
@@ -52,9 +54,12 @@
 #include "utils/event.h"
 #include "utils/fs.h"
 #include "utils/log.h"
+#include "utils/macros.h"
 #include "utils/path.h"
+#include "utils/reactor.h"
 #include "utils/selector.h"
 #include "utils/str.h"
+#include "utils/string_array.h"
 #include "utils/utils.h"
 #include "cmd_completion.h"
 #include "status.h"
@@ -74,15 +79,16 @@
  *
  * Operations are displayed on designated job bar.
  *
- * On non-Windows systems background thread reads data from error streams of
- * external applications, which are then displayed by main thread.  This thread
- * maintains its own list of jobs (via err_next field), which is added to by
- * building a temporary list with new_err_jobs pointing to its head.  Every job
- * that has associated external process has the following life cycle:
+ * Background thread reads data from error streams of external applications,
+ * which are then displayed by main thread.  This thread watches error streams
+ * via a reactor, to which new jobs are added by building a temporary list
+ * (via err_next field) with new_err_jobs pointing to its head.  Every job that
+ * has associated external process has the following life cycle:
  *  1. Created by main thread and passed to error thread through new_err_jobs.
- *  2. Either gets marked by signal handler or its stream reaches EOF.
- *  3. Its use_count field is decremented.
- *  4. Main thread frees corresponding entry.
+ *  2. Its error stream is registered in the reactor of error thread.
+ *  3. The stream reaches EOF and is removed from the reactor.
+ *  4. Its use_count field is decremented.
+ *  5. Main thread frees corresponding entry.
  */
 
 /* Turns pointer (P) to field (F) of a structure (S) to address of that
@@ -103,6 +109,23 @@
 #define NO_JOB_ID INVALID_HANDLE_VALUE
 #endif
 
+/* State of a batch of external commands which is represented by a single
+ * job. */
+typedef struct batch_t
+{
+	bg_job_t *job;        /* Job that represents the whole batch. */
+	char **cmds;          /* Commands to run. */
+	char *cwd;            /* Working directory of the commands. */
+	int ncmds;            /* Number of elements in cmds array. */
+	int next_cmd;         /* Index of the next command to start. */
+	bg_job_t **running;   /* Jobs of running commands, NULL for free slots. */
+	int max_jobs;         /* Number of elements in running array. */
+	int skip_errors;      /* Whether to not show errors of the commands. */
+	int exit_code;        /* Exit code of the last failed command or zero. */
+	struct batch_t *next; /* Next batch in the list of active batches. */
+}
+batch_t;
+
 /* Structure with passed to background_task_bootstrap() so it can perform
  * correct initialization/cleanup. */
 typedef struct
@@ -117,17 +140,21 @@ static void set_jobcount_var(int count);
 static void job_check(bg_job_t *job);
 static void job_free(bg_job_t *job);
 static void * error_thread(void *p);
-static void update_error_jobs(bg_job_t **jobs);
-static void free_drained_jobs(bg_job_t **jobs);
-static void import_error_jobs(bg_job_t **jobs);
-static void make_ready_list(const bg_job_t *jobs, selector_t *selector);
+static void import_error_jobs(void);
+static void handle_wake_up(selector_item_t item, void *arg);
+static void handle_job_errors(selector_item_t item, void *arg);
+static void release_error_job(bg_job_t *job);
 #ifndef _WIN32
 static void rip_children(void);
 static void rip_child(pid_t pid, int status);
 static void report_error_msg(const char title[], const char text[]);
 #endif
+static void check_batches(void);
+static int batch_step(batch_t *batch);
+static void finish_batch_cmd(batch_t *batch, int exit_code);
+static void batch_free(batch_t *batch);
 static bg_job_t * launch_external(const char cmd[], BgJobFlags flags,
-		ShellRequester by);
+		ShellRequester by, const char cwd[]);
 #ifdef _WIN32
 static int finish_startup_info(STARTUPINFOW *startup);
 #endif
@@ -139,16 +166,20 @@ static bg_job_t * add_background_job(pid_t pid, const char cmd[],
 static void * background_task_bootstrap(void *arg);
 static int update_job_status(bg_job_t *job);
 static void mark_job_finished(bg_job_t *job, int exit_code);
-static void maybe_wake_error_thread(void);
 static int is_job_erroring(bg_job_t *job);
 static void wake_error_thread(void);
 static int bg_op_cancel(bg_op_t *bg_op);
 
 bg_job_t *bg_jobs = NULL;
 
+/* List of batches that have commands to start or wait for. */
+static batch_t *batches;
+
 /* Event to wake up error thread from sleep for processing by
  * wake_error_thread(). */
 static event_t *error_thread_event;
+/* Error streams of jobs watched by error thread, which is the only user. */
+static reactor_t *error_reactor;
 /* Head of list of newly started jobs. */
 static bg_job_t *new_err_jobs;
 /* Mutex to protect new_err_jobs. */
@@ -210,8 +241,6 @@ bg_check(void)
 	rip_children();
 #endif
 
-	maybe_wake_error_thread();
-
 	int active_jobs = 0;
 
 	bg_job_t *head = bg_jobs;
@@ -272,6 +301,9 @@ bg_check(void)
 	assert(bg_jobs == NULL && "Job list shouldn't be used by anyone.");
 	bg_jobs = head;
 
+	/* This can add new jobs, so do it only after job list is restored. */
+	check_batches();
+
 	set_jobcount_var(active_jobs);
 
 	checking = 0;
@@ -383,55 +415,51 @@ bg_and_wait_for_errors(char cmd[], const struct cancellation_t *cancellation)
 	int error_pipe[2];
 	int result = 0;
 
-	if(pipe(error_pipe) != 0)
+	if(make_cloexec_pipe(error_pipe) != 0)
 	{
 		report_error_msg("File pipe error", "Error creating pipe");
 		return -1;
 	}
 
-	if((pid = fork()) == -1)
+	pid = spawn_shell(cmd, SHELL_BY_APP, SPAWN_DEVNULL, SPAWN_DEVNULL,
+			error_pipe[1], /*new_session=*/0, /*cwd=*/NULL);
+	close(error_pipe[1]); /* Close write end of pipe. */
+
+	if(pid == (pid_t)-1)
 	{
+		close(error_pipe[0]);
 		return -1;
 	}
 
-	if(pid == 0)
-	{
-		run_from_fork(error_pipe, 1, 0, cmd, SHELL_BY_APP);
-	}
-	else
-	{
-		char buf[80*10];
-		char linebuf[80];
-		int nread = 0;
+	char buf[80*10];
+	char linebuf[80];
+	int nread = 0;
 
-		close(error_pipe[1]); /* Close write end of pipe. */
+	wait_for_data_from(pid, NULL, error_pipe[0], cancellation);
 
-		wait_for_data_from(pid, NULL, error_pipe[0], cancellation);
+	buf[0] = '\0';
+	while((nread = read(error_pipe[0], linebuf, sizeof(linebuf) - 1)) > 0)
+	{
+		const int read_empty_line = nread == 1 && linebuf[0] == '\n';
+		result = -1;
+		linebuf[nread] = '\0';
 
-		buf[0] = '\0';
-		while((nread = read(error_pipe[0], linebuf, sizeof(linebuf) - 1)) > 0)
+		if(!read_empty_line)
 		{
-			const int read_empty_line = nread == 1 && linebuf[0] == '\n';
-			result = -1;
-			linebuf[nread] = '\0';
-
-			if(!read_empty_line)
-			{
-				strncat(buf, linebuf, sizeof(buf) - strlen(buf) - 1);
-			}
-
-			wait_for_data_from(pid, NULL, error_pipe[0], cancellation);
+			strncat(buf, linebuf, sizeof(buf) - strlen(buf) - 1);
 		}
-		close(error_pipe[0]);
 
-		if(result != 0)
-		{
-			report_error_msg("Background Process Error", buf);
-		}
-		else
-		{
-			result = status_to_exit_code(get_proc_exit_status(pid, cancellation));
-		}
+		wait_for_data_from(pid, NULL, error_pipe[0], cancellation);
+	}
+	close(error_pipe[0]);
+
+	if(result != 0)
+	{
+		report_error_msg("Background Process Error", buf);
+	}
+	else
+	{
+		result = status_to_exit_code(get_proc_exit_status(pid, cancellation));
 	}
 
 	return result;
@@ -445,12 +473,10 @@ bg_and_wait_for_errors(char cmd[], const struct cancellation_t *cancellation)
 static void *
 error_thread(void *p)
 {
-	enum { ERROR_SELECT_TIMEOUT_MS = 250 };
+	enum { ERROR_WAIT_TIMEOUT_MS = 250 };
 
-	bg_job_t *jobs = NULL;
-
-	selector_t *selector = selector_alloc();
-	if(selector == NULL)
+	error_reactor = reactor_alloc();
+	if(error_reactor == NULL)
 	{
 		return NULL;
 	}
@@ -459,130 +485,37 @@ error_thread(void *p)
 	block_all_thread_signals();
 
 	const event_end_t event_end = event_wait_end(error_thread_event);
+	if(reactor_add(error_reactor, event_end, &handle_wake_up, NULL) != 0)
+	{
+		reactor_free(error_reactor);
+		return NULL;
+	}
 
 	while(1)
 	{
-		update_error_jobs(&jobs);
-		make_ready_list(jobs, selector);
-		selector_add(selector, event_end);
-		while(selector_wait(selector, ERROR_SELECT_TIMEOUT_MS))
-		{
-			int need_update_list = (jobs == NULL);
-
-			if(selector_is_ready(selector, event_end))
-			{
-				(void)event_reset(error_thread_event);
-			}
-
-			bg_job_t **job = &jobs;
-			while(*job != NULL)
-			{
-				bg_job_t *const j = *job;
-				char err_msg[ERR_MSG_LEN];
-				ssize_t nread;
-
-				if(j->drained)
-				{
-					/* List update drops jobs which aren't running anymore thus allowing
-					 * them to be gone.  Matters at least in tests which wait for all
-					 * tasks to finish and looping here leads to a timeout. */
-					need_update_list = 1;
-					goto next_job;
-				}
-
-				if(!selector_is_ready(selector, j->err_stream))
-				{
-					goto next_job;
-				}
-
-#ifndef _WIN32
-				nread = read(j->err_stream, err_msg, sizeof(err_msg) - 1U);
-#else
-				nread = -1;
-				DWORD bytes_read;
-				if(ReadFile(j->err_stream, err_msg, sizeof(err_msg) - 1U, &bytes_read,
-							NULL))
-				{
-					nread = bytes_read;
-				}
-#endif
-				if(nread > 0)
-				{
-					err_msg[nread] = '\0';
-					append_error_msg(j, err_msg);
-				}
-				else
-				{
-					/* EOF or some error. */
-					need_update_list = 1;
-					j->drained = 1;
-				}
-
-			next_job:
-				job = &j->err_next;
-			}
-
-			if(!need_update_list && pthread_mutex_lock(&new_err_jobs_lock) == 0)
-			{
-				need_update_list = (new_err_jobs != NULL);
-				(void)pthread_mutex_unlock(&new_err_jobs_lock);
-			}
-			if(need_update_list)
-			{
-				break;
-			}
-		}
+		import_error_jobs();
+		(void)reactor_run(error_reactor, ERROR_WAIT_TIMEOUT_MS);
 	}
 
-	selector_free(selector);
+	reactor_free(error_reactor);
 	event_free(error_thread_event);
 	return NULL;
 }
 
-/* Updates *jobs by removing finished tasks and adding new ones. */
+/* Registers new jobs in the reactor, waits if there are no jobs. */
 static void
-update_error_jobs(bg_job_t **jobs)
-{
-	free_drained_jobs(jobs);
-	import_error_jobs(jobs);
-}
-
-/* Updates *jobs by removing finished tasks. */
-static void
-free_drained_jobs(bg_job_t **jobs)
-{
-	bg_job_t **job = jobs;
-	while(*job != NULL)
-	{
-		bg_job_t *const j = *job;
-
-		if(j->drained && pthread_spin_lock(&j->status_lock) == 0)
-		{
-			/* Drop it from the list even if the job is still running, we won't be
-			 * able to get anything out of it anyway. */
-			--j->use_count;
-			j->erroring = 0;
-			*job = j->err_next;
-			(void)pthread_spin_unlock(&j->status_lock);
-			continue;
-		}
-
-		job = &j->err_next;
-	}
-}
-
-/* Updates *jobs by adding new tasks. */
-static void
-import_error_jobs(bg_job_t **jobs)
+import_error_jobs(void)
 {
 	bg_job_t *new_jobs;
 
-	/* Add new tasks to internal list, wait if there are no jobs. */
+	/* Only the event is being watched when there are no jobs. */
+	const int have_jobs = (reactor_size(error_reactor) > 1);
+
 	if(pthread_mutex_lock(&new_err_jobs_lock) != 0)
 	{
 		return;
 	}
-	while(*jobs == NULL && new_err_jobs == NULL)
+	while(!have_jobs && new_err_jobs == NULL)
 	{
 		if(pthread_cond_wait(&new_err_jobs_cond, &new_err_jobs_lock) != 0)
 		{
@@ -593,7 +526,6 @@ import_error_jobs(bg_job_t **jobs)
 	new_err_jobs = NULL;
 	(void)pthread_mutex_unlock(&new_err_jobs_lock);
 
-	/* Prepend new jobs to the list. */
 	while(new_jobs != NULL)
 	{
 		bg_job_t *const new_job = new_jobs;
@@ -602,25 +534,63 @@ import_error_jobs(bg_job_t **jobs)
 		assert(new_job->type == BJT_COMMAND &&
 				"Only external commands should be here.");
 
-		/* Mark a this job as an interesting one to avoid it being killed until we
-		 * have a chance to read error stream. */
-		new_job->drained = 0;
-
-		new_job->err_next = *jobs;
-		*jobs = new_job;
+		if(reactor_add(error_reactor, new_job->err_stream, &handle_job_errors,
+					new_job) != 0)
+		{
+			release_error_job(new_job);
+		}
 	}
 }
 
-/* Reinitializes the selector with up-to-date list of objects to watch. */
+/* Handles signaled state of error thread event by resetting it, new jobs are
+ * picked up after returning from the reactor. */
+static void
+handle_wake_up(selector_item_t item, void *arg)
+{
+	(void)event_reset(error_thread_event);
+}
+
+/* Reads error stream of a job that has data or has reached EOF. */
 static void
-make_ready_list(const bg_job_t *jobs, selector_t *selector)
+handle_job_errors(selector_item_t item, void *arg)
 {
-	selector_reset(selector);
+	bg_job_t *const job = arg;
+	char err_msg[ERR_MSG_LEN];
+	ssize_t nread;
 
-	while(jobs != NULL)
+#ifndef _WIN32
+	nread = read(item, err_msg, sizeof(err_msg) - 1U);
+#else
+	nread = -1;
+	DWORD bytes_read;
+	if(ReadFile(item, err_msg, sizeof(err_msg) - 1U, &bytes_read, NULL))
+	{
+		nread = bytes_read;
+	}
+#endif
+
+	if(nread > 0)
 	{
-		selector_add(selector, jobs->err_stream);
-		jobs = jobs->err_next;
+		err_msg[nread] = '\0';
+		append_error_msg(job, err_msg);
+		return;
+	}
+
+	/* EOF or some error, we won't be able to get anything out of the job, even
+	 * if it's still running. */
+	reactor_remove(error_reactor, item);
+	release_error_job(job);
+}
+
+/* Makes error thread stop using the job. */
+static void
+release_error_job(bg_job_t *job)
+{
+	if(pthread_spin_lock(&job->status_lock) == 0)
+	{
+		--job->use_count;
+		job->erroring = 0;
+		(void)pthread_spin_unlock(&job->status_lock);
 	}
 }
 
@@ -698,13 +668,13 @@ bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err)
 	int out_pipe[2];
 	int error_pipe[2];
 
-	if(out != NULL && pipe(out_pipe) != 0)
+	if(out != NULL && make_cloexec_pipe(out_pipe) != 0)
 	{
 		show_error_msg("File pipe error", "Error creating pipe");
 		return (pid_t)-1;
 	}
 
-	if(err != NULL && pipe(error_pipe) != 0)
+	if(err != NULL && make_cloexec_pipe(error_pipe) != 0)
 	{
 		show_error_msg("File pipe error", "Error creating pipe");
 		if(out != NULL)
@@ -718,9 +688,15 @@ bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err)
 	if(in != NULL)
 	{
 		fflush(in);
+		rewind(in);
 	}
 
-	if((pid = fork()) == -1)
+	pid = spawn_shell(cmd, user_sh ? SHELL_BY_USER : SHELL_BY_APP,
+			(in == NULL ? SPAWN_INHERIT : fileno(in)),
+			(out == NULL ? SPAWN_INHERIT : out_pipe[1]),
+			(err == NULL ? SPAWN_INHERIT : error_pipe[1]),
+			/*new_session=*/0, /*cwd=*/NULL);
+	if(pid == (pid_t)-1)
 	{
 		if(out != NULL)
 		{
@@ -735,37 +711,6 @@ bg_run_and_capture(char cmd[], int user_sh, FILE *in, FILE **out, FILE **err)
 		return (pid_t)-1;
 	}
 
-	if(pid == 0)
-	{
-		if(out != NULL)
-		{
-			bind_pipe_or_die(STDOUT_FILENO, out_pipe[1], out_pipe[0]);
-		}
-
-		if(err != NULL)
-		{
-			bind_pipe_or_die(STDERR_FILENO, error_pipe[1], error_pipe[0]);
-		}
-
-		if(in != NULL)
-		{
-			rewind(in);
-
-			if(dup2(fileno(in), STDIN_FILENO) == -1)
-			{
-				_Exit(EXIT_FAILURE);
-			}
-
-			fclose(in);
-		}
-
-		char *sh_flag = user_sh ? cfg.shell_cmd_flag : "-c";
-		prepare_for_exec();
-		execvp(get_execv_path(cfg.shell),
-				make_execv_array(cfg.shell, sh_flag, cmd));
-		_Exit(127);
-	}
-
 	if(out != NULL)
 	{
 		close(out_pipe[1]);
@@ -946,7 +891,7 @@ bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
 	}
 
 	const BgJobFlags flags = (input == NULL ? BJF_NONE : BJF_SUPPLY_INPUT);
-	bg_job_t *job = launch_external(command, flags, by);
+	bg_job_t *job = launch_external(command, flags, by, /*cwd=*/NULL);
 	free(command);
 	if(job == NULL)
 	{
@@ -972,7 +917,7 @@ bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
 bg_job_t *
 bg_run_external_job(const char cmd[], BgJobFlags flags, const char descr[])
 {
-	bg_job_t *job = launch_external(cmd, flags, SHELL_BY_APP);
+	bg_job_t *job = launch_external(cmd, flags, SHELL_BY_APP, /*cwd=*/NULL);
 	if(job == NULL)
 	{
 		return NULL;
@@ -996,9 +941,173 @@ bg_run_external_job(const char cmd[], BgJobFlags flags, const char descr[])
 	return job;
 }
 
-/* Starts a new external command job.  Returns the new job or NULL on error. */
+bg_job_t *
+bg_run_batch(char *cmds[], int ncmds, int max_jobs, int skip_errors,
+		const char descr[])
+{
+	batch_t *const batch = calloc(1, sizeof(*batch));
+	if(batch == NULL)
+	{
+		return NULL;
+	}
+
+	batch->max_jobs = MAX(max_jobs, 1);
+	batch->running = calloc(batch->max_jobs, sizeof(*batch->running));
+	batch->cmds = copy_string_array(cmds, ncmds);
+	batch->ncmds = ncmds;
+	batch->skip_errors = skip_errors;
+
+	char cwd[PATH_MAX + 1];
+	if(get_cwd(cwd, sizeof(cwd)) != NULL)
+	{
+		batch->cwd = strdup(cwd);
+	}
+
+	if(batch->running == NULL || (batch->cmds == NULL && ncmds != 0) ||
+			batch->cwd == NULL)
+	{
+		batch_free(batch);
+		return NULL;
+	}
+
+	batch->job = add_background_job(WRONG_PID, descr, (uintptr_t)NO_JOB_ID,
+			(uintptr_t)NO_JOB_ID, BJT_TASK, /*with_bg_op=*/1);
+	if(batch->job == NULL)
+	{
+		batch_free(batch);
+		return NULL;
+	}
+
+	bg_job_t *const job = batch->job;
+	bg_job_incref(job);
+	replace_string(&job->bg_op.descr, descr);
+	job->bg_op.total = ncmds;
+	place_on_job_bar(job);
+
+	batch->next = batches;
+	batches = batch;
+	check_batches();
+
+	return job;
+}
+
+/* Advances state of all active batches dropping those that are done. */
+static void
+check_batches(void)
+{
+	batch_t **link = &batches;
+	while(*link != NULL)
+	{
+		batch_t *const batch = *link;
+		if(batch_step(batch))
+		{
+			*link = batch->next;
+			batch_free(batch);
+		}
+		else
+		{
+			link = &batch->next;
+		}
+	}
+}
+
+/* Collects results of finished commands of the batch and starts new ones in
+ * their place.  Returns non-zero if the batch has finished. */
+static int
+batch_step(batch_t *batch)
+{
+	const int cancelled = bg_op_cancelled(&batch->job->bg_op);
+
+	int nrunning = 0;
+	int i;
+	for(i = 0; i < batch->max_jobs; ++i)
+	{
+		bg_job_t *job = batch->running[i];
+
+		if(job != NULL && !bg_job_is_running(job))
+		{
+			int exit_code = 1;
+			if(pthread_spin_lock(&job->status_lock) == 0)
+			{
+				exit_code = job->exit_code;
+				(void)pthread_spin_unlock(&job->status_lock);
+			}
+			finish_batch_cmd(batch, exit_code);
+
+			bg_job_decref(job);
+			job = batch->running[i] = NULL;
+		}
+
+		if(job == NULL && !cancelled && batch->next_cmd < batch->ncmds)
+		{
+			const char *const cmd = batch->cmds[batch->next_cmd++];
+			job = launch_external(cmd, BJF_NONE, SHELL_BY_USER, batch->cwd);
+			if(job == NULL)
+			{
+				finish_batch_cmd(batch, /*exit_code=*/1);
+				continue;
+			}
+
+			bg_job_incref(job);
+			job->skip_errors = batch->skip_errors;
+			batch->running[i] = job;
+		}
+		else if(job != NULL && cancelled && !bg_job_cancelled(job))
+		{
+			(void)bg_job_cancel(job);
+		}
+
+		nrunning += (job != NULL);
+	}
+
+	if(nrunning != 0 || (!cancelled && batch->next_cmd < batch->ncmds))
+	{
+		return 0;
+	}
+
+	if(batch->exit_code != 0 && !batch->skip_errors && !cancelled)
+	{
+		ui_sb_errf("Batch has failed (exit code %d): %s", batch->exit_code,
+				batch->job->cmd);
+	}
+
+	mark_job_finished(batch->job, batch->exit_code);
+	return 1;
+}
+
+/* Accounts for a finished command of the batch. */
+static void
+finish_batch_cmd(batch_t *batch, int exit_code)
+{
+	if(exit_code != 0)
+	{
+		batch->exit_code = exit_code;
+	}
+
+	if(bg_op_lock(&batch->job->bg_op))
+	{
+		++batch->job->bg_op.done;
+		bg_op_unlock(&batch->job->bg_op);
+	}
+	bg_op_changed(&batch->job->bg_op);
+}
+
+/* Frees resources of a batch.  The job of the batch isn't affected. */
+static void
+batch_free(batch_t *batch)
+{
+	free_string_array(batch->cmds, batch->ncmds);
+	free(batch->cwd);
+	free(batch->running);
+	free(batch);
+}
+
+/* Starts a new external command job.  cwd specifies working directory of the
+ * command and can be NULL to inherit it.  Returns the new job or NULL on
+ * error. */
 static bg_job_t *
-launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
+launch_external(const char cmd[], BgJobFlags flags, ShellRequester by,
+		const char cwd[])
 {
 	/* TODO: simplify this function (launch_external()) somehow, maybe split in
 	 *       two. */
@@ -1016,7 +1125,7 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 
 	/* For the sake of simplicity just use -1, calling close(-1) won't hurt. */
 	int error_pipe[2] = { -1, -1 };
-	if(!merge_streams && pipe(error_pipe) != 0)
+	if(!merge_streams && make_cloexec_pipe(error_pipe) != 0)
 	{
 		show_error_msg("File pipe error", "Error creating error pipe");
 		return NULL;
@@ -1024,7 +1133,7 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 
 	if(supply_input)
 	{
-		if(pipe(input_pipe) != 0)
+		if(make_cloexec_pipe(input_pipe) != 0)
 		{
 			show_error_msg("File pipe error", "Error creating input pipe");
 			close(error_pipe[0]);
@@ -1035,7 +1144,7 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 
 	if(capture_output)
 	{
-		if(pipe(output_pipe) != 0)
+		if(make_cloexec_pipe(output_pipe) != 0)
 		{
 			show_error_msg("File pipe error", "Error creating output pipe");
 			close(input_pipe[0]);
@@ -1046,7 +1155,12 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 		}
 	}
 
-	if((pid = fork()) == -1)
+	pid = spawn_shell(cmd, by,
+			(supply_input ? input_pipe[0] : SPAWN_DEVNULL),
+			(capture_output ? output_pipe[1] : SPAWN_DEVNULL),
+			(merge_streams ? output_pipe[1] : error_pipe[1]),
+			/*new_session=*/!keep_in_fg, cwd);
+	if(pid == (pid_t)-1)
 	{
 		close(error_pipe[0]);
 		close(error_pipe[1]);
@@ -1063,73 +1177,6 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 		return NULL;
 	}
 
-	if(pid == 0)
-	{
-		extern char **environ;
-
-		int stderr_pipe = (merge_streams ? output_pipe[1] : error_pipe[1]);
-
-		/* Redirect stderr to write end of pipe. */
-		if(dup2(stderr_pipe, STDERR_FILENO) == -1)
-		{
-			perror("dup2");
-			_Exit(EXIT_FAILURE);
-		}
-		close(STDIN_FILENO);
-		close(STDOUT_FILENO);
-
-		/* Close original error pipe descriptors. */
-		if(error_pipe[0] != -1)
-		{
-			close(error_pipe[0]);
-			close(error_pipe[1]);
-		}
-
-		if(supply_input)
-		{
-			bind_pipe_or_die(STDIN_FILENO, input_pipe[0], input_pipe[1]);
-		}
-
-		if(capture_output)
-		{
-			bind_pipe_or_die(STDOUT_FILENO, output_pipe[1], output_pipe[0]);
-		}
-
-		/* Attach stdin and optionally stdout to /dev/null. */
-		int nullfd = open("/dev/null", O_RDWR);
-		if(nullfd != -1)
-		{
-			if(!supply_input && dup2(nullfd, STDIN_FILENO) == -1)
-			{
-				perror("dup2 for stdin");
-				_Exit(EXIT_FAILURE);
-			}
-			if(!capture_output && dup2(nullfd, STDOUT_FILENO) == -1)
-			{
-				perror("dup2 for stdout");
-				_Exit(EXIT_FAILURE);
-			}
-			if(nullfd != STDIN_FILENO && nullfd != STDOUT_FILENO)
-			{
-				close(nullfd);
-			}
-		}
-
-		/* setsid() creates process group as well and doesn't work if current
-		 * process is a group leader, so don't do setpgid(). */
-		if(!keep_in_fg && setsid() == (pid_t)-1)
-		{
-			perror("setsid");
-			_Exit(EXIT_FAILURE);
-		}
-
-		prepare_for_exec();
-		char *sh_flag = (by == SHELL_BY_USER ? cfg.shell_cmd_flag : "-c");
-		execve(get_execv_path(cfg.shell),
-				make_execv_array(cfg.shell, sh_flag, strdup(cmd)), environ);
-		_Exit(127);
-	}
-
 	/* Close unused ends of pipes. */
 	if(error_pipe[1] != -1)
 	{
@@ -1229,8 +1276,10 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 	sh_cmd = win_make_sh_cmd(cmd, by);
 
 	wide_cmd = to_wide(sh_cmd);
+	wchar_t *wide_cwd = (cwd == NULL ? NULL : to_wide(cwd));
 	int started = CreateProcessW(NULL, wide_cmd, NULL, NULL, 1, CREATE_SUSPENDED,
-			NULL, NULL, &startup, &pinfo);
+			NULL, wide_cwd, &startup, &pinfo);
+	free(wide_cwd);
 	free(wide_cmd);
 
 	CloseHandle(startup.hStdInput);
@@ -1515,6 +1564,9 @@ add_background_job(pid_t pid, const char cmd[], uintptr_t err, uintptr_t data,
 		new_err_jobs = new;
 		(void)pthread_mutex_unlock(&new_err_jobs_lock);
 		(void)pthread_cond_signal(&new_err_jobs_cond);
+
+		/* Error thread might be waiting on streams of other jobs. */
+		wake_error_thread();
 	}
 
 	new->with_bg_op = with_bg_op;
@@ -1796,7 +1848,6 @@ bg_job_wait_errors(bg_job_t *job)
 		erroring = is_job_erroring(job);
 		if(erroring)
 		{
-			wake_error_thread();
 			usleep(ERROR_SLEEP_US);
 		}
 	}
@@ -1807,24 +1858,6 @@ bg_job_wait_errors(bg_job_t *job)
 	return erroring;
 }
 
-/* Wakes up error thread to process any changes to the jobs if it makes
- * sense. */
-static void
-maybe_wake_error_thread(void)
-{
-	/* Don't wake up the error thread unless there is at least one job handled by
-	 * it. */
-	bg_job_t *job;
-	for(job = bg_jobs; job != NULL; job = job->next)
-	{
-		if(is_job_erroring(job))
-		{
-			wake_error_thread();
-			break;
-		}
-	}
-}
-
 /* Checks whether the job is being used by the error thread.  Returns non-zero
  * if so. */
 static int
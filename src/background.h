@@ -122,9 +122,8 @@ typedef struct bg_job_t
 
 	struct bg_job_t *next;     /* Link to the next element in bg_jobs list. */
 
-	/* Used by error thread for BJT_COMMAND jobs. */
-	struct bg_job_t *err_next; /* Link to the next element in error read list. */
-	int drained;               /* Whether error stream of no interest anymore. */
+	/* Used to pass BJT_COMMAND jobs to error thread. */
+	struct bg_job_t *err_next; /* Link to the next element in new jobs list. */
 
 	int in_menu; /* Whether this task is visible in :jobs menu. */
 }
@@ -154,6 +153,15 @@ int bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
 bg_job_t * bg_run_external_job(const char cmd[], BgJobFlags flags,
 		const char descr[]);
 
+/* Creates a single background job that runs external commands at most
+ * max_jobs of them at a time.  The job finishes when all of the commands do,
+ * its exit code is that of the last failed command or zero.  Errors of the
+ * commands are displayed unless skip_errors is set.  Upon creation the job has
+ * one extra use, which needs to be decremented for it to be freed.  Returns
+ * the job or NULL on error. */
+bg_job_t * bg_run_batch(char *cmds[], int ncmds, int max_jobs,
+		int skip_errors, const char descr[]);
+
 struct cancellation_t;
 
 /* Runs command in background and displays its errors to a user.  To determine
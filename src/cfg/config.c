@@ -58,6 +58,7 @@
 #include "../utils/str.h"
 #include "../utils/path.h"
 #include "../utils/string_array.h"
+#include "../utils/trace.h"
 #include "../utils/utils.h"
 #include "../cmd_core.h"
 #include "../filelist.h"
@@ -784,7 +785,9 @@ cfg_source_file(const char filename[])
 	SourcingState sourcing_state = curr_stats.sourcing_state;
 	curr_stats.sourcing_state = SOURCING_PROCESSING;
 
+	trace_begin(filename, "source");
 	int result = source_file_internal(lines, filename);
+	trace_end();
 
 	curr_stats.sourcing_state = sourcing_state;
 
@@ -833,11 +836,25 @@ source_file_internal(strlist_t lines, const char filename[])
 
 		ui_sb_clear();
 
+		/* Every line gets its own span to make slow ones stand out. */
+		const int traced = (trace_enabled() && line[0] != '\0');
+		if(traced)
+		{
+			char location[PATH_MAX + 32];
+			snprintf(location, sizeof(location), "%s:%d", filename, line_num);
+			trace_begin(line, location);
+		}
+
 		if(cmds_dispatch(line, curr_view, CIT_COMMAND) < 0)
 		{
 			show_sourcing_error(filename, line_num);
 			encoutered_errors = 1;
 		}
+
+		if(traced)
+		{
+			trace_end();
+		}
 		if(curr_stats.sourcing_state == SOURCING_FINISHING)
 			break;
 
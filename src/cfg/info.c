@@ -19,10 +19,13 @@
 
 #include "info.h"
 
+#include <sys/stat.h> /* stat */
+
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
 #include <locale.h> /* setlocale() LC_ALL */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* FILE fpos_t fclose() fgetpos() fgets() fprintf() fputc()
                       fscanf() fsetpos() snprintf() */
 #include <stdlib.h> /* abs() free() */
@@ -183,10 +186,42 @@
  *  - for elements of arrays timestamps act more like generation numbers and
  *    while merging happens per element, effectively it's generations (defined
  *    by time of storing of the array) which are being merged
+ *
+ * Changes made by an instance that was the last one to write vifminfo.json are
+ * appended to vifminfo.journal instead of rewriting the whole file.  The first
+ * line of the journal identifies the file it applies to, every other line is a
+ * record of the following form:
+ *  set = {
+ *      "section" = <new value or null to remove the section>
+ *  }
+ *  dicts = {
+ *      "section" = {
+ *          "key" = <new value or null to remove the key>
+ *      }
+ *  }
+ *  hists = {
+ *      "section" = {
+ *          add = [ <items added to the end of a history> ]
+ *          size = 10 # new size of the history
+ *      }
+ *  }
+ *
+ * Journal is merged into vifminfo.json on writes that need merging or once it
+ * gets large in comparison with the file.
  */
 
+/* Maximum number of history items that are recorded in the journal for a
+ * single history.  Larger changes replace whole history. */
+enum { MAX_HIST_DELTA = 64 };
+
+/* Journal is merged into vifminfo.json once it's larger than a quarter of the
+ * file, but not before it reaches this size. */
+enum { MIN_JOURNAL_LIMIT = 16*1024 };
+
 static JSON_Value * read_legacy_info_file(const char info_file[]);
-static void load_state(JSON_Object *root, int reread);
+static void load_info(int reread, int defer);
+static void load_state(JSON_Object *root, int reread, int defer);
+static void load_deferrable(JSON_Object *root, int extend_hists);
 static void load_gtabs(JSON_Object *root, int reread);
 static tab_layout_t load_gtab_layout(const JSON_Object *gtab, int apply,
 		int reread);
@@ -203,7 +238,8 @@ static void load_bmarks(JSON_Object *root);
 static void load_regs(JSON_Object *root);
 static void load_dir_stack(JSON_Object *root);
 static void load_trash(JSON_Object *root);
-static void load_history(JSON_Object *root, const char node[], hist_t *hist);
+static void load_history(JSON_Object *root, const char node[], hist_t *hist,
+		int extend);
 static void load_sorting(JSON_Object *ptab, view_t *view);
 static void ensure_history_not_full(hist_t *hist);
 static void put_dhistory_entry(view_t *view, int reread, const char dir[],
@@ -211,7 +247,32 @@ static void put_dhistory_entry(view_t *view, int reread, const char dir[],
 static void set_manual_filter(view_t *view, const char value[]);
 TSTATIC void write_info_file(void);
 static int copy_file(const char src[], const char dst[]);
-static void update_info_file(const char filename[], int vinfo, int merge);
+static JSON_Value * update_info_file(const char filename[], int vinfo,
+		int merge, const char journal[]);
+static void get_journal_path(char buf[], size_t buf_size);
+static JSON_Value * read_info_file(const char info_file[],
+		const char journal[]);
+static void remember_stored_state(JSON_Value *state, const char journal[]);
+static int can_use_journal(const char info_file[], const char journal[]);
+static int journal_changed(const char journal[]);
+static int journal_applies(const char journal[], const char info_file[]);
+static int update_journal(const char info_file[], const char journal[]);
+static int append_journal_record(const char info_file[], const char journal[],
+		const JSON_Value *record);
+static JSON_Value * make_journal_record(const JSON_Object *stored,
+		const JSON_Object *current);
+static void record_dict_delta(JSON_Object *dicts, const char name[],
+		const JSON_Object *stored, const JSON_Object *current);
+static int record_hist_delta(JSON_Object *hists, const char name[],
+		const JSON_Array *stored, const JSON_Array *current);
+static int hist_delta_matches(const JSON_Array *stored,
+		const JSON_Array *current, int count);
+static void replay_journal(JSON_Object *root, const char journal[]);
+static void apply_journal_record(JSON_Object *root, const JSON_Object *record);
+static void apply_dict_delta(JSON_Object *root, const char name[],
+		const JSON_Object *delta);
+static void apply_hist_delta(JSON_Object *root, const char name[],
+		const JSON_Object *delta);
 TSTATIC char * drop_locale(void);
 TSTATIC void restore_locale(char locale[]);
 TSTATIC JSON_Value * serialize_state(int vinfo);
@@ -236,6 +297,9 @@ static void merge_history(int session_load, JSON_Object *current,
 		const JSON_Object *admixture, const char node[]);
 static void merge_history_by_order(JSON_Object *current,
 		const JSON_Object *admixture, const char node[]);
+static trie_t * make_hist_set(const JSON_Array *hist);
+static int hist_contains(trie_t *set, const JSON_Array *hist,
+		const char text[]);
 static void merge_regs(JSON_Object *current, const JSON_Object *admixture);
 static void merge_dir_stack(JSON_Object *current, const JSON_Object *admixture);
 static void merge_options(JSON_Object *current, const JSON_Object *admixture);
@@ -289,7 +353,8 @@ static void clone_array(JSON_Object *parent, const JSON_Array *array,
 		const char node[]);
 static void set_session(const char new_session[]);
 static void write_session_file(void);
-static void store_file(const char path[], filemon_t *mon, int vinfo);
+static JSON_Value * store_file(const char path[], filemon_t *mon, int vinfo,
+		const char journal[]);
 static void get_session_dir(char buf[], size_t buf_size);
 
 /* Monitor to check for changes of vifminfo file. */
@@ -298,10 +363,21 @@ static filemon_t vifminfo_mon;
 static filemon_t session_mon;
 /* Callback to be invoked when active session has changed.  Can be NULL. */
 static sessions_changed session_changed_cb;
+/* State of vifminfo.json with its journal applied as it was last read or
+ * written by this instance.  Can be NULL. */
+static JSON_Value *stored_state;
+/* Monitor to check for changes of vifminfo.journal file.  Not set if there is
+ * no journal. */
+static filemon_t journal_mon;
+/* Whether some parts of stored_state are yet to be loaded. */
+static int deferred_load;
 
 void
 state_store(void)
 {
+	/* Not loading postponed data would drop it. */
+	state_load_deferred();
+
 	write_info_file();
 
 	if(sessions_active())
@@ -313,11 +389,43 @@ state_store(void)
 void
 state_load(int reread)
 {
+	load_info(reread, /*defer=*/0);
+}
+
+void
+state_load_initial(void)
+{
+	load_info(/*reread=*/0, /*defer=*/1);
+}
+
+void
+state_load_deferred(void)
+{
+	if(deferred_load)
+	{
+		deferred_load = 0;
+		load_deferrable(json_object(stored_state), /*extend_hists=*/0);
+	}
+}
+
+/* Reads vifminfo file populating internal structures with information it
+ * contains.  Loading of some parts can be postponed until
+ * state_load_deferred() is called. */
+static void
+load_info(int reread, int defer)
+{
+	state_load_deferred();
+
 	char info_file[PATH_MAX + 16];
 	snprintf(info_file, sizeof(info_file), "%s/vifminfo.json", cfg.config_dir);
+	char journal[PATH_MAX + 32];
+	get_journal_path(journal, sizeof(journal));
+
+	const char *valid_journal = journal_applies(journal, info_file) ? journal
+	                                                               : NULL;
 
 	char *locale = drop_locale();
-	JSON_Value *state = json_parse_file(info_file);
+	JSON_Value *state = read_info_file(info_file, valid_journal);
 	restore_locale(locale);
 
 	if(state == NULL)
@@ -326,15 +434,21 @@ state_load(int reread)
 		snprintf(legacy_info_file, sizeof(legacy_info_file), "%s/vifminfo",
 				cfg.config_dir);
 		state = read_legacy_info_file(legacy_info_file);
+		if(state == NULL)
+		{
+			return;
+		}
+
+		load_state(json_object(state), reread, /*defer=*/0);
+		json_value_free(state);
 	}
-	if(state == NULL)
+	else
 	{
-		return;
+		load_state(json_object(state), reread, defer);
+		remember_stored_state(state, valid_journal);
+		deferred_load = defer;
 	}
 
-	load_state(json_object(state), reread);
-	json_value_free(state);
-
 	(void)filemon_from_file(info_file, FMT_MODIFIED, &vifminfo_mon);
 
 	dir_stack_freeze();
@@ -652,9 +766,10 @@ read_legacy_info_file(const char info_file[])
 	return root_value;
 }
 
-/* Loads state of the application from JSON. */
+/* Loads state of the application from JSON.  Loading of histories and trash is
+ * skipped if defer is set. */
 static void
-load_state(JSON_Object *root, int reread)
+load_state(JSON_Object *root, int reread, int defer)
 {
 	int use_term_multiplexer;
 	if(get_bool(root, "use-term-multiplexer", &use_term_multiplexer))
@@ -679,13 +794,26 @@ load_state(JSON_Object *root, int reread)
 	load_bmarks(root);
 	load_regs(root);
 	load_dir_stack(root);
+
+	if(!defer)
+	{
+		load_deferrable(root, /*extend_hists=*/1);
+	}
+}
+
+/* Loads parts of the state that aren't necessary to display the first frame.
+ * Histories grow to fit loaded items if extend_hists is set, otherwise older
+ * items are dropped. */
+static void
+load_deferrable(JSON_Object *root, int extend_hists)
+{
 	load_trash(root);
-	load_history(root, "cmd-hist", &curr_stats.cmd_hist);
-	load_history(root, "exprreg-hist", &curr_stats.exprreg_hist);
-	load_history(root, "search-hist", &curr_stats.search_hist);
-	load_history(root, "prompt-hist", &curr_stats.prompt_hist);
-	load_history(root, "lfilt-hist", &curr_stats.filter_hist);
-	load_history(root, "menu-cmd-hist", &curr_stats.menucmd_hist);
+	load_history(root, "cmd-hist", &curr_stats.cmd_hist, extend_hists);
+	load_history(root, "exprreg-hist", &curr_stats.exprreg_hist, extend_hists);
+	load_history(root, "search-hist", &curr_stats.search_hist, extend_hists);
+	load_history(root, "prompt-hist", &curr_stats.prompt_hist, extend_hists);
+	load_history(root, "lfilt-hist", &curr_stats.filter_hist, extend_hists);
+	load_history(root, "menu-cmd-hist", &curr_stats.menucmd_hist, extend_hists);
 }
 
 /* Loads global tabs from JSON. */
@@ -1156,9 +1284,11 @@ load_trash(JSON_Object *root)
 	}
 }
 
-/* Loads history data from JSON. */
+/* Loads history data from JSON.  History is extended to fit all items if
+ * extend is set. */
 static void
-load_history(JSON_Object *root, const char node[], hist_t *hist)
+load_history(JSON_Object *root, const char node[], hist_t *hist,
+		int extend)
 {
 	JSON_Array *entries = json_object_get_array(root, node);
 
@@ -1173,7 +1303,10 @@ load_history(JSON_Object *root, const char node[], hist_t *hist)
 			double ts = -1;
 			get_double(entry, "ts", &ts);
 
-			ensure_history_not_full(hist);
+			if(extend)
+			{
+				ensure_history_not_full(hist);
+			}
 			hist_add(hist, text, (time_t)ts);
 		}
 	}
@@ -1279,8 +1412,18 @@ write_info_file(void)
 {
 	char info_file[PATH_MAX + 16];
 	snprintf(info_file, sizeof(info_file), "%s/vifminfo.json", cfg.config_dir);
+	char journal[PATH_MAX + 32];
+	get_journal_path(journal, sizeof(journal));
+
+	if(can_use_journal(info_file, journal) &&
+			update_journal(info_file, journal) == 0)
+	{
+		return;
+	}
 
-	store_file(info_file, &vifminfo_mon, cfg.vifm_info);
+	JSON_Value *state = store_file(info_file, &vifminfo_mon, cfg.vifm_info,
+			journal);
+	remember_stored_state(state, journal);
 }
 
 /* Copies the src file to the dst location.  Returns zero on success. */
@@ -1297,9 +1440,11 @@ copy_file(const char src[], const char dst[])
 }
 
 /* Reads contents of the filename file as a JSON info file and updates it with
- * the state of current instance. */
-static void
-update_info_file(const char filename[], int vinfo, int merge)
+ * the state of current instance.  Journal is applied on top of the file before
+ * merging unless it's NULL.  Returns written state or NULL on error. */
+static JSON_Value *
+update_info_file(const char filename[], int vinfo, int merge,
+		const char journal[])
 {
 	char *locale = drop_locale();
 	JSON_Value *current = serialize_state(vinfo);
@@ -1309,6 +1454,10 @@ update_info_file(const char filename[], int vinfo, int merge)
 		JSON_Value *admixture = json_parse_file(filename);
 		if(admixture != NULL)
 		{
+			if(journal != NULL)
+			{
+				replay_journal(json_object(admixture), journal);
+			}
 			merge_states(vinfo, 0, json_object(current), json_object(admixture));
 			json_value_free(admixture);
 		}
@@ -1317,10 +1466,541 @@ update_info_file(const char filename[], int vinfo, int merge)
 	if(json_serialize_to_file(current, filename) == JSONError)
 	{
 		LOG_ERROR_MSG("Error storing state to: %s", filename);
+		json_value_free(current);
+		current = NULL;
 	}
 
-	json_value_free(current);
 	restore_locale(locale);
+	return current;
+}
+
+/* Fills buffer with the path to journal of vifminfo.json file. */
+static void
+get_journal_path(char buf[], size_t buf_size)
+{
+	snprintf(buf, buf_size, "%s/vifminfo.journal", cfg.config_dir);
+}
+
+/* Reads vifminfo.json file and applies its journal unless it's NULL.  Returns
+ * JSON value or NULL on error. */
+static JSON_Value *
+read_info_file(const char info_file[], const char journal[])
+{
+	JSON_Value *state = json_parse_file(info_file);
+	if(state != NULL && journal != NULL)
+	{
+		replay_journal(json_object(state), journal);
+	}
+	return state;
+}
+
+/* Remembers state of vifminfo.json as it's stored on disk along with state of
+ * its journal, which is NULL if there is no valid journal.  Takes ownership of
+ * the state, which can be NULL. */
+static void
+remember_stored_state(JSON_Value *state, const char journal[])
+{
+	json_value_free(stored_state);
+	stored_state = state;
+
+	if(journal == NULL ||
+			filemon_from_file(journal, FMT_MODIFIED, &journal_mon) != 0)
+	{
+		filemon_reset(&journal_mon);
+	}
+}
+
+/* Checks whether changes can be appended to the journal instead of updating
+ * vifminfo.json file, which is the case when nobody else has modified either of
+ * them since the last time.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+can_use_journal(const char info_file[], const char journal[])
+{
+	if(stored_state == NULL)
+	{
+		return 0;
+	}
+
+	filemon_t current_mon;
+	if(filemon_from_file(info_file, FMT_MODIFIED, &current_mon) != 0 ||
+			!filemon_equal(&vifminfo_mon, &current_mon) || journal_changed(journal))
+	{
+		return 0;
+	}
+
+	const uint64_t limit = MAX(get_file_size(info_file)/4U,
+			(uint64_t)MIN_JOURNAL_LIMIT);
+	return (get_file_size(journal) <= limit);
+}
+
+/* Checks whether journal was created, removed or modified by someone else.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+journal_changed(const char journal[])
+{
+	filemon_t current_mon;
+	if(filemon_from_file(journal, FMT_MODIFIED, &current_mon) != 0)
+	{
+		return filemon_is_set(&journal_mon);
+	}
+	return !filemon_equal(&journal_mon, &current_mon);
+}
+
+/* Checks whether journal exists and was written for the current version of
+ * vifminfo.json.  Returns non-zero if so, otherwise zero is returned. */
+static int
+journal_applies(const char journal[], const char info_file[])
+{
+	struct stat st;
+	if(os_stat(info_file, &st) != 0)
+	{
+		return 0;
+	}
+
+	FILE *fp = os_fopen(journal, "rb");
+	if(fp == NULL)
+	{
+		return 0;
+	}
+
+	char *line = read_line(fp, NULL);
+	fclose(fp);
+	if(line == NULL)
+	{
+		return 0;
+	}
+
+	char *locale = drop_locale();
+	JSON_Value *header = json_parse_string(line);
+	restore_locale(locale);
+	free(line);
+
+	double size, inode;
+	const int applies = get_double(json_object(header), "size", &size)
+	                 && get_double(json_object(header), "inode", &inode)
+	                 && size == (double)st.st_size
+	                 && inode == (double)st.st_ino;
+	json_value_free(header);
+	return applies;
+}
+
+/* Appends changes of the state since the last write to the journal.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+update_journal(const char info_file[], const char journal[])
+{
+	char *locale = drop_locale();
+
+	JSON_Value *current = serialize_state(cfg.vifm_info);
+	JSON_Value *record = make_journal_record(json_object(stored_state),
+			json_object(current));
+
+	int error = 0;
+	if(record != NULL)
+	{
+		error = append_journal_record(info_file, journal, record);
+		json_value_free(record);
+	}
+
+	restore_locale(locale);
+
+	if(error)
+	{
+		json_value_free(current);
+		return 1;
+	}
+
+	remember_stored_state(current, journal);
+	return 0;
+}
+
+/* Writes record at the end of the journal creating it if necessary.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+append_journal_record(const char info_file[], const char journal[],
+		const JSON_Value *record)
+{
+	JSON_Value *header = NULL;
+	if(!filemon_is_set(&journal_mon))
+	{
+		struct stat st;
+		if(os_stat(info_file, &st) != 0)
+		{
+			return 1;
+		}
+
+		header = json_value_init_object();
+		set_double(json_object(header), "size", st.st_size);
+		set_double(json_object(header), "inode", st.st_ino);
+	}
+
+	FILE *fp = os_fopen(journal, header == NULL ? "ab" : "wb");
+	if(fp == NULL)
+	{
+		json_value_free(header);
+		return 1;
+	}
+
+	if(header != NULL)
+	{
+		char *line = json_serialize_to_string(header);
+		if(line != NULL)
+		{
+			fprintf(fp, "%s\n", line);
+			json_free_serialized_string(line);
+		}
+		json_value_free(header);
+	}
+
+	char *line = json_serialize_to_string(record);
+	if(line != NULL)
+	{
+		fprintf(fp, "%s\n", line);
+		json_free_serialized_string(line);
+	}
+
+	int error = (line == NULL || ferror(fp));
+	error |= (fclose(fp) != 0);
+	if(error)
+	{
+		LOG_ERROR_MSG("Error appending to journal: %s", journal);
+	}
+	return error;
+}
+
+/* Builds journal record that turns stored state into the current one.  Returns
+ * the record or NULL if states are equal. */
+static JSON_Value *
+make_journal_record(const JSON_Object *stored, const JSON_Object *current)
+{
+	JSON_Value *record_value = json_value_init_object();
+	JSON_Object *record = json_object(record_value);
+	JSON_Object *set = add_object(record, "set");
+	JSON_Object *dicts = add_object(record, "dicts");
+	JSON_Object *hists = add_object(record, "hists");
+
+	int changed = 0;
+
+	size_t i, n;
+	for(i = 0U, n = json_object_get_count(current); i < n; ++i)
+	{
+		const char *name = json_object_get_name(current, i);
+		JSON_Value *value = json_object_get_value_at(current, i);
+		JSON_Value *old_value = json_object_get_value(stored, name);
+		if(json_value_equals(old_value, value))
+		{
+			continue;
+		}
+
+		changed = 1;
+
+		if(json_value_get_type(old_value) == JSONObject &&
+				json_value_get_type(value) == JSONObject)
+		{
+			record_dict_delta(dicts, name, json_value_get_object(old_value),
+					json_value_get_object(value));
+		}
+		else if(!ends_with(name, "-hist") ||
+				!record_hist_delta(hists, name, json_value_get_array(old_value),
+					json_value_get_array(value)))
+		{
+			json_object_set_value(set, name, json_value_deep_copy(value));
+		}
+	}
+
+	for(i = 0U, n = json_object_get_count(stored); i < n; ++i)
+	{
+		const char *name = json_object_get_name(stored, i);
+		if(json_object_get_value(current, name) == NULL)
+		{
+			json_object_set_null(set, name);
+			changed = 1;
+		}
+	}
+
+	if(!changed)
+	{
+		json_value_free(record_value);
+		return NULL;
+	}
+	return record_value;
+}
+
+/* Records changes of a dictionary as a set of updated and removed keys. */
+static void
+record_dict_delta(JSON_Object *dicts, const char name[],
+		const JSON_Object *stored, const JSON_Object *current)
+{
+	JSON_Object *delta = add_object(dicts, name);
+
+	size_t i, n;
+	for(i = 0U, n = json_object_get_count(current); i < n; ++i)
+	{
+		const char *key = json_object_get_name(current, i);
+		JSON_Value *value = json_object_get_value_at(current, i);
+		if(!json_value_equals(json_object_get_value(stored, key), value))
+		{
+			json_object_set_value(delta, key, json_value_deep_copy(value));
+		}
+	}
+
+	for(i = 0U, n = json_object_get_count(stored); i < n; ++i)
+	{
+		const char *key = json_object_get_name(stored, i);
+		if(json_object_get_value(current, key) == NULL)
+		{
+			json_object_set_null(delta, key);
+		}
+	}
+}
+
+/* Records changes of a history as a list of items that were added to it, which
+ * is how histories usually change.  Returns non-zero on success and zero if the
+ * change can't be represented this way. */
+static int
+record_hist_delta(JSON_Object *hists, const char name[],
+		const JSON_Array *stored, const JSON_Array *current)
+{
+	if(stored == NULL || current == NULL)
+	{
+		return 0;
+	}
+
+	const int n = json_array_get_count(current);
+	int count;
+	for(count = 0; count <= n && count <= MAX_HIST_DELTA; ++count)
+	{
+		if(!hist_delta_matches(stored, current, count))
+		{
+			continue;
+		}
+
+		JSON_Object *delta = add_object(hists, name);
+		set_int(delta, "size", n);
+
+		JSON_Array *added = add_array(delta, "add");
+		int i;
+		for(i = n - count; i < n; ++i)
+		{
+			JSON_Value *item = json_array_get_value(current, i);
+			json_array_append_value(added, json_value_deep_copy(item));
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+/* Checks whether adding last count items of the current history to the stored
+ * one produces the current history.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+hist_delta_matches(const JSON_Array *stored, const JSON_Array *current,
+		int count)
+{
+	const int n = json_array_get_count(current);
+	trie_t *added = trie_create(/*free_func=*/NULL);
+	if(added == NULL)
+	{
+		/* Whole history will be recorded instead. */
+		return 0;
+	}
+
+	int i;
+	for(i = n - count; i < n; ++i)
+	{
+		const char *text;
+		if(!get_str(json_array_get_object(current, i), "text", &text) ||
+				trie_put(added, text) < 0)
+		{
+			trie_free(added);
+			return 0;
+		}
+	}
+
+	/* Walk both histories from their ends skipping items that were added. */
+	int j = n - count - 1;
+	i = json_array_get_count(stored) - 1;
+	while(j >= 0 && i >= 0)
+	{
+		const char *text;
+		void *data;
+		if(get_str(json_array_get_object(stored, i), "text", &text) &&
+				trie_get(added, text, &data) == 0)
+		{
+			--i;
+			continue;
+		}
+
+		if(!json_value_equals(json_array_get_value(stored, i),
+					json_array_get_value(current, j)))
+		{
+			break;
+		}
+
+		--i;
+		--j;
+	}
+
+	trie_free(added);
+	return (j < 0);
+}
+
+/* Applies records of the journal to the state. */
+static void
+replay_journal(JSON_Object *root, const char journal[])
+{
+	FILE *fp = os_fopen(journal, "rb");
+	if(fp == NULL)
+	{
+		return;
+	}
+
+	/* Skip the header. */
+	char *line = read_line(fp, NULL);
+
+	while((line = read_line(fp, line)) != NULL)
+	{
+		JSON_Value *record = json_parse_string(line);
+		if(record == NULL)
+		{
+			/* Record could have been written only partially. */
+			break;
+		}
+
+		apply_journal_record(root, json_object(record));
+		json_value_free(record);
+	}
+
+	free(line);
+	fclose(fp);
+}
+
+/* Applies a single journal record to the state. */
+static void
+apply_journal_record(JSON_Object *root, const JSON_Object *record)
+{
+	JSON_Object *set = json_object_get_object(record, "set");
+	JSON_Object *dicts = json_object_get_object(record, "dicts");
+	JSON_Object *hists = json_object_get_object(record, "hists");
+
+	size_t i, n;
+	for(i = 0U, n = json_object_get_count(set); i < n; ++i)
+	{
+		const char *name = json_object_get_name(set, i);
+		JSON_Value *value = json_object_get_value_at(set, i);
+		if(json_value_get_type(value) == JSONNull)
+		{
+			json_object_remove(root, name);
+		}
+		else
+		{
+			json_object_set_value(root, name, json_value_deep_copy(value));
+		}
+	}
+
+	for(i = 0U, n = json_object_get_count(dicts); i < n; ++i)
+	{
+		apply_dict_delta(root, json_object_get_name(dicts, i),
+				json_value_get_object(json_object_get_value_at(dicts, i)));
+	}
+
+	for(i = 0U, n = json_object_get_count(hists); i < n; ++i)
+	{
+		apply_hist_delta(root, json_object_get_name(hists, i),
+				json_value_get_object(json_object_get_value_at(hists, i)));
+	}
+}
+
+/* Updates and removes keys of a dictionary. */
+static void
+apply_dict_delta(JSON_Object *root, const char name[], const JSON_Object *delta)
+{
+	JSON_Object *dict = json_object_get_object(root, name);
+	if(dict == NULL)
+	{
+		dict = add_object(root, name);
+	}
+
+	size_t i, n;
+	for(i = 0U, n = json_object_get_count(delta); i < n; ++i)
+	{
+		const char *key = json_object_get_name(delta, i);
+		JSON_Value *value = json_object_get_value_at(delta, i);
+		if(json_value_get_type(value) == JSONNull)
+		{
+			json_object_remove(dict, key);
+		}
+		else
+		{
+			json_object_set_value(dict, key, json_value_deep_copy(value));
+		}
+	}
+}
+
+/* Adds items to a history removing their older duplicates and items that don't
+ * fit. */
+static void
+apply_hist_delta(JSON_Object *root, const char name[], const JSON_Object *delta)
+{
+	int size;
+	JSON_Array *added = json_object_get_array(delta, "add");
+	if(added == NULL || !get_int(delta, "size", &size))
+	{
+		return;
+	}
+
+	trie_t *const set = make_hist_set(added);
+
+	JSON_Array *entries = json_object_get_array(root, name);
+
+	/* Number of old items that remain in the history. */
+	int kept = 0;
+	int i, n;
+	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
+	{
+		const char *text;
+		if(!get_str(json_array_get_object(entries, i), "text", &text) ||
+				!hist_contains(set, added, text))
+		{
+			++kept;
+		}
+	}
+
+	int to_skip = kept - (size - (int)json_array_get_count(added));
+
+	JSON_Value *merged_value = json_value_init_array();
+	JSON_Array *merged = json_array(merged_value);
+
+	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
+	{
+		const char *text;
+		if(get_str(json_array_get_object(entries, i), "text", &text) &&
+				hist_contains(set, added, text))
+		{
+			continue;
+		}
+
+		if(to_skip > 0)
+		{
+			--to_skip;
+			continue;
+		}
+
+		JSON_Value *entry = json_array_get_value(entries, i);
+		json_array_append_value(merged, json_value_deep_copy(entry));
+	}
+
+	trie_free(set);
+
+	for(i = 0, n = json_array_get_count(added); i < n; ++i)
+	{
+		JSON_Value *entry = json_array_get_value(added, i);
+		json_array_append_value(merged, json_value_deep_copy(entry));
+	}
+
+	json_object_set_value(root, name, merged_value);
 }
 
 /* Replaces current locale with C locale and returns string to be passed to
@@ -1913,21 +2593,12 @@ merge_history(int session_load, JSON_Object *current,
 		return;
 	}
 
-	trie_t *trie = trie_create(/*free_func=*/NULL);
+	trie_t *const set = make_hist_set(entries);
 	int i, n;
 
 	JSON_Value *combined_value = json_value_init_array();
 	JSON_Array *combined = json_array(combined_value);
 
-	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
-	{
-		const char *text;
-		if(get_str(json_array_get_object(entries, i), "text", &text))
-		{
-			trie_put(trie, text);
-		}
-	}
-
 	for(i = 0, n = json_array_get_count(updated); i < n; ++i)
 	{
 		JSON_Object *entry = json_array_get_object(updated, i);
@@ -1935,8 +2606,7 @@ merge_history(int session_load, JSON_Object *current,
 		const char *text;
 		if(get_str(entry, "text", &text))
 		{
-			void *data;
-			if(trie_get(trie, text, &data) != 0)
+			if(!hist_contains(set, entries, text))
 			{
 				JSON_Value *value = json_object_get_wrapping_value(entry);
 				json_array_append_value(combined, json_value_deep_copy(value));
@@ -1944,7 +2614,7 @@ merge_history(int session_load, JSON_Object *current,
 		}
 	}
 
-	trie_free(trie);
+	trie_free(set);
 
 	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
 	{
@@ -1980,27 +2650,17 @@ merge_history_by_order(JSON_Object *current, const JSON_Object *admixture,
 	JSON_Array *updated = json_object_get_array(admixture, node);
 
 	int i, n;
-	trie_t *trie = trie_create(/*free_func=*/NULL);
+	trie_t *const set = make_hist_set(entries);
 
 	JSON_Value *merged_value = json_value_init_array();
 	JSON_Array *merged = json_array(merged_value);
 
-	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
-	{
-		const char *text;
-		if(get_str(json_array_get_object(entries, i), "text", &text))
-		{
-			trie_put(trie, text);
-		}
-	}
-
 	for(i = 0, n = json_array_get_count(updated); i < n; ++i)
 	{
 		const char *text;
 		if(get_str(json_array_get_object(updated, i), "text", &text))
 		{
-			void *data;
-			if(trie_get(trie, text, &data) != 0)
+			if(!hist_contains(set, entries, text))
 			{
 				JSON_Value *entry = json_array_get_value(updated, i);
 				json_array_append_value(merged, json_value_deep_copy(entry));
@@ -2008,7 +2668,7 @@ merge_history_by_order(JSON_Object *current, const JSON_Object *admixture,
 		}
 	}
 
-	trie_free(trie);
+	trie_free(set);
 
 	for(i = 0, n = json_array_get_count(entries); i < n; ++i)
 	{
@@ -2019,6 +2679,57 @@ merge_history_by_order(JSON_Object *current, const JSON_Object *admixture,
 	json_object_set_value(current, node, merged_value);
 }
 
+/* Builds a set of texts of history items for quick lookups via
+ * hist_contains().  Returns the set or NULL on error. */
+static trie_t *
+make_hist_set(const JSON_Array *hist)
+{
+	trie_t *set = trie_create(/*free_func=*/NULL);
+	if(set == NULL)
+	{
+		return NULL;
+	}
+
+	int i, n;
+	for(i = 0, n = json_array_get_count(hist); i < n; ++i)
+	{
+		const char *text;
+		if(get_str(json_array_get_object(hist, i), "text", &text) &&
+				trie_put(set, text) < 0)
+		{
+			trie_free(set);
+			return NULL;
+		}
+	}
+
+	return set;
+}
+
+/* Checks whether history contains an item with specified text.  The set made
+ * by make_hist_set() can be NULL, in which case the history is searched
+ * linearly.  Returns non-zero if so, otherwise zero is returned. */
+static int
+hist_contains(trie_t *set, const JSON_Array *hist, const char text[])
+{
+	if(set != NULL)
+	{
+		void *data;
+		return (trie_get(set, text, &data) == 0);
+	}
+
+	int i, n;
+	for(i = 0, n = json_array_get_count(hist); i < n; ++i)
+	{
+		const char *item_text;
+		if(get_str(json_array_get_object(hist, i), "text", &item_text) &&
+				strcmp(item_text, text) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 /* Merges two states of registers. */
 static void
 merge_regs(JSON_Object *current, const JSON_Object *admixture)
@@ -2942,6 +3653,8 @@ sessions_exists(const char name[])
 int
 sessions_load(const char name[])
 {
+	state_load_deferred();
+
 	char sessions_dir[PATH_MAX + 16];
 	get_session_dir(sessions_dir, sizeof(sessions_dir));
 	char session_file[PATH_MAX + 32];
@@ -2961,18 +3674,22 @@ sessions_load(const char name[])
 
 	char info_file[PATH_MAX + 16];
 	snprintf(info_file, sizeof(info_file), "%s/vifminfo.json", cfg.config_dir);
-	JSON_Value *common = json_parse_file(info_file);
+	char journal[PATH_MAX + 32];
+	get_journal_path(journal, sizeof(journal));
+	const char *valid_journal = journal_applies(journal, info_file) ? journal
+	                                                               : NULL;
+	JSON_Value *common = read_info_file(info_file, valid_journal);
 	restore_locale(locale);
 
 	if(common != NULL)
 	{
 		merge_states(FULL_VINFO, 1, json_object(session), json_object(common));
-		json_value_free(common);
+		remember_stored_state(common, valid_journal);
 
 		(void)filemon_from_file(info_file, FMT_MODIFIED, &vifminfo_mon);
 	}
 
-	load_state(json_object(session), 0);
+	load_state(json_object(session), 0, /*defer=*/0);
 	json_value_free(session);
 
 	set_session(name);
@@ -3010,31 +3727,55 @@ write_session_file(void)
 	snprintf(session_file, sizeof(session_file), "%s/%s.json", sessions_dir,
 			cfg.session);
 
-	store_file(session_file, &session_mon, cfg.session_options);
+	json_value_free(store_file(session_file, &session_mon, cfg.session_options,
+				/*journal=*/NULL));
 }
 
-/* Writes file updating it with state of the current instance if necessary. */
-static void
-store_file(const char path[], filemon_t *mon, int vinfo)
+/* Writes file updating it with state of the current instance if necessary.
+ * Journal of the file is merged into it and removed unless it's NULL.  Returns
+ * written state or NULL on error. */
+static JSON_Value *
+store_file(const char path[], filemon_t *mon, int vinfo, const char journal[])
 {
 	char tmp_file[PATH_MAX + 64];
 	snprintf(tmp_file, sizeof(tmp_file), "%s_%u", path, get_pid());
 
-	if(os_access(path, R_OK) != 0 || copy_file(path, tmp_file) == 0)
+	if(os_access(path, R_OK) == 0 && copy_file(path, tmp_file) != 0)
 	{
-		filemon_t current_mon;
-		int file_changed = filemon_from_file(path, FMT_MODIFIED, &current_mon) != 0
-		                || !filemon_equal(mon, &current_mon);
+		return NULL;
+	}
 
-		update_info_file(tmp_file, vinfo, file_changed);
-		(void)filemon_from_file(tmp_file, FMT_MODIFIED, mon);
+	filemon_t current_mon;
+	int file_changed = filemon_from_file(path, FMT_MODIFIED, &current_mon) != 0
+	                || !filemon_equal(mon, &current_mon);
 
-		if(rename_file(tmp_file, path) != 0)
+	const char *replayed_journal = NULL;
+	if(journal != NULL)
+	{
+		file_changed |= journal_changed(journal);
+		if(journal_applies(journal, path))
 		{
-			LOG_ERROR_MSG("Can't replace \"%s\" file with updated temporary", path);
-			(void)remove(tmp_file);
+			replayed_journal = journal;
 		}
 	}
+
+	JSON_Value *state = update_info_file(tmp_file, vinfo, file_changed,
+			replayed_journal);
+	(void)filemon_from_file(tmp_file, FMT_MODIFIED, mon);
+
+	if(rename_file(tmp_file, path) != 0)
+	{
+		LOG_ERROR_MSG("Can't replace \"%s\" file with updated temporary", path);
+		(void)remove(tmp_file);
+		json_value_free(state);
+		return NULL;
+	}
+
+	if(journal != NULL)
+	{
+		(void)remove(journal);
+	}
+	return state;
 }
 
 int
@@ -30,6 +30,15 @@ typedef void (*sessions_changed)(const char new_session[]);
  * during startup process. */
 void state_load(int reread);
 
+/* Same as state_load(0), but postpones loading of histories and trash, which
+ * aren't needed to draw the first frame, until state_load_deferred() is
+ * called. */
+void state_load_initial(void);
+
+/* Loads parts of the state postponed by state_load_initial().  Does nothing if
+ * there is nothing to load. */
+void state_load_deferred(void);
+
 /* Stores state of the application.  Always writes vifminfo and stores session
  * if any is active. */
 void state_store(void);
@@ -612,6 +612,7 @@ complete_tree(const char str[])
 {
 	static const char *lines[][2] = {
 		{ "depth=", "maximum node nesting level before folding" },
+		{ "lazy",   "list directories only on unfolding" },
 	};
 
 	complete_from_string_list(str, lines, ARRAY_LEN(lines), 0);
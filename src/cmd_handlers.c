@@ -346,6 +346,7 @@ static int yank_cmd(const cmd_info_t *cmd_info);
 static int get_reg_and_count(const cmd_info_t *cmd_info, int *reg);
 static int get_reg(const char arg[], int *reg);
 static int usercmd_cmd(const cmd_info_t* cmd_info);
+static void strip_batch_cmds(strlist_t *batch, size_t prefix_len);
 static int parse_bg_mark(char cmd[]);
 
 const cmd_add_t cmds_list[] = {
@@ -1043,6 +1044,20 @@ emark_cmd(const cmd_info_t *cmd_info)
 
 	MacroFlags flags = (MacroFlags)cmd_info->usr1;
 	char *title = format_str("!%s", cmd_info->raw_args);
+
+	if(ma_flags_present(flags, MF_BATCH))
+	{
+		/* Expand again, this time splitting list of files into parts. */
+		int jobs;
+		strlist_t cmds = ma_expand_batched(cmd_info->raw_args, NULL, MER_SHELL_OP,
+				&jobs);
+		save_msg = rn_ext_batch(curr_view, cmds.items, cmds.nitems, jobs, title,
+				flags, /*pause=*/cmd_info->emark, cmd_info->bg);
+		free_string_array(cmds.items, cmds.nitems);
+		free(title);
+		return save_msg;
+	}
+
 	int handled = rn_ext(curr_view, com, title, flags, /*pause=*/cmd_info->emark,
 			cmd_info->bg, &save_msg);
 	free(title);
@@ -5196,6 +5211,10 @@ parse_tree_properties(const cmd_info_t *cmd_info, int *depth)
 
 			*depth = value - 1;
 		}
+		else if(strcmp(arg, "lazy") == 0)
+		{
+			*depth = 0;
+		}
 		else
 		{
 			ui_sb_errf("Invalid argument: %s", arg);
@@ -5723,6 +5742,20 @@ get_reg(const char arg[], int *reg)
 	return 0;
 }
 
+/* Drops prefix of the specified length and background mark from every command
+ * of a batch. */
+static void
+strip_batch_cmds(strlist_t *batch, size_t prefix_len)
+{
+	int i;
+	for(i = 0; i < batch->nitems; ++i)
+	{
+		char *const cmd = batch->items[i];
+		(void)parse_bg_mark(cmd);
+		memmove(cmd, cmd + prefix_len, strlen(cmd + prefix_len) + 1U);
+	}
+}
+
 /* Special handler for user defined commands, which are defined using
  * :command. */
 static int
@@ -5772,12 +5805,32 @@ usercmd_cmd(const cmd_info_t *cmd_info)
 		ext_cmd = skip_whitespace(ext_cmd);
 	}
 
+	strlist_t batch = {};
+	int jobs = 1;
+	if(expanded_com[0] == '!' && ma_flags_present(flags, MF_BATCH))
+	{
+		/* Expand again, this time splitting list of files into parts. */
+		batch = ma_expand_batched(cmd_info->user_action, cmd_info->args, mer,
+				&jobs);
+		strip_batch_cmds(&batch, ext_cmd - expanded_com);
+	}
+
 	flist_sel_stash(curr_view);
 
 	char *title = format_str(":%s%s%s", cmd_info->user_cmd,
 			(cmd_info->raw_args[0] == '\0' ? "" : " "), cmd_info->raw_args);
-	int handled = rn_ext(curr_view, ext_cmd, title, flags, pause, bg,
-			&save_msg);
+	int handled;
+	if(batch.nitems != 0)
+	{
+		save_msg = rn_ext_batch(curr_view, batch.items, batch.nitems, jobs, title,
+				flags, pause, bg);
+		free_string_array(batch.items, batch.nitems);
+		handled = 1;
+	}
+	else
+	{
+		handled = rn_ext(curr_view, ext_cmd, title, flags, pause, bg, &save_msg);
+	}
 	free(title);
 
 	const int use_term_multiplexer = ma_flags_missing(flags, MF_NO_TERM_MUX);
@@ -36,8 +36,10 @@
 #include "engine/keys.h"
 #include "engine/mode.h"
 #include "lua/vlua.h"
+#include "menus/menus.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/modes.h"
+#include "modes/view.h"
 #include "modes/wk.h"
 #include "ui/fileview.h"
 #include "ui/quickview.h"
@@ -59,10 +61,12 @@
 #include "vcache.h"
 #include "vifm.h"
 
+/* Maximum number of IPC packages processed per iteration of input loop. */
+enum { IPC_BATCH_SIZE = 64 };
+
 static int ensure_term_is_ready(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout,
 		int process_callbacks);
-static int is_previewed(const char path[]);
 static void process_scheduled_updates(void);
 TSTATIC int process_scheduled_updates_of_view(view_t *view);
 static void update_hardware_cursor(void);
@@ -364,6 +368,8 @@ ensure_term_is_ready(void)
  * performing the following tasks while waiting for input:
  *  - checks for new IPC messages;
  *  - checks whether contents of displayed directories changed;
+ *  - continues search in view mode;
+ *  - loads items of menus from commands that are still running;
  *  - redraws UI if requested.
  * Returns KEY_CODE_YES for functional keys (preprocesses *c in this case), OK
  * for wide character and ERR otherwise (e.g. after timeout). */
@@ -392,16 +398,25 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 
 		for(i = 0; i < IPC_F && timeout > 0; ++i)
 		{
-			if(curr_stats.ipc != NULL)
+			/* Process pending messages in batches so that a batch of requests isn't
+			 * spread over several iterations, but a flood of them can't starve input
+			 * handling and redrawing. */
+			int npkgs = 0;
+			while(npkgs < IPC_BATCH_SIZE && curr_stats.ipc != NULL &&
+					ipc_check(curr_stats.ipc))
 			{
-				ipc_check(curr_stats.ipc);
+				++npkgs;
 			}
 
-			if(vcache_check(&is_previewed))
+			if(vcache_check(&qv_is_previewed))
 			{
 				stats_redraw_later();
 			}
 
+			menus_check_for_updates();
+
+			modview_continue_search();
+
 			if(process_callbacks)
 			{
 				bg_check();
@@ -477,20 +492,6 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout, int process_callbacks)
 	return ERR;
 }
 
-/* Checks if preview of specified path is visible.  Returns non-zero if so and
- * zero otherwise. */
-static int
-is_previewed(const char path[])
-{
-	if(curr_stats.preview.on)
-	{
-		dir_entry_t *entry = get_current_entry(curr_view);
-		return fentry_points_to(entry, path);
-	}
-
-	return (fview_previews(curr_view, path) || fview_previews(other_view, path));
-}
-
 /* Updates TUI or its elements if something is scheduled. */
 static void
 process_scheduled_updates(void)
@@ -44,6 +44,7 @@
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "compat/pthread.h"
+#include "compat/reallocarray.h"
 #include "engine/autocmds.h"
 #include "engine/mode.h"
 #include "int/fuse.h"
@@ -99,12 +100,29 @@ typedef enum
 }
 FoldState;
 
+/* Heap-allocated origin of entries.  Origins are reference counted, so that
+ * entries of the same directory can share a single copy of it. */
+typedef struct
+{
+	unsigned int refs; /* Number of entries that use the origin. */
+	char path[];       /* The origin itself. */
+}
+shared_origin_t;
+
+/* Gets shared_origin_t from pointer to its path. */
+#define ORIGIN(str) \
+	((shared_origin_t *)((char *)(str) - offsetof(shared_origin_t, path)))
+
 static void init_flist(view_t *view);
 static void reset_view(view_t *view);
 static void init_view_history(view_t *view);
 static int navigate_to_file_in_custom_view(view_t *view, const char dir[],
 		const char file[]);
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
+static char * origin_get(const char path[], const dir_entry_t *neighbour);
+static char * origin_alloc(const char path[]);
+static char * origin_share(char origin[]);
+static void origin_release(char origin[]);
 static void on_custom_view_leave(view_t *view);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
@@ -114,6 +132,7 @@ static int data_is_dir_entry(const struct dirent *d, const char path[]);
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
 		const WIN32_FIND_DATAW *ffd);
 static int data_is_dir_entry(const WIN32_FIND_DATAW *ffd, const char path[]);
+static int is_broken_link(const char path[]);
 #endif
 static int flist_custom_finish_internal(view_t *view, CVType type, int reload,
 		const char dir[], int allow_empty);
@@ -132,6 +151,13 @@ static void load_dir_list_internal(view_t *view, int reload, int draw_only);
 static int populate_dir_list_internal(view_t *view, int reload);
 static int populate_custom_view(view_t *view, int reload);
 static void re_apply_folds(view_t *view, trie_t *folded_paths);
+static void remove_folded_children(view_t *view);
+static int load_unfolded_dir(view_t *view, dir_entry_t *entry);
+static int remove_folded_dir(view_t *view, dir_entry_t *entry);
+static int can_update_tree_in_place(const view_t *view);
+static int list_tree_dir(view_t *view, const char path[], entries_t *children);
+static int insert_child_entries(view_t *view, int pos, dir_entry_t children[],
+		int nchildren);
 static int entry_exists(view_t *view, const dir_entry_t *entry, void *arg);
 static void zap_compare_view(view_t *view, view_t *other, zap_filter filter,
 		void *arg);
@@ -163,7 +189,16 @@ static int rescue_from_empty_filelist(view_t *view);
 static void add_parent_entry(view_t *view, dir_entry_t **entries, int *count);
 static void init_dir_entry(view_t *view, dir_entry_t *entry, const char name[]);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
-static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
+static int apply_entry_changes(view_t *view);
+static int compact_changed_entries(view_t *view, const char updated[],
+		int nold);
+static int refresh_changed_entry(view_t *view, dir_entry_t *entry);
+static int add_changed_entry(view_t *view, const fswatch_change_t *change);
+static void drop_changed_entry(view_t *view, dir_entry_t *entry);
+static int changed_entry_is_visible(view_t *view, const dir_entry_t *entry);
+static int tree_has_changed(view_t *view);
+static int tree_dirs_have_changed(const dir_entry_t *entries, size_t nchildren);
+static void update_tree_watch(view_t *view);
 static FSWatchState poll_watcher(fswatch_t *watch, const char path[]);
 static void remove_child_entries(view_t *view, dir_entry_t *entry);
 static void find_dir_in_cdpath(const char base_dir[], const char dst[],
@@ -301,6 +336,9 @@ flist_free_view(view_t *view)
 	view->watch = NULL;
 	update_string(&view->watched_dir, NULL);
 
+	fswatch_set_free(view->tree_watch);
+	view->tree_watch = NULL;
+
 	update_string(&view->last_dir, NULL);
 
 	flist_free_cache(&view->left_column);
@@ -759,6 +797,9 @@ on_custom_view_leave(view_t *view)
 		}
 	}
 
+	fswatch_set_free(view->tree_watch);
+	view->tree_watch = NULL;
+
 	trie_free(view->custom.excluded_paths);
 	view->custom.excluded_paths = NULL;
 
@@ -908,7 +949,7 @@ flist_custom_add_separator(view_t *view, int id)
 	if(dir_entry != NULL)
 	{
 		init_dir_entry(view, dir_entry, "");
-		dir_entry->origin = strdup(flist_get_dir(view));
+		dir_entry->origin = origin_alloc(flist_get_dir(view));
 		dir_entry->owns_origin = 1;
 		dir_entry->id = id;
 		++view->custom.entry_count;
@@ -969,10 +1010,19 @@ fill_dir_entry(dir_entry_t *entry, const char path[], const struct dirent *d)
 		entry->dir_link = (symlink_type != SLT_UNKNOWN);
 		entry->slow_target = (symlink_type == SLT_SLOW);
 
-		/* Query mode of symbolic link target. */
-		if(!entry->slow_target && os_stat(entry->name, &s) == 0)
+		/* Query mode of symbolic link target.  Targets on slow file system are
+		 * assumed to exist as actual check might take long time. */
+		entry->broken_link = 0;
+		if(!entry->slow_target)
 		{
-			entry->mode = s.st_mode;
+			if(os_stat(path, &s) == 0)
+			{
+				entry->mode = s.st_mode;
+			}
+			else
+			{
+				entry->broken_link = 1;
+			}
 		}
 	}
 
@@ -1033,6 +1083,7 @@ fill_dir_entry(dir_entry_t *entry, const char path[],
 		const SymLinkType symlink_type = get_symlink_type(path);
 		entry->dir_link = (symlink_type != SLT_UNKNOWN);
 		entry->slow_target = (symlink_type == SLT_SLOW);
+		entry->broken_link = !entry->slow_target && is_broken_link(path);
 
 		entry->type = FT_LINK;
 	}
@@ -1062,6 +1113,25 @@ data_is_dir_entry(const WIN32_FIND_DATAW *ffd, const char path[])
 	return (ffd->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
 }
 
+/* Checks whether symbolic link points to a file that doesn't exist.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_broken_link(const char path[])
+{
+	char dir[PATH_MAX + 1];
+	char target[PATH_MAX + 1];
+
+	copy_str(dir, sizeof(dir), path);
+	remove_last_path_component(dir);
+
+	if(get_link_target_abs(path, (dir[0] == '\0' ? "." : dir), target,
+				sizeof(target)) != 0)
+	{
+		return 1;
+	}
+	return (os_access(target, F_OK) != 0);
+}
+
 #endif
 
 int
@@ -1105,7 +1175,7 @@ flist_custom_finish_internal(view_t *view, CVType type, int reload,
 		{
 			init_dir_entry(view, dir_entry, "..");
 			dir_entry->type = FT_DIR;
-			dir_entry->origin = strdup(dir);
+			dir_entry->origin = origin_alloc(dir);
 			dir_entry->owns_origin = 1;
 			++view->custom.entry_count;
 		}
@@ -1402,7 +1472,8 @@ flist_custom_clone(view_t *to, const view_t *from, int as_tree)
 
 		dst[j] = src[i];
 		dst[j].name = strdup(dst[j].name);
-		dst[j].origin = (dst[j].owns_origin ? strdup(dst[j].origin) : to->curr_dir);
+		dst[j].origin = (dst[j].owns_origin ? origin_share(dst[j].origin)
+		                                    : to->curr_dir);
 
 		if(!dst_is_tree)
 		{
@@ -1917,33 +1988,119 @@ re_apply_folds(view_t *view, trie_t *folded_paths)
 		return;
 	}
 
-	int i;
-	for(i = 0; i < view->list_rows; ++i)
+	int nfolds = 0;
+	int i = 0;
+	while(i < view->list_rows)
 	{
 		dir_entry_t *entry = &view->dir_entry[i];
 		if(entry->type != FT_DIR)
 		{
+			++i;
 			continue;
 		}
 
-		/* Just folded entry or an old one whose visibility hasn't changed. */
+		/* Folded entries are either just folded ones or old ones whose visibility
+		 * hasn't changed, the rest might be previously folded entries that have
+		 * just become visible. */
+		if(!entry->folded)
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+
+			FoldState state = get_fold_state(folded_paths, full_path);
+			entry->folded = (state == FOLD_USER_CLOSED || state == FOLD_AUTO_CLOSED);
+		}
+
+		if(entry->folded && entry->child_count != 0)
+		{
+			/* Nested folds are removed along with this one. */
+			++nfolds;
+			i += entry->child_count + 1;
+		}
+		else
+		{
+			++i;
+		}
+	}
+
+	if(nfolds != 0)
+	{
+		remove_folded_children(view);
+	}
+}
+
+/* Removes children of all folded entries of a tree and updates tree metadata
+ * accordingly.  Compacts the list in a single pass instead of moving its tail
+ * once per fold. */
+static void
+remove_folded_children(view_t *view)
+{
+	dir_entry_t *const entries = view->dir_entry;
+	const int count = view->list_rows;
+
+	flist_custom_save(view);
+
+	/* Number of entries that are kept before each entry, which is also new
+	 * position of the entry if it's kept. */
+	int *const kept_before = reallocarray(NULL, count + 1, sizeof(*kept_before));
+	if(kept_before == NULL)
+	{
+		int i;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			if(view->dir_entry[i].folded)
+			{
+				remove_child_entries(view, &view->dir_entry[i]);
+			}
+		}
+		return;
+	}
+
+	int i = 0;
+	int nkept = 0;
+	while(i < count)
+	{
+		dir_entry_t *const entry = &entries[i];
+		kept_before[i++] = nkept++;
+
 		if(entry->folded)
 		{
-			remove_child_entries(view, entry);
+			int k;
+			for(k = 0; k < entry->child_count; ++k)
+			{
+				fentry_free(&entries[i]);
+				kept_before[i++] = nkept;
+			}
+		}
+	}
+	kept_before[count] = nkept;
+
+	/* Parent of a kept entry is always kept, so links can be recomputed from
+	 * new positions.  Entries only move up, hence nothing is overwritten before
+	 * being processed. */
+	for(i = 0; i < count; ++i)
+	{
+		const int pos = kept_before[i];
+		if(kept_before[i + 1] == pos)
+		{
 			continue;
 		}
 
-		char full_path[PATH_MAX + 1];
-		get_full_path_of(entry, sizeof(full_path), full_path);
+		dir_entry_t *const entry = &entries[i];
+		if(entry->child_pos != 0)
+		{
+			entry->child_pos = pos - kept_before[i - entry->child_pos];
+		}
+		entry->child_count = kept_before[i + entry->child_count + 1] - (pos + 1);
 
-		FoldState state = get_fold_state(folded_paths, full_path);
-		if(state == FOLD_USER_CLOSED || state == FOLD_AUTO_CLOSED)
+		if(pos != i)
 		{
-			/* Previously folded entry that has just become visible. */
-			remove_child_entries(view, entry);
-			entry->folded = 1;
+			entries[pos] = *entry;
 		}
 	}
+
+	view->list_rows = nkept;
+	free(kept_before);
 }
 
 int
@@ -2207,8 +2364,9 @@ zap_entries(view_t *view, dir_entry_t *entries, int *count, zap_filter filter,
 			char *path = format_str("%s/..", full_path);
 			init_parent_entry(view, &entries[j], path);
 			remove_last_path_component(path);
-			entries[j].origin = path;
+			entries[j].origin = origin_alloc(path);
 			entries[j].owns_origin = 1;
+			free(path);
 			entries[j].child_pos = 1;
 
 			/* Since we are now adding back one entry, increase parent counts and
@@ -2673,6 +2831,7 @@ init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 	entry->nlinks = 0;
 	entry->dir_link = 0;
 	entry->slow_target = 0;
+	entry->broken_link = 0;
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
 
@@ -2713,7 +2872,8 @@ replace_dir_entries(view_t *view, dir_entry_t **entries, int *count,
 		dir_entry_t *const entry = &new[i];
 
 		entry->name = strdup(entry->name);
-		entry->origin = strdup(entry->origin);
+		entry->origin = (entry->owns_origin ? origin_share(entry->origin)
+		                                    : origin_alloc(entry->origin));
 		entry->owns_origin = 1;
 
 		if(entry->name == NULL || entry->origin == NULL)
@@ -2751,11 +2911,76 @@ fentry_free(dir_entry_t *entry)
 
 	if(entry->owns_origin)
 	{
-		free(entry->origin);
+		origin_release(entry->origin);
 		entry->origin = NULL;
 	}
 }
 
+void
+fentry_set_origin(dir_entry_t *entry, const char origin[])
+{
+	char *const copy = origin_alloc(origin);
+	if(copy != NULL)
+	{
+		if(entry->owns_origin)
+		{
+			origin_release(entry->origin);
+		}
+		entry->origin = copy;
+		entry->owns_origin = 1;
+	}
+}
+
+/* Retrieves origin for an entry reusing origin of its neighbour in a list if
+ * it's the same.  neighbour can be NULL.  Returns the origin or NULL on
+ * error. */
+static char *
+origin_get(const char path[], const dir_entry_t *neighbour)
+{
+	if(neighbour != NULL && neighbour->owns_origin && neighbour->origin != NULL &&
+			strcmp(neighbour->origin, path) == 0)
+	{
+		return origin_share(neighbour->origin);
+	}
+	return origin_alloc(path);
+}
+
+/* Makes a copy of the path to be used as an origin owned by an entry.  Returns
+ * the copy or NULL on error. */
+static char *
+origin_alloc(const char path[])
+{
+	const size_t len = strlen(path);
+	shared_origin_t *const origin = malloc(sizeof(*origin) + len + 1U);
+	if(origin == NULL)
+	{
+		return NULL;
+	}
+
+	origin->refs = 1U;
+	memcpy(origin->path, path, len + 1U);
+	return origin->path;
+}
+
+/* Makes one more entry own the origin.  Returns the origin. */
+static char *
+origin_share(char origin[])
+{
+	++ORIGIN(origin)->refs;
+	return origin;
+}
+
+/* Drops ownership of an origin freeing it if it's not used anymore.  origin can
+ * be NULL. */
+static void
+origin_release(char origin[])
+{
+	if(origin != NULL && --ORIGIN(origin)->refs == 0U)
+	{
+		free(ORIGIN(origin));
+	}
+}
+
 dir_entry_t *
 add_dir_entry(dir_entry_t **list, size_t *list_size, const dir_entry_t *entry)
 {
@@ -2782,9 +3007,13 @@ entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 
 	init_dir_entry(view, dir_entry, get_last_path_component(path));
 
-	dir_entry->origin = strdup(path);
+	char dir[PATH_MAX + 1];
+	copy_str(dir, sizeof(dir), path);
+	remove_last_path_component(dir);
+
+	/* Files of the same directory usually come one after another. */
+	dir_entry->origin = origin_get(dir, (*list_size == 0) ? NULL : dir_entry - 1);
 	dir_entry->owns_origin = 1;
-	remove_last_path_component(dir_entry->origin);
 
 	if(fill_dir_entry_by_path(dir_entry, path) != 0)
 	{
@@ -2814,7 +3043,7 @@ alloc_dir_entry(dir_entry_t **list, int list_size)
 void
 check_if_filelist_has_changed(view_t *view)
 {
-	int failed, changed;
+	int failed, changed, updated = 0;
 	const char *const curr_dir = flist_get_dir(view);
 
 	if(view->on_slow_fs ||
@@ -2837,6 +3066,7 @@ check_if_filelist_has_changed(view_t *view)
 		FSWatchState state = poll_watcher(view->watch, curr_dir);
 		changed = (state != FSWS_UNCHANGED);
 		failed = (state == FSWS_ERRORED);
+		updated = (state == FSWS_UPDATED);
 	}
 
 	/* Check if we still have permission to visit this directory. */
@@ -2860,12 +3090,18 @@ check_if_filelist_has_changed(view_t *view)
 
 	if(changed)
 	{
-		ui_view_schedule_reload(view);
+		if(updated && apply_entry_changes(view) == 0)
+		{
+			ui_view_schedule_redraw(view);
+		}
+		else
+		{
+			ui_view_schedule_reload(view);
+		}
 	}
 	else if(flist_custom_active(view) && cv_tree(view->custom.type))
 	{
-		if(flist_is_fs_backed(view) &&
-				tree_has_changed(view->dir_entry, view->list_rows))
+		if(flist_is_fs_backed(view) && tree_has_changed(view))
 		{
 			ui_view_schedule_reload(view);
 		}
@@ -2880,10 +3116,288 @@ check_if_filelist_has_changed(view_t *view)
 	}
 }
 
+/* Updates only those entries of the view that were reported as changed by the
+ * watcher instead of rereading whole directory.  Returns zero on success and
+ * non-zero if the list has to be reloaded. */
+static int
+apply_entry_changes(view_t *view)
+{
+	const fswatch_change_t *changes;
+	const int nchanges = fswatch_get_changes(view->watch, &changes);
+	if(nchanges < 0 || flist_custom_active(view) ||
+			view->local_filter.in_progress || curr_stats.load_stage < 2 ||
+			vle_mode_is(VISUAL_MODE))
+	{
+		return 1;
+	}
+
+	/* Marks entries which were updated and might need to change position. */
+	const int nold = view->list_rows;
+	char *const updated = calloc(nold + 1, sizeof(*updated));
+	if(updated == NULL)
+	{
+		return 1;
+	}
+
+	trie_t *const names = trie_create(/*free_func=*/NULL);
+	if(names == NULL)
+	{
+		free(updated);
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(trie_set(names, view->dir_entry[i].name, (void *)(intptr_t)i) < 0)
+		{
+			trie_free(names);
+			free(updated);
+			return 1;
+		}
+	}
+
+	char *const saved_cwd = save_cwd();
+	if(vifm_chdir(view->curr_dir) != 0)
+	{
+		restore_cwd(saved_cwd);
+		trie_free(names);
+		free(updated);
+		return 1;
+	}
+
+	char full_path[PATH_MAX + 1];
+	const int top_delta = view->list_pos - view->top_line;
+	get_current_full_path(view, sizeof(full_path), full_path);
+
+	for(i = 0; i < nchanges; ++i)
+	{
+		void *data;
+		if(trie_get(names, changes[i].name, &data) == 0)
+		{
+			const int pos = (intptr_t)data;
+			updated[pos] |= refresh_changed_entry(view, &view->dir_entry[pos]);
+		}
+		else
+		{
+			(void)add_changed_entry(view, &changes[i]);
+		}
+	}
+
+	trie_free(names);
+	restore_cwd(saved_cwd);
+
+	/* Parent directory entry might be present only because directory was
+	 * empty. */
+	const int show_parent = cfg_parent_dir_is_visible(
+			is_root_dir(view->curr_dir));
+	for(i = 0; i < view->list_rows && !show_parent && view->list_rows > 1; ++i)
+	{
+		if(is_parent_dir(view->dir_entry[i].name))
+		{
+			view->dir_entry[i].temporary = 1;
+		}
+	}
+
+	const int cursor_kept = (view->list_pos < view->list_rows)
+	                     && !view->dir_entry[view->list_pos].temporary;
+	const int nsorted = compact_changed_entries(view, updated, nold);
+	free(updated);
+
+	if(sort_insert_tail(view, nsorted) != 0)
+	{
+		sort_dir_list(0, view);
+	}
+
+	if(cursor_kept)
+	{
+		flist_goto_by_path(view, full_path);
+		view->top_line = view->list_pos - top_delta;
+	}
+	fpos_ensure_valid_pos(view);
+
+	fview_list_updated(view);
+	return 0;
+}
+
+/* Removes entries marked for removal and moves updated entries past the new
+ * ones at the end of the list in a single pass, so that only the tail of the
+ * list needs sorting.  Returns number of leading entries that stay sorted. */
+static int
+compact_changed_entries(view_t *view, const char updated[], int nold)
+{
+	dir_entry_t *const entries = view->dir_entry;
+
+	int i;
+	int nupdated = 0;
+	for(i = 0; i < nold; ++i)
+	{
+		nupdated += (updated[i] && !entries[i].temporary);
+	}
+
+	/* On failure to allocate updated entries are left in place and the whole
+	 * list is reported as unsorted. */
+	dir_entry_t *const moved = (nupdated == 0)
+	                         ? NULL
+	                         : reallocarray(NULL, nupdated, sizeof(*moved));
+
+	int j = 0;
+	int nmoved = 0;
+	for(i = 0; i < nold; ++i)
+	{
+		dir_entry_t *const entry = &entries[i];
+
+		if(entry->temporary)
+		{
+			if(entry->selected)
+			{
+				--view->selected_files;
+			}
+			if(view->list_pos == i)
+			{
+				view->list_pos = j;
+			}
+			fentry_free(entry);
+			continue;
+		}
+
+		if(updated[i] && moved != NULL)
+		{
+			moved[nmoved++] = *entry;
+			continue;
+		}
+
+		if(i != j)
+		{
+			entries[j] = *entry;
+		}
+		++j;
+	}
+
+	const int nsorted = (nupdated == 0 || moved != NULL) ? j : 0;
+
+	const int nadded = view->list_rows - nold;
+	memmove(&entries[j], &entries[nold], sizeof(*entries)*nadded);
+	j += nadded;
+
+	if(nmoved != 0)
+	{
+		memcpy(&entries[j], moved, sizeof(*entries)*nmoved);
+		j += nmoved;
+	}
+	free(moved);
+
+	view->list_rows = j;
+	return nsorted;
+}
+
+/* Updates information about an entry of the view that has changed on disk.
+ * Entry is marked for removal if it doesn't exist or isn't visible anymore.
+ * Returns non-zero if the entry was updated and might need to be moved. */
+static int
+refresh_changed_entry(view_t *view, dir_entry_t *entry)
+{
+	const FileType type = entry->type;
+	if(fill_dir_entry_by_path(entry, entry->name) != 0)
+	{
+		drop_changed_entry(view, entry);
+		return 0;
+	}
+
+	if(entry->type != type)
+	{
+		/* Type affects both highlighting and decorations. */
+		entry->hi_num = -1;
+		entry->name_dec_num = -1;
+	}
+
+	if(!changed_entry_is_visible(view, entry))
+	{
+		drop_changed_entry(view, entry);
+		++view->filtered;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* Adds entry for a changed file that isn't in the list of the view.  Returns
+ * non-zero if an entry was added. */
+static int
+add_changed_entry(view_t *view, const fswatch_change_t *change)
+{
+	const int kind = change->changes & (FSWC_CREATED | FSWC_DELETED);
+
+	dir_entry_t *const entry = alloc_dir_entry(&view->dir_entry,
+			view->list_rows);
+	if(entry == NULL)
+	{
+		return 0;
+	}
+
+	init_dir_entry(view, entry, change->name);
+	if(entry->name == NULL || fill_dir_entry_by_path(entry, entry->name) != 0)
+	{
+		/* The file was in the directory before, but filtered out. */
+		if(kind == FSWC_DELETED && view->filtered > 0)
+		{
+			--view->filtered;
+		}
+		fentry_free(entry);
+		return 0;
+	}
+
+	if(!changed_entry_is_visible(view, entry))
+	{
+		if(kind == FSWC_CREATED)
+		{
+			++view->filtered;
+		}
+		fentry_free(entry);
+		return 0;
+	}
+
+	++view->list_rows;
+	return 1;
+}
+
+/* Marks entry for removal from the list keeping counters in sync. */
+static void
+drop_changed_entry(view_t *view, dir_entry_t *entry)
+{
+	entry->temporary = 1;
+	if(entry->search_match)
+	{
+		entry->search_match = 0;
+		--view->matches;
+	}
+}
+
+/* Checks whether entry of a directory view passes all filters.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+changed_entry_is_visible(view_t *view, const dir_entry_t *entry)
+{
+	return tree_candidate_is_visible(view, flist_get_dir(view), entry->name,
+			fentry_is_dir(entry), 1);
+}
+
 /* Checks whether tree-view needs a reload (any of subdirectories were changed).
  * Returns non-zero if so, otherwise zero is returned. */
 static int
-tree_has_changed(const dir_entry_t *entries, size_t nchildren)
+tree_has_changed(view_t *view)
+{
+	if(view->tree_watch != NULL)
+	{
+		return (fswatch_set_poll(view->tree_watch) != FSWS_UNCHANGED);
+	}
+	return tree_dirs_have_changed(view->dir_entry, view->list_rows);
+}
+
+/* Polls modification time of every directory in the tree.  Returns non-zero if
+ * any of them has changed, otherwise zero is returned. */
+static int
+tree_dirs_have_changed(const dir_entry_t *entries, size_t nchildren)
 {
 	size_t pos = 0U;
 	while(pos < nchildren)
@@ -2900,7 +3414,7 @@ tree_has_changed(const dir_entry_t *entries, size_t nchildren)
 				return 1;
 			}
 
-			if(tree_has_changed(entry + 1, entry->child_count))
+			if(tree_dirs_have_changed(entry + 1, entry->child_count))
 			{
 				return 1;
 			}
@@ -3030,12 +3544,184 @@ flist_toggle_fold(view_t *view)
 	if(set_fold_state(view->custom.folded_paths, full_path, state))
 	{
 		curr->folded = !curr->folded;
-		/* We reload even on folding to update number of filtered entries
-		 * properly. */
-		ui_view_schedule_reload(view);
+		const int error = curr->folded ? remove_folded_dir(view, curr)
+		                               : load_unfolded_dir(view, curr);
+		if(error)
+		{
+			ui_view_schedule_reload(view);
+		}
+		else
+		{
+			ui_view_schedule_redraw(view);
+		}
 	}
 }
 
+/* Lists just unfolded directory of a file-system tree and inserts its subtree
+ * into the list without rebuilding the rest of the tree.  Returns zero on
+ * success and non-zero if the tree should be reloaded instead. */
+static int
+load_unfolded_dir(view_t *view, dir_entry_t *entry)
+{
+	const int show_empty_dir_leafs = (cfg.dot_dirs & DD_TREE_LEAFS_PARENT);
+	if(!can_update_tree_in_place(view) || entry->child_count != 0)
+	{
+		return 1;
+	}
+
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+	const int pos = entry - view->dir_entry;
+
+	entries_t children;
+	const int nfiltered = list_tree_dir(view, full_path, &children);
+
+	if(ui_cancellation_requested())
+	{
+		free_dir_entries(&children.entries, &children.nentries);
+		/* Leave the directory folded as it was. */
+		entry->folded = 1;
+		(void)set_fold_state(view->custom.folded_paths, full_path,
+				FOLD_USER_CLOSED);
+		return 0;
+	}
+
+	/* Leaf of an empty directory is added only along with the rest of the
+	 * tree. */
+	if(nfiltered < 0 || (children.nentries == 0 && show_empty_dir_leafs) ||
+			sort_subtree(view, children) != 0 ||
+			insert_child_entries(view, pos, children.entries,
+				children.nentries) != 0)
+	{
+		free_dir_entries(&children.entries, &children.nentries);
+		return 1;
+	}
+	dynarray_free(children.entries);
+
+	view->filtered += nfiltered;
+	fview_list_updated(view);
+	update_tree_watch(view);
+	return 0;
+}
+
+/* Removes subtree of just folded directory of a file-system tree without
+ * rebuilding the rest of the tree.  Returns zero on success and non-zero if the
+ * tree should be reloaded instead. */
+static int
+remove_folded_dir(view_t *view, dir_entry_t *entry)
+{
+	/* Sorting and filtering with local filter take whole tree into account. */
+	if(!can_update_tree_in_place(view) || view->local_filter.in_progress ||
+			!filter_is_empty(&view->local_filter.filter))
+	{
+		return 1;
+	}
+
+	char full_path[PATH_MAX + 1];
+	get_full_path_of(entry, sizeof(full_path), full_path);
+
+	/* Number of filtered out files isn't tracked per directory, so the folded
+	 * subtree is listed once more to find out how many of them stop being
+	 * counted. */
+	entries_t children;
+	const int nfiltered = list_tree_dir(view, full_path, &children);
+	free_dir_entries(&children.entries, &children.nentries);
+	if(nfiltered < 0 || ui_cancellation_requested())
+	{
+		return 1;
+	}
+
+	remove_child_entries(view, entry);
+
+	view->filtered = MAX(view->filtered - nfiltered, 0);
+	fview_list_updated(view);
+	update_tree_watch(view);
+	return 0;
+}
+
+/* Checks whether subtrees of a tree can be added or removed without rebuilding
+ * the tree.  Returns non-zero if so, otherwise zero is returned. */
+static int
+can_update_tree_in_place(const view_t *view)
+{
+	return view->custom.type == CV_TREE
+	    && flist_is_fs_backed(view)
+	    && view->custom.entry_count == 0;
+}
+
+/* Lists directory of a file-system tree recursively skipping folded
+ * subdirectories.  *children is set to entries of the subtree, which aren't
+ * sorted and whose top-level entries have zero child_pos.  Returns number of
+ * filtered out files or negative number on error. */
+static int
+list_tree_dir(view_t *view, const char path[], entries_t *children)
+{
+	show_progress("Building tree...", 0);
+
+	/* Entries of the tree are unique by construction, so the cache needs to
+	 * cover only the new ones. */
+	assert(view->custom.paths_cache == NULL && "Custom view wasn't finished.");
+	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
+
+	ui_cancellation_push_on();
+	const int nfiltered = add_files_recursively(view, path,
+			view->custom.excluded_paths, view->custom.folded_paths, -1, 0, INT_MAX);
+	ui_cancellation_pop();
+
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = NULL;
+
+	ui_sb_quick_msg_clear();
+
+	children->entries = view->custom.entries;
+	children->nentries = view->custom.entry_count;
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
+
+	return nfiltered;
+}
+
+/* Inserts subtrees of a directory at specified position of the tree right after
+ * it.  Top-level entries of children array should have zero child_pos.  On
+ * success the view owns the entries.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+insert_child_entries(view_t *view, int pos, dir_entry_t children[],
+		int nchildren)
+{
+	if(nchildren == 0)
+	{
+		return 0;
+	}
+
+	dir_entry_t *const entries = dynarray_extend(view->dir_entry,
+			nchildren*sizeof(*entries));
+	if(entries == NULL)
+	{
+		return 1;
+	}
+	view->dir_entry = entries;
+
+	dir_entry_t *const entry = &entries[pos];
+
+	/* Update links of the tree while it still has old layout. */
+	fix_tree_links(entries, entry, pos, pos, 0, nchildren);
+	entry->child_count = nchildren;
+
+	memmove(entry + 1 + nchildren, entry + 1,
+			sizeof(*entry)*(view->list_rows - (pos + 1)));
+	memcpy(entry + 1, children, sizeof(*entry)*nchildren);
+	view->list_rows += nchildren;
+
+	int i;
+	for(i = 0; i < nchildren; i += children[i].child_count + 1)
+	{
+		entry[1 + i].child_pos = 1 + i;
+	}
+
+	return 0;
+}
+
 /* Folds a single entry by removing all of its children and updating tree
  * metadata accordingly. */
 static void
@@ -3863,10 +4549,11 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 				chosp(new_origin);
 				if(e->owns_origin)
 				{
-					free(e->origin);
+					origin_release(e->origin);
 				}
-				e->origin = new_origin;
+				e->origin = origin_get(new_origin, (i == 0) ? NULL : e - 1);
 				e->owns_origin = 1;
+				free(new_origin);
 
 				/* Clone visible child folds. */
 				e->folded = 0;
@@ -4016,6 +4703,13 @@ flist_load_tree_internal(view_t *view, const char path[], int reload, int depth)
 	trie_t *excluded_paths = reload ? view->custom.excluded_paths : NULL;
 	trie_t *folded_paths = reload ? view->custom.folded_paths
 	                              : trie_create(/*free_func=*/NULL);
+
+	if(!reload && depth == 0)
+	{
+		/* Make directories that appear on reloads folded as well to keep listing
+		 * only what was unfolded. */
+		(void)set_fold_state(folded_paths, path, FOLD_AUTO_OPENED);
+	}
 	if(make_tree(view, path, reload, excluded_paths, folded_paths, depth) != 0)
 	{
 		if(!reload)
@@ -4050,6 +4744,13 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	const int from_custom = flist_custom_active(view)
 	                     && ONE_OF(view->custom.type, CV_REGULAR, CV_VERY);
 
+	if(view->tree_watch != NULL)
+	{
+		/* Drain all events that happened before this point, whole tree is about to
+		 * be reread. */
+		(void)fswatch_set_poll(view->tree_watch);
+	}
+
 	flist_custom_start(view, from_custom ? view->custom.title : "");
 
 	show_progress("Building tree...", 0);
@@ -4093,9 +4794,57 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 
 	replace_string(&view->custom.orig_dir, canonic_path);
 
+	update_tree_watch(view);
 	return 0;
 }
 
+/* Makes tree watch of the view cover all directories of the tree or frees it
+ * if the tree doesn't need one or there are too many directories. */
+static void
+update_tree_watch(view_t *view)
+{
+	if(view->custom.type != CV_TREE || !flist_is_fs_backed(view))
+	{
+		fswatch_set_free(view->tree_watch);
+		view->tree_watch = NULL;
+		return;
+	}
+
+	if(view->tree_watch == NULL)
+	{
+		view->tree_watch = fswatch_set_create();
+		if(view->tree_watch == NULL)
+		{
+			return;
+		}
+	}
+
+	strlist_t dirs = {};
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[i];
+		if(entry->type == FT_DIR && !is_parent_dir(entry->name))
+		{
+			char full_path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(full_path), full_path);
+			dirs.nitems = add_to_string_array(&dirs.items, dirs.nitems, full_path);
+		}
+	}
+
+	/* Not checking whether newly watched directories have changed after they
+	 * were read, because doing that means visiting all of them, which is what
+	 * the watches are used to avoid. */
+	if(fswatch_set_update(view->tree_watch, dirs.items, dirs.nitems) != 0)
+	{
+		/* Probably limit on number of watches was hit, resort to polling. */
+		fswatch_set_free(view->tree_watch);
+		view->tree_watch = NULL;
+	}
+
+	free_string_array(dirs.items, dirs.nitems);
+}
+
 /* Turns custom list into custom tree. */
 static void
 tree_from_cv(view_t *view)
@@ -4183,12 +4932,12 @@ complete_tree(const char name[], int valid, const void *parent_data, void *data,
 				 * as a storage of path prefix and is removed afterwards in
 				 * drop_tops(). */
 				init_dir_entry(view, dir_entry, "");
-				dir_entry->origin = strdup(name);
+				dir_entry->origin = origin_alloc(name);
 			}
 			else
 			{
 				init_dir_entry(view, dir_entry, name);
-				dir_entry->origin = strdup("/");
+				dir_entry->origin = origin_alloc("/");
 			}
 			free(typed_path);
 			dir_entry->owns_origin = 1;
@@ -4200,7 +4949,8 @@ complete_tree(const char name[], int valid, const void *parent_data, void *data,
 			init_dir_entry(view, dir_entry, name);
 			get_full_path_of(&(*entries)[*parent_idx], sizeof(parent_path),
 					parent_path);
-			dir_entry->origin = strdup(parent_path);
+			dir_entry->origin = origin_get(parent_path,
+					(dir_entry == *entries) ? NULL : dir_entry - 1);
 			dir_entry->owns_origin = 1;
 		}
 
@@ -4485,8 +5235,9 @@ add_directory_leaf(view_t *view, const char path[], int parent_pos)
 	}
 
 	remove_last_path_component(full_path);
-	entry->origin = full_path;
+	entry->origin = origin_alloc(full_path);
 	entry->owns_origin = 1;
+	free(full_path);
 
 	if(parent_pos >= 0)
 	{
@@ -281,6 +281,9 @@ dir_entry_t * entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 void free_dir_entries(dir_entry_t **entries, int *count);
 /* Frees single directory entry. */
 void fentry_free(dir_entry_t *entry);
+/* Makes entry own a copy of the origin replacing its current origin.  Origin
+ * is left unchanged on error. */
+void fentry_set_origin(dir_entry_t *entry, const char origin[]);
 /* Adds parent directory entry (..) to filelist. */
 void add_parent_dir(view_t *view);
 /* Changes name of a file entry, performing additional required updates. */
@@ -268,7 +268,7 @@ fops_replace_entry(ops_t *ops, view_t *src, const dir_entry_t *src_entry,
 		{
 			/* Update the destination entry to not be fake. */
 			replace_string(&dst_entry->name, src_entry->name);
-			replace_string(&dst_entry->origin, dst_dir);
+			fentry_set_origin(dst_entry, dst_dir);
 		}
 	}
 
@@ -454,22 +454,22 @@ fops_yank(view_t *view, int reg)
 {
 	int nyanked_files;
 	dir_entry_t *entry;
+	strlist_t files = {};
 
 	reg = prepare_register(reg);
 
-	nyanked_files = 0;
 	entry = NULL;
 	while(iter_marked_entries(view, &entry))
 	{
 		char full_path[PATH_MAX + 1];
 		get_full_path_of(entry, sizeof(full_path), full_path);
-
-		if(regs_append(reg, full_path) == 0)
-		{
-			++nyanked_files;
-		}
+		files.nitems = add_to_string_array(&files.items, files.nitems, full_path);
 	}
 
+	/* Adding files all at once is much faster for large number of files. */
+	nyanked_files = regs_append_files(reg, files.items, files.nitems);
+	free_string_array(files.items, files.nitems);
+
 	regs_update_unnamed(reg);
 
 	ui_sb_msgf("%d file%s yanked", nyanked_files,
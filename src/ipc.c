@@ -29,6 +29,9 @@
 #ifndef WIN32_PIPE_READ
 # include <sys/types.h>
 # include <sys/select.h> /* FD_* select() */
+# include <sys/socket.h> /* AF_UNIX SOCK_STREAM accept() bind() connect()
+                            listen() recv() send() socket() */
+# include <sys/un.h> /* sockaddr_un */
 #else
 # define O_NONBLOCK 0
 # include <windows.h>
@@ -40,24 +43,27 @@
 # endif
 #endif
 
-#include <sys/stat.h> /* mkfifo() stat() */
+#include <sys/stat.h> /* mkfifo() stat() umask() */
 #include <dirent.h> /* DIR closedir() opendir() readdir() */
 #include <fcntl.h>
 #include <unistd.h> /* close() open() select() unlink() usleep() */
 
 #include <errno.h> /* EACCES EEXIST EDQUOT ENOSPC ENXIO errno */
 #include <stddef.h> /* NULL size_t ssize_t */
+#include <stdint.h> /* uint32_t */
 #include <stdio.h> /* FILE fclose() fdopen() fread() fwrite() */
-#include <stdlib.h> /* free() malloc() snprintf() */
-#include <string.h> /* strcmp() strcpy() strlen() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() snprintf() */
+#include <string.h> /* memcpy() memmove() strcmp() strcpy() strlen() */
 
 #include "compat/fs_limits.h"
 #include "compat/os.h"
 #include "engine/text_buffer.h"
+#include "utils/darray.h"
 #include "utils/fs.h"
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/path.h"
+#include "utils/selector.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/utils.h"
@@ -94,10 +100,46 @@
  *
  * On version mismatch or unknown field name, packet is discarded which is
  * logged.
+ *
+ * Packages are delivered via a named pipe, which is also what makes instances
+ * discoverable.  Where Unix domain sockets are available, each instance also
+ * listens on a socket next to its pipe and clients try it first.  Connections
+ * to the socket are persistent and carry frames of the following form:
+ *
+ *     uint32_t size; -- size of the package
+ *     uint32_t id;   -- identifier of a request
+ *     package        -- package in the format described above
+ *
+ * Client is free to send several requests without waiting for replies.  Reply
+ * to a request (only "eval" has one) is a frame with the same id.
  */
 
 /* Prefix for names of all pipes to distinguish them from other pipes. */
 #define PREFIX "vifm-ipc-"
+/* Prefix for names of sockets, which is different from PREFIX to keep them out
+ * of the list of servers. */
+#define SOCK_PREFIX "vifm-sock-"
+
+#ifndef WIN32_PIPE_READ
+/* Don't raise SIGPIPE on writing to a socket that was closed by the other
+ * side. */
+# ifdef MSG_NOSIGNAL
+#  define SEND_FLAGS MSG_NOSIGNAL
+# else
+#  define SEND_FLAGS 0
+# endif
+#endif
+
+/* How long to wait for socket to become ready for I/O. */
+enum { IO_TIMEOUT_MS = 1000 };
+
+/* Largest package that can be received over a socket.  Connection that
+ * announces a bigger one is closed. */
+enum { MAX_FRAME_SIZE = 4*1024*1024 };
+
+/* Largest amount of replies that can wait for a client to read them.
+ * Connection of a client that doesn't read replies is closed. */
+enum { MAX_PENDING_OUTPUT = 16*MAX_FRAME_SIZE };
 
 #ifndef WIN32_PIPE_READ
 typedef FILE *read_pipe_t;
@@ -117,6 +159,25 @@ typedef struct
 }
 list_data_t;
 
+/* Connection accepted on the socket of an instance. */
+typedef struct
+{
+	int fd;         /* Socket of the connection or -1 after end of input. */
+	char *buf;      /* Received data that wasn't processed yet. */
+	size_t len;     /* Number of bytes in the buffer. */
+	char *out;      /* Replies that weren't sent yet. */
+	size_t out_len; /* Number of bytes in the output buffer. */
+}
+ipc_conn_t;
+
+/* Destination of a reply to a package received over a socket. */
+typedef struct
+{
+	ipc_conn_t *conn; /* Connection to send the reply over. */
+	uint32_t id;      /* Identifier of the request. */
+}
+reply_to_t;
+
 /* Storage of data of an instance. */
 struct ipc_t
 {
@@ -132,17 +193,42 @@ struct ipc_t
 	read_pipe_t pipe_file;
 	/* Holds result of expression evaluation or NULL on evaluation error. */
 	char *eval_result;
+
+	/* Listening socket or -1 if only the pipe is used. */
+	int sock_fd;
+	/* Path to the socket. */
+	char sock_path[PATH_MAX + 1];
+	/* Connections accepted on the socket. */
+	ipc_conn_t *conns;
+	/* Declarations to enable use of DA_* on conns. */
+	DA_INSTANCE_FIELD(conns);
+	/* Watches the socket and connections to it for incoming data. */
+	selector_t *selector;
+
+	/* Persistent connection to socket of another instance or -1. */
+	int peer_fd;
+	/* Name of the instance peer_fd is connected to or NULL. */
+	char *peer_name;
+	/* Identifier of the next request sent over peer_fd. */
+	uint32_t next_id;
 };
 
 static read_pipe_t create_pipe(const char name[], char path_buf[], size_t len);
 static char * receive_pkg(ipc_t *ipc, int *len);
 static read_pipe_t try_use_pipe(const char path[], int *fatal);
-static void handle_pkg(ipc_t *ipc, const char pkg[], const char *end);
+static void handle_pkg(ipc_t *ipc, const char pkg[], const char *end,
+		const reply_to_t *reply_to);
 static void handle_args(ipc_t *ipc, char ***array, int len);
-static void handle_expr(ipc_t *ipc, const char from[], char *array[], int len);
+static void handle_expr(ipc_t *ipc, const char from[], char *array[], int len,
+		const reply_to_t *reply_to);
 static void handle_eval_result(ipc_t *ipc, char *array[], int len);
+static int reply(ipc_t *ipc, const char whom[], const reply_to_t *reply_to,
+		char *data[], const char type[]);
 static int format_and_send(ipc_t *ipc, const char whom[], char *data[],
 		const char type[]);
+static char * eval_over_pipe(ipc_t *ipc, const char whom[], const char expr[]);
+static vle_textbuf * format_pkg(ipc_t *ipc, char *data[], const char type[]);
+static char * resolve_target(const ipc_t *ipc, const char whom[]);
 static int send_pkg(ipc_t *ipc, const char whom[], const char what[],
 		size_t len);
 static char * get_the_only_target(const ipc_t *ipc);
@@ -151,6 +237,30 @@ static int add_to_list(const char name[], const void *data, void *param);
 static const char * get_ipc_dir(void);
 #ifndef WIN32_PIPE_READ
 static int pipe_is_in_use(const char path[]);
+static void open_socket(ipc_t *ipc);
+static void close_socket(ipc_t *ipc);
+static int check_socket(ipc_t *ipc);
+static void accept_conns(ipc_t *ipc);
+static void read_conn(ipc_conn_t *conn);
+static char * take_frame(ipc_conn_t *conn, uint32_t *id, size_t *len);
+static int queue_frame(ipc_conn_t *conn, uint32_t id, const char data[],
+		size_t len);
+static void flush_conn(ipc_conn_t *conn);
+static void close_conn(ipc_conn_t *conn);
+static void drop_closed_conns(ipc_t *ipc);
+static void update_selector(ipc_t *ipc);
+static int connect_to_peer(ipc_t *ipc, const char whom[]);
+static void disconnect_peer(ipc_t *ipc);
+static int send_over_socket(ipc_t *ipc, const char whom[], const char what[],
+		size_t len);
+static int eval_over_socket(ipc_t *ipc, const char whom[], char *exprs[],
+		int n, char *results[]);
+static int send_frame(int fd, uint32_t id, const char data[], size_t len);
+static char * recv_frame(int fd, uint32_t *id, size_t *len);
+static int write_all(int fd, const char data[], size_t len);
+static int read_all(int fd, char buf[], size_t len);
+static int wait_for_socket(int fd, int for_write);
+static int setup_socket(int fd, int nonblocking);
 #endif
 
 /* Current version string. */
@@ -173,7 +283,7 @@ ipc_enabled(void)
 ipc_t *
 ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
 {
-	ipc_t *const ipc = malloc(sizeof(*ipc));
+	ipc_t *const ipc = calloc(1, sizeof(*ipc));
 	if(ipc == NULL)
 	{
 		return NULL;
@@ -182,6 +292,8 @@ ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
 	ipc->args_cb = args_cb;
 	ipc->eval_cb = eval_cb;
 	ipc->locked = 0;
+	ipc->sock_fd = -1;
+	ipc->peer_fd = -1;
 
 	if(name == NULL)
 	{
@@ -195,6 +307,11 @@ ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
 		return NULL;
 	}
 
+#ifndef WIN32_PIPE_READ
+	/* Socket is optional, the pipe is enough to communicate. */
+	open_socket(ipc);
+#endif
+
 	return ipc;
 }
 
@@ -207,6 +324,8 @@ ipc_free(ipc_t *ipc)
 	}
 
 #ifndef WIN32_PIPE_READ
+	close_socket(ipc);
+	disconnect_peer(ipc);
 	fclose(ipc->pipe_file);
 	unlink(ipc->pipe_path);
 #else
@@ -232,10 +351,17 @@ ipc_check(ipc_t *ipc)
 		return 0;
 	}
 
+#ifndef WIN32_PIPE_READ
+	if(check_socket(ipc))
+	{
+		return 1;
+	}
+#endif
+
 	pkg = receive_pkg(ipc, &len);
 	if(pkg != NULL)
 	{
-		handle_pkg(ipc, pkg, pkg + len);
+		handle_pkg(ipc, pkg, pkg + len, /*reply_to=*/NULL);
 		free(pkg);
 		return 1;
 	}
@@ -450,9 +576,11 @@ try_use_pipe(const char path[], int *fatal)
 #endif
 }
 
-/* Parses pkg into array of strings and invokes callback. */
+/* Parses pkg into array of strings and invokes callback.  reply_to is NULL
+ * for packages received via the pipe. */
 static void
-handle_pkg(ipc_t *ipc, const char pkg[], const char *end)
+handle_pkg(ipc_t *ipc, const char pkg[], const char *end,
+		const reply_to_t *reply_to)
 {
 	char **array = NULL;
 	size_t len = 0U;
@@ -507,7 +635,7 @@ handle_pkg(ipc_t *ipc, const char pkg[], const char *end)
 	}
 	else if(strcmp(type, EVAL_TYPE) == 0)
 	{
-		handle_expr(ipc, from, array, len);
+		handle_expr(ipc, from, array, len, reply_to);
 	}
 	else if(strcmp(type, EVAL_RESULT_TYPE) == 0)
 	{
@@ -544,7 +672,8 @@ handle_args(ipc_t *ipc, char ***array, int len)
 
 /* Handles received message with expression to evaluate. */
 static void
-handle_expr(ipc_t *ipc, const char from[], char *array[], int len)
+handle_expr(ipc_t *ipc, const char from[], char *array[], int len,
+		const reply_to_t *reply_to)
 {
 	char *result;
 
@@ -560,7 +689,7 @@ handle_expr(ipc_t *ipc, const char from[], char *array[], int len)
 	if(result == NULL)
 	{
 		char *data[] = { NULL };
-		if(format_and_send(ipc, from, data, EVAL_ERROR_TYPE) != 0)
+		if(reply(ipc, from, reply_to, data, EVAL_ERROR_TYPE) != 0)
 		{
 			LOG_ERROR_MSG("Failed to report evaluation failure");
 		}
@@ -568,7 +697,7 @@ handle_expr(ipc_t *ipc, const char from[], char *array[], int len)
 	else
 	{
 		char *data[] = { result, NULL };
-		if(format_and_send(ipc, from, data, EVAL_RESULT_TYPE) != 0)
+		if(reply(ipc, from, reply_to, data, EVAL_RESULT_TYPE) != 0)
 		{
 			LOG_ERROR_MSG("Failed to report evaluation result");
 		}
@@ -587,6 +716,34 @@ handle_eval_result(ipc_t *ipc, char *array[], int len)
 	}
 }
 
+/* Sends reply either over the socket or via the pipe when reply_to is NULL.
+ * The data array should be NULL terminated.  Returns zero on success and
+ * non-zero otherwise. */
+static int
+reply(ipc_t *ipc, const char whom[], const reply_to_t *reply_to, char *data[],
+		const char type[])
+{
+	if(reply_to == NULL)
+	{
+		return format_and_send(ipc, whom, data, type);
+	}
+
+#ifndef WIN32_PIPE_READ
+	vle_textbuf *pkg = format_pkg(ipc, data, type);
+	if(pkg == NULL)
+	{
+		return 1;
+	}
+
+	int ret = queue_frame(reply_to->conn, reply_to->id, vle_tb_get_data(pkg),
+			vle_tb_get_len(pkg));
+	vle_tb_free(pkg);
+	return ret;
+#else
+	return 1;
+#endif
+}
+
 int
 ipc_send(ipc_t *ipc, const char whom[], char *data[])
 {
@@ -595,6 +752,55 @@ ipc_send(ipc_t *ipc, const char whom[], char *data[])
 
 char *
 ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
+{
+	char *exprs[] = { (char *)expr };
+	char *result;
+	(void)ipc_eval_batch(ipc, whom, exprs, 1, &result);
+	return result;
+}
+
+int
+ipc_eval_batch(ipc_t *ipc, const char whom[], char *exprs[], int n,
+		char *results[])
+{
+	int i;
+	for(i = 0; i < n; ++i)
+	{
+		results[i] = NULL;
+	}
+
+	char *name = resolve_target(ipc, whom);
+	if(name == NULL)
+	{
+		return 1;
+	}
+
+#ifndef WIN32_PIPE_READ
+	if(eval_over_socket(ipc, name, exprs, n, results) != 0)
+#endif
+	{
+		for(i = 0; i < n; ++i)
+		{
+			results[i] = eval_over_pipe(ipc, name, exprs[i]);
+		}
+	}
+
+	free(name);
+
+	for(i = 0; i < n; ++i)
+	{
+		if(results[i] == NULL)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Evaluates expression in another instance using pipes.  Returns result
+ * converted to a string or NULL on error. */
+static char *
+eval_over_pipe(ipc_t *ipc, const char whom[], const char expr[])
 {
 	enum { MAX_USEC = 1000000, MAX_REPEATS = 20 };
 	int repeats;
@@ -626,11 +832,36 @@ ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
  * terminated.  Returns zero on successful send and non-zero otherwise. */
 static int
 format_and_send(ipc_t *ipc, const char whom[], char *data[], const char type[])
+{
+	vle_textbuf *pkg = format_pkg(ipc, data, type);
+	if(pkg == NULL)
+	{
+		return 1;
+	}
+
+	char *name = resolve_target(ipc, whom);
+	if(name == NULL)
+	{
+		vle_tb_free(pkg);
+		return 1;
+	}
+
+	int ret = send_pkg(ipc, name, vle_tb_get_data(pkg), vle_tb_get_len(pkg));
+	vle_tb_free(pkg);
+
+	free(name);
+	return ret;
+}
+
+/* Formats a package of specified type.  The data array should be NULL
+ * terminated.  Returns the package or NULL on error. */
+static vle_textbuf *
+format_pkg(ipc_t *ipc, char *data[], const char type[])
 {
 	vle_textbuf *pkg = vle_tb_create();
 	if(pkg == NULL)
 	{
-		return -1;
+		return NULL;
 	}
 
 	/* Compose "header". */
@@ -645,7 +876,7 @@ format_and_send(ipc_t *ipc, const char whom[], char *data[], const char type[])
 		{
 			vle_tb_free(pkg);
 			LOG_ERROR_MSG("Can't get working directory");
-			return 1;
+			return NULL;
 		}
 		vle_tb_appendf(pkg, "%s%c", cwd, '\0');
 	}
@@ -655,23 +886,27 @@ format_and_send(ipc_t *ipc, const char whom[], char *data[], const char type[])
 		vle_tb_appendf(pkg, "%s%c", *data++, '\0');
 	}
 
-	char *name = NULL;
+	return pkg;
+}
+
+/* Determines name of the instance to communicate with.  If whom is NULL, target
+ * instance is automatically determined.  Returns newly allocated string or NULL
+ * on error. */
+static char *
+resolve_target(const ipc_t *ipc, const char whom[])
+{
 	if(whom == NULL)
 	{
-		name = get_the_only_target(ipc);
-		if(name == NULL)
-		{
-			vle_tb_free(pkg);
-			return 1;
-		}
-		whom = name;
+		return get_the_only_target(ipc);
 	}
 
-	int ret = send_pkg(ipc, whom, vle_tb_get_data(pkg), vle_tb_get_len(pkg));
-	vle_tb_free(pkg);
+	if(stroscmp(ipc_get_name(ipc), whom) == 0)
+	{
+		LOG_ERROR_MSG("Won't send IPC message to myself");
+		return NULL;
+	}
 
-	free(name);
-	return ret;
+	return strdup(whom);
 }
 
 /* Performs actual sending of package to another instance.  Returns zero on
@@ -679,13 +914,12 @@ format_and_send(ipc_t *ipc, const char whom[], char *data[], const char type[])
 static int
 send_pkg(ipc_t *ipc, const char whom[], const char what[], size_t len)
 {
-	if(stroscmp(ipc_get_name(ipc), whom) == 0)
+#ifndef WIN32_PIPE_READ
+	if(send_over_socket(ipc, whom, what, len) == 0)
 	{
-		LOG_SERROR_MSG(errno, "Won't send IPC message to myself");
-		return 1;
+		return 0;
 	}
 
-#ifndef WIN32_PIPE_READ
 	char path[PATH_MAX + 1];
 	int fd;
 	FILE *dst;
@@ -895,58 +1129,798 @@ pipe_is_in_use(const char path[])
 	return 0;
 }
 
-#endif
+/* Creates listening socket of the instance.  Failing to do so isn't an error,
+ * the pipe is used then. */
+static void
+open_socket(ipc_t *ipc)
+{
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
 
-#else
+	const int len = snprintf(ipc->sock_path, sizeof(ipc->sock_path),
+			"%s/" SOCK_PREFIX "%s", get_ipc_dir(), ipc_get_name(ipc));
+	if(len < 0 || (size_t)len >= sizeof(addr.sun_path))
+	{
+		LOG_INFO_MSG("Not using IPC socket due to long path: %s", ipc->sock_path);
+		return;
+	}
+	copy_str(addr.sun_path, sizeof(addr.sun_path), ipc->sock_path);
 
-#include <stddef.h> /* NULL */
+	ipc->selector = selector_alloc();
+	if(ipc->selector == NULL)
+	{
+		return;
+	}
 
-int
-ipc_enabled(void)
-{
-	return 0;
-}
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Failed to create IPC socket");
+		return;
+	}
 
-char **
-ipc_list(int *len)
-{
-	*len = 0;
-	return NULL;
-}
+	/* The name belongs to this instance after it got the pipe, so whatever is
+	 * at this path was left behind by an instance that's gone. */
+	(void)unlink(ipc->sock_path);
 
-ipc_t *
-ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
-{
-	return NULL;
+	/* Make the socket accessible only to the current user just like the pipe. */
+	const mode_t old_umask = umask(0077);
+	const int bound = (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+	(void)umask(old_umask);
+
+	if(!bound || listen(fd, 16) != 0 || setup_socket(fd, /*nonblocking=*/1) != 0)
+	{
+		LOG_SERROR_MSG(errno, "Failed to set up IPC socket");
+		if(bound)
+		{
+			(void)unlink(ipc->sock_path);
+		}
+		close(fd);
+		return;
+	}
+
+	ipc->sock_fd = fd;
+	update_selector(ipc);
 }
 
-void
-ipc_free(ipc_t *ipc)
+/* Closes listening socket of the instance and all connections to it. */
+static void
+close_socket(ipc_t *ipc)
 {
+	size_t i;
+	for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+	{
+		if(ipc->conns[i].fd != -1)
+		{
+			close(ipc->conns[i].fd);
+		}
+		free(ipc->conns[i].buf);
+		free(ipc->conns[i].out);
+	}
+	DA_REMOVE_ALL(ipc->conns);
+
+	if(ipc->sock_fd != -1)
+	{
+		close(ipc->sock_fd);
+		unlink(ipc->sock_path);
+	}
+
+	selector_free(ipc->selector);
 }
 
-const char *
-ipc_get_name(const ipc_t *ipc)
+/* Processes at most one package received via the socket.  Returns non-zero if
+ * something was processed, otherwise zero is returned. */
+static int
+check_socket(ipc_t *ipc)
 {
-	return "";
+	if(ipc->sock_fd == -1)
+	{
+		return 0;
+	}
+
+	if(selector_wait(ipc->selector, 0))
+	{
+		size_t i;
+		for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+		{
+			ipc_conn_t *const conn = &ipc->conns[i];
+			if(conn->fd != -1 && selector_is_ready(ipc->selector, conn->fd))
+			{
+				read_conn(conn);
+			}
+		}
+
+		if(selector_is_ready(ipc->selector, ipc->sock_fd))
+		{
+			accept_conns(ipc);
+		}
+
+		update_selector(ipc);
+	}
+
+	/* Replies are sent as clients read them, so that a client that sends many
+	 * requests before reading replies doesn't block this instance. */
+	size_t i;
+	for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+	{
+		flush_conn(&ipc->conns[i]);
+	}
+
+	/* Connection can have several frames buffered, but only one is processed per
+	 * call. */
+	for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+	{
+		ipc_conn_t *const conn = &ipc->conns[i];
+
+		uint32_t id;
+		size_t len;
+		char *const pkg = take_frame(conn, &id, &len);
+		if(pkg != NULL)
+		{
+			const reply_to_t reply_to = { .conn = conn, .id = id };
+			handle_pkg(ipc, pkg, pkg + len, &reply_to);
+			free(pkg);
+			return 1;
+		}
+	}
+
+	drop_closed_conns(ipc);
+	return 0;
 }
 
-int
-ipc_check(ipc_t *ipc)
+/* Accepts all pending connections to the socket. */
+static void
+accept_conns(ipc_t *ipc)
 {
-	return 0;
+	for(;;)
+	{
+		const int fd = accept(ipc->sock_fd, NULL, NULL);
+		if(fd == -1)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			break;
+		}
+
+		ipc_conn_t *const conn = DA_EXTEND(ipc->conns);
+		if(conn == NULL || setup_socket(fd, /*nonblocking=*/1) != 0)
+		{
+			close(fd);
+			continue;
+		}
+
+		conn->fd = fd;
+		conn->buf = NULL;
+		conn->len = 0U;
+		conn->out = NULL;
+		conn->out_len = 0U;
+		DA_COMMIT(ipc->conns);
+
+		/* Client is likely to have sent something already. */
+		read_conn(conn);
+	}
 }
 
-int
-ipc_send(ipc_t *ipc, const char whom[], char *data[])
+/* Reads all data that's available on the connection, but not more than a
+ * single frame of maximum size.  Closes the connection on end of input or
+ * error. */
+static void
+read_conn(ipc_conn_t *conn)
 {
-	return 1;
+	while(conn->len < 2*sizeof(uint32_t) + MAX_FRAME_SIZE)
+	{
+		char buf[16*1024];
+		const ssize_t nread = recv(conn->fd, buf, sizeof(buf), 0);
+		if(nread > 0)
+		{
+			char *const new_buf = realloc(conn->buf, conn->len + nread);
+			if(new_buf == NULL)
+			{
+				LOG_ERROR_MSG("Failed to allocate memory for IPC connection");
+				break;
+			}
+
+			memcpy(new_buf + conn->len, buf, nread);
+			conn->buf = new_buf;
+			conn->len += nread;
+			continue;
+		}
+
+		if(nread == -1 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if(nread == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+
+		close_conn(conn);
+		break;
+	}
 }
 
-char *
-ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
+/* Extracts complete frame from the buffer of the connection.  *id and *len are
+ * set to identifier of the request and length of the package.  Returns newly
+ * allocated package with a trailing zero or NULL if there is no complete
+ * frame. */
+static char *
+take_frame(ipc_conn_t *conn, uint32_t *id, size_t *len)
 {
-	return NULL;
+	uint32_t header[2];
+	if(conn->len < sizeof(header))
+	{
+		return NULL;
+	}
+
+	memcpy(header, conn->buf, sizeof(header));
+	const size_t size = header[0];
+	if(size > MAX_FRAME_SIZE)
+	{
+		LOG_ERROR_MSG("Closing IPC connection due to frame size: %lu",
+				(unsigned long)size);
+		close_conn(conn);
+		conn->len = 0U;
+		return NULL;
+	}
+
+	if(conn->len - sizeof(header) < size)
+	{
+		return NULL;
+	}
+
+	char *const pkg = malloc(size + 1U);
+	if(pkg == NULL)
+	{
+		LOG_ERROR_MSG("Failed to allocate memory: %lu", (unsigned long)(size + 1));
+		return NULL;
+	}
+
+	memcpy(pkg, conn->buf + sizeof(header), size);
+	pkg[size] = '\0';
+
+	conn->len -= sizeof(header) + size;
+	memmove(conn->buf, conn->buf + sizeof(header) + size, conn->len);
+
+	*id = header[1];
+	*len = size;
+	return pkg;
+}
+
+/* Queues frame to be sent over the connection and sends as much of the queue
+ * as possible without blocking.  Returns zero on success and non-zero
+ * otherwise. */
+static int
+queue_frame(ipc_conn_t *conn, uint32_t id, const char data[], size_t len)
+{
+	if(conn->fd == -1)
+	{
+		return 1;
+	}
+
+	const uint32_t header[2] = { len, id };
+	const size_t size = conn->out_len + sizeof(header) + len;
+	if(size > MAX_PENDING_OUTPUT)
+	{
+		LOG_ERROR_MSG("Closing IPC connection that doesn't read replies");
+		close_conn(conn);
+		return 1;
+	}
+
+	char *const out = realloc(conn->out, size);
+	if(out == NULL)
+	{
+		return 1;
+	}
+
+	memcpy(out + conn->out_len, header, sizeof(header));
+	memcpy(out + conn->out_len + sizeof(header), data, len);
+	conn->out = out;
+	conn->out_len = size;
+
+	flush_conn(conn);
+	return 0;
+}
+
+/* Sends queued replies until there are none left or the socket isn't ready to
+ * accept more data.  Closes the connection on error. */
+static void
+flush_conn(ipc_conn_t *conn)
+{
+	size_t sent = 0U;
+	while(conn->fd != -1 && sent < conn->out_len)
+	{
+		const ssize_t nwritten = send(conn->fd, conn->out + sent,
+				conn->out_len - sent, SEND_FLAGS);
+		if(nwritten > 0)
+		{
+			sent += nwritten;
+			continue;
+		}
+
+		if(nwritten == -1 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if(nwritten == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			break;
+		}
+
+		close_conn(conn);
+	}
+
+	if(conn->fd == -1)
+	{
+		conn->out_len = 0U;
+		return;
+	}
+
+	conn->out_len -= sent;
+	memmove(conn->out, conn->out + sent, conn->out_len);
+}
+
+/* Closes socket of the connection.  Its buffers are freed later along with the
+ * connection itself. */
+static void
+close_conn(ipc_conn_t *conn)
+{
+	if(conn->fd != -1)
+	{
+		close(conn->fd);
+		conn->fd = -1;
+	}
+}
+
+/* Removes connections that were closed after all their frames got
+ * processed. */
+static void
+drop_closed_conns(ipc_t *ipc)
+{
+	size_t i, j = 0U;
+	for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+	{
+		if(ipc->conns[i].fd == -1)
+		{
+			free(ipc->conns[i].buf);
+			free(ipc->conns[i].out);
+			continue;
+		}
+
+		ipc->conns[j++] = ipc->conns[i];
+	}
+
+	if(j != DA_SIZE(ipc->conns))
+	{
+		DA_REMOVE_AFTER(ipc->conns, &ipc->conns[j]);
+	}
+}
+
+/* Makes selector watch the socket and all open connections to it. */
+static void
+update_selector(ipc_t *ipc)
+{
+	selector_reset(ipc->selector);
+	selector_add(ipc->selector, ipc->sock_fd);
+
+	size_t i;
+	for(i = 0U; i < DA_SIZE(ipc->conns); ++i)
+	{
+		if(ipc->conns[i].fd != -1)
+		{
+			selector_add(ipc->selector, ipc->conns[i].fd);
+		}
+	}
+}
+
+/* Prepares socket for use by this unit.  Returns zero on success and non-zero
+ * otherwise. */
+static int
+setup_socket(int fd, int nonblocking)
+{
+	/* Descriptors that don't fit into fd_set can't be waited on. */
+	if(fd >= FD_SETSIZE)
+	{
+		return 1;
+	}
+
+	if(fcntl(fd, F_SETFD, FD_CLOEXEC) != 0)
+	{
+		return 1;
+	}
+
+	if(nonblocking && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) != 0)
+	{
+		return 1;
+	}
+
+#if !defined(MSG_NOSIGNAL) && defined(SO_NOSIGPIPE)
+	const int on = 1;
+	if(setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on)) != 0)
+	{
+		return 1;
+	}
+#endif
+
+	return 0;
+}
+
+/* Connects to the socket of another instance reusing existing connection if
+ * possible.  Returns the socket or -1 on error. */
+static int
+connect_to_peer(ipc_t *ipc, const char whom[])
+{
+	if(ipc->peer_fd != -1 && stroscmp(ipc->peer_name, whom) == 0)
+	{
+		return ipc->peer_fd;
+	}
+
+	disconnect_peer(ipc);
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	const int len = snprintf(addr.sun_path, sizeof(addr.sun_path),
+			"%s/" SOCK_PREFIX "%s", get_ipc_dir(), whom);
+	if(len < 0 || (size_t)len >= sizeof(addr.sun_path))
+	{
+		return -1;
+	}
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd == -1)
+	{
+		return -1;
+	}
+
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+			setup_socket(fd, /*nonblocking=*/0) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	ipc->peer_fd = fd;
+	(void)replace_string(&ipc->peer_name, whom);
+	return fd;
+}
+
+/* Closes persistent connection to another instance if there is one. */
+static void
+disconnect_peer(ipc_t *ipc)
+{
+	if(ipc->peer_fd != -1)
+	{
+		close(ipc->peer_fd);
+		ipc->peer_fd = -1;
+	}
+	update_string(&ipc->peer_name, NULL);
+}
+
+/* Sends package to another instance over its socket without waiting for a
+ * reply.  Returns zero on success and non-zero if socket can't be used. */
+static int
+send_over_socket(ipc_t *ipc, const char whom[], const char what[], size_t len)
+{
+	int attempt;
+	for(attempt = 0; attempt < 2; ++attempt)
+	{
+		const int fd = connect_to_peer(ipc, whom);
+		if(fd == -1)
+		{
+			return 1;
+		}
+
+		if(send_frame(fd, ipc->next_id++, what, len) == 0)
+		{
+			return 0;
+		}
+
+		/* Persistent connection might have been closed by the other side, retry
+		 * with a new one. */
+		disconnect_peer(ipc);
+	}
+	return 1;
+}
+
+/* Evaluates expressions in another instance over its socket by sending all of
+ * them before waiting for replies.  Results are put into the results array with
+ * NULL standing for an error.  Returns zero if socket was used and non-zero if
+ * it's unavailable. */
+static int
+eval_over_socket(ipc_t *ipc, const char whom[], char *exprs[], int n,
+		char *results[])
+{
+	int sent;
+	uint32_t first_id = 0U;
+	for(sent = 0; sent < n; ++sent)
+	{
+		char *data[] = { exprs[sent], NULL };
+		vle_textbuf *pkg = format_pkg(ipc, data, EVAL_TYPE);
+		if(pkg == NULL)
+		{
+			break;
+		}
+
+		const char *what = vle_tb_get_data(pkg);
+		const size_t len = vle_tb_get_len(pkg);
+
+		int error;
+		if(sent == 0)
+		{
+			/* This establishes connection, if it's possible. */
+			error = send_over_socket(ipc, whom, what, len);
+			first_id = ipc->next_id - 1U;
+		}
+		else
+		{
+			error = send_frame(ipc->peer_fd, ipc->next_id++, what, len);
+		}
+
+		vle_tb_free(pkg);
+
+		if(error)
+		{
+			break;
+		}
+	}
+
+	if(sent == 0)
+	{
+		return 1;
+	}
+
+	int received = 0;
+	while(received < sent)
+	{
+		uint32_t id;
+		size_t len;
+		char *const pkg = recv_frame(ipc->peer_fd, &id, &len);
+		if(pkg == NULL)
+		{
+			LOG_ERROR_MSG("Failed to receive --remote-expr response");
+			break;
+		}
+
+		ipc->eval_result = NULL;
+		handle_pkg(ipc, pkg, pkg + len, /*reply_to=*/NULL);
+		free(pkg);
+
+		/* Replies are matched with requests by their identifiers. */
+		const uint32_t idx = id - first_id;
+		if(idx < (uint32_t)sent)
+		{
+			free(results[idx]);
+			results[idx] = ipc->eval_result;
+			++received;
+		}
+		else
+		{
+			free(ipc->eval_result);
+		}
+		ipc->eval_result = NULL;
+	}
+
+	if(sent != n || received != sent)
+	{
+		/* Connection is in unknown state. */
+		disconnect_peer(ipc);
+	}
+
+	return 0;
+}
+
+/* Sends a single frame.  Returns zero on success and non-zero otherwise. */
+static int
+send_frame(int fd, uint32_t id, const char data[], size_t len)
+{
+	if(len > MAX_FRAME_SIZE)
+	{
+		return 1;
+	}
+
+	const uint32_t header[2] = { len, id };
+	return (write_all(fd, (const char *)header, sizeof(header)) != 0)
+	    || (write_all(fd, data, len) != 0);
+}
+
+/* Receives a single frame.  *id and *len are set to identifier of the request
+ * and length of the package.  Returns newly allocated package with a trailing
+ * zero or NULL on error or timeout. */
+static char *
+recv_frame(int fd, uint32_t *id, size_t *len)
+{
+	uint32_t header[2];
+	if(read_all(fd, (char *)header, sizeof(header)) != 0)
+	{
+		return NULL;
+	}
+
+	const size_t size = header[0];
+	if(size > MAX_FRAME_SIZE)
+	{
+		LOG_ERROR_MSG("Received IPC frame is too big: %lu", (unsigned long)size);
+		return NULL;
+	}
+
+	char *const pkg = malloc(size + 1U);
+	if(pkg == NULL)
+	{
+		return NULL;
+	}
+
+	if(read_all(fd, pkg, size) != 0)
+	{
+		free(pkg);
+		return NULL;
+	}
+
+	pkg[size] = '\0';
+	*id = header[1];
+	*len = size;
+	return pkg;
+}
+
+/* Writes whole buffer to a socket waiting for it to become writable if
+ * necessary.  Returns zero on success and non-zero otherwise. */
+static int
+write_all(int fd, const char data[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t nwritten = send(fd, data, len, SEND_FLAGS);
+		if(nwritten > 0)
+		{
+			data += nwritten;
+			len -= nwritten;
+			continue;
+		}
+
+		if(nwritten == -1 && errno == EINTR)
+		{
+			continue;
+		}
+
+		if(nwritten == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if(wait_for_socket(fd, /*for_write=*/1) != 0)
+			{
+				return 1;
+			}
+			continue;
+		}
+
+		return 1;
+	}
+	return 0;
+}
+
+/* Reads exactly len bytes from a socket.  Returns zero on success and non-zero
+ * otherwise. */
+static int
+read_all(int fd, char buf[], size_t len)
+{
+	while(len != 0U)
+	{
+		if(wait_for_socket(fd, /*for_write=*/0) != 0)
+		{
+			return 1;
+		}
+
+		const ssize_t nread = recv(fd, buf, len, 0);
+		if(nread > 0)
+		{
+			buf += nread;
+			len -= nread;
+			continue;
+		}
+
+		if(nread == -1 &&
+				(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			continue;
+		}
+
+		return 1;
+	}
+	return 0;
+}
+
+/* Waits for socket to become readable or writable for at most IO_TIMEOUT_MS.
+ * Returns zero if it did and non-zero on error or timeout. */
+static int
+wait_for_socket(int fd, int for_write)
+{
+	for(;;)
+	{
+		fd_set set;
+		FD_ZERO(&set);
+		FD_SET(fd, &set);
+
+		struct timeval ts = {
+			.tv_sec = IO_TIMEOUT_MS/1000,
+			.tv_usec = (IO_TIMEOUT_MS%1000)*1000,
+		};
+
+		const int result = for_write
+		                 ? select(fd + 1, NULL, &set, NULL, &ts)
+		                 : select(fd + 1, &set, NULL, NULL, &ts);
+		if(result > 0)
+		{
+			return 0;
+		}
+		if(result == 0 || errno != EINTR)
+		{
+			return 1;
+		}
+	}
+}
+
+#endif
+
+#else
+
+#include <stddef.h> /* NULL */
+
+int
+ipc_enabled(void)
+{
+	return 0;
+}
+
+char **
+ipc_list(int *len)
+{
+	*len = 0;
+	return NULL;
+}
+
+ipc_t *
+ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
+{
+	return NULL;
+}
+
+void
+ipc_free(ipc_t *ipc)
+{
+}
+
+const char *
+ipc_get_name(const ipc_t *ipc)
+{
+	return "";
+}
+
+int
+ipc_check(ipc_t *ipc)
+{
+	return 0;
+}
+
+int
+ipc_send(ipc_t *ipc, const char whom[], char *data[])
+{
+	return 1;
+}
+
+char *
+ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
+{
+	return NULL;
+}
+
+int
+ipc_eval_batch(ipc_t *ipc, const char whom[], char *exprs[], int n,
+		char *results[])
+{
+	int i;
+	for(i = 0; i < n; ++i)
+	{
+		results[i] = NULL;
+	}
+	return 1;
 }
 
 #endif
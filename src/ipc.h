@@ -64,6 +64,14 @@ int ipc_send(ipc_t *ipc, const char whom[], char *data[]);
  * of ipc_send().  Returns result converted to a string or NULL on error. */
 char * ipc_eval(ipc_t *ipc, const char whom[], const char expr[]);
 
+/* Evaluates n expressions in a remote instance sending all of them at once if
+ * possible.  Rules for arguments match those of ipc_send().  Results are
+ * converted to strings and stored in the results array with NULL standing for
+ * an error.  Returns zero if all expressions were evaluated successfully and
+ * non-zero otherwise. */
+int ipc_eval_batch(ipc_t *ipc, const char whom[], char *exprs[], int n,
+		char *results[]);
+
 #endif /* VIFM__IPC_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
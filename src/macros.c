@@ -19,6 +19,10 @@
 
 #include "macros.h"
 
+#ifndef _WIN32
+#include <unistd.h> /* _POSIX_ARG_MAX _SC_ARG_MAX sysconf() */
+#endif
+
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() tolower() */
 #include <stddef.h> /* NULL size_t */
@@ -35,6 +39,7 @@
 #include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
+#include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
@@ -63,16 +68,34 @@ typedef struct
 	const reg_t *reg; /* Register to be used by MK_r. */
 	int quoted;       /* Whether escaping via quotes should be used during macro
 	                     expansion. */
+	int jobs;         /* Number of parallel jobs requested by MK_x. */
 }
 macro_info_t;
 
+/* State of expansion in batch mode.  The list of files is expanded separately
+ * from the rest of the command to be able to split it later. */
+typedef struct
+{
+	int found;       /* Whether a macro to split was found. */
+	size_t offset;   /* Position of the list of files in the expanded string. */
+	strlist_t items; /* Separately expanded elements of the list. */
+	int jobs;        /* Number of commands to run in parallel. */
+}
+batch_t;
+
 /* File iteration function. */
 typedef int (*iter_func)(view_t *view, dir_entry_t **entry);
 
 static char * expand_macros(const char command[], const char args[],
-		MacroFlags *flags, int for_shell, int for_op, int single_only);
+		MacroFlags *flags, int for_shell, int for_op, int single_only,
+		batch_t *batch);
 static macro_info_t find_next_macro(const char str[]);
 static void limit_to_single_only(macro_info_t *info, int ncurr, int nother);
+TSTATIC strlist_t expand_batched(const char command[], const char args[],
+		MacroExpandReason reason, size_t limit, int *jobs);
+static int collect_selected_files(view_t *view, int quotes, const char mod[],
+		iter_func iter, int for_shell, strlist_t *list);
+static PathType get_path_type(view_t *view);
 TSTATIC char * append_selected_files(view_t *view, char expanded[],
 		int under_cursor, int quotes, const char mod[], iter_func iter,
 		int for_shell);
@@ -93,6 +116,7 @@ static cline_t expand_custom(const char **pattern, size_t nmacros,
 		custom_macro_t macros[], int with_opt, int in_opt);
 static char * add_missing_macros(char expanded[], size_t len, size_t nmacros,
 		custom_macro_t macros[]);
+static size_t get_batch_limit(void);
 
 char *
 ma_expand(const char command[], const char args[], MacroFlags *flags,
@@ -104,8 +128,8 @@ ma_expand(const char command[], const char args[], MacroFlags *flags,
 	int lpending_marking = lwin.pending_marking;
 	int rpending_marking = rwin.pending_marking;
 
-	char *res =
-		expand_macros(command, args, flags, for_shell, for_op, /*single_only=*/0);
+	char *res = expand_macros(command, args, flags, for_shell, for_op,
+			/*single_only=*/0, /*batch=*/NULL);
 
 	lwin.pending_marking = lpending_marking;
 	rwin.pending_marking = rpending_marking;
@@ -120,7 +144,7 @@ ma_expand_single(const char command[])
 	int rpending_marking = rwin.pending_marking;
 
 	char *const res = expand_macros(command, NULL, NULL, /*for_shell=*/0,
-			/*for_op=*/0, /*single_only=*/1);
+			/*for_op=*/0, /*single_only=*/1, /*batch=*/NULL);
 
 	lwin.pending_marking = lpending_marking;
 	rwin.pending_marking = rpending_marking;
@@ -129,13 +153,159 @@ ma_expand_single(const char command[])
 	return res;
 }
 
+strlist_t
+ma_expand_batched(const char command[], const char args[],
+		MacroExpandReason reason, int *jobs)
+{
+	return expand_batched(command, args, reason, get_batch_limit(), jobs);
+}
+
+/* Implementation of ma_expand_batched() with configurable limit on length of
+ * a command.  Returns list of commands. */
+TSTATIC strlist_t
+expand_batched(const char command[], const char args[],
+		MacroExpandReason reason, size_t limit, int *jobs)
+{
+	int for_shell = (reason == MER_SHELL || reason == MER_SHELL_OP);
+	int for_op = (reason == MER_OP || reason == MER_SHELL_OP);
+
+	int lpending_marking = lwin.pending_marking;
+	int rpending_marking = rwin.pending_marking;
+
+	batch_t batch = { .jobs = 1 };
+	char *expanded = expand_macros(command, args, NULL, for_shell, for_op,
+			/*single_only=*/0, &batch);
+
+	lwin.pending_marking = lpending_marking;
+	rwin.pending_marking = rpending_marking;
+
+	*jobs = batch.jobs;
+
+	strlist_t cmds = {};
+	if(expanded == NULL)
+	{
+		free_string_array(batch.items.items, batch.items.nitems);
+		return cmds;
+	}
+
+	if(batch.items.nitems == 0)
+	{
+		cmds.nitems = add_to_string_array(&cmds.items, cmds.nitems, expanded);
+		free(expanded);
+		return cmds;
+	}
+
+	const size_t fixed_len = strlen(expanded);
+
+	int i = 0;
+	while(i < batch.items.nitems)
+	{
+		/* Take at least one item even if it doesn't fit. */
+		size_t len = fixed_len + strlen(batch.items.items[i]);
+		int n = 1;
+		while(i + n < batch.items.nitems)
+		{
+			const size_t item_len = strlen(batch.items.items[i + n]);
+			if(len + 1U + item_len > limit)
+			{
+				break;
+			}
+			len += 1U + item_len;
+			++n;
+		}
+
+		char *const cmd = malloc(len + 1U);
+		if(cmd == NULL)
+		{
+			free_string_array(cmds.items, cmds.nitems);
+			cmds.items = NULL;
+			cmds.nitems = 0;
+			break;
+		}
+
+		char *p = cmd;
+		memcpy(p, expanded, batch.offset);
+		p += batch.offset;
+
+		int j;
+		for(j = i; j < i + n; ++j)
+		{
+			if(j != i)
+			{
+				*p++ = ' ';
+			}
+			const size_t item_len = strlen(batch.items.items[j]);
+			memcpy(p, batch.items.items[j], item_len);
+			p += item_len;
+		}
+
+		strcpy(p, expanded + batch.offset);
+
+		if(put_into_string_array(&cmds.items, cmds.nitems, cmd) != cmds.nitems + 1)
+		{
+			free(cmd);
+			free_string_array(cmds.items, cmds.nitems);
+			cmds.items = NULL;
+			cmds.nitems = 0;
+			break;
+		}
+		++cmds.nitems;
+
+		i += n;
+	}
+
+	free_string_array(batch.items.items, batch.items.nitems);
+	free(expanded);
+	return cmds;
+}
+
+/* Computes limit on length of a command-line passed to a shell in a way that
+ * doesn't exceed system limits.  Returns the limit. */
+static size_t
+get_batch_limit(void)
+{
+#ifndef _WIN32
+	long arg_max = sysconf(_SC_ARG_MAX);
+	if(arg_max <= 0)
+	{
+		arg_max = _POSIX_ARG_MAX;
+	}
+
+	/* Environment shares space with arguments. */
+	extern char **environ;
+	char **env;
+	for(env = environ; *env != NULL; ++env)
+	{
+		arg_max -= (long)(strlen(*env) + 1U + sizeof(*env));
+	}
+
+	/* Reserve space for arguments of the shell and variables set by vifm. */
+	arg_max -= 4096;
+
+	/* Linux limits length of a single argument to 128 KiB and the whole command
+	 * is passed to the shell as a single argument. */
+	if(arg_max > 128*1024)
+	{
+		arg_max = 128*1024;
+	}
+
+	/* Leave room for transformations of the command like escaping for terminal
+	 * multiplexers. */
+	return (arg_max/2 > 2048 ? arg_max/2 : 2048);
+#else
+	/* cmd.exe limits command-line to 8191 characters. */
+	return 8191/2;
+#endif
+}
+
 /* Performs substitution of macros with their values.  args and flags
  * parameters can be NULL.  The string returned needs to be freed by the
- * caller.  After executing flags is one of MF_* values.  On error NULL is
+ * caller.  After executing flags is one of MF_* values.  batch is NULL or
+ * receives list of files separately from the result.  On error NULL is
  * returned. */
 static char *
 expand_macros(const char command[], const char args[], MacroFlags *flags,
-		int for_shell, int for_op, int single_only)
+		int for_shell, int for_op, int single_only, batch_t *batch)
 {
 	ma_flags_set(flags, MF_NONE);
 
@@ -193,6 +363,26 @@ expand_macros(const char command[], const char args[], MacroFlags *flags,
 			limit_to_single_only(&info, ncurr, nother);
 		}
 
+		if(batch != NULL && !batch->found &&
+				ONE_OF(info.kind, MK_f, MK_F, MK_l, MK_L))
+		{
+			view_t *const view = ONE_OF(info.kind, MK_f, MK_l) ? curr_view
+			                                                  : other_view;
+			iter_func list_iter = ONE_OF(info.kind, MK_f, MK_F)
+			                    ? iter
+			                    : &iter_selected_entries;
+
+			batch->found = 1;
+			batch->offset = strlen(expanded);
+			if(collect_selected_files(view, info.quoted, info.mod, list_iter,
+						for_shell, &batch->items) != 0)
+			{
+				free(expanded);
+				return NULL;
+			}
+			continue;
+		}
+
 		switch(info.kind)
 		{
 			case MK_NONE:           /* Handled above.  Pass-through. */
@@ -264,6 +454,14 @@ expand_macros(const char command[], const char args[], MacroFlags *flags,
 			case MK_U: ma_flags_set(flags, MF_VERYCUSTOMVIEW_OUTPUT); break;
 			case MK_i: ma_flags_set(flags, MF_IGNORE); break;
 
+			case MK_x:
+				ma_flags_set(flags, MF_BATCH);
+				if(batch != NULL)
+				{
+					batch->jobs = info.jobs;
+				}
+				break;
+
 			case MK_r:
 				expanded = expand_register(info.reg, flist_get_dir(curr_view), expanded,
 						info.quoted, info.mod, for_shell);
@@ -349,6 +547,16 @@ find_next_macro(const char str[])
 		case 'U': info.kind = MK_U; break;
 		case 'i': info.kind = MK_i; break;
 
+		case 'x':
+			info.kind = MK_x;
+			info.jobs = 0;
+			while(isdigit(p[1]))
+			{
+				info.jobs = MIN(info.jobs*10 + (*++p - '0'), 999);
+			}
+			info.jobs = MAX(info.jobs, 1);
+			break;
+
 		case 'r':
 			info.kind = MK_r;
 			info.reg = regs_find(tolower(*++p));
@@ -463,19 +671,21 @@ ma_flags_set(MacroFlags *flags, MacroFlags flag)
 	{
 		*flags = (*flags & ~0x0f00) | flag;
 	}
-	else
+	else if(flag < MF_FIFTH_SET_)
 	{
 		*flags = (*flags & ~0xf000) | flag;
 	}
+	else
+	{
+		*flags = (*flags & ~0xf0000) | flag;
+	}
 }
 
 TSTATIC char *
 append_selected_files(view_t *view, char expanded[], int under_cursor,
 		int quotes, const char mod[], iter_func iter, int for_shell)
 {
-	const PathType type = (view == other_view)
-	                    ? PT_FULL
-	                    : (flist_custom_active(view) ? PT_REL : PT_NAME);
+	const PathType type = get_path_type(view);
 #ifdef _WIN32
 	size_t old_len = strlen(expanded);
 #endif
@@ -514,6 +724,59 @@ append_selected_files(view_t *view, char expanded[], int under_cursor,
 	return expanded;
 }
 
+/* Expands each file of the view into a separate element of the list.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+collect_selected_files(view_t *view, int quotes, const char mod[],
+		iter_func iter, int for_shell, strlist_t *list)
+{
+	const PathType type = get_path_type(view);
+
+	dir_entry_t *entry = NULL;
+	while(iter(view, &entry))
+	{
+		char *const empty = strdup("");
+		if(empty == NULL)
+		{
+			return 1;
+		}
+
+		char *const item = append_entry(view, empty, type, entry, quotes, mod,
+				for_shell);
+		if(item == NULL)
+		{
+			return 1;
+		}
+
+		if(for_shell && curr_stats.shell_type == ST_CMD)
+		{
+			internal_to_system_slashes(item);
+		}
+
+		if(put_into_string_array(&list->items, list->nitems, item) ==
+				list->nitems)
+		{
+			free(item);
+			return 1;
+		}
+		++list->nitems;
+	}
+
+	return 0;
+}
+
+/* Determines how paths of files of the view should be formatted.  Returns the
+ * type. */
+static PathType
+get_path_type(view_t *view)
+{
+	if(view == other_view)
+	{
+		return PT_FULL;
+	}
+	return (flist_custom_active(view) ? PT_REL : PT_NAME);
+}
+
 /* Appends path to the entry to the expanded string.  Returns new value of
  * expanded string. */
 static char *
@@ -936,10 +1199,14 @@ ma_flags_present(MacroFlags flags, MacroFlags flag)
 	{
 		return ((flags & 0x0f00) == flag);
 	}
-	else
+	else if(flag < MF_FIFTH_SET_)
 	{
 		return ((flags & 0xf000) == flag);
 	}
+	else
+	{
+		return ((flags & 0xf0000) == flag);
+	}
 }
 
 int
@@ -957,6 +1224,7 @@ ma_flags_to_str(MacroFlags flags)
 		case MF_SECOND_SET_:
 		case MF_THIRD_SET_:
 		case MF_FOURTH_SET_:
+		case MF_FIFTH_SET_:
 		case MF_NONE: return "";
 
 		case MF_MENU_OUTPUT: return "%m";
@@ -975,6 +1243,8 @@ ma_flags_to_str(MacroFlags flags)
 
 		case MF_KEEP_IN_FG: return "%N";
 
+		case MF_BATCH: return "%x";
+
 		case MF_PIPE_FILE_LIST: return "%Pl";
 		case MF_PIPE_FILE_LIST_Z: return "%Pz";
 
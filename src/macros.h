@@ -62,6 +62,7 @@ typedef enum
 	MK_u, /* Parse output as list of files and compose custom view. */
 	MK_U, /* Parse output as list of files and compose unsorted view. */
 	MK_i, /* Ignore output. */
+	MK_x, /* Run command in batches over the list of files (xargs-like). */
 
 	/*
 	 * Single-argument macros.
@@ -134,6 +135,13 @@ typedef enum
 	/* Don't detach command from terminal session or process group.  In separate
 	 * group so it can safely appear among other flags without disabling them. */
 	MF_KEEP_IN_FG = 0x2000,
+
+	/* Fifth set of mutually exclusive flags. */
+	MF_FIFTH_SET_ = 0x10000,
+
+	/* Split command into several ones with parts of the list of files.  In
+	 * separate group because it's orthogonal to handling of the output. */
+	MF_BATCH = 0x20000,
 }
 MacroFlags;
 
@@ -186,6 +194,16 @@ char * ma_expand(const char command[], const char args[], MacroFlags *flags,
  * single string, so escaping is disabled. */
 char * ma_expand_single(const char command[]);
 
+struct strlist_t;
+
+/* Like ma_expand(), but expands the first macro which lists files (%f, %F, %l
+ * or %L) in parts producing several commands, none of which exceeds limit on
+ * length of a command-line (unless a single path is too long).  *jobs is set to
+ * the maximum number of commands to run in parallel as specified by %x.
+ * Returns list of commands, which is empty on error. */
+struct strlist_t ma_expand_batched(const char command[], const char args[],
+		MacroExpandReason reason, int *jobs);
+
 /* Gets clear part of the viewer.  Returns NULL if there is none, otherwise
  * pointer inside the cmd string is returned. */
 const char * ma_get_clear_cmd(const char cmd[]);
@@ -232,6 +250,8 @@ TSTATIC_DEFS(
 	char * append_selected_files(struct view_t *view, char expanded[],
 		int under_cursor, int quotes, const char mod[], iter_func iter,
 		int for_shell);
+	struct strlist_t expand_batched(const char command[], const char args[],
+		MacroExpandReason reason, size_t limit, int *jobs);
 )
 
 #endif /* VIFM__MACROS_H__ */
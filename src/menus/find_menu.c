@@ -122,7 +122,7 @@ show_find_menu(view_t *view, int with_path, const char args[])
 	}
 
 	ui_sb_msg("find...");
-	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
+	save_msg = menus_capture_async(view, cmd, &m, flags);
 	free(cmd);
 
 	return save_msg;
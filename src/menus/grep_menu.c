@@ -96,7 +96,7 @@ show_grep_menu(view_t *view, const char args[], int invert)
 	}
 
 	ui_sb_msg("grep...");
-	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
+	save_msg = menus_capture_async(view, cmd, &m, flags);
 	free(cmd);
 
 	return save_msg;
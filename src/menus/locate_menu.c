@@ -75,7 +75,7 @@ show_locate_menu(view_t *view, const char args[])
 	}
 
 	ui_sb_msg("locate...");
-	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
+	save_msg = menus_capture_async(view, cmd, &m, flags);
 	free(cmd);
 
 	return save_msg;
@@ -20,13 +20,16 @@
 #include "menus.h"
 
 #include <curses.h>
+#include <fcntl.h> /* F_GETFL F_SETFL O_NONBLOCK fcntl() */
 
 #include <assert.h> /* assert() */
+#include <errno.h> /* EAGAIN errno */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE */
-#include <stdlib.h> /* free() malloc() */
-#include <string.h> /* memmove() memset() strdup() strcat() strncat() strchr()
-                       strlen() strrchr() */
+#include <stdio.h> /* FILE clearerr() fclose() feof() ferror() fileno() fread() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() */
+#include <string.h> /* memchr() memcpy() memmove() memset() strdup() strcat()
+                       strncat() strchr() strlen() strrchr() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
 #include <wchar.h> /* wchar_t wcscmp() */
 
 #include "../cfg/config.h"
@@ -66,6 +69,25 @@
 #include "../search.h"
 #include "../status.h"
 
+/* Minimal period in milliseconds between redraws of a menu caused by loading of
+ * its items. */
+enum { LOAD_REDRAW_PERIOD_MS = 200 };
+
+/* Maximum time in milliseconds spent on reading output of a single command per
+ * check, which keeps user interface responsive when output is large. */
+enum { LOAD_TIME_LIMIT_MS = 50 };
+
+/* State of loading menu items from output of a background job. */
+typedef struct menu_loader_t
+{
+	bg_job_t *job;  /* Job that produces the items. */
+	char *buf;      /* Output that doesn't form a complete item yet. */
+	size_t buf_len; /* Length of the buf field, buf[buf_len] is always '\0'. */
+	int null_sep;   /* Whether items are separated by null characters. */
+	int cancelled;  /* Whether loading was stopped by the user. */
+}
+menu_loader_t;
+
 static void deinit_menu_data(menu_data_t *m);
 static void show_position_in_menu(const menu_data_t *m);
 static void open_selected_file(const char path[], int line_num);
@@ -78,6 +100,16 @@ static void draw_menu_frame(const menu_state_t *ms);
 static void output_handler(const char line[], void *arg);
 static void append_to_string(char **str, const char suffix[]);
 static char * expand_tabulation_a(const char line[], size_t tab_stops);
+static int start_loading(menu_data_t *m, view_t *view, const char cmd[],
+		MacroFlags flags);
+static int load_items(menu_data_t *m);
+static int read_job_output(bg_job_t *job, char buf[], size_t buf_len);
+static void take_items(menu_data_t *m, int flush);
+static void finish_loading(menu_data_t *m);
+static void stop_loading(menu_data_t *m);
+static void free_loader(menu_data_t *m);
+static void redraw_loaded_menu(menu_state_t *ms);
+static long long time_in_ms(void);
 static void init_menu_state(menu_state_t *ms, menu_data_t *m, view_t *view);
 static void replace_menu_data(menu_data_t *m);
 static int can_stash_menu(const menu_data_t *m);
@@ -89,6 +121,8 @@ static const char * get_relative_path_base(const menu_data_t *m,
 		const view_t *view);
 static int menu_and_view_are_in_sync(const menu_data_t *m, const view_t *view);
 static int search_menu(menu_state_t *ms, int print_errors);
+static int match_items(menu_state_t *ms, int from, int print_errors);
+static void extend_search_matches(menu_state_t *ms, int from);
 static int search_menu_forwards(menu_state_t *ms, int start_pos);
 static int search_menu_backwards(menu_state_t *ms, int start_pos);
 static int navigate_to_match(menu_state_t *ms, int pos);
@@ -120,6 +154,10 @@ struct menu_state_t
 	int search_repeat;
 	/* View associated with the menu (e.g. to navigate to a file in it). */
 	view_t *view;
+	/* Whether the menu needs to be redrawn to display newly loaded items. */
+	int load_redraw;
+	/* Time of the last redraw caused by loading of items in milliseconds. */
+	long long load_redraw_time;
 }
 menu_state;
 
@@ -195,6 +233,7 @@ menus_init_data(menu_data_t *m, view_t *view, char title[], char empty_msg[])
 	m->execute_handler = NULL;
 	m->empty_msg = empty_msg;
 	m->cwd = strdup(flist_get_dir(view));
+	m->loader = NULL;
 	m->state = &menu_state;
 	m->initialized = 1;
 }
@@ -227,6 +266,11 @@ deinit_menu_data(menu_data_t *m)
 		return;
 	}
 
+	if(m->loader != NULL)
+	{
+		stop_loading(m);
+	}
+
 	/* Menu elements don't always have data associated with them, but len isn't
 	 * zero.  That's why we need this check. */
 	if(m->data != NULL)
@@ -595,6 +639,12 @@ draw_menu_frame(const menu_state_t *ms)
 		free(title);
 		title = full_title;
 	}
+	if(ms->d->loader != NULL)
+	{
+		char *full_title = format_str("%s (loading...)", title);
+		free(title);
+		title = full_title;
+	}
 
 	const size_t title_len = getmaxx(menu_win) - 2*4;
 	char *const ellipsed = right_ellipsis(title, title_len, curr_stats.ellipsis);
@@ -725,6 +775,7 @@ init_menu_state(menu_state_t *ms, menu_data_t *m, view_t *view)
 	ms->regexp = NULL;
 	ms->search_repeat = 0;
 	ms->view = view;
+	ms->load_redraw = 0;
 }
 
 void
@@ -1090,27 +1141,417 @@ menus_capture(view_t *view, const char cmd[], int user_sh, menu_data_t *m,
 		return 0;
 	}
 
-	FILE *input_tmp = make_in_file(view, flags);
+	char *cmds[] = { (char *)cmd };
+	return menus_capture_batch(view, cmds, 1, user_sh, m, flags);
+}
+
+int
+menus_capture_batch(view_t *view, char *cmds[], int ncmds, int user_sh,
+		menu_data_t *m, MacroFlags flags)
+{
+	int i;
+	for(i = 0; i < ncmds; ++i)
+	{
+		FILE *input_tmp = make_in_file(view, flags);
+
+		if(process_cmd_output("Loading menu", cmds[i], input_tmp, user_sh, 0,
+					&output_handler, m) != 0)
+		{
+			show_error_msgf("Trouble running command", "Unable to run: %s",
+					cmds[i]);
+			return 0;
+		}
+
+		if(input_tmp != NULL)
+		{
+			fclose(input_tmp);
+		}
+
+		if(ui_cancellation_requested())
+		{
+			break;
+		}
+	}
+
+	if(ui_cancellation_requested())
+	{
+		append_to_string(&m->title, "(cancelled)");
+		append_to_string(&m->empty_msg, " (cancelled)");
+	}
+
+	return menus_enter(m, view);
+}
+
+int
+menus_capture_async(view_t *view, const char cmd[], menu_data_t *m,
+		MacroFlags flags)
+{
+	if(ma_flags_present(flags, MF_CUSTOMVIEW_OUTPUT) ||
+			ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT))
+	{
+		return menus_capture(view, cmd, /*user_sh=*/0, m, flags);
+	}
 
-	if(process_cmd_output("Loading menu", cmd, input_tmp, user_sh, 0,
-				&output_handler, m) != 0)
+	if(start_loading(m, view, cmd, flags) != 0)
 	{
 		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
 		return 0;
 	}
 
-	if(input_tmp != NULL)
+	/* Wait for the first item to have something to display or for the command to
+	 * finish to report an empty menu as usual. */
+	ui_cancellation_push_on();
+	while(m->len == 0 && m->loader != NULL)
+	{
+		bg_job_t *const job = m->loader->job;
+		wait_for_data_from(job->pid, job->output, 0, &ui_cancellation_info);
+
+		if(ui_cancellation_requested())
+		{
+			m->loader->cancelled = 1;
+			finish_loading(m);
+			break;
+		}
+
+		(void)load_items(m);
+	}
+	ui_cancellation_pop();
+
+	return menus_enter(m, view);
+}
+
+/* Starts background job that produces items of the menu.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+start_loading(menu_data_t *m, view_t *view, const char cmd[], MacroFlags flags)
+{
+	LOG_INFO_MSG("Loading menu from output of the command: %s", cmd);
+
+	BgJobFlags bg_flags = BJF_MENU_VISIBLE | BJF_CAPTURE_OUT;
+	if(ma_flags_present(flags, MF_PIPE_FILE_LIST) ||
+			ma_flags_present(flags, MF_PIPE_FILE_LIST_Z))
+	{
+		bg_flags |= BJF_SUPPLY_INPUT;
+	}
+
+	bg_job_t *const job = bg_run_external_job(cmd, bg_flags, /*descr=*/NULL);
+	if(job == NULL)
 	{
-		fclose(input_tmp);
+		return 1;
 	}
 
-	if(ui_cancellation_requested())
+	/* Errors are reported as they come because the menu can be in use for a
+	 * while. */
+	job->skip_errors = 0;
+
+	if(job->input != NULL)
+	{
+		const int null_sep = ma_flags_present(flags, MF_PIPE_FILE_LIST_Z);
+		write_marked_paths(job->input, view, null_sep);
+		fclose(job->input);
+		job->input = NULL;
+	}
+
+#ifndef _WIN32
+	/* Enable non-blocking read from output pipe.  On Windows we read the exact
+	 * amount of data present in the stream. */
+	const int fd = fileno(job->output);
+	(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	m->loader = calloc(1, sizeof(*m->loader));
+	if(m->loader == NULL)
+	{
+		(void)bg_job_cancel(job);
+		bg_job_terminate(job);
+		bg_job_decref(job);
+		return 1;
+	}
+
+	m->loader->job = job;
+	return 0;
+}
+
+void
+menus_check_for_updates(void)
+{
+	int i;
+	for(i = 0; i < menu_stash_depth; ++i)
+	{
+		/* Data of displayed stash is in the menu state and isn't initialized
+		 * here. */
+		menu_data_t *const m = &menu_data_stash[i];
+		if(m->initialized && m->loader != NULL)
+		{
+			(void)load_items(m);
+		}
+	}
+
+	menu_state_t *const ms = &menu_state;
+	if(ms->d == NULL || !ms->d->initialized)
+	{
+		return;
+	}
+
+	if(ms->d->loader != NULL)
+	{
+		const int old_len = ms->d->len;
+		if(load_items(ms->d))
+		{
+			extend_search_matches(ms, old_len);
+			ms->load_redraw = 1;
+		}
+	}
+
+	if(ms->load_redraw && vle_mode_is(MENU_MODE))
+	{
+		redraw_loaded_menu(ms);
+	}
+}
+
+int
+menus_are_loading(void)
+{
+	const menu_data_t *const m = menu_state.d;
+	if(m != NULL && m->initialized && m->loader != NULL)
+	{
+		return 1;
+	}
+
+	int i;
+	for(i = 0; i < menu_stash_depth; ++i)
+	{
+		if(menu_data_stash[i].initialized && menu_data_stash[i].loader != NULL)
+		{
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int
+menus_cancel_loading(menu_state_t *ms)
+{
+	menu_data_t *const m = ms->d;
+	if(m->loader == NULL)
+	{
+		return 0;
+	}
+
+	const int old_len = m->len;
+	m->loader->cancelled = 1;
+	finish_loading(m);
+	extend_search_matches(ms, old_len);
+
+	ms->load_redraw = 1;
+	redraw_loaded_menu(ms);
+	return 1;
+}
+
+/* Reads output of menu's job that's available at the moment and turns it into
+ * menu items.  Finishes loading on reaching end of the output.  Returns
+ * non-zero if the menu has changed. */
+static int
+load_items(menu_data_t *m)
+{
+	menu_loader_t *const loader = m->loader;
+	const int old_len = m->len;
+	const long long deadline = time_in_ms() + LOAD_TIME_LIMIT_MS;
+
+	char piece[4096];
+	int nread;
+	while((nread = read_job_output(loader->job, piece, sizeof(piece))) > 0)
+	{
+		char *const buf = realloc(loader->buf, loader->buf_len + nread + 1);
+		if(buf == NULL)
+		{
+			break;
+		}
+
+		memcpy(buf + loader->buf_len, piece, nread);
+		loader->buf = buf;
+		loader->buf_len += nread;
+		loader->buf[loader->buf_len] = '\0';
+
+		take_items(m, /*flush=*/0);
+
+		if(time_in_ms() >= deadline)
+		{
+			break;
+		}
+	}
+
+	if(nread < 0)
+	{
+		finish_loading(m);
+		return 1;
+	}
+
+	return (m->len != old_len);
+}
+
+/* Reads next piece of output of the job without blocking.  Returns number of
+ * read bytes, which is zero if there is no data at the moment, or -1 on
+ * reaching end of the output. */
+static int
+read_job_output(bg_job_t *job, char buf[], size_t buf_len)
+{
+	FILE *const output = job->output;
+	size_t to_read = buf_len;
+
+#ifdef _WIN32
+	/* Simulate asynchronous reading by not reading more than stream has. */
+	HANDLE hpipe = (HANDLE)_get_osfhandle(fileno(output));
+	DWORD bytes_available = 0;
+	if(!PeekNamedPipe(hpipe, NULL, 0, NULL, &bytes_available, NULL))
+	{
+		return -1;
+	}
+	if(bytes_available == 0)
+	{
+		return 0;
+	}
+	if(bytes_available < to_read)
+	{
+		to_read = bytes_available;
+	}
+#endif
+
+	const size_t len = fread(buf, 1, to_read, output);
+	if(len == 0 && (feof(output) || (ferror(output) && errno != EAGAIN)))
+	{
+		return -1;
+	}
+
+	clearerr(output);
+	return len;
+}
+
+/* Turns complete items in loader's buffer into menu items.  Incomplete item is
+ * left in the buffer unless flushing is requested. */
+static void
+take_items(menu_data_t *m, int flush)
+{
+	menu_loader_t *const loader = m->loader;
+	if(loader->buf_len == 0)
+	{
+		return;
+	}
+
+	/* This matches heuristic of synchronous capturing, where null character in
+	 * the output means that items are separated by nulls instead of newlines. */
+	if(!loader->null_sep && memchr(loader->buf, '\0', loader->buf_len) != NULL)
+	{
+		loader->null_sep = 1;
+	}
+
+	const char sep = (loader->null_sep ? '\0' : '\n');
+	size_t len = loader->buf_len;
+	while(!flush && len > 0 && loader->buf[len - 1] != sep)
+	{
+		--len;
+	}
+
+	if(len == 0)
+	{
+		return;
+	}
+
+	int nlines;
+	char **const lines = break_into_lines(loader->buf, len, &nlines,
+			loader->null_sep);
+	int i;
+	for(i = 0; i < nlines; ++i)
+	{
+		output_handler(lines[i], m);
+	}
+	free_string_array(lines, nlines);
+
+	loader->buf_len -= len;
+	memmove(loader->buf, loader->buf + len, loader->buf_len + 1);
+}
+
+/* Finishes loading of menu items.  Incomplete item is dropped if loading was
+ * cancelled. */
+static void
+finish_loading(menu_data_t *m)
+{
+	menu_loader_t *const loader = m->loader;
+	const int cancelled = (loader->cancelled || bg_job_cancelled(loader->job));
+
+	take_items(m, /*flush=*/!cancelled);
+
+	if(cancelled)
 	{
 		append_to_string(&m->title, "(cancelled)");
 		append_to_string(&m->empty_msg, " (cancelled)");
 	}
 
-	return menus_enter(m, view);
+	if(loader->cancelled)
+	{
+		stop_loading(m);
+	}
+	else
+	{
+		free_loader(m);
+	}
+}
+
+/* Stops job of the menu if it's still running and frees the loader. */
+static void
+stop_loading(menu_data_t *m)
+{
+	bg_job_t *const job = m->loader->job;
+	if(bg_job_is_running(job))
+	{
+		(void)bg_job_cancel(job);
+		bg_job_terminate(job);
+	}
+	free_loader(m);
+}
+
+/* Frees loader of the menu. */
+static void
+free_loader(menu_data_t *m)
+{
+	bg_job_decref(m->loader->job);
+	free(m->loader->buf);
+	free(m->loader);
+	m->loader = NULL;
+}
+
+/* Redraws active menu to display newly loaded items unless it was redrawn for
+ * this reason recently. */
+static void
+redraw_loaded_menu(menu_state_t *ms)
+{
+	const long long now = time_in_ms();
+	if(ms->d->loader != NULL &&
+			now - ms->load_redraw_time < LOAD_REDRAW_PERIOD_MS)
+	{
+		return;
+	}
+
+	ms->load_redraw = 0;
+	ms->load_redraw_time = now;
+
+	menus_partial_redraw(ms);
+	menus_set_pos(ms, ms->d->pos);
+	ui_refresh_win(menu_win);
+}
+
+/* Retrieves current time in milliseconds. */
+static long long
+time_in_ms(void)
+{
+	struct timespec current_time;
+	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
+	{
+		return 0;
+	}
+
+	return current_time.tv_sec*1000LL + current_time.tv_nsec/1000000;
 }
 
 void
@@ -1182,10 +1623,6 @@ static int
 search_menu(menu_state_t *ms, int print_errors)
 {
 	menu_data_t *const m = ms->d;
-	int cflags;
-	regex_t re;
-	int err;
-	int i;
 
 	if(ms->matches == NULL)
 	{
@@ -1200,6 +1637,20 @@ search_menu(menu_state_t *ms, int print_errors)
 		return 0;
 	}
 
+	return match_items(ms, 0, print_errors);
+}
+
+/* Marks menu items starting at the specified position that match search
+ * pattern.  Returns non-zero on error. */
+static int
+match_items(menu_state_t *ms, int from, int print_errors)
+{
+	menu_data_t *const m = ms->d;
+	int cflags;
+	regex_t re;
+	int err;
+	int i;
+
 	cflags = get_regexp_cflags(ms->regexp);
 	err = regexp_compile(&re, ms->regexp, cflags);
 	if(err != 0)
@@ -1212,7 +1663,7 @@ search_menu(menu_state_t *ms, int print_errors)
 		return -1;
 	}
 
-	for(i = 0; i < m->len; ++i)
+	for(i = from; i < m->len; ++i)
 	{
 		regmatch_t matches[1];
 		const char *item = m->items[i];
@@ -1230,6 +1681,37 @@ search_menu(menu_state_t *ms, int print_errors)
 	return 0;
 }
 
+/* Updates search matches after new items were appended to the menu starting at
+ * the specified position. */
+static void
+extend_search_matches(menu_state_t *ms, int from)
+{
+	menu_data_t *const m = ms->d;
+	if(ms->matches == NULL || m->len == from)
+	{
+		return;
+	}
+
+	short int (*const matches)[2] = reallocarray(ms->matches, m->len,
+			sizeof(*ms->matches));
+	if(matches == NULL)
+	{
+		/* Search will be redone from scratch on its next use. */
+		free(ms->matches);
+		ms->matches = NULL;
+		ms->matching_entries = 0;
+		return;
+	}
+
+	ms->matches = matches;
+	memset(ms->matches + from, -1, sizeof(*ms->matches)*(m->len - from));
+
+	if(!is_null_or_empty(ms->regexp))
+	{
+		(void)match_items(ms, from, /*print_errors=*/0);
+	}
+}
+
 /* Looks for next matching element in forward direction from current position.
  * Returns new value for save_msg flag. */
 static int
@@ -25,6 +25,7 @@
 #include "../utils/test_helpers.h"
 #include "../macros.h"
 
+struct menu_loader_t;
 struct view_t;
 
 /* Result of handling key sequence by menu-specific shortcut handler. */
@@ -85,6 +86,10 @@ typedef struct menu_data_t
 	 * execute_handler. */
 	int menu_context;
 
+	/* State of loading items from output of a command which hasn't finished yet
+	 * or NULL. */
+	struct menu_loader_t *loader;
+
 	menu_state_t *state; /* Opaque pointer to menu mode state. */
 	int initialized;     /* Marker that shows whether menu data needs freeing. */
 }
@@ -150,6 +155,19 @@ int menus_to_custom_view(menu_state_t *ms, struct view_t *view, int very);
 int menus_capture(struct view_t *view, const char cmd[], int user_sh,
 		menu_data_t *m, MacroFlags flags);
 
+/* Same as menus_capture(), but makes a menu out of combined output of several
+ * commands, which are run one after another.  Returns non-zero if status bar
+ * message should be saved. */
+int menus_capture_batch(struct view_t *view, char *cmds[], int ncmds,
+		int user_sh, menu_data_t *m, MacroFlags flags);
+
+/* Same as menus_capture(), but runs the command in background and enters the
+ * menu as soon as the first item is available.  The rest of items is appended
+ * by menus_check_for_updates() while the menu is in use.  Returns non-zero if
+ * status bar message should be saved. */
+int menus_capture_async(struct view_t *view, const char cmd[], menu_data_t *m,
+		MacroFlags flags);
+
 /* Menu drawing. */
 
 /* Erases current menu item in menu window. */
@@ -179,6 +197,20 @@ int menus_goto_file(menu_data_t *m, struct view_t *view, const char spec[],
 /* Navigates to directory from a menu. */
 void menus_goto_dir(struct view_t *view, const char path[]);
 
+/* Menu loading. */
+
+/* Appends items that became available to menus which are still being loaded.
+ * Redraws active menu if it has changed, but not too often. */
+void menus_check_for_updates(void);
+
+/* Checks whether any of the menus (active or stashed ones) is still being
+ * loaded.  Returns non-zero if so. */
+int menus_are_loading(void);
+
+/* Stops loading of the active menu keeping items that were loaded so far.
+ * Returns non-zero if the menu was being loaded. */
+int menus_cancel_loading(menu_state_t *ms);
+
 /* Menu search. */
 
 /* Performs search of pattern among menu items.  NULL pattern requests use of
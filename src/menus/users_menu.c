@@ -31,7 +31,7 @@ static KHandlerResponse users_khandler(view_t *view, menu_data_t *m,
 		const wchar_t keys[]);
 
 int
-show_user_menu(view_t *view, const char command[], const char title[],
+show_user_menu(view_t *view, char *cmds[], int ncmds, const char title[],
 		MacroFlags flags)
 {
 	static menu_data_t m;
@@ -44,7 +44,7 @@ show_user_menu(view_t *view, const char command[], const char title[],
 	m.execute_handler = &execute_users_cb;
 	m.key_handler = &users_khandler;
 
-	return menus_capture(view, command, 1, &m, flags);
+	return menus_capture_batch(view, cmds, ncmds, /*user_sh=*/1, &m, flags);
 }
 
 /* Callback that is called when menu item is selected.  Should return non-zero
@@ -24,9 +24,9 @@
 
 struct view_t;
 
-/* Creates menu out of output of the command.  Returns non-zero if status bar
- * message should be saved. */
-int show_user_menu(struct view_t *view, const char command[],
+/* Creates menu out of output of the commands, which are run one by one.
+ * Returns non-zero if status bar message should be saved. */
+int show_user_menu(struct view_t *view, char *cmds[], int ncmds,
 		const char title[], MacroFlags flags);
 
 #endif /* VIFM__MENUS__USERS_MENU_H__ */
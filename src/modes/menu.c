@@ -72,6 +72,7 @@ static int key_handler(wchar_t key);
 static void cmd_ctrl_b(key_info_t key_info, keys_info_t *keys_info);
 static int can_scroll_menu_up(const menu_data_t *menu);
 static void cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info);
+static void cmd_leave(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_d(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_e(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_f(key_info_t key_info, keys_info_t *keys_info);
@@ -132,7 +133,7 @@ static int saved_top, saved_pos;
 
 static keys_add_info_t builtin_cmds[] = {
 	{WK_C_b,     {{&cmd_ctrl_b},  .descr = "scroll page up"}},
-	{WK_C_c,     {{&cmd_ctrl_c},  .descr = "leave menu mode"}},
+	{WK_C_c,     {{&cmd_ctrl_c},  .descr = "stop loading or leave menu mode"}},
 	{WK_C_d,     {{&cmd_ctrl_d},  .descr = "scroll half-page down"}},
 	{WK_C_e,     {{&cmd_ctrl_e},  .descr = "scroll one line down"}},
 	{WK_C_f,     {{&cmd_ctrl_f},  .descr = "scroll page down"}},
@@ -142,7 +143,7 @@ static keys_add_info_t builtin_cmds[] = {
 	{WK_C_p,     {{&cmd_k},       .descr = "go to item above"}},
 	{WK_C_u,     {{&cmd_ctrl_u},  .descr = "scroll half-page up"}},
 	{WK_C_y,     {{&cmd_ctrl_y},  .descr = "scroll one line up"}},
-	{WK_ESC,     {{&cmd_ctrl_c},  .descr = "leave menu mode"}},
+	{WK_ESC,     {{&cmd_leave},   .descr = "leave menu mode"}},
 	{WK_SLASH,   {{&cmd_slash},   .descr = "search forward"}},
 	{WK_PERCENT, {{&cmd_percent}, .descr = "go to [count]% position"}},
 	{WK_COLON,   {{&cmd_colon},   .descr = "go to cmdline mode"}},
@@ -153,8 +154,8 @@ static keys_add_info_t builtin_cmds[] = {
 	{WK_L,       {{&cmd_L},       .descr = "go to bottom of viewport"}},
 	{WK_M,       {{&cmd_M},       .descr = "go to middle of viewport"}},
 	{WK_N,       {{&cmd_N},       .descr = "go to previous search match"}},
-	{WK_Z WK_Z,  {{&cmd_ctrl_c},  .descr = "leave menu mode"}},
-	{WK_Z WK_Q,  {{&cmd_ctrl_c},  .descr = "leave menu mode"}},
+	{WK_Z WK_Z,  {{&cmd_leave},   .descr = "leave menu mode"}},
+	{WK_Z WK_Q,  {{&cmd_leave},   .descr = "leave menu mode"}},
 	{WK_b,       {{&cmd_b},       .descr = "make custom view"}},
 	{WK_d WK_d,  {{&cmd_dd},      .descr = "remove files"}},
 	{WK_g WK_f,  {{&cmd_gf},      .descr = "navigate to file location"}},
@@ -163,7 +164,7 @@ static keys_add_info_t builtin_cmds[] = {
 	{WK_k,       {{&cmd_k},       .descr = "go to item above"}},
 	{WK_l,       {{&cmd_return},  .descr = "pick current item"}},
 	{WK_n,       {{&cmd_n},       .descr = "go to next search match"}},
-	{WK_q,       {{&cmd_ctrl_c},  .descr = "leave menu mode"}},
+	{WK_q,       {{&cmd_leave},   .descr = "leave menu mode"}},
 	{WK_v,       {{&cmd_v},       .descr = "use items as Vim quickfix list"}},
 	{WK_z WK_b,  {{&cmd_zb},      .descr = "push cursor to the bottom"}},
 	{WK_z WK_H,  {{&cmd_zH},      .descr = "scroll page left"}},
@@ -415,8 +416,19 @@ can_scroll_menu_up(const menu_data_t *menu)
 	return menu->top > 0;
 }
 
+/* Stops loading of menu items if it's in progress, otherwise leaves the
+ * mode. */
 static void
 cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info)
+{
+	if(!menus_cancel_loading(menu->state))
+	{
+		leave_menu_mode(1);
+	}
+}
+
+static void
+cmd_leave(key_info_t key_info, keys_info_t *keys_info)
 {
 	leave_menu_mode(1);
 }
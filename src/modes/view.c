@@ -25,10 +25,10 @@
 
 #include <assert.h> /* assert() */
 #include <limits.h> /* INT_MAX */
-#include <stddef.h> /* ptrdiff_t size_t */
-#include <string.h> /* memset() strdup() */
+#include <stddef.h> /* size_t */
+#include <string.h> /* memcpy() memset() strdup() */
 #include <stdio.h>  /* snprintf() */
-#include <stdlib.h> /* free() */
+#include <stdlib.h> /* free() realloc() */
 
 #include "../cfg/config.h"
 #include "../compat/curses.h"
@@ -45,9 +45,12 @@
 #include "../ui/quickview.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/darray.h"
 #include "../utils/filemon.h"
 #include "../utils/fs.h"
+#include "../utils/fswatch.h"
 #include "../utils/macros.h"
+#include "../utils/mfile.h"
 #include "../utils/path.h"
 #include "../utils/regexp.h"
 #include "../utils/str.h"
@@ -66,6 +69,21 @@
 #include "normal.h"
 #include "wk.h"
 
+/* Number of bytes of an mfile to index on each check for updates. */
+enum { INDEX_CHUNK_SIZE = 32*1024*1024 };
+
+/* Number of lines to check for search matches on each step. */
+enum { SEARCH_CHUNK_SIZE = 8192 };
+
+/* Result of looking up a search match. */
+typedef enum
+{
+	SR_FOUND,     /* Match was found and view was scrolled to it. */
+	SR_NOT_FOUND, /* There is no match in the requested direction. */
+	SR_PENDING,   /* Not enough lines was scanned to decide. */
+}
+SearchResult;
+
 /* Named boolean values of "silent" parameter for better readability. */
 enum
 {
@@ -77,26 +95,44 @@ enum
 struct modview_info_t
 {
 	/* Data of the view. */
-	char **lines;     /* List of real lines (owned by vcache unit). */
-	int (*widths)[2]; /* (virtual line, screen width) pair per real line. */
-	int nlines;       /* Number of real lines. */
-	int nlinesv;      /* Number of virtual (possibly wrapped) lines. */
-	int line;         /* Current real line number (first visible line). */
-	int linev;        /* Current virtual line number. */
+	char **lines;        /* List of real lines (owned by vcache unit). */
+	mfile_t *mfile;      /* Source of lines instead of the list above for
+	                        regular files viewed without a viewer. */
+	char *line_buf;      /* Null-terminated copy of a line of mfile. */
+	size_t line_buf_len; /* Size of line_buf. */
+	int nlines;          /* Number of real lines (known so far for mfile). */
+	int line;            /* Current real line number (first visible line). */
+	int subline;         /* Virtual line of the current real line that's the
+	                        first one visible. */
 
 	/* Dimensions, units of actions. */
 	int win_size; /* Scroll window size. */
 	int half_win; /* Height of a "page" (can be changed). */
-	int width;    /* Last width used for breaking lines. */
 
 	/* Monitoring of changes for automatic forwarding. */
 	int auto_forward;   /* Whether auto forwarding (tail -F) is enabled. */
-	filemon_t file_mon; /* File monitor for auto forwarding mode. */
+	fswatch_t *watch;   /* Watcher of the file in auto forwarding mode. */
+	filemon_t file_mon; /* File monitor for when watcher isn't available. */
 
 	/* Related to search. */
 	regex_t re;               /* Search regular expression. */
 	int last_search_backward; /* Value -1 means no search was performed. */
 	int search_repeat;        /* Saved count prefix of search commands. */
+	char *search_pattern;     /* Pattern of the last search. */
+	int search_cflags;        /* Flags with which the pattern was compiled. */
+
+	/* Index of matches of the search pattern.  It's built in steps while idle
+	 * to not block on large files. */
+	int *matches;           /* Sorted list of lines that contain a match. */
+	DA_INSTANCE_FIELD(matches);
+	int scanned;            /* Number of lines that were matched already. */
+	int scan_done;          /* Whether all lines were matched. */
+	int scan_paused;        /* Whether scanning was cancelled by the user. */
+	int scan_width;         /* Width of the view during the scan. */
+	int scan_wrap;          /* Whether lines were wrapped during the scan. */
+	int pending_jumps;      /* Number of jumps waiting for more scanned lines. */
+	int pending_backward;   /* Direction of the pending jumps. */
+	int reported;           /* Whether progress of the search was reported. */
 
 	/* Viewers. */
 	strlist_t viewers;       /* List of viewers of current file. */
@@ -111,7 +147,6 @@ struct modview_info_t
 	int detached;     /* Whether view mode was detached. */
 	ViewerKind kind;  /* Kind of preview. */
 	MacroFlags flags; /* Macro flags for ext_viewer. */
-	int wrap;         /* Whether lines are wrapped. */
 	int raw;          /* Forced raw preview. */
 };
 
@@ -129,12 +164,17 @@ static void reset_view_info(modview_info_t *vi);
 static void init_view_info(modview_info_t *vi);
 static void free_view_info(modview_info_t *vi);
 static void redraw(void);
-static void calc_vlines(void);
-static void calc_vlines_wrapped(modview_info_t *vi);
-static void calc_vlines_non_wrapped(modview_info_t *vi);
+static void fix_position(modview_info_t *vi);
+static int has_line(modview_info_t *vi, int line);
+static int line_count(modview_info_t *vi);
+static const char * get_line(modview_info_t *vi, int line);
+static int line_height(modview_info_t *vi, int line);
+static int count_rows(modview_info_t *vi, int max);
+static int scroll_down(modview_info_t *vi, int n);
+static int scroll_up(modview_info_t *vi, int n);
 static void draw(void);
-static int get_part(const char line[], int offset, size_t max_len, char part[]);
 static void display_error(const char error_msg[]);
+static void cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_l(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_wH(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_ctrl_wJ(key_info_t key_info, keys_info_t *keys_info);
@@ -186,8 +226,15 @@ static void cmd_k(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_n(key_info_t key_info, keys_info_t *keys_info);
 static void goto_search_result(int repeat_count, int inverse_direction);
 static void search(int repeat_count, int backward);
-static int find_previous(void);
-static int find_next(void);
+static SearchResult navigate(int repeat_count, int backward);
+static SearchResult find_previous(void);
+static SearchResult find_next(void);
+static int scan_for_matches(modview_info_t *vi);
+static void drop_matches(modview_info_t *vi, int from);
+static size_t find_match_pos(const modview_info_t *vi, int line);
+static void report_search_progress(modview_info_t *vi, SearchResult result);
+static int match_line(modview_info_t *vi, int line, int from, int to,
+		int backward);
 static void cmd_q(key_info_t key_info, keys_info_t *keys_info);
 static void cmd_u(key_info_t key_info, keys_info_t *keys_info);
 static void update_with_half_win(key_info_t *key_info);
@@ -197,7 +244,9 @@ static void cmd_z(key_info_t key_info, keys_info_t *keys_info);
 static void update_with_win(key_info_t *key_info);
 static int is_trying_the_same_file(void);
 static int get_file_to_explore(const view_t *view, char buf[], size_t buf_len);
+static int index_in_background(modview_info_t *vi);
 static int forward_if_changed(modview_info_t *vi);
+static int apply_file_changes(modview_info_t *vi, int replaced);
 static int scroll_to_bottom(modview_info_t *vi);
 static void reload_view(modview_info_t *vi, int silent);
 static void cleanup(modview_info_t *vi);
@@ -215,6 +264,7 @@ static modview_info_t *vi;
 
 static keys_add_info_t builtin_cmds[] = {
 	{WK_C_b,           {{&cmd_b},      .descr = "scroll page up"}},
+	{WK_C_c,           {{&cmd_ctrl_c}, .descr = "cancel search"}},
 	{WK_C_d,           {{&cmd_d},      .descr = "scroll half-page down"}},
 	{WK_C_e,           {{&cmd_j},      .descr = "scroll one line down"}},
 	{WK_C_f,           {{&cmd_f},      .descr = "scroll page down"}},
@@ -478,13 +528,24 @@ modview_post(void)
 void
 modview_ruler_update(void)
 {
-	char rel_pos[32];
-	format_position(rel_pos, sizeof(rel_pos), vi->line, vi->nlines,
-			vi->view->window_rows);
-
 	char buf[64];
+	char rel_pos[32];
 	int curr_line = vi->line + (vi->nlines > 0 ? 1 : 0);
-	snprintf(buf, sizeof(buf), "%d-%d %s", curr_line, vi->nlines, rel_pos);
+
+	if(vi->mfile != NULL && !mfile_is_indexed(vi->mfile))
+	{
+		/* Total number of lines isn't known yet, so estimate position by
+		 * offset. */
+		const size_t offset = mfile_line_offset(vi->mfile, vi->line);
+		const int percent = (int)((double)offset*100/mfile_size(vi->mfile));
+		snprintf(buf, sizeof(buf), "%d-%d+ %d%%", curr_line, vi->nlines, percent);
+	}
+	else
+	{
+		format_position(rel_pos, sizeof(rel_pos), vi->line, vi->nlines,
+				vi->view->window_rows);
+		snprintf(buf, sizeof(buf), "%d-%d %s", curr_line, vi->nlines, rel_pos);
+	}
 
 	ui_ruler_set(buf);
 }
@@ -579,7 +640,6 @@ init_view_info(modview_info_t *vi)
 	memset(vi, '\0', sizeof(*vi));
 	vi->win_size = -1;
 	vi->half_win = -1;
-	vi->width = -1;
 	vi->last_search_backward = -1;
 	vi->search_repeat = NO_COUNT_GIVEN;
 }
@@ -589,7 +649,11 @@ static void
 free_view_info(modview_info_t *vi)
 {
 	free_string_array(vi->viewers.items, vi->viewers.nitems);
-	free(vi->widths);
+	mfile_free(vi->mfile);
+	free(vi->line_buf);
+	fswatch_free(vi->watch);
+	free(vi->search_pattern);
+	DA_REMOVE_ALL(vi->matches);
 	if(vi->last_search_backward != -1)
 	{
 		regfree(&vi->re);
@@ -598,64 +662,184 @@ free_view_info(modview_info_t *vi)
 	free(vi->ext_viewer);
 }
 
-/* Updates line width and redraws the view. */
+/* Corrects position after changes in data or dimensions and redraws the
+ * view. */
 static void
 redraw(void)
 {
 	ui_view_title_update(vi->view);
-	calc_vlines();
+	fix_position(vi);
 	draw();
 }
 
-/* Recalculates virtual lines of a view if display options require it. */
+/* Makes sure that current position points to an existing virtual line. */
 static void
-calc_vlines(void)
+fix_position(modview_info_t *vi)
 {
-	/* Skip the recalculation if window size and wrapping options are the same. */
-	if(ui_qv_width(vi->view) == vi->width && vi->wrap == cfg.wrap_quick_view)
+	if(!has_line(vi, vi->line))
 	{
-		return;
+		vi->line = MAX(line_count(vi) - 1, 0);
+		vi->subline = 0;
+	}
+	else
+	{
+		vi->subline = MIN(vi->subline, line_height(vi, vi->line) - 1);
 	}
+}
 
-	vi->width = ui_qv_width(vi->view);
-	vi->wrap = cfg.wrap_quick_view;
+/* Checks whether real line exists.  Indexes the file up to the line if
+ * necessary.  Returns non-zero if so, otherwise zero is returned. */
+static int
+has_line(modview_info_t *vi, int line)
+{
+	if(vi->mfile == NULL)
+	{
+		return (line >= 0 && line < vi->nlines);
+	}
 
-	if(vi->wrap)
+	const int exists = mfile_has_line(vi->mfile, line);
+	vi->nlines = mfile_known_lines(vi->mfile);
+	return exists;
+}
+
+/* Retrieves total number of real lines.  Indexes the whole file if
+ * necessary.  Returns the number. */
+static int
+line_count(modview_info_t *vi)
+{
+	if(vi->mfile != NULL)
 	{
-		calc_vlines_wrapped(vi);
+		vi->nlines = mfile_line_count(vi->mfile);
 	}
-	else
+	return vi->nlines;
+}
+
+/* Retrieves real line by its number, which must exist.  Returns pointer to the
+ * line, which might be valid only until the next call. */
+static const char *
+get_line(modview_info_t *vi, int line)
+{
+	if(vi->mfile == NULL)
+	{
+		return vi->lines[line];
+	}
+
+	size_t len;
+	const char *const data = mfile_line(vi->mfile, line, &len);
+	if(data == NULL)
 	{
-		calc_vlines_non_wrapped(vi);
+		return "";
 	}
+
+	if(len + 1U > vi->line_buf_len)
+	{
+		char *const buf = realloc(vi->line_buf, len + 1U);
+		if(buf == NULL)
+		{
+			return "";
+		}
+		vi->line_buf = buf;
+		vi->line_buf_len = len + 1U;
+	}
+
+	memcpy(vi->line_buf, data, len);
+	vi->line_buf[len] = '\0';
+	return vi->line_buf;
 }
 
-/* Recalculates virtual lines of a view with line wrapping. */
-static void
-calc_vlines_wrapped(modview_info_t *vi)
+/* Computes number of virtual lines that real line occupies on the screen.
+ * Returns the number. */
+static int
+line_height(modview_info_t *vi, int line)
 {
-	int i;
-	vi->nlinesv = 0;
-	for(i = 0; i < vi->nlines; i++)
+	const int width = ui_qv_width(vi->view);
+	if(!cfg.wrap_quick_view || width <= 0)
 	{
-		vi->widths[i][0] = vi->nlinesv++;
-		vi->widths[i][1] = utf8_strsw_with_tabs(vi->lines[i], cfg.tab_stop) -
-			esc_str_overhead(vi->lines[i]);
-		vi->nlinesv += vi->widths[i][1]/vi->width;
+		return 1;
 	}
+
+	const char *const text = get_line(vi, line);
+	const int text_width = utf8_strsw_with_tabs(text, cfg.tab_stop)
+	                     - esc_str_overhead(text);
+	return MAX(DIV_ROUND_UP(text_width, width), 1);
 }
 
-/* Recalculates virtual lines of a view without line wrapping. */
-static void
-calc_vlines_non_wrapped(modview_info_t *vi)
+/* Counts virtual lines starting with the first visible one, but stops after
+ * reaching the limit.  Returns the number, which is never greater than the
+ * limit. */
+static int
+count_rows(modview_info_t *vi, int max)
 {
-	int i;
-	vi->nlinesv = vi->nlines;
-	for(i = 0; i < vi->nlines; i++)
+	if(!has_line(vi, vi->line))
+	{
+		return 0;
+	}
+
+	int rows = line_height(vi, vi->line) - vi->subline;
+	int l = vi->line + 1;
+	while(rows < max && has_line(vi, l))
+	{
+		rows += line_height(vi, l++);
+	}
+	return MIN(rows, max);
+}
+
+/* Moves position down by at most n virtual lines.  Returns number of virtual
+ * lines by which position was changed. */
+static int
+scroll_down(modview_info_t *vi, int n)
+{
+	int moved = 0;
+	while(moved < n && has_line(vi, vi->line))
+	{
+		const int left = line_height(vi, vi->line) - 1 - vi->subline;
+		if(n - moved <= left)
+		{
+			vi->subline += n - moved;
+			moved = n;
+			break;
+		}
+
+		if(!has_line(vi, vi->line + 1))
+		{
+			vi->subline += left;
+			moved += left;
+			break;
+		}
+
+		moved += left + 1;
+		++vi->line;
+		vi->subline = 0;
+	}
+	return moved;
+}
+
+/* Moves position up by at most n virtual lines.  Returns number of virtual
+ * lines by which position was changed. */
+static int
+scroll_up(modview_info_t *vi, int n)
+{
+	int moved = 0;
+	while(moved < n)
 	{
-		vi->widths[i][0] = i;
-		vi->widths[i][1] = vi->width;
+		if(vi->subline > 0)
+		{
+			const int delta = MIN(vi->subline, n - moved);
+			vi->subline -= delta;
+			moved += delta;
+		}
+		else if(vi->line > 0)
+		{
+			--vi->line;
+			vi->subline = line_height(vi, vi->line) - 1;
+			++moved;
+		}
+		else
+		{
+			break;
+		}
 	}
+	return moved;
 }
 
 static void
@@ -664,7 +848,7 @@ draw(void)
 	int l, vl;
 	const int height = ui_qv_height(vi->view);
 	const int width = ui_qv_width(vi->view);
-	const int max_l = MIN(vi->line + height, vi->nlines);
+	const int wrap = cfg.wrap_quick_view;
 	const int searched = (vi->last_search_backward != -1);
 	esc_state state;
 
@@ -692,23 +876,22 @@ draw(void)
 	ui_view_erase(vi->view, 1);
 	ui_drop_attr(vi->view->win);
 
-	for(vl = 0, l = vi->line; l < max_l && vl < height; ++l)
+	for(vl = 0, l = vi->line; vl < height && has_line(vi, l); ++l)
 	{
 		int offset = 0;
 		int processed = 0;
-		char *const line = vi->lines[l];
-		char *p = searched ? esc_highlight_pattern(line, &vi->re) : line;
+		const char *const line = get_line(vi, l);
+		char *p = searched ? esc_highlight_pattern(line, &vi->re) : (char *)line;
 		do
 		{
 			int printed;
-			const int vis = l != vi->line
-			             || vl + processed >= vi->linev - vi->widths[vi->line][0];
+			const int vis = (l != vi->line || processed >= vi->subline);
 			offset += esc_print_line(p + offset, vi->view->win, ui_qv_left(vi->view),
-					ui_qv_top(vi->view) + vl, width, !vis, !vi->wrap, &state, &printed);
+					ui_qv_top(vi->view) + vl, width, !vis, !wrap, &state, &printed);
 			vl += vis;
 			++processed;
 		}
-		while(vi->wrap && p[offset] != '\0' && vl < height);
+		while(wrap && p[offset] != '\0' && vl < height);
 		if(searched)
 		{
 			free(p);
@@ -727,10 +910,12 @@ modview_find(const char pattern[], int backward)
 	if(pattern == NULL)
 		return 0;
 
+	const int cflags = get_regexp_cflags(pattern);
+
 	if(vi->last_search_backward != -1)
 		regfree(&vi->re);
 	vi->last_search_backward = -1;
-	if((err = regexp_compile(&vi->re, pattern, get_regexp_cflags(pattern))) != 0)
+	if((err = regexp_compile(&vi->re, pattern, cflags)) != 0)
 	{
 		ui_sb_errf("Invalid pattern: %s", get_regexp_error(err, &vi->re));
 		regfree(&vi->re);
@@ -740,11 +925,35 @@ modview_find(const char pattern[], int backward)
 
 	vi->last_search_backward = backward;
 
+	/* Index of matches remains valid as long as the pattern is the same. */
+	if(vi->search_pattern == NULL || strcmp(vi->search_pattern, pattern) != 0 ||
+			vi->search_cflags != cflags)
+	{
+		replace_string(&vi->search_pattern, pattern);
+		vi->search_cflags = cflags;
+		drop_matches(vi, 0);
+	}
+
 	search(vi->search_repeat, backward);
 
 	return curr_stats.save_msg;
 }
 
+/* Stops search that's still in progress. */
+static void
+cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info)
+{
+	if(vi->last_search_backward == -1 || vi->scan_done || vi->scan_paused)
+	{
+		return;
+	}
+
+	vi->scan_paused = 1;
+	vi->pending_jumps = 0;
+	vi->reported = 0;
+	ui_sb_msg("Search was cancelled");
+}
+
 static void
 cmd_ctrl_l(key_info_t key_info, keys_info_t *keys_info)
 {
@@ -950,7 +1159,8 @@ cmd_meta_space(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(vi->nlines == 0)
+	const int nlines = line_count(vi);
+	if(nlines == 0)
 	{
 		return;
 	}
@@ -960,10 +1170,10 @@ cmd_percent(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count > 100)
 		key_info.count = 100;
 
-	vi->line = (key_info.count*vi->nlinesv)/100;
-	if(vi->line >= vi->nlines)
-		vi->line = vi->nlines - 1;
-	vi->linev = vi->widths[vi->line][0];
+	vi->line = ((long long)key_info.count*nlines)/100;
+	if(vi->line >= nlines)
+		vi->line = nlines - 1;
+	vi->subline = 0;
 	draw();
 }
 
@@ -1028,9 +1238,17 @@ static void
 cmd_F(key_info_t key_info, keys_info_t *keys_info)
 {
 	vi->auto_forward = !vi->auto_forward;
+
+	fswatch_free(vi->watch);
+	vi->watch = NULL;
+
 	if(vi->auto_forward)
 	{
-		if(forward_if_changed(vi) || scroll_to_bottom(vi))
+		vi->watch = fswatch_create(vi->filename);
+		memset(&vi->file_mon, 0, sizeof(vi->file_mon));
+
+		/* Catch up with changes made since the file was loaded. */
+		if(apply_file_changes(vi, 0) || scroll_to_bottom(vi))
 		{
 			draw();
 		}
@@ -1087,22 +1305,6 @@ load_view_data(modview_info_t *vi, const char action[],
 		return 1;
 	}
 
-	if(vi->nlines == 0)
-	{
-		vi->widths = NULL;
-	}
-	else
-	{
-		vi->widths = reallocarray(NULL, vi->nlines, sizeof(*vi->widths));
-		if(vi->widths == NULL)
-		{
-			vi->lines = NULL;
-			vi->nlines = 0;
-			show_error_msg(action, "Not enough memory");
-			return 1;
-		}
-	}
-
 	return 0;
 }
 
@@ -1127,15 +1329,31 @@ get_view_data(modview_info_t *vi, const char file_to_view[])
 	};
 	curr_stats.preview_hint = &parea;
 
-	const char *error;
+	const char *error = NULL;
 	const char *viewer = (vi->raw ? NULL : vi->curr_viewer);
+	const int builtin = (vi->curr_viewer == vi->ext_viewer)
+	                  ? (vi->ext_viewer == NULL)
+	                  : (viewer == NULL);
 
-	strlist_t lines;
-	if(vi->curr_viewer == vi->ext_viewer)
+	mfile_free(vi->mfile);
+	vi->mfile = NULL;
+
+	strlist_t lines = {};
+	if(builtin && is_regular_file(file_to_view))
+	{
+		/* Map file instead of reading it to not load all of its contents into
+		 * memory, which matters for large files. */
+		vi->mfile = mfile_open(file_to_view);
+		if(vi->mfile == NULL)
+		{
+			error = "Failed to read file's contents";
+		}
+	}
+	else if(vi->curr_viewer == vi->ext_viewer)
 	{
 		/* No macros in this viewer. */
 		lines = vcache_lookup(file_to_view, vi->ext_viewer, vi->flags, kind,
-				INT_MAX, VC_SYNC, &error);
+				INT_MAX, VC_SYNC, &qv_is_previewed, &error);
 	}
 	else
 	{
@@ -1144,7 +1362,7 @@ get_view_data(modview_info_t *vi, const char file_to_view[])
 		               ? NULL
 		               : qv_expand_viewer(curr_view, viewer, &flags);
 		lines = vcache_lookup(file_to_view, expanded, flags, kind, INT_MAX, VC_SYNC,
-				&error);
+				&qv_is_previewed, &error);
 		free(expanded);
 	}
 
@@ -1152,7 +1370,7 @@ get_view_data(modview_info_t *vi, const char file_to_view[])
 	curr_stats.preview_hint = NULL;
 
 	vi->lines = lines.items;
-	vi->nlines = lines.nitems;
+	vi->nlines = (vi->mfile == NULL ? lines.nitems : 0);
 
 	vi->kind = kind;
 
@@ -1202,14 +1420,22 @@ replace_vi(modview_info_t *orig, modview_info_t *new)
 		orig->last_search_backward = -1;
 	}
 
+	/* Contents might have changed, so only the pattern is preserved. */
+	new->search_pattern = orig->search_pattern;
+	new->search_cflags = orig->search_cflags;
+	orig->search_pattern = NULL;
+
 	new->win_size = orig->win_size;
 	new->half_win = orig->half_win;
 	new->line = orig->line;
-	new->linev = orig->linev;
+	new->subline = orig->subline;
 	new->view = orig->view;
 	new->auto_forward = orig->auto_forward;
 	new->file_mon = orig->file_mon;
 
+	new->watch = orig->watch;
+	orig->watch = NULL;
+
 	free_view_info(orig);
 	*orig = *new;
 }
@@ -1295,16 +1521,23 @@ cmd_g(key_info_t key_info, keys_info_t *keys_info)
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
 
-	key_info.count = MIN(vi->nlinesv - ui_qv_height(vi->view), key_info.count);
-	key_info.count = MAX(1, key_info.count);
-
-	if(vi->nlines == 0 || vi->linev == vi->widths[key_info.count - 1][0])
+	if(!has_line(vi, 0))
 	{
 		return;
 	}
 
-	vi->line = key_info.count - 1;
-	vi->linev = vi->widths[vi->line][0];
+	const int line = MAX(1, key_info.count) - 1;
+	vi->line = (has_line(vi, line) ? line : line_count(vi) - 1);
+	vi->subline = 0;
+
+	/* Don't leave empty space at the bottom unless the view is too short. */
+	const int height = ui_qv_height(vi->view);
+	const int rows = count_rows(vi, height);
+	if(rows < height)
+	{
+		(void)scroll_up(vi, height - rows);
+	}
+
 	draw();
 }
 
@@ -1322,52 +1555,29 @@ cmd_i(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_j(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(key_info.reg == NO_REG_GIVEN)
-	{
-		if((vi->linev + 1) + ui_qv_height(vi->view) > vi->nlinesv)
-			return;
-	}
-	else
-	{
-		if(vi->linev + 1 > vi->nlinesv)
-			return;
-	}
+	/* Number of virtual lines to keep visible. */
+	const int reserve = (key_info.reg == NO_REG_GIVEN)
+	                  ? ui_qv_height(vi->view)
+	                  : 1;
 
 	if(key_info.count == NO_COUNT_GIVEN)
 		key_info.count = 1;
-	if(key_info.reg == NO_REG_GIVEN)
-		key_info.count = MIN(key_info.count,
-				vi->nlinesv - ui_qv_height(vi->view) - vi->linev);
-	else
-		key_info.count = MIN(key_info.count, vi->nlinesv - vi->linev - 1);
-
-	while(key_info.count-- > 0)
-	{
-		const int height = MAX(DIV_ROUND_UP(vi->widths[vi->line][1], vi->width), 1);
-		if(vi->linev + 1 >= vi->widths[vi->line][0] + height)
-			++vi->line;
 
-		++vi->linev;
-	}
+	const int rows = count_rows(vi, key_info.count + reserve);
+	if(rows <= reserve)
+		return;
 
+	(void)scroll_down(vi, MIN(key_info.count, rows - reserve));
 	draw();
 }
 
 static void
 cmd_k(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(vi->linev == 0)
+	if(vi->line == 0 && vi->subline == 0)
 		return;
 
-	int repeat_count = MIN(def_count(key_info.count), vi->linev);
-	while(repeat_count-- > 0)
-	{
-		if(vi->linev - 1 < vi->widths[vi->line][0])
-			--vi->line;
-
-		--vi->linev;
-	}
-
+	(void)scroll_up(vi, def_count(key_info.count));
 	draw();
 }
 
@@ -1386,7 +1596,8 @@ goto_search_result(int repeat_count, int inverse_direction)
 	search(repeat_count, backward);
 }
 
-/* Performs search and navigation to the first match. */
+/* Performs search and navigation to the first match.  If the result depends
+ * on lines that weren't matched yet, navigation is postponed until they are. */
 static void
 search(int repeat_count, int backward)
 {
@@ -1400,143 +1611,264 @@ search(int repeat_count, int backward)
 		repeat_count = 1;
 	}
 
-	while(repeat_count-- > 0)
+	vi->pending_jumps = 0;
+	vi->scan_paused = 0;
+	(void)scan_for_matches(vi);
+
+	report_search_progress(vi, navigate(repeat_count, backward));
+}
+
+/* Performs up to repeat_count jumps to search matches in the specified
+ * direction.  Returns result of the last jump. */
+static SearchResult
+navigate(int repeat_count, int backward)
+{
+	SearchResult result = SR_NOT_FOUND;
+	while(repeat_count > 0)
 	{
-		if(backward ? find_previous() : find_next())
+		result = (backward ? find_previous() : find_next());
+		if(result == SR_PENDING)
 		{
+			vi->pending_jumps = repeat_count;
+			vi->pending_backward = backward;
 			break;
 		}
+		if(result == SR_NOT_FOUND)
+		{
+			break;
+		}
+		--repeat_count;
 	}
+	return result;
 }
 
-/* Scrolls to the previous search match.  Returns zero on success and non-zero
- * if pattern wasn't found.  Prints a message on search failure. */
-static int
+/* Scrolls to the previous search match.  Prints a message on search failure.
+ * Returns result of the lookup. */
+static SearchResult
 find_previous(void)
 {
-	if(vi->linev == 0)
+	if(vi->line == 0 && vi->subline == 0)
 	{
 		draw();
 		display_error("Nothing to search");
-		return 1;
+		return SR_NOT_FOUND;
 	}
 
-	char buf[ui_qv_width(vi->view)*4];
+	int line = vi->line;
+	int subline = (vi->subline > 0)
+	            ? match_line(vi, vi->line, 0, vi->subline - 1, 1)
+	            : -1;
+	if(subline < 0)
+	{
+		if(vi->scanned < vi->line && !vi->scan_done)
+		{
+			return SR_PENDING;
+		}
 
-	int vl = vi->linev - 1;
-	int l = vi->line;
+		const size_t pos = find_match_pos(vi, vi->line);
+		if(pos == 0U)
+		{
+			draw();
+			display_error("Pattern not found");
+			return SR_NOT_FOUND;
+		}
 
-	if(l > 0 && vl < vi->widths[l][0])
-	{
-		--l;
+		line = vi->matches[pos - 1U];
+		subline = match_line(vi, line, 0, line_height(vi, line) - 1, 1);
 	}
 
-	int i;
-	int offset = 0;
-	for(i = 0; l < vi->nlines && i <= vl - vi->widths[l][0]; ++i)
-	{
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-	}
+	vi->line = line;
+	vi->subline = MAX(subline, 0);
+	draw();
+	return SR_FOUND;
+}
 
-	/* Don't stop until we go above first virtual line of the first line. */
-	while(l >= 0 && vl >= 0)
+/* Scrolls to the next search match.  Prints a message on search failure.
+ * Returns result of the lookup. */
+static SearchResult
+find_next(void)
+{
+	int line = vi->line;
+	int subline = -1;
+	if(has_line(vi, vi->line))
 	{
-		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
+		const int height = line_height(vi, vi->line);
+		if(vi->subline + 1 < height)
 		{
-			vi->linev = vl;
-			vi->line = l;
-			break;
+			subline = match_line(vi, vi->line, vi->subline + 1, height - 1, 0);
 		}
-		if(l > 0 && vl - 1 < vi->widths[l][0])
+	}
+
+	if(subline < 0)
+	{
+		const size_t pos = find_match_pos(vi, vi->line + 1);
+		if(pos == DA_SIZE(vi->matches))
 		{
-			--l;
-			offset = 0;
-			for(i = 0; i <= vl - 1 - vi->widths[l][0]; i++)
-				offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
+			if(!vi->scan_done)
+			{
+				return SR_PENDING;
+			}
+
+			draw();
+			display_error("Pattern not found");
+			return SR_NOT_FOUND;
 		}
-		else
-			offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-		--vl;
+
+		line = vi->matches[pos];
+		subline = match_line(vi, line, 0, line_height(vi, line) - 1, 0);
 	}
 
+	vi->line = line;
+	vi->subline = MAX(subline, 0);
 	draw();
-
-	if(vi->linev != vl || vi->nlines == 0)
-	{
-		display_error("Pattern not found");
-		return 1;
-	}
-	return 0;
+	return SR_FOUND;
 }
 
-/* Scrolls to the next search match.  Returns zero on success and non-zero if
- * pattern wasn't found.  Prints a message on search failure. */
-static int
-find_next(void)
+void
+modview_continue_search(void)
 {
-	char buf[ui_qv_width(vi->view)*4];
+	if(!vle_mode_is(VIEW_MODE) || vi->last_search_backward == -1 ||
+			vi->scan_done || vi->scan_paused)
+	{
+		return;
+	}
 
-	int vl = vi->linev + 1;
-	int l = vi->line;
+	(void)scan_for_matches(vi);
 
-	if(l < vi->nlines - 1 && vl == vi->widths[l + 1][0])
+	SearchResult result = SR_FOUND;
+	if(vi->pending_jumps > 0)
 	{
-		++l;
+		const int count = vi->pending_jumps;
+		vi->pending_jumps = 0;
+		result = navigate(count, vi->pending_backward);
 	}
 
-	int i;
-	int offset = 0;
-	for(i = 0; l < vi->nlines && i <= vl - vi->widths[l][0]; ++i)
+	report_search_progress(vi, result);
+}
+
+/* Matches next chunk of lines against the search pattern extending the index
+ * of matches.  Returns non-zero if there are more lines to match. */
+static int
+scan_for_matches(modview_info_t *vi)
+{
+	const int width = ui_qv_width(vi->view);
+	if(vi->scan_width != width || vi->scan_wrap != cfg.wrap_quick_view)
 	{
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
+		/* Matches depend on how lines are split into virtual ones. */
+		drop_matches(vi, 0);
+		vi->scan_width = width;
+		vi->scan_wrap = cfg.wrap_quick_view;
 	}
 
-	while(l < vi->nlines)
+	int left = SEARCH_CHUNK_SIZE;
+	while(left-- > 0 && has_line(vi, vi->scanned))
 	{
-		if(regexec(&vi->re, buf, 0, NULL, 0) == 0)
+		const int line = vi->scanned++;
+		if(match_line(vi, line, 0, line_height(vi, line) - 1, 0) < 0)
 		{
-			vi->linev = vl;
-			vi->line = l;
-			break;
+			continue;
 		}
-		if(l == vi->nlines - 1)
+
+		int *const match = DA_EXTEND(vi->matches);
+		if(match != NULL)
 		{
-			break;
+			*match = line;
+			DA_COMMIT(vi->matches);
 		}
+	}
+
+	vi->scan_done = !has_line(vi, vi->scanned);
+	return !vi->scan_done;
+}
 
-		if(vl + 1 >= vi->widths[l + 1][0])
+/* Forgets about matches starting with the specified line, so that lines are
+ * matched anew. */
+static void
+drop_matches(modview_info_t *vi, int from)
+{
+	DA_SIZE(vi->matches) = find_match_pos(vi, from);
+	vi->scanned = MIN(vi->scanned, from);
+	vi->scan_done = 0;
+}
+
+/* Performs binary search of the first match at or after the line.  Returns
+ * index in the matches array. */
+static size_t
+find_match_pos(const modview_info_t *vi, int line)
+{
+	size_t lo = 0U, hi = DA_SIZE(vi->matches);
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo)/2U;
+		if(vi->matches[mid] < line)
 		{
-			++l;
-			offset = 0;
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
 		}
-		offset = get_part(vi->lines[l], offset, ui_qv_width(vi->view), buf);
-		++vl;
 	}
+	return lo;
+}
 
-	draw();
+/* Informs the user about progress of a search that takes a while. */
+static void
+report_search_progress(modview_info_t *vi, SearchResult result)
+{
+	const int nmatches = DA_SIZE(vi->matches);
 
-	if(vi->linev != vl || vi->nlines == 0)
+	if(result == SR_NOT_FOUND)
 	{
-		display_error("Pattern not found");
-		return 1;
+		/* Don't overwrite error message. */
+		vi->reported = 0;
+	}
+	else if(!vi->scan_done)
+	{
+		ui_sb_msgf("Searching... %d match%s so far", nmatches,
+				(nmatches == 1 ? "" : "es"));
+		vi->reported = 1;
+	}
+	else if(vi->reported)
+	{
+		vi->reported = 0;
+		if(result != SR_NOT_FOUND)
+		{
+			ui_sb_msgf("%d match%s found", nmatches, (nmatches == 1 ? "" : "es"));
+		}
 	}
-	return 0;
 }
 
-/* Extracts part of the line replacing all occurrences of horizontal tabulation
- * character with appropriate number of spaces.  The offset specifies beginning
- * of the part in the line.  The max_len parameter designates the maximum number
- * of screen characters to put into the part.  Returns number of processed items
- * of the line. */
+/* Matches virtual lines of a real line in the [from; to] range against search
+ * pattern.  Searching backward finds the last match.  Returns number of matched
+ * virtual line or -1 if there was no match. */
 static int
-get_part(const char line[], int offset, size_t max_len, char part[])
+match_line(modview_info_t *vi, int line, int from, int to, int backward)
 {
-	char *const no_esc = esc_remove(line);
-	const char *const begin = no_esc + offset;
-	const char *const end = expand_tabulation(begin, max_len, cfg.tab_stop, part);
-	const ptrdiff_t processed_chars = end - no_esc;
+	const int width = ui_qv_width(vi->view);
+	char part[width*4 + 1];
+
+	char *const no_esc = esc_remove(get_line(vi, line));
+	const char *begin = no_esc;
+
+	int match = -1;
+	int i;
+	for(i = 0; i <= to; ++i)
+	{
+		/* Tabulation is expanded to match what's displayed. */
+		begin = expand_tabulation(begin, width, cfg.tab_stop, part);
+		if(i >= from && regexec(&vi->re, part, 0, NULL, 0) == 0)
+		{
+			match = i;
+			if(!backward)
+			{
+				break;
+			}
+		}
+	}
+
 	free(no_esc);
-	return processed_chars;
+	return match;
 }
 
 /* Displays the error message in the status bar. */
@@ -1717,20 +2049,55 @@ modview_check_for_updates(void)
 	{
 		stats_redraw_later();
 	}
+
+	int indexed = 0;
+	indexed += index_in_background(curr_stats.preview.explore);
+	indexed += index_in_background(lwin.vi);
+	indexed += index_in_background(rwin.vi);
+
+	if(indexed && vle_mode_is(VIEW_MODE))
+	{
+		modview_ruler_update();
+	}
 }
 
-/* Forwards the view if underlying file changed.  Returns non-zero if reload
- * occurred, otherwise zero is returned. */
+/* Indexes next part of an mfile if there is one to have number of lines
+ * known by the time it's needed.  Returns non-zero if something was indexed,
+ * otherwise zero is returned. */
 static int
-forward_if_changed(modview_info_t *vi)
+index_in_background(modview_info_t *vi)
 {
-	filemon_t mon;
+	if(vi == NULL || vi->mfile == NULL || mfile_is_indexed(vi->mfile))
+	{
+		return 0;
+	}
+
+	(void)mfile_index_step(vi->mfile, INDEX_CHUNK_SIZE);
+	vi->nlines = mfile_known_lines(vi->mfile);
+	return 1;
+}
 
+/* Forwards the view if underlying file changed.  Returns non-zero if view
+ * needs to be redrawn, otherwise zero is returned. */
+static int
+forward_if_changed(modview_info_t *vi)
+{
 	if(vi == NULL || !vi->auto_forward)
 	{
 		return 0;
 	}
 
+	if(vi->watch != NULL)
+	{
+		const FSWatchState state = fswatch_poll(vi->watch);
+		if(state == FSWS_UNCHANGED || state == FSWS_ERRORED)
+		{
+			return 0;
+		}
+		return apply_file_changes(vi, state == FSWS_REPLACED);
+	}
+
+	filemon_t mon;
 	if(filemon_from_file(vi->filename, FMT_MODIFIED, &mon) != 0)
 	{
 		return 0;
@@ -1742,6 +2109,33 @@ forward_if_changed(modview_info_t *vi)
 	}
 
 	vi->file_mon = mon;
+	return apply_file_changes(vi, 0);
+}
+
+/* Updates the view after its file has changed.  Data appended to an mfile is
+ * picked up incrementally, otherwise (file was replaced, truncated, rewritten
+ * or isn't an mfile) the view is reloaded.  Returns non-zero if view needs to
+ * be redrawn, otherwise zero is returned. */
+static int
+apply_file_changes(modview_info_t *vi, int replaced)
+{
+	if(!replaced && vi->mfile != NULL)
+	{
+		const int result = mfile_refresh(vi->mfile);
+		if(result == 0)
+		{
+			return 0;
+		}
+
+		if(result > 0)
+		{
+			vi->nlines = mfile_known_lines(vi->mfile);
+			drop_matches(vi, vi->nlines);
+			(void)scroll_to_bottom(vi);
+			return 1;
+		}
+	}
+
 	reload_view(vi, SILENT);
 	return scroll_to_bottom(vi);
 }
@@ -1751,20 +2145,15 @@ forward_if_changed(modview_info_t *vi)
 static int
 scroll_to_bottom(modview_info_t *vi)
 {
-	if(vi->linev + 1 + ui_qv_height(vi->view) > vi->nlinesv)
+	const int height = ui_qv_height(vi->view);
+	if(count_rows(vi, height + 1) <= height)
 	{
 		return 0;
 	}
 
-	vi->linev = vi->nlinesv - ui_qv_height(vi->view);
-	for(vi->line = 0; vi->line < vi->nlines - 1; ++vi->line)
-	{
-		if(vi->linev < vi->widths[vi->line + 1][0])
-		{
-			break;
-		}
-	}
-
+	vi->line = line_count(vi) - 1;
+	vi->subline = line_height(vi, vi->line) - 1;
+	(void)scroll_up(vi, height - 1);
 	return 1;
 }
 
@@ -1917,7 +2306,24 @@ modview_current_line(modview_info_t *vi)
 TSTATIC strlist_t
 modview_lines(modview_info_t *vi)
 {
-	strlist_t lines = { .items = vi->lines, .nitems = vi->nlines };
+	if(vi->mfile == NULL)
+	{
+		strlist_t lines = { .items = vi->lines, .nitems = vi->nlines };
+		return lines;
+	}
+
+	/* Lines of an mfile are materialized on request. */
+	static strlist_t lines;
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	int i;
+	for(i = 0; has_line(vi, i); ++i)
+	{
+		lines.nitems = add_to_string_array(&lines.items, lines.nitems,
+				get_line(vi, i));
+	}
 	return lines;
 }
 
@@ -69,6 +69,10 @@ void modview_panes_swapped(void);
 /* Checks whether contents of either view should be updated. */
 void modview_check_for_updates(void);
 
+/* Matches next portion of lines against the search pattern if search in view
+ * mode is still in progress.  Performs postponed jumps to matches. */
+void modview_continue_search(void);
+
 /* Hides graphics that needs special care (doesn't disappear on UI redraw). */
 void modview_hide_graphics(void);
 
@@ -33,6 +33,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trace.h"
 #include "utils/utils.h"
 
 /* State of the unit. */
@@ -197,14 +198,21 @@ load_plugs_dir(plugs_t *plugs, const char plugin_path[])
 			plug_log(plug, "[vifm][info]: skipped due to blacklist/whitelist");
 			plug->status = PLS_SKIPPED;
 		}
-		else if(vlua_load_plugin(plugs->vlua, plug) == 0)
-		{
-			plug_log(plug, "[vifm][info]: plugin was loaded successfully");
-			plug->status = PLS_SUCCESS;
-		}
 		else
 		{
-			plug_log(plug, "[vifm][error]: loading plugin has failed");
+			trace_begin(plug->name, plug->path);
+			const int error = vlua_load_plugin(plugs->vlua, plug);
+			trace_end();
+
+			if(error == 0)
+			{
+				plug_log(plug, "[vifm][info]: plugin was loaded successfully");
+				plug->status = PLS_SUCCESS;
+			}
+			else
+			{
+				plug_log(plug, "[vifm][error]: loading plugin has failed");
+			}
 		}
 	}
 
@@ -21,7 +21,7 @@
 
 #include <stddef.h>   /* NULL size_t */
 #include <stdio.h>    /* snprintf() */
-#include <string.h>   /* memmove() */
+#include <string.h>   /* memchr() memcpy() memmove() memset() strlen() */
 #include <stdlib.h>   /* free */
 
 #include <fcntl.h>    /* O_RDWR, O_EXCL, O_CREAT, ... */
@@ -51,6 +51,9 @@
 
 /* Data of all registers. */
 static reg_t registers[NUM_REGISTERS];
+/* Whether contents of a register has changed since the last time it was
+ * synchronized with shared memory. */
+static char changed_registers[NUM_REGISTERS];
 
 /* Names of registers + names of 26 uppercase register names + termination null
  * character. */
@@ -160,15 +163,22 @@ static char *shmem_raw;
 static shared_state_t *shmem;
 /* Last generation number that we've seen. */
 static unsigned int seen_generation;
+/* Generations of contents of our registers.  Zero means the contents hasn't
+ * been synchronized with shared memory. */
+static unsigned int reg_generations[NUM_REGISTERS];
 /* Whether we're in debug mode. */
 static int debug_print_to_stdout;
 
 static int find_in_reg(const reg_t *reg, const char file[]);
+static int sort_and_dedup(char *files[], int nfiles);
+static int insert_into_reg(reg_t *reg, int pos, char file[]);
 static reg_t * reg_from_name(int reg_name);
+static void mark_changed(const reg_t *reg);
 static void regs_sync_error(const char msg[]);
 static int regs_sync_to_shared_memory_critical(void);
 static int regs_sync_enter_critical_section(void);
-static void regs_sync_rewrite_critical(void);
+static void regs_sync_compact_critical(void);
+static size_t regs_sync_get_register_size(size_t reg_id);
 static size_t regs_sync_store_register_contents_critical(size_t current_offset,
 	size_t reg_id);
 static size_t regs_sync_store_register_contents_in_place(size_t current_offset,
@@ -225,20 +235,99 @@ regs_append(int reg_name, const char file[])
 	}
 	pos = -(pos + 1);
 
-	const int nfiles = add_to_string_array(&reg->files, reg->nfiles, file);
-	if(nfiles == reg->nfiles)
+	char *const file_copy = strdup(file);
+	if(file_copy == NULL || insert_into_reg(reg, pos, file_copy) != 0)
 	{
+		free(file_copy);
 		return 1;
 	}
-	reg->nfiles = nfiles;
 
-	char *file_copy = reg->files[nfiles - 1];
-	memmove(reg->files + pos + 1, reg->files + pos,
-			sizeof(*reg->files)*(nfiles - 1 - pos));
-	reg->files[pos] = file_copy;
+	mark_changed(reg);
 	return 0;
 }
 
+/* Inserts file at specified position of a register taking ownership of the
+ * string.  Returns zero on success, otherwise non-zero is returned. */
+static int
+insert_into_reg(reg_t *reg, int pos, char file[])
+{
+	char **const files = reallocarray(reg->files, reg->nfiles + 1,
+			sizeof(*files));
+	if(files == NULL)
+	{
+		return 1;
+	}
+
+	memmove(files + pos + 1, files + pos, sizeof(*files)*(reg->nfiles - pos));
+	files[pos] = file;
+	reg->files = files;
+	++reg->nfiles;
+	return 0;
+}
+
+int
+regs_append_files(int reg_name, char *files[], int nfiles)
+{
+	if(reg_name == BLACKHOLE_REG_NAME)
+	{
+		return nfiles;
+	}
+
+	reg_t *const reg = reg_from_name(reg_name);
+	if(reg == NULL)
+	{
+		return 0;
+	}
+
+	files = copy_string_array(files, nfiles);
+	if(files == NULL)
+	{
+		return 0;
+	}
+	nfiles = (nfiles == 0 ? 0 : sort_and_dedup(files, nfiles));
+
+	char **const merged = reallocarray(NULL, reg->nfiles + nfiles,
+			sizeof(*merged));
+	if(merged == NULL)
+	{
+		free_string_array(files, nfiles);
+		return 0;
+	}
+
+	/* Merge two sorted lists skipping files that are already in the register. */
+	int i = 0, j = 0, n = 0;
+	while(i < reg->nfiles || j < nfiles)
+	{
+		const int cmp = (i == reg->nfiles) ? 1
+		              : (j == nfiles) ? -1
+		              : stroscmp(reg->files[i], files[j]);
+		if(cmp <= 0)
+		{
+			merged[n++] = reg->files[i++];
+			if(cmp == 0)
+			{
+				free(files[j++]);
+			}
+		}
+		else
+		{
+			merged[n++] = files[j++];
+		}
+	}
+
+	const int added = n - reg->nfiles;
+	free(files);
+	free(reg->files);
+	reg->files = merged;
+	reg->nfiles = n;
+
+	if(added != 0)
+	{
+		mark_changed(reg);
+	}
+	return added;
+}
+
 void
 regs_set(int reg_name, char **files, int nfiles)
 {
@@ -260,15 +349,26 @@ regs_set(int reg_name, char **files, int nfiles)
 		return;
 	}
 
-	/* Registers are sorted. */
+	nfiles = sort_and_dedup(files, nfiles);
+
+	free_string_array(reg->files, reg->nfiles);
+	reg->files = files;
+	reg->nfiles = nfiles;
+	mark_changed(reg);
+}
+
+/* Brings list of files into the form used by registers: sorts it and frees
+ * duplicates.  Returns new size of the list. */
+static int
+sort_and_dedup(char *files[], int nfiles)
+{
 	safe_qsort(files, nfiles, sizeof(*files), &strossorter);
 
-	/* And don't contain duplicates. */
 	int i;
 	int j = 1;
 	for(i = 1; i < nfiles; ++i)
 	{
-		if(stroscmp(files[i - 1], files[i]) == 0)
+		if(stroscmp(files[j - 1], files[i]) == 0)
 		{
 			free(files[i]);
 		}
@@ -277,11 +377,7 @@ regs_set(int reg_name, char **files, int nfiles)
 			files[j++] = files[i];
 		}
 	}
-	nfiles = j;
-
-	free_string_array(reg->files, reg->nfiles);
-	reg->files = files;
-	reg->nfiles = nfiles;
+	return j;
 }
 
 void
@@ -306,6 +402,7 @@ regs_clear(int reg_name)
 	free_string_array(reg->files, reg->nfiles);
 	reg->files = NULL;
 	reg->nfiles = 0;
+	mark_changed(reg);
 }
 
 void
@@ -326,7 +423,12 @@ regs_pack(int reg_name)
 			reg->files[j++] = reg->files[i];
 		}
 	}
-	reg->nfiles = j;
+
+	if(j != reg->nfiles)
+	{
+		reg->nfiles = j;
+		mark_changed(reg);
+	}
 }
 
 char **
@@ -365,12 +467,34 @@ regs_rename_contents(const char old[], const char new[])
 	int i;
 	for(i = 0; i < NUM_REGISTERS; ++i)
 	{
+		reg_t *const reg = &registers[i];
+
 		/* Registers don't contain duplicates, so updating single element is
 		 * enough. */
-		const int pos = find_in_reg(&registers[i], old);
-		if(pos >= 0)
+		const int pos = find_in_reg(reg, old);
+		if(pos < 0)
 		{
-			(void)replace_string(&registers[i].files[pos], new);
+			continue;
+		}
+
+		/* Changing the path can change its position in the register or make it
+		 * a duplicate of another path. */
+		char *file = reg->files[pos];
+		--reg->nfiles;
+		memmove(reg->files + pos, reg->files + pos + 1,
+				sizeof(*reg->files)*(reg->nfiles - pos));
+		mark_changed(reg);
+
+		const int new_pos = find_in_reg(reg, new);
+		if(new_pos >= 0 || replace_string(&file, new) != 0)
+		{
+			free(file);
+			continue;
+		}
+
+		if(insert_into_reg(reg, -(new_pos + 1), file) != 0)
+		{
+			free(file);
 		}
 	}
 }
@@ -419,6 +543,14 @@ reg_from_name(int reg_name)
 	return NULL;
 }
 
+/* Marks register as one that needs to be written to shared memory on the next
+ * synchronization. */
+static void
+mark_changed(const reg_t *reg)
+{
+	changed_registers[reg - registers] = 1;
+}
+
 void
 regs_remove_trashed_files(const char trash_dir[])
 {
@@ -468,6 +600,7 @@ regs_update_unnamed(int reg_name)
 	{
 		unnamed->files[i] = strdup(reg->files[i]);
 	}
+	mark_changed(unnamed);
 }
 
 void
@@ -539,6 +672,10 @@ regs_sync_enable(const char shared_memory_name[])
 	/* structured view on the same data */
 	shmem = (shared_state_t *)shmem_raw;
 
+	/* Contents of registers in shared memory takes precedence over our own. */
+	seen_generation = 0U;
+	memset(reg_generations, 0, sizeof(reg_generations));
+
 	/* Initialization of just created shared memory area. */
 	if(shmem_created_by_us(shmem_obj))
 	{
@@ -546,6 +683,8 @@ regs_sync_enable(const char shared_memory_name[])
 		shmem->data_is_consistent = 0;
 		shmem->size_backed = shared_initial;
 
+		memset(changed_registers, 1, sizeof(changed_registers));
+
 		if(!regs_sync_to_shared_memory_critical())
 		{
 			shmem_destroy(shmem_obj);
@@ -595,29 +734,38 @@ regs_sync_to_shared_memory(void)
 	}
 }
 
-/* Puts contents of our registers into shared memory.  Returns 1 on success, 0
- * on failure (cleans up as needed on fail). */
+/* Puts contents of registers that have changed since the last synchronization
+ * into shared memory.  Returns 1 on success, 0 on failure (cleans up as needed
+ * on fail). */
 static int
 regs_sync_to_shared_memory_critical(void)
 {
+	if(memchr(changed_registers, 1, sizeof(changed_registers)) == NULL)
+	{
+		return 1;
+	}
+
 	shmem->data_is_consistent = 0;
-	seen_generation = ++shmem->generation;
+
+	/* Don't skip changes of other instances that weren't read yet. */
+	const int seen_everything = (shmem->generation == seen_generation);
+	++shmem->generation;
+	if(seen_everything)
+	{
+		seen_generation = shmem->generation;
+	}
 
 	/* Determine memory requirements for state to be synchronized. */
 	size_t new_register_sizes_total = 0;
 	size_t new_register_sizes[NUM_REGISTERS];
 
 	int i;
-	int j;
 
 	for(i = 0; i < NUM_REGISTERS; ++i)
 	{
-		new_register_sizes[i] = 0;
-		for(j = 0; j < registers[i].nfiles; ++j)
-		{
-			/* +1 to count the 0 terminator byte. */
-			new_register_sizes[i] += strlen(registers[i].files[j]) + 1;
-		}
+		new_register_sizes[i] = changed_registers[i]
+		                      ? regs_sync_get_register_size(i)
+		                      : shmem->reg_metadata[i].length_used;
 		new_register_sizes_total += new_register_sizes[i];
 	}
 
@@ -638,18 +786,23 @@ regs_sync_to_shared_memory_critical(void)
 		if(new_register_sizes_total < (halved_size - SHARED_ALL_METADATA_SIZE)
 				&& shmem->size_backed > shared_initial)
 		{
-			/* Halve allocation size. */
+			/* Halve allocation size after moving everything out of the way. */
+			regs_sync_compact_critical();
 			if(!regs_sync_resize_allocation(halved_size))
 			{
 				return 0;
 			}
-			regs_sync_rewrite_critical();
 		}
 		else
 		{
 			size_t offset = SHARED_ALL_METADATA_SIZE + shmem->length_area_used;
 			for(i = 0; i < NUM_REGISTERS; ++i)
 			{
+				if(!changed_registers[i])
+				{
+					continue;
+				}
+
 				if(new_register_sizes[i] >
 						shmem->reg_metadata[i].length_available)
 				{
@@ -680,12 +833,27 @@ regs_sync_to_shared_memory_critical(void)
 			return 0;
 		}
 
-		regs_sync_rewrite_critical();
+		regs_sync_compact_critical();
 	}
 
 	return 1;
 }
 
+/* Computes size of contents of a register in shared memory.  Returns the
+ * size. */
+static size_t
+regs_sync_get_register_size(size_t reg_id)
+{
+	size_t size = 0;
+	int i;
+	for(i = 0; i < registers[reg_id].nfiles; ++i)
+	{
+		/* +1 to count the 0 terminator byte. */
+		size += strlen(registers[reg_id].files[i]) + 1;
+	}
+	return size;
+}
+
 /* Locks the mutex protecting shared memory.  Returns non-zero on success,
  * otherwise zero is returned. */
 static int
@@ -706,17 +874,51 @@ regs_sync_enter_critical_section(void)
 	return 1;
 }
 
-/* Rewrites shared memory from scratch. */
+/* Packs contents of registers in shared memory leaving no gaps between them.
+ * Unchanged registers are moved within shared memory, changed ones are written
+ * after them.  Assumes that there is enough space in shared memory. */
 static void
-regs_sync_rewrite_critical(void)
+regs_sync_compact_critical(void)
 {
-	/* Assumption: enough space in shared memory. */
 	size_t offset = SHARED_ALL_METADATA_SIZE;
+	char moved[NUM_REGISTERS] = { 0 };
 	int i;
+
+	/* Processing registers in the order of their offsets guarantees that data is
+	 * only moved backward and never overwritten before it's moved. */
+	while(1)
+	{
+		int next = -1;
+		for(i = 0; i < NUM_REGISTERS; ++i)
+		{
+			if(!changed_registers[i] && !moved[i] && (next == -1 ||
+					shmem->reg_metadata[i].offset < shmem->reg_metadata[next].offset))
+			{
+				next = i;
+			}
+		}
+
+		if(next == -1)
+		{
+			break;
+		}
+
+		reg_metadata_t *const md = &shmem->reg_metadata[next];
+		memmove(shmem_raw + offset, shmem_raw + md->offset, md->length_used);
+		md->offset = offset;
+		md->length_available = md->length_used;
+		offset += md->length_used;
+		moved[next] = 1;
+	}
+
 	for(i = 0; i < NUM_REGISTERS; ++i)
 	{
-		offset = regs_sync_store_register_contents_critical(offset, i);
+		if(changed_registers[i])
+		{
+			offset = regs_sync_store_register_contents_critical(offset, i);
+		}
 	}
+
 	shmem->length_area_used = offset - SHARED_ALL_METADATA_SIZE;
 }
 
@@ -738,7 +940,7 @@ static size_t
 regs_sync_store_register_contents_in_place(size_t current_offset, size_t reg_id)
 {
 	int i;
-	shmem->reg_metadata[reg_id].generation  = seen_generation;
+	shmem->reg_metadata[reg_id].generation  = shmem->generation;
 	shmem->reg_metadata[reg_id].num_entries = registers[reg_id].nfiles;
 	shmem->reg_metadata[reg_id].offset      = current_offset;
 	for(i = 0; i < registers[reg_id].nfiles; ++i)
@@ -749,6 +951,9 @@ regs_sync_store_register_contents_in_place(size_t current_offset, size_t reg_id)
 	}
 	shmem->reg_metadata[reg_id].length_used =
 		current_offset - shmem->reg_metadata[reg_id].offset;
+
+	changed_registers[reg_id] = 0;
+	reg_generations[reg_id] = shmem->generation;
 	return current_offset;
 }
 
@@ -794,7 +999,7 @@ regs_sync_from_shared_memory(void)
 		int i;
 		for(i = 0; i < NUM_REGISTERS; ++i)
 		{
-			if(shmem->reg_metadata[i].generation != seen_generation)
+			if(shmem->reg_metadata[i].generation != reg_generations[i])
 			{
 				free_string_array(registers[i].files, registers[i].nfiles);
 
@@ -811,6 +1016,9 @@ regs_sync_from_shared_memory(void)
 					memcpy(registers[i].files[j], curstrptr, curlen);
 					curstrptr += curlen;
 				}
+
+				changed_registers[i] = 0;
+				reg_generations[i] = shmem->reg_metadata[i].generation;
 			}
 		}
 		seen_generation = shmem->generation;
@@ -63,6 +63,11 @@ const reg_t * regs_find(int reg_name);
  * is added, otherwise non-zero is returned. */
 int regs_append(int reg_name, const char file[]);
 
+/* Appends paths to files to register specified by name.  This is a faster
+ * equivalent of calling regs_append() for each of the files.  Returns number
+ * of files that were added. */
+int regs_append_files(int reg_name, char *files[], int nfiles);
+
 /* Replaces contents of a register. */
 void regs_set(int reg_name, char **files, int nfiles);
 
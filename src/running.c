@@ -1276,7 +1276,8 @@ rn_ext(view_t *view, const char cmd[], const char title[], MacroFlags flags,
 			ma_flags_present(flags, MF_MENU_NAV_OUTPUT))
 	{
 		setup_shellout_env();
-		*save_msg = show_user_menu(view, cmd, title, flags) != 0;
+		char *cmds[] = { (char *)cmd };
+		*save_msg = show_user_menu(view, cmds, 1, title, flags) != 0;
 		cleanup_shellout_env();
 	}
 	else if((ma_flags_present(flags, MF_SPLIT) ||
@@ -1429,6 +1430,78 @@ run_in_split(const view_t *view, const char cmd[], int vert_split, int pause)
 	free(escaped_cmd);
 }
 
+int
+rn_ext_batch(view_t *view, char *cmds[], int ncmds, int jobs,
+		const char title[], MacroFlags flags, int pause, int bg)
+{
+	static const MacroFlags incompatible[] = {
+		MF_STATUSBAR_OUTPUT, MF_PREVIEW_OUTPUT, MF_SPLIT, MF_SPLIT_VERT,
+		MF_CUSTOMVIEW_OUTPUT, MF_VERYCUSTOMVIEW_OUTPUT,
+		MF_CUSTOMVIEW_IOUTPUT, MF_VERYCUSTOMVIEW_IOUTPUT,
+		MF_PIPE_FILE_LIST, MF_PIPE_FILE_LIST_Z,
+	};
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(incompatible); ++i)
+	{
+		if(ma_flags_present(flags, incompatible[i]))
+		{
+			ui_sb_errf("\"%s\" macro can't be combined with \"%s\"",
+					ma_flags_to_str(MF_BATCH), ma_flags_to_str(incompatible[i]));
+			return 1;
+		}
+	}
+
+	const int to_menu = ma_flags_present(flags, MF_MENU_OUTPUT)
+	                 || ma_flags_present(flags, MF_MENU_NAV_OUTPUT);
+	const int ignore = ma_flags_present(flags, MF_IGNORE);
+	const int use_term_mux = ma_flags_missing(flags, MF_NO_TERM_MUX);
+
+	if(to_menu && bg)
+	{
+		ui_sb_errf("\"%s\" macro can't be combined with \" &\"",
+				ma_flags_to_str(ma_flags_present(flags, MF_MENU_OUTPUT)
+					? MF_MENU_OUTPUT
+					: MF_MENU_NAV_OUTPUT));
+		return 1;
+	}
+
+	if(to_menu)
+	{
+		setup_shellout_env();
+		const int save_msg = show_user_menu(view, cmds, ncmds, title, flags) != 0;
+		cleanup_shellout_env();
+		return save_msg;
+	}
+
+	if(bg || ignore)
+	{
+		setup_shellout_env();
+		bg_job_t *job = bg_run_batch(cmds, ncmds, jobs, ignore, title);
+		cleanup_shellout_env();
+
+		if(job == NULL)
+		{
+			show_error_msgf("Trouble running command", "Unable to run: %s", title);
+			return 0;
+		}
+		bg_job_decref(job);
+		return 0;
+	}
+
+	flist_sel_stash_if_nonempty(view);
+
+	int j;
+	for(j = 0; j < ncmds; ++j)
+	{
+		/* Explicit pause is needed only after the last command. */
+		const ShellPause shell_pause = (pause && j == ncmds - 1) ? PAUSE_ALWAYS
+		                                                         : PAUSE_ON_ERROR;
+		(void)rn_shell(cmds[j], shell_pause, use_term_mux, SHELL_BY_USER);
+	}
+	return 0;
+}
+
 void
 rn_start_bg_command(view_t *view, const char cmd[], MacroFlags flags)
 {
@@ -85,6 +85,12 @@ int rn_open_with_match(struct view_t *view, const char beginning[],
 int rn_ext(struct view_t *view, const char cmd[], const char title[],
 		MacroFlags flags, int pause, int bg, int *save_msg);
 
+/* Runs parts of a batched command (see %x macro) either in foreground, in
+ * background (at most jobs of them in parallel) or capturing their output into
+ * a menu.  Returns non-zero if status bar message should be saved. */
+int rn_ext_batch(struct view_t *view, char *cmds[], int ncmds, int jobs,
+		const char title[], MacroFlags flags, int pause, int bg);
+
 /* Starts background command optionally handling input redirection. */
 void rn_start_bg_command(struct view_t *view, const char cmd[],
 		MacroFlags flags);
@@ -23,8 +23,10 @@
 
 #include <assert.h> /* assert() */
 #include <ctype.h>
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcmp() strrchr() */
+#include <stdint.h> /* UINT64_C int64_t uint64_t */
+#include <stdlib.h> /* abs() free() */
+#include <string.h> /* memcpy() memmove() strcmp() strrchr() */
+#include <time.h> /* time_t */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
@@ -83,14 +85,24 @@ ARRAY_GUARD(sort_enum, SK_TOTAL);
 
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		size_t nchildren, int root);
+static int compare_entries(const dir_entry_t *a, const dir_entry_t *b,
+		regex_t groups[], int ngroups);
+static int compare_by_key(const dir_entry_t *a, const dir_entry_t *b,
+		signed char key, void *data);
 static int prepare_for_sorting(view_t *v, int local);
 static int setup_linking(dir_entry_t *entries, int nentries);
 static void cleanup_linking(void);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
+static int compile_groups(regex_t **groups);
 static void sort_by_groups(dir_entry_t *entries, signed char key,
 		size_t nentries);
 static void sort_by_key(dir_entry_t *entries, size_t nentries, signed char key,
 		void *data);
+static int sort_by_number(dir_entry_t *entries, size_t nentries);
+static int is_numeric_key(SortingKey key);
+static uint64_t get_numeric_key(const dir_entry_t *entry);
+static uint64_t time_key(time_t t);
+static int compare_numbers(const void *one, const void *two);
 static char * map_ascii_clone(const char str[], int ignore_case);
 static char * map_ascii(const char str[], int ignore_case);
 static char * lowerdup(const char str[]);
@@ -123,6 +135,17 @@ static const char *view_sort_groups;
 /* Whether the view displays custom file list. */
 static int custom_view;
 
+/* Compact representation of an entry for sorting by a numeric key.  Sorting
+ * these instead of entries avoids calling full comparison function and
+ * computing the key (which can involve lookups) for every pair of entries. */
+typedef struct
+{
+	uint64_t key;   /* Value of the key in a form that's compared as a number. */
+	int pos;        /* Position of the entry before sorting. */
+	int is_parent;  /* Whether this is ".." entry that's always the first. */
+}
+number_rec_t;
+
 /* The following variables are set up by setup_linking() and managed by
  * sort_by_key(). */
 
@@ -263,6 +286,210 @@ sort_entries(view_t *v, entries_t entries)
 	}
 }
 
+int
+sort_subtree(view_t *v, entries_t entries)
+{
+	/* Local filter affects how tree is sorted, see sort_view(). */
+	if(v->local_filter.in_progress || !filter_is_empty(&v->local_filter.filter))
+	{
+		return 1;
+	}
+
+	if(prepare_for_sorting(v, /*local=*/1) != 0)
+	{
+		return 0;
+	}
+
+	if(setup_linking(entries.entries, entries.nentries) != 0)
+	{
+		return 1;
+	}
+
+	dir_entry_t *const unsorted_list = reallocarray(NULL, entries.nentries,
+			sizeof(*unsorted_list));
+	if(unsorted_list == NULL)
+	{
+		cleanup_linking();
+		return 1;
+	}
+
+	memcpy(unsorted_list, entries.entries,
+			sizeof(*unsorted_list)*entries.nentries);
+	sort_tree_slice(entries.entries, unsorted_list, entries.nentries, 1);
+
+	free(unsorted_list);
+	cleanup_linking();
+	return 0;
+}
+
+int
+sort_insert_tail(view_t *v, int nsorted)
+{
+	const int ntail = v->list_rows - nsorted;
+	if(ntail <= 0 || prepare_for_sorting(v, /*local=*/1) != 0)
+	{
+		return 0;
+	}
+
+	/* Short paths of a custom view aren't handled by compare_by_key(). */
+	if(custom_view)
+	{
+		return 1;
+	}
+
+	dir_entry_t *const tail = reallocarray(NULL, ntail, sizeof(*tail));
+	if(tail == NULL)
+	{
+		return 1;
+	}
+
+	if(setup_linking(&v->dir_entry[nsorted], ntail) != 0)
+	{
+		free(tail);
+		return 1;
+	}
+	sort_sequence(&v->dir_entry[nsorted], ntail);
+	cleanup_linking();
+
+	regex_t *groups = NULL;
+	const int ngroups = ui_view_sort_list_contains(view_sort, SK_BY_GROUPS)
+	                  ? compile_groups(&groups)
+	                  : 0;
+
+	memcpy(tail, &v->dir_entry[nsorted], sizeof(*tail)*ntail);
+
+	/* Merge starting with the greatest element, which moves every entry of the
+	 * sorted part at most once. */
+	dir_entry_t *const entries = v->dir_entry;
+	int end = v->list_rows;
+	int nleft = nsorted;
+	int i;
+	for(i = ntail - 1; i >= 0; --i)
+	{
+		/* Find the first entry that's greater than the inserted one. */
+		int lo = 0, hi = nleft;
+		while(lo < hi)
+		{
+			const int mid = lo + (hi - lo)/2;
+			if(compare_entries(&entries[mid], &tail[i], groups, ngroups) > 0)
+			{
+				hi = mid;
+			}
+			else
+			{
+				lo = mid + 1;
+			}
+		}
+
+		const int nmoved = nleft - lo;
+		end -= nmoved;
+		memmove(&entries[end], &entries[lo], sizeof(*entries)*nmoved);
+		entries[--end] = tail[i];
+		nleft = lo;
+	}
+
+	for(i = 0; i < ngroups; ++i)
+	{
+		regfree(&groups[i]);
+	}
+	free(groups);
+	free(tail);
+	return 0;
+}
+
+/* Compares two entries by all sorting keys in the order of their significance
+ * as if they were sorted by sort_sequence().  Returns standard < 0, == 0, > 0
+ * comparison result. */
+static int
+compare_entries(const dir_entry_t *a, const dir_entry_t *b, regex_t groups[],
+		int ngroups)
+{
+	int result;
+
+	/* sort_sequence() does this as its last pass. */
+	if(!ui_view_sort_list_contains(view_sort, SK_BY_DIR))
+	{
+		result = compare_by_key(a, b, SK_BY_DIR, NULL);
+		if(result != 0)
+		{
+			return result;
+		}
+	}
+
+	int i;
+	for(i = 0; i < SK_COUNT; ++i)
+	{
+		const signed char sorting_key = view_sort[i];
+		const int sorting_type = abs(sorting_key);
+
+		if(sorting_type > SK_LAST)
+		{
+			continue;
+		}
+
+		if(sorting_type == SK_BY_GROUPS)
+		{
+			int j;
+			for(j = 0; j < ngroups; ++j)
+			{
+				result = compare_by_key(a, b, sorting_key, &groups[j]);
+				if(result != 0)
+				{
+					return result;
+				}
+			}
+			continue;
+		}
+
+		result = compare_by_key(a, b, sorting_key, NULL);
+		if(result != 0)
+		{
+			return result;
+		}
+	}
+
+	return 0;
+}
+
+/* Compares two entries by a single sorting key using sort_dir_list().  Returns
+ * standard < 0, == 0, > 0 comparison result. */
+static int
+compare_by_key(const dir_entry_t *a, const dir_entry_t *b, signed char key,
+		void *data)
+{
+	sort_descending = (key < 0);
+	sort_type = (SortingKey)abs(key);
+	sort_data = data;
+
+	char *keys[2] = { NULL, NULL };
+	if(sort_type == SK_BY_NAME || sort_type == SK_BY_INAME)
+	{
+		const int ignore_case = (sort_type == SK_BY_INAME);
+		keys[0] = map_ascii(a->name, ignore_case);
+		keys[1] = map_ascii(b->name, ignore_case);
+	}
+	else if(sort_type == SK_BY_FILEEXT || sort_type == SK_BY_EXTENSION)
+	{
+		keys[0] = map_ascii(a->name, /*ignore_case=*/0);
+		keys[1] = map_ascii(b->name, /*ignore_case=*/0);
+	}
+
+	/* Copies are linked to the keys above and have equal tags to not order
+	 * them by position. */
+	dir_entry_t first = *a, second = *b;
+	first.link = 0;
+	second.link = 1;
+	first.tag = second.tag = 0;
+
+	cached_keys = keys;
+	const int result = sort_dir_list(&first, &second);
+	cached_keys = NULL;
+
+	free(keys[0]);
+	free(keys[1]);
+	return result;
+}
+
 /* Prepares globals of this unit for performing sorting.  Returns non-zero if
  * there is no sorting to do. */
 static int
@@ -342,6 +569,39 @@ sort_sequence(dir_entry_t *entries, size_t nentries)
 	}
 }
 
+/* Compiles regular expressions of all sorting groups.  Returns number of
+ * elements in *groups, which is zero on error. */
+static int
+compile_groups(regex_t **groups)
+{
+	char **exprs = NULL;
+	int nexprs = 0;
+
+	char *const copy = strdup(view_sort_groups);
+	char *expr = copy, *state = NULL;
+	while((expr = split_and_get(expr, ',', &state)) != NULL)
+	{
+		nexprs = add_to_string_array(&exprs, nexprs, expr);
+	}
+	free(copy);
+
+	*groups = reallocarray(NULL, nexprs, sizeof(**groups));
+	if(*groups == NULL)
+	{
+		free_string_array(exprs, nexprs);
+		return 0;
+	}
+
+	int i;
+	for(i = 0; i < nexprs; ++i)
+	{
+		(void)regexp_compile(&(*groups)[i], exprs[i], REG_EXTENDED | REG_ICASE);
+	}
+
+	free_string_array(exprs, nexprs);
+	return nexprs;
+}
+
 /* Sorts specified range of entries according to sorting groups option. */
 static void
 sort_by_groups(dir_entry_t *entries, signed char key, size_t nentries)
@@ -385,6 +645,11 @@ sort_by_key(dir_entry_t *entries, size_t nentries, signed char key, void *data)
 	sort_type = (SortingKey)abs(key);
 	sort_data = data;
 
+	if(sort_by_number(entries, nentries))
+	{
+		return;
+	}
+
 	int using_cache = 0;
 
 	if(sort_type == SK_BY_NAME || sort_type == SK_BY_INAME)
@@ -441,6 +706,148 @@ sort_by_key(dir_entry_t *entries, size_t nentries, signed char key, void *data)
 	}
 }
 
+/* Sorts entries by current key if it's numeric in a stable way.  Returns
+ * non-zero if sorting was performed, otherwise zero is returned. */
+static int
+sort_by_number(dir_entry_t *entries, size_t nentries)
+{
+	if(!is_numeric_key(sort_type))
+	{
+		return 0;
+	}
+
+	number_rec_t *const recs = reallocarray(NULL, nentries, sizeof(*recs));
+	if(recs == NULL)
+	{
+		return 0;
+	}
+
+	size_t i;
+	for(i = 0U; i < nentries; ++i)
+	{
+		const dir_entry_t *const entry = &entries[i];
+		recs[i].key = get_numeric_key(entry);
+		recs[i].pos = i;
+		recs[i].is_parent = fentry_is_dir(entry) && is_parent_dir(entry->name);
+	}
+
+	safe_qsort(recs, nentries, sizeof(*recs), &compare_numbers);
+
+	/* Move entries into their places following cycles of the permutation, so
+	 * that every entry is copied about once. */
+	for(i = 0U; i < nentries; ++i)
+	{
+		if(recs[i].pos == (int)i)
+		{
+			continue;
+		}
+
+		const dir_entry_t first = entries[i];
+		size_t pos = i;
+		while(1)
+		{
+			const size_t from = recs[pos].pos;
+			recs[pos].pos = pos;
+			if(from == i)
+			{
+				entries[pos] = first;
+				break;
+			}
+			entries[pos] = entries[from];
+			pos = from;
+		}
+	}
+
+	free(recs);
+	return 1;
+}
+
+/* Checks whether values of the key can be compared as numbers.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_numeric_key(SortingKey key)
+{
+	switch(key)
+	{
+		case SK_BY_DIR:
+		case SK_BY_SIZE:
+		case SK_BY_TIME_MODIFIED:
+		case SK_BY_TIME_ACCESSED:
+		case SK_BY_TIME_CHANGED:
+#ifndef _WIN32
+		case SK_BY_MODE:
+		case SK_BY_INODE:
+		case SK_BY_OWNER_NAME:
+		case SK_BY_OWNER_ID:
+		case SK_BY_GROUP_NAME:
+		case SK_BY_GROUP_ID:
+		case SK_BY_NLINKS:
+#endif
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/* Computes value of current numeric key for an entry in the same order as
+ * sort_dir_list() would compare them.  Returns the value. */
+static uint64_t
+get_numeric_key(const dir_entry_t *entry)
+{
+	switch(sort_type)
+	{
+		case SK_BY_DIR:           return !fentry_is_dir(entry);
+		case SK_BY_SIZE:          return fentry_get_size(view, entry);
+		case SK_BY_TIME_MODIFIED: return time_key(entry->mtime);
+		case SK_BY_TIME_ACCESSED: return time_key(entry->atime);
+		case SK_BY_TIME_CHANGED:  return time_key(entry->ctime);
+#ifndef _WIN32
+		case SK_BY_MODE:          return entry->mode;
+		case SK_BY_INODE:         return entry->inode;
+		case SK_BY_OWNER_NAME: /* FIXME */
+		case SK_BY_OWNER_ID:      return entry->uid;
+		case SK_BY_GROUP_NAME: /* FIXME */
+		case SK_BY_GROUP_ID:      return entry->gid;
+		case SK_BY_NLINKS:        return entry->nlinks;
+#endif
+
+		default:
+			assert(0 && "Unhandled numeric sorting key.");
+			return 0U;
+	}
+}
+
+/* Maps possibly negative time onto unsigned number preserving order.  Returns
+ * the number. */
+static uint64_t
+time_key(time_t t)
+{
+	return (uint64_t)(int64_t)t ^ (UINT64_C(1) << 63);
+}
+
+/* qsort() comparer of number_rec_t.  Returns standard -1, 0, 1 for
+ * comparisons. */
+static int
+compare_numbers(const void *one, const void *two)
+{
+	const number_rec_t *const first = one;
+	const number_rec_t *const second = two;
+
+	if(first->is_parent != second->is_parent)
+	{
+		return (first->is_parent ? -1 : 1);
+	}
+
+	const int retval = SORT_CMP(first->key, second->key);
+	if(retval != 0)
+	{
+		return (sort_descending ? -retval : retval);
+	}
+
+	return SORT_CMP(first->pos, second->pos);
+}
+
 /* Turns non-ASCII strings into normalized UTF-8 strings or just clones it.
  * Returns a newly allocated string. */
 static char *
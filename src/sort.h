@@ -32,6 +32,17 @@ void sort_view(view_t *view);
 /* Sorts specified entries using global settings of the view. */
 void sort_entries(view_t *view, entries_t entries);
 
+/* Sorts entries that form a tree (its top-level entries have zero child_pos)
+ * and are about to be inserted into the view using its local settings.  Returns
+ * zero on success and non-zero if the whole view needs to be sorted instead. */
+int sort_subtree(view_t *view, entries_t entries);
+
+/* Moves entries of the view starting at nsorted position to where they belong
+ * among already sorted entries before them using local settings of the view.
+ * Returns zero on success and non-zero if the whole view needs to be sorted
+ * instead. */
+int sort_insert_tail(view_t *view, int nsorted);
+
 /* Maps primary sort key to second column type.  Returns secondary key that
  * corresponds to the primary one. */
 SortingKey get_secondary_key(SortingKey primary_key);
@@ -39,6 +39,7 @@ const char *tags[] = {
 	"vifm-%s",
 	"vifm-%u",
 	"vifm-%v",
+	"vifm-%x",
 	"vifm-'",
 	"vifm-'aproposprg'",
 	"vifm-'autocd'",
@@ -178,6 +179,7 @@ const char *tags[] = {
 	"vifm---select",
 	"vifm---server-list",
 	"vifm---server-name",
+	"vifm---startup-profile",
 	"vifm---version",
 	"vifm--c",
 	"vifm--f",
@@ -889,6 +891,7 @@ const char *tags[] = {
 	"vifm-q_ALT-Space",
 	"vifm-q_ALT-V",
 	"vifm-q_CTRL-B",
+	"vifm-q_CTRL-C",
 	"vifm-q_CTRL-D",
 	"vifm-q_CTRL-E",
 	"vifm-q_CTRL-F",
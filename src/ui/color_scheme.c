@@ -23,12 +23,14 @@
 #include <regex.h> /* regexec() */
 
 #include <assert.h> /* assert() */
+#include <ctype.h> /* tolower() */
 #include <limits.h> /* INT_MAX */
 #include <math.h> /* abs() */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uintptr_t */
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() */
-#include <string.h> /* memcpy() memset() strcpy() strlen() */
+#include <string.h> /* memcpy() memset() strchr() strcpy() strdup() strlen() */
 
 #include "../cfg/config.h"
 #include "../compat/dtype.h"
@@ -37,18 +39,46 @@
 #include "../compat/reallocarray.h"
 #include "../engine/completion.h"
 #include "../modes/dialogs/msg_dialog.h"
+#include "../utils/darray.h"
 #include "../utils/fs.h"
 #include "../utils/fsddata.h"
 #include "../utils/macros.h"
 #include "../utils/matchers.h"
+#include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "../status.h"
 #include "color_manager.h"
 #include "statusbar.h"
 #include "ui.h"
 
+/* Index of file highlight rules.  Rules that match file names against literals
+ * and extensions (globs like `*.ext`) are looked up by lower case key, which
+ * yields the first such rule.  The rest of the rules are checked one by one,
+ * but only until the first rule found via lookup. */
+typedef struct file_hi_index_t
+{
+	trie_t *names; /* Maps literal names to indexes of rules. */
+	trie_t *exts;  /* Maps extensions with leading dot to indexes of rules. */
+
+	int *others;                /* Indexes of rules that weren't indexed. */
+	DA_INSTANCE_FIELD(others);  /* Declarations to enable use of DA_* on
+	                               others. */
+}
+file_hi_index_t;
+
+/* Kinds of globs with regard to indexing them. */
+typedef enum
+{
+	GK_EMPTY, /* Empty glob, which matches nothing. */
+	GK_NAME,  /* Literal file name. */
+	GK_EXT,   /* Extension (`*.ext`). */
+	GK_OTHER, /* Glob that can't be indexed. */
+}
+GlobKind;
+
 char *HI_GROUPS[] = {
 	[WIN_COLOR]          = "Win",
 	[DIRECTORY_COLOR]    = "Directory",
@@ -534,6 +564,17 @@ static void free_cs_highlights(col_scheme_t *cs);
 static file_hi_t * clone_file_highlights(const col_scheme_t *from);
 static col_attr_t * clone_column_highlights(const col_scheme_t *from);
 static void reset_cs_colors(col_scheme_t *cs);
+static void rebuild_file_hi_index(col_scheme_t *cs);
+static void free_file_hi_index(file_hi_index_t *index);
+static int index_file_hi(file_hi_index_t *index, const file_hi_t *file_hi,
+		int i);
+static int globs_are_indexable(const char globs[]);
+static GlobKind classify_glob(const char glob[]);
+static int index_put(trie_t *trie, char key[], int i);
+static int find_file_hi(const col_scheme_t *cs, const char fname[]);
+static int index_lookup(const file_hi_index_t *index, const char fname[]);
+static int index_get(trie_t *trie, const char key[], int best);
+static void to_lower(char str[]);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
 static int get_colors_dir(int idx, char buf[], size_t buf_len);
@@ -938,6 +979,8 @@ cs_assign(col_scheme_t *to, const col_scheme_t *from)
 	*to = *from;
 	to->file_hi = clone_file_highlights(from);
 	to->column_hi = clone_column_highlights(from);
+	to->file_hi_index = NULL;
+	rebuild_file_hi_index(to);
 }
 
 /* Resets color scheme to default builtin values. */
@@ -967,6 +1010,9 @@ free_cs_highlights(col_scheme_t *cs)
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
 
+	free_file_hi_index(cs->file_hi_index);
+	cs->file_hi_index = NULL;
+
 	free(cs->column_hi);
 	cs->column_hi = NULL;
 	cs->column_hi_count = 0;
@@ -1349,6 +1395,14 @@ cs_add_file_hi(struct matchers_t *matchers, const col_attr_t *hi)
 	file_hi->hi = *hi;
 
 	++cs->file_hi_count;
+
+	/* The new rule has the lowest priority, so it can just be added to the
+	 * index. */
+	if(cs->file_hi_index == NULL ||
+			index_file_hi(cs->file_hi_index, file_hi, cs->file_hi_count - 1) != 0)
+	{
+		rebuild_file_hi_index(cs);
+	}
 }
 
 const col_attr_t *
@@ -1365,19 +1419,83 @@ cs_get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
-	int i;
-	for(i = 0; i < cs->file_hi_count; ++i)
+	*hi_hint = find_file_hi(cs, fname);
+	return (*hi_hint == INT_MAX ? NULL : &cs->file_hi[*hi_hint].hi);
+}
+
+/* Finds the first file highlight rule that matches file name.  Returns index
+ * of the rule or INT_MAX if nothing matches. */
+static int
+find_file_hi(const col_scheme_t *cs, const char fname[])
+{
+	const file_hi_index_t *const index = cs->file_hi_index;
+	if(index == NULL)
 	{
-		const file_hi_t *const file_hi = &cs->file_hi[i];
-		if(matchers_match(file_hi->matchers, fname))
+		int i;
+		for(i = 0; i < cs->file_hi_count; ++i)
 		{
-			*hi_hint = i;
-			return &file_hi->hi;
+			if(matchers_match(cs->file_hi[i].matchers, fname))
+			{
+				return i;
+			}
 		}
+		return INT_MAX;
 	}
 
-	*hi_hint = INT_MAX;
-	return NULL;
+	const int found = index_lookup(index, fname);
+
+	size_t i;
+	for(i = 0U; i < DA_SIZE(index->others) && index->others[i] < found; ++i)
+	{
+		if(matchers_match(cs->file_hi[index->others[i]].matchers, fname))
+		{
+			return index->others[i];
+		}
+	}
+	return found;
+}
+
+/* Looks up the first indexed rule that matches file name.  Returns index of the
+ * rule or INT_MAX if nothing matches. */
+static int
+index_lookup(const file_hi_index_t *index, const char fname[])
+{
+	char *const name = strdup(get_last_path_component(fname));
+	if(name == NULL)
+	{
+		/* Make the caller check all the rules. */
+		return 0;
+	}
+	to_lower(name);
+
+	int best = index_get(index->names, name, INT_MAX);
+
+	/* Extensions aren't matched against the leading character and hidden files
+	 * don't have extensions. */
+	if(name[0] != '.')
+	{
+		const char *ext = name;
+		while((ext = strchr(ext + 1, '.')) != NULL)
+		{
+			best = index_get(index->exts, ext, best);
+		}
+	}
+
+	free(name);
+	return best;
+}
+
+/* Looks up rule index in the trie.  Returns the index if it's less than best,
+ * otherwise best is returned. */
+static int
+index_get(trie_t *trie, const char key[], int best)
+{
+	void *data;
+	if(trie_get(trie, key, &data) == 0 && (int)(uintptr_t)data < best)
+	{
+		return (int)(uintptr_t)data;
+	}
+	return best;
 }
 
 int
@@ -1394,6 +1512,7 @@ cs_del_file_hi(const char matchers_expr[])
 			memmove(&cs->file_hi[i], &cs->file_hi[i + 1],
 					sizeof(*cs->file_hi)*((cs->file_hi_count - 1) - i));
 			--cs->file_hi_count;
+			rebuild_file_hi_index(cs);
 			return 1;
 		}
 	}
@@ -1401,6 +1520,181 @@ cs_del_file_hi(const char matchers_expr[])
 	return 0;
 }
 
+/* Builds index of file highlight rules from scratch.  On failure the index is
+ * absent and rules are checked one by one. */
+static void
+rebuild_file_hi_index(col_scheme_t *cs)
+{
+	free_file_hi_index(cs->file_hi_index);
+	cs->file_hi_index = NULL;
+
+	file_hi_index_t *const index = calloc(1, sizeof(*index));
+	if(index == NULL)
+	{
+		return;
+	}
+
+	index->names = trie_create(/*free_func=*/NULL);
+	index->exts = trie_create(/*free_func=*/NULL);
+	if(index->names == NULL || index->exts == NULL)
+	{
+		free_file_hi_index(index);
+		return;
+	}
+
+	int i;
+	for(i = 0; i < cs->file_hi_count; ++i)
+	{
+		if(index_file_hi(index, &cs->file_hi[i], i) != 0)
+		{
+			free_file_hi_index(index);
+			return;
+		}
+	}
+
+	cs->file_hi_index = index;
+}
+
+/* Frees index of file highlight rules.  index can be NULL. */
+static void
+free_file_hi_index(file_hi_index_t *index)
+{
+	if(index != NULL)
+	{
+		trie_free(index->names);
+		trie_free(index->exts);
+		DA_REMOVE_ALL(index->others);
+		free(index);
+	}
+}
+
+/* Adds a rule, which must have the lowest priority, to the index.  i is index
+ * of the rule.  Returns zero on success, otherwise non-zero is returned. */
+static int
+index_file_hi(file_hi_index_t *index, const file_hi_t *file_hi, int i)
+{
+	const char *const simple_globs = matchers_get_simple_globs(file_hi->matchers);
+	char *const globs = (simple_globs == NULL ? NULL : strdup(simple_globs));
+	if(simple_globs != NULL && globs == NULL)
+	{
+		return 1;
+	}
+
+	if(globs == NULL || !globs_are_indexable(globs))
+	{
+		free(globs);
+
+		int *const other = DA_EXTEND(index->others);
+		if(other == NULL)
+		{
+			return 1;
+		}
+		*other = i;
+		DA_COMMIT(index->others);
+		return 0;
+	}
+
+	int error = 0;
+	char *glob = globs, *state = NULL;
+	while(!error && (glob = split_and_get_dc(glob, &state)) != NULL)
+	{
+		switch(classify_glob(glob))
+		{
+			case GK_NAME:
+				error = index_put(index->names, glob, i);
+				break;
+			case GK_EXT:
+				error = index_put(index->exts, glob + 1, i);
+				break;
+			case GK_EMPTY:
+				break;
+			case GK_OTHER:
+				assert(0 && "Unexpected glob kind.");
+				break;
+		}
+	}
+
+	free(globs);
+	return error;
+}
+
+/* Checks whether every glob in comma-separated list can be indexed.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+globs_are_indexable(const char globs[])
+{
+	char *const copy = strdup(globs);
+	if(copy == NULL)
+	{
+		return 0;
+	}
+
+	char *glob = copy, *state = NULL;
+	while((glob = split_and_get_dc(glob, &state)) != NULL)
+	{
+		if(classify_glob(glob) == GK_OTHER)
+		{
+			break;
+		}
+	}
+
+	free(copy);
+	return (glob == NULL);
+}
+
+/* Determines how a glob of simple globs matcher can be indexed.  Returns kind
+ * of the glob. */
+static GlobKind
+classify_glob(const char glob[])
+{
+	if(glob[0] == '\0')
+	{
+		return GK_EMPTY;
+	}
+
+	const char *const asterisk = strchr(glob, '*');
+	if(asterisk == NULL)
+	{
+		return GK_NAME;
+	}
+
+	if(asterisk == glob && glob[1] == '.' && strchr(glob + 1, '*') == NULL)
+	{
+		return GK_EXT;
+	}
+
+	return GK_OTHER;
+}
+
+/* Maps lower case version of the key to rule index unless key is already
+ * mapped to a rule with higher priority.  The key is modified.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+index_put(trie_t *trie, char key[], int i)
+{
+	to_lower(key);
+
+	void *data;
+	if(trie_get(trie, key, &data) == 0)
+	{
+		return 0;
+	}
+
+	return (trie_set(trie, key, (void *)(uintptr_t)i) < 0);
+}
+
+/* Converts string to lower case in place the same way strcasecmp() compares
+ * strings. */
+static void
+to_lower(char str[])
+{
+	while(*str != '\0')
+	{
+		*str = tolower((unsigned char)*str);
+		++str;
+	}
+}
+
 int
 cs_is_color_set(const col_attr_t *color)
 {
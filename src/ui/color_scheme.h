@@ -61,6 +61,8 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	/* Index of file_hi for faster lookup (can be NULL). */
+	struct file_hi_index_t *file_hi_index;
 
 	col_attr_t *column_hi; /* List of column highlight preferences.
 	                          Unused entries are filled with 0xff. */
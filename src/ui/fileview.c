@@ -28,13 +28,18 @@
 #include <grp.h>
 #endif
 
+#include <sys/types.h> /* mode_t */
+
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* abs() malloc() */
-#include <string.h> /* memset() strcpy() strlen() */
+#include <string.h> /* memmove() memset() strcpy() strlen() */
+#include <time.h> /* time_t */
 
 #include "../cfg/config.h"
 #include "../compat/pthread.h"
+#include "../compat/reallocarray.h"
 #include "../lua/vlua.h"
 #include "../utils/fs.h"
 #include "../utils/macros.h"
@@ -49,7 +54,6 @@
 #include "../flist_pos.h"
 #include "../opt_handlers.h"
 #include "../sort.h"
-#include "../vifm.h"
 #include "color_scheme.h"
 #include "column_view.h"
 #include "quickview.h"
@@ -92,8 +96,70 @@
  *
  * Padding should be included in widths unless it's explicitly specified
  * separately.
+ *
+ * Partial redraw
+ * --------------
+ *
+ * Full redraw of a file list remembers state of entries drawn in each cell of
+ * the window (render cache).  When only top line of the view changes, contents
+ * of the window is scrolled and only cells that don't match the cache are
+ * redrawn.  Curses compares windows with the screen on its own, but scrolling
+ * saves formatting of every cell and lets curses scroll the terminal when a
+ * view spans the whole width of the screen.  Anything drawn over the list
+ * outside of this unit must invalidate the cache.
  */
 
+/* Flags that describe state of a drawn cell. */
+enum
+{
+	DCF_SELECTED = 1 << 0, /* Entry was selected. */
+	DCF_MARKED   = 1 << 1, /* Entry was marked. */
+	DCF_CURRENT  = 1 << 2, /* Entry was under the cursor. */
+	DCF_UNKNOWN  = 1 << 3, /* Contents of the cell isn't known. */
+};
+
+/* State of an entry at the moment it was drawn in a cell. */
+typedef struct
+{
+	const dir_entry_t *entry; /* Drawn entry or NULL if the cell is empty. */
+	const char *name;         /* Name of the entry. */
+	uint64_t size;            /* Size of the entry. */
+	time_t mtime;             /* Modification time of the entry. */
+	mode_t mode;              /* Mode of the entry. */
+	int search_match;         /* Search match of the entry. */
+	int hi_num;               /* Cached highlight of the entry. */
+	int flags;                /* Combination of DCF_* flags. */
+}
+drawn_cell_t;
+
+/* Parameters of a file list, change of any of which makes render cache
+ * unusable. */
+typedef struct
+{
+	const dir_entry_t *entries; /* List of entries. */
+	int list_rows;              /* Number of entries. */
+	int window_rows;            /* Height of the window. */
+	int window_cols;            /* Width of the window. */
+	size_t col_count;           /* Number of columns. */
+	size_t col_width;           /* Width of a column. */
+	int num_width;              /* Width of line number field. */
+	int left_reserved;          /* Width of the left miller column. */
+	int right_reserved;         /* Width of the right miller column. */
+}
+render_layout_t;
+
+/* Information about what is displayed in a window of a file list. */
+typedef struct
+{
+	WINDOW *win;            /* Window the cache is bound to or NULL. */
+	int valid;              /* Whether the cache matches the window. */
+	int top;                /* Top line of the view. */
+	render_layout_t layout; /* Layout of the view. */
+	drawn_cell_t *cells;    /* State of cells. */
+	int ncells;             /* Number of elements in cells array. */
+}
+render_cache_t;
+
 static void draw_left_column(view_t *view);
 static void draw_right_column(view_t *view);
 static void draw_miller_separator(view_t *view, int column);
@@ -179,7 +245,23 @@ static int cache_cursor_pos(view_t *view);
 static void invalidate_cursor_pos_cache(view_t *view);
 static void position_hardware_cursor(view_t *view);
 static int move_curr_line(view_t *view);
+static int cell_width_changed(view_t *view, size_t col_width);
 static void reset_view_columns(view_t *view);
+static int scroll_dir_list(view_t *view, int old_top);
+static render_cache_t * get_render_cache(const view_t *view, int create);
+static void start_render_cache(view_t *view, int ncells, size_t col_count,
+		size_t col_width);
+static void update_render_cache(const view_t *view, int cell, int top,
+		const dir_entry_t *entry, int is_current);
+static void shift_render_cache(render_cache_t *rc, int by);
+static render_layout_t get_render_layout(const view_t *view, size_t col_count,
+		size_t col_width);
+static int layouts_equal(const render_layout_t *a, const render_layout_t *b);
+static drawn_cell_t make_drawn_cell(const dir_entry_t *entry, int is_current);
+static int drawn_cells_equal(const drawn_cell_t *a, const drawn_cell_t *b);
+
+/* Render caches of windows of the views. */
+static render_cache_t render_caches[2];
 
 void
 fview_setup(void)
@@ -313,7 +395,8 @@ draw_dir_list_only(view_t *view)
 	size_t col_width, col_count;
 	int visible_cells;
 
-	if(curr_stats.load_stage < 2 || vifm_testing())
+	/* Window is missing in tests unless they draw. */
+	if(curr_stats.load_stage < 2 || view->win == NULL)
 	{
 		return;
 	}
@@ -333,14 +416,16 @@ draw_dir_list_only(view_t *view)
 
 	ui_view_erase(view, 0);
 
-	draw_left_column(view);
-
 	visible_cells = view->window_cells;
 	if(has_extra_tls_col(view, col_width))
 	{
 		visible_cells += view->window_rows;
 	}
 
+	start_render_cache(view, visible_cells, col_count, col_width);
+
+	draw_left_column(view);
+
 	for(x = view->top_line, cell = 0;
 			x < view->list_rows && cell < visible_cells;
 			++x, ++cell)
@@ -684,28 +769,13 @@ get_entry_color(const view_t *view, const dir_entry_t *entry)
 		case FT_FIFO:
 			return FIFO_COLOR;
 		case FT_LINK:
-			if(view->on_slow_fs)
+			/* Status of link target is determined on loading the entry to avoid
+			 * querying file system on every redraw. */
+			if(view->on_slow_fs || !entry->broken_link)
 			{
 				return LINK_COLOR;
 			}
-			else
-			{
-				char full[PATH_MAX + 1];
-				get_full_path_of(entry, sizeof(full), full);
-				if(get_link_target_abs(full, entry->origin, full, sizeof(full)) != 0)
-				{
-					return BROKEN_LINK_COLOR;
-				}
-
-				/* Assume that targets on slow file system are not broken as actual
-				 * check might take long time. */
-				if(is_on_slow_fs(full, cfg.slow_fs_list))
-				{
-					return LINK_COLOR;
-				}
-
-				return path_exists(full, DEREF) ? LINK_COLOR : BROKEN_LINK_COLOR;
-			}
+			return BROKEN_LINK_COLOR;
 #ifndef _WIN32
 		case FT_SOCK:
 			return SOCKET_COLOR;
@@ -956,6 +1026,9 @@ fview_draw_inactive_cursor(view_t *view)
 	/* Reset last seen position on drawing inactive cursor or an active one won't
 	 * be drawn next time. */
 	invalidate_cursor_pos_cache(view);
+	/* Partial redraw isn't performed for inactive view, but contents of the
+	 * window can change while it's inactive. */
+	fview_invalidate_render_cache(view);
 
 	if(curr_stats.load_stage < 2)
 	{
@@ -1081,6 +1154,9 @@ compute_and_draw_cell(column_data_t *cdt, int cell, size_t col_count,
 	draw_cell(columns, cdt, lpadding, col_width - lpadding - rpadding, rpadding);
 
 	cdt->prefix_len = NULL;
+
+	update_render_cache(cdt->view, cell, cdt->line_pos - cell, cdt->entry,
+			cdt->line_pos == cdt->current_pos);
 }
 
 void
@@ -2073,7 +2149,10 @@ fview_position_updated(view_t *view)
 
 	if(redraw)
 	{
-		draw_dir_list(view);
+		if(!scroll_dir_list(view, old_top))
+		{
+			draw_dir_list(view);
+		}
 	}
 	else
 	{
@@ -2167,6 +2246,317 @@ position_hardware_cursor(view_t *view)
 			(cfg.extra_padding != 0) + column_offset + prefix_len);
 }
 
+/* Updates the view after change of its top line by scrolling contents of the
+ * window and redrawing only cells that differ from what was drawn there.
+ * Returns non-zero on success, otherwise zero is returned and full redraw is
+ * needed. */
+static int
+scroll_dir_list(view_t *view, int old_top)
+{
+	render_cache_t *const rc = get_render_cache(view, /*create=*/0);
+	if(rc == NULL || !rc->valid || rc->top != old_top)
+	{
+		return 0;
+	}
+
+	/* Relative numbers change on every movement, graphics can't be scrolled and
+	 * transposed view is scrolled horizontally. */
+	if(curr_stats.load_stage < 2 || view != curr_view ||
+			(view->num_type & NT_REL) || view->displays_graphics ||
+			fview_is_transposed(view))
+	{
+		return 0;
+	}
+
+	size_t col_width, col_count;
+	calculate_table_conf(view, &col_count, &col_width);
+
+	const render_layout_t layout = get_render_layout(view, col_count, col_width);
+	if(!layouts_equal(&layout, &rc->layout))
+	{
+		return 0;
+	}
+
+	if(cell_width_changed(view, col_width))
+	{
+		return 0;
+	}
+
+	const int by = view->top_line - old_top;
+	if(by%view->run_size != 0 || abs(by/view->run_size) >= view->window_rows)
+	{
+		return 0;
+	}
+
+	if(by != 0)
+	{
+		scrollok(view->win, TRUE);
+		wscrl(view->win, by/view->run_size);
+		scrollok(view->win, FALSE);
+
+		shift_render_cache(rc, by);
+	}
+	rc->top = view->top_line;
+
+	int cell;
+	for(cell = 0; cell < rc->ncells; ++cell)
+	{
+		const int pos = view->top_line + cell;
+		const dir_entry_t *entry = (pos < view->list_rows)
+		                         ? &view->dir_entry[pos]
+		                         : NULL;
+		const int is_current = (pos == view->list_pos);
+
+		const drawn_cell_t drawn = make_drawn_cell(entry, is_current);
+		if(drawn_cells_equal(&drawn, &rc->cells[cell]))
+		{
+			continue;
+		}
+
+		if(entry == NULL)
+		{
+			/* Clearing a cell isn't supported. */
+			return 0;
+		}
+
+		column_data_t cdt = {
+			.view = view,
+			.entry = &view->dir_entry[pos],
+			.line_pos = pos,
+			.current_pos = view->list_pos,
+		};
+
+		if(is_current && !ui_view_displays_columns(view))
+		{
+			/* Inactive cell in ls-like view usually takes less space than an active
+			 * one.  Need to clear the cell before drawing over it. */
+			cdt.current_pos = -1;
+			compute_and_draw_cell(&cdt, cell, col_count, col_width);
+			cdt.current_pos = view->list_pos;
+		}
+
+		compute_and_draw_cell(&cdt, cell, col_count, col_width);
+	}
+
+	draw_left_column(view);
+	draw_right_column(view);
+
+	view->curr_line = view->list_pos - view->top_line;
+
+	consider_scroll_bind(view);
+	position_hardware_cursor(view);
+
+	ui_view_win_changed(view);
+	return 1;
+}
+
+void
+fview_invalidate_render_cache(view_t *view)
+{
+	render_cache_t *const rc = get_render_cache(view, /*create=*/0);
+	if(rc != NULL)
+	{
+		rc->valid = 0;
+	}
+}
+
+/* Looks up render cache of the window of the view.  Returns the cache or NULL
+ * if there is none and it wasn't requested to be created or all caches are in
+ * use. */
+static render_cache_t *
+get_render_cache(const view_t *view, int create)
+{
+	if(view->win == NULL)
+	{
+		return NULL;
+	}
+
+	render_cache_t *unused = NULL;
+
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(render_caches); ++i)
+	{
+		if(render_caches[i].win == view->win)
+		{
+			return &render_caches[i];
+		}
+		if(render_caches[i].win == NULL && unused == NULL)
+		{
+			unused = &render_caches[i];
+		}
+	}
+
+	if(create && unused != NULL)
+	{
+		unused->win = view->win;
+		return unused;
+	}
+	return NULL;
+}
+
+/* Prepares render cache of the view for a full redraw of the window. */
+static void
+start_render_cache(view_t *view, int ncells, size_t col_count,
+		size_t col_width)
+{
+	render_cache_t *const rc = get_render_cache(view, /*create=*/1);
+	if(rc == NULL)
+	{
+		return;
+	}
+
+	if(ncells != rc->ncells)
+	{
+		drawn_cell_t *const cells = reallocarray(rc->cells, ncells,
+				sizeof(*cells));
+		if(cells == NULL && ncells != 0)
+		{
+			rc->valid = 0;
+			return;
+		}
+		rc->cells = cells;
+		rc->ncells = ncells;
+	}
+
+	/* Cells that aren't drawn remain empty. */
+	int i;
+	for(i = 0; i < ncells; ++i)
+	{
+		rc->cells[i] = make_drawn_cell(NULL, 0);
+	}
+
+	rc->valid = 1;
+	rc->top = view->top_line;
+	rc->layout = get_render_layout(view, col_count, col_width);
+}
+
+/* Records drawing of a cell in render cache of the view.  top is the top line
+ * with which cell index was computed. */
+static void
+update_render_cache(const view_t *view, int cell, int top,
+		const dir_entry_t *entry, int is_current)
+{
+	render_cache_t *const rc = get_render_cache(view, /*create=*/0);
+	if(rc == NULL || !rc->valid)
+	{
+		return;
+	}
+
+	if(top != rc->top || cell < 0 || cell >= rc->ncells)
+	{
+		/* Drawing doesn't match the cache, better stop using it. */
+		rc->valid = 0;
+		return;
+	}
+
+	rc->cells[cell] = make_drawn_cell(entry, is_current);
+}
+
+/* Moves cells of render cache to reflect scrolling by the specified number of
+ * cells.  Cells that became visible are marked as unknown. */
+static void
+shift_render_cache(render_cache_t *rc, int by)
+{
+	const int kept = rc->ncells - abs(by);
+	const drawn_cell_t unknown = { .flags = DCF_UNKNOWN };
+
+	int i;
+	if(by > 0)
+	{
+		memmove(&rc->cells[0], &rc->cells[by], sizeof(*rc->cells)*kept);
+		for(i = kept; i < rc->ncells; ++i)
+		{
+			rc->cells[i] = unknown;
+		}
+	}
+	else
+	{
+		memmove(&rc->cells[-by], &rc->cells[0], sizeof(*rc->cells)*kept);
+		for(i = 0; i < -by; ++i)
+		{
+			rc->cells[i] = unknown;
+		}
+	}
+}
+
+/* Collects parameters of the view that affect placement of cells.  Returns the
+ * parameters. */
+static render_layout_t
+get_render_layout(const view_t *view, size_t col_count, size_t col_width)
+{
+	const render_layout_t layout = {
+		.entries = view->dir_entry,
+		.list_rows = view->list_rows,
+		.window_rows = view->window_rows,
+		.window_cols = view->window_cols,
+		.col_count = col_count,
+		.col_width = col_width,
+		.num_width = view->real_num_width,
+		.left_reserved = ui_view_left_reserved(view),
+		.right_reserved = ui_view_right_reserved(view),
+	};
+	return layout;
+}
+
+/* Compares two layouts.  Returns non-zero if they are the same, otherwise zero
+ * is returned. */
+static int
+layouts_equal(const render_layout_t *a, const render_layout_t *b)
+{
+	return a->entries == b->entries
+	    && a->list_rows == b->list_rows
+	    && a->window_rows == b->window_rows
+	    && a->window_cols == b->window_cols
+	    && a->col_count == b->col_count
+	    && a->col_width == b->col_width
+	    && a->num_width == b->num_width
+	    && a->left_reserved == b->left_reserved
+	    && a->right_reserved == b->right_reserved;
+}
+
+/* Captures state of an entry that affects how it's drawn.  entry can be NULL
+ * for an empty cell.  Returns the state. */
+static drawn_cell_t
+make_drawn_cell(const dir_entry_t *entry, int is_current)
+{
+	if(entry == NULL)
+	{
+		const drawn_cell_t empty = { .entry = NULL };
+		return empty;
+	}
+
+	const drawn_cell_t drawn = {
+		.entry = entry,
+		.name = entry->name,
+		.size = entry->size,
+		.mtime = entry->mtime,
+		.mode = entry->mode,
+		.search_match = entry->search_match,
+		.hi_num = entry->hi_num,
+		.flags = (entry->selected ? DCF_SELECTED : 0)
+		       | (entry->marked ? DCF_MARKED : 0)
+		       | (is_current ? DCF_CURRENT : 0),
+	};
+	return drawn;
+}
+
+/* Compares states of two cells.  Returns non-zero if they are drawn in the same
+ * way, otherwise zero is returned. */
+static int
+drawn_cells_equal(const drawn_cell_t *a, const drawn_cell_t *b)
+{
+	return !(a->flags & DCF_UNKNOWN)
+	    && !(b->flags & DCF_UNKNOWN)
+	    && a->entry == b->entry
+	    && a->name == b->name
+	    && a->size == b->size
+	    && a->mtime == b->mtime
+	    && a->mode == b->mode
+	    && a->search_match == b->search_match
+	    && a->hi_num == b->hi_num
+	    && a->flags == b->flags;
+}
+
 /* Returns non-zero if redraw is needed. */
 static int
 move_curr_line(view_t *view)
@@ -2175,7 +2565,6 @@ move_curr_line(view_t *view)
 	int pos = view->list_pos;
 	int last;
 	size_t col_width, col_count;
-	columns_t *columns;
 
 	if(pos < 1)
 		pos = 0;
@@ -2215,9 +2604,7 @@ move_curr_line(view_t *view)
 	}
 
 	calculate_table_conf(view, &col_count, &col_width);
-	/* Columns might be NULL in tests. */
-	columns = get_view_columns(view, 0);
-	if(columns != NULL && !columns_matches_width(columns, col_width))
+	if(cell_width_changed(view, col_width))
 	{
 		redraw++;
 	}
@@ -2225,6 +2612,28 @@ move_curr_line(view_t *view)
 	return redraw != 0 || (view->num_type & NT_REL);
 }
 
+/* Checks whether columns of the view were formatted for a different width of a
+ * cell.  Returns non-zero if so, otherwise zero is returned. */
+static int
+cell_width_changed(view_t *view, size_t col_width)
+{
+	/* Columns might be NULL in tests. */
+	columns_t *const columns = get_view_columns(view, 0);
+	if(columns == NULL)
+	{
+		return 0;
+	}
+
+	/* Padding isn't part of columns.  Cells of ls-like view don't have the same
+	 * width, so they are compared as is. */
+	int width = col_width;
+	if(ui_view_displays_columns(view) && cfg.extra_padding)
+	{
+		width -= 2;
+	}
+	return !columns_matches_width(columns, width);
+}
+
 void
 fview_sorting_updated(view_t *view)
 {
@@ -76,6 +76,10 @@ void fview_reset(struct view_t *view);
 /* Resets view state with regard to color schemes. */
 void fview_reset_cs(struct view_t *view);
 
+/* Forgets what was drawn in the window of the view to not rely on it during
+ * the next update.  Should be called when something else is drawn there. */
+void fview_invalidate_render_cache(struct view_t *view);
+
 /* Appearance related functions. */
 
 /* Redraws directory list and puts inactive mark for the other view. */
@@ -437,7 +437,7 @@ get_lines(const quickview_cache_t *cache)
 	               : qv_expand_viewer(cache->pa.source, cache->viewer, &flags);
 
 	strlist_t lines = vcache_lookup(cache->path, expanded, flags, cache->kind,
-			cache->max_lines, VC_ASYNC, &error);
+			cache->max_lines, VC_ASYNC, &qv_is_previewed, &error);
 	free(expanded);
 
 	if(error != NULL)
@@ -939,6 +939,7 @@ wipe_area(const preview_area_t *parea)
 	if(cfg.hard_graphics_clear)
 	{
 		wclear(parea->view->win);
+		fview_invalidate_render_cache(parea->view);
 		return;
 	}
 
@@ -1023,5 +1024,19 @@ qv_ui_updated(void)
 	qv_cache.graphics_lost = 1;
 }
 
+int
+qv_is_previewed(const char path[])
+{
+	if(curr_stats.preview.on)
+	{
+		dir_entry_t *entry = get_current_entry(curr_view);
+		return fentry_points_to(entry, path);
+	}
+
+	/* Not using curr_view and other_view, because they can be temporarily
+	 * changed while a preview is being produced. */
+	return (fview_previews(&lwin, path) || fview_previews(&rwin, path));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
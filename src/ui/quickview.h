@@ -94,6 +94,10 @@ void qv_get_path_to_explore(const struct dir_entry_t *entry, char buf[],
 /* Informs this unit that it's data was probably erased from the screen. */
 void qv_ui_updated(void);
 
+/* Checks if preview of specified path is visible.  Returns non-zero if so and
+ * zero otherwise. */
+int qv_is_previewed(const char path[]);
+
 #endif /* VIFM__UI__QUICKVIEW_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
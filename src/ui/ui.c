@@ -478,6 +478,11 @@ create_windows(void)
 	leaveok(job_bar, TRUE);
 	leaveok(ruler_win, TRUE);
 	leaveok(input_win, TRUE);
+
+	/* Let curses consider scrolling terminal when contents of file lists is
+	 * scrolled. */
+	idlok(lwin.win, TRUE);
+	idlok(rwin.win, TRUE);
 }
 
 void
@@ -2848,6 +2853,8 @@ ui_view_erase(view_t *view, int use_global_cs)
 	col_attr_t col = ui_get_win_color(view, cs);
 	ui_set_bg(view->win, &col, -1);
 	werase(view->win);
+
+	fview_invalidate_render_cache(view);
 }
 
 col_attr_t
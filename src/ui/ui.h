@@ -266,6 +266,8 @@ struct dir_entry_t
 	unsigned int temporary : 1;    /* Whether this is temporary node. */
 	unsigned int dir_link : 1;     /* Whether this is symlink to a directory. */
 	unsigned int slow_target : 1;  /* Whether this symlink has a slow target. */
+	unsigned int broken_link : 1;  /* Whether target of this symlink is missing.
+	                                  Determined on loading the entry. */
 	unsigned int owns_origin : 1;  /* Whether this entry is custom one. */
 	unsigned int folded : 1;       /* Whether this entry is folded. */
 };
@@ -399,6 +401,8 @@ struct view_t
 
 	fswatch_t *watch;  /* Monitor that checks for directory changes. */
 	char *watched_dir; /* Path for which the monitor was created. */
+	/* Watches for directories of a tree or NULL to poll them instead. */
+	fswatch_set_t *tree_watch;
 
 	char *last_dir; /* Location visited by the view before the current one. */
 
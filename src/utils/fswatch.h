@@ -31,6 +31,23 @@ typedef enum
 }
 FSWatchState;
 
+/* Kinds of changes of a directory entry, can be combined. */
+typedef enum
+{
+	FSWC_CREATED  = 1 << 0, /* Entry appeared (created or moved in). */
+	FSWC_DELETED  = 1 << 1, /* Entry disappeared (deleted or moved out). */
+	FSWC_MODIFIED = 1 << 2, /* Contents or attributes of the entry changed. */
+}
+FSWatchChange;
+
+/* Description of changes of a single directory entry. */
+typedef struct
+{
+	char *name;  /* Name of the entry. */
+	int changes; /* Combination of FSWatchChange values. */
+}
+fswatch_change_t;
+
 /* Opaque type of a watcher. */
 typedef struct fswatch_t fswatch_t;
 
@@ -45,6 +62,34 @@ void fswatch_free(fswatch_t *w);
  * query.  Returns latest state. */
 FSWatchState fswatch_poll(fswatch_t *w);
 
+/* Retrieves changes of entries of the watched directory that were collected by
+ * the last fswatch_poll() that reported FSWS_UPDATED.  *changes is set to point
+ * to an internal array.  Returns number of elements in the array or -1 if
+ * changes aren't known in detail (e.g., some events were lost), in which case
+ * everything should be considered as changed. */
+int fswatch_get_changes(const fswatch_t *w, const fswatch_change_t **changes);
+
+/* Opaque type of a set of watches for several directories, which reports only
+ * changes of lists of files of those directories. */
+typedef struct fswatch_set_t fswatch_set_t;
+
+/* Creates an empty set of watches.  Returns the set or NULL on error or if
+ * sets aren't supported on this platform. */
+fswatch_set_t * fswatch_set_create(void);
+
+/* Frees a set of watches.  s can be NULL. */
+void fswatch_set_free(fswatch_set_t *s);
+
+/* Makes the set watch exactly the specified directories by adding new watches
+ * and removing those that aren't in the list.  Returns zero on success,
+ * otherwise non-zero is returned (e.g., when system limit on number of watches
+ * is reached), in which case the set should be freed in favour of a fallback. */
+int fswatch_set_update(fswatch_set_t *s, char *paths[], int count);
+
+/* Checks whether any of directories of the set has changed since last query.
+ * Returns latest state, which is never FSWS_REPLACED. */
+FSWatchState fswatch_set_poll(fswatch_set_t *s);
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
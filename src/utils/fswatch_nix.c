@@ -26,27 +26,58 @@
 #include <sys/types.h> /* dev_t ino_t */
 #include <unistd.h> /* close() read() */
 
-#include <errno.h> /* EAGAIN errno */
-#include <stddef.h> /* NULL */
-#include <stdint.h> /* uint32_t */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <errno.h> /* EAGAIN ENOMEM ENOSPC errno */
+#include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* intptr_t uint32_t */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* memcpy() memmove() memset() strdup() */
 #include <time.h> /* time_t time() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "darray.h"
 #include "trie.h"
 
-/* TODO: consider implementation that could reuse already available descriptor
- *       by just removing old watch and then adding a new one. */
+/* All watchers share single inotify instance, which exists while there is at
+ * least one watcher.  Kernel watches are shared as well (inotify returns the
+ * same descriptor when the same file is added twice), so each of them is
+ * reference counted and its events are dispatched to every subscriber. */
+
+/* Events received for a watcher, but not processed by it yet. */
+typedef struct
+{
+	char *events;    /* Events in the format returned by read(). */
+	size_t len;      /* Number of used bytes in the buffer. */
+	size_t capacity; /* Size of the buffer. */
+	int overflow;    /* Whether some events were lost. */
+}
+inbox_t;
+
+/* Subscription of an inbox to events of a kernel watch. */
+typedef struct
+{
+	inbox_t *inbox; /* Where events are put. */
+	uint32_t mask;  /* Events that subscriber is interested in. */
+}
+sub_t;
+
+/* Kernel watch shared by one or more subscribers. */
+typedef struct
+{
+	int wd;                  /* Watch descriptor. */
+	sub_t *subs;             /* Subscriptions to events of the watch. */
+	DA_INSTANCE_FIELD(subs);
+}
+kwatch_t;
 
 /* Watcher data. */
 struct fswatch_t
 {
 	/* Path that's being watched. */
 	char *path;
-	/* File descriptor for inotify. */
-	int fd;
+	/* Events of the watch. */
+	inbox_t inbox;
 	/* Watch descriptor. */
 	int wd;
 	/* Trie to keep track of per file frequency of notifications. */
@@ -54,6 +85,24 @@ struct fswatch_t
 	/* To monitor mount events, which aren't reported by inotify. */
 	dev_t dev;
 	ino_t inode;
+
+	/* Changes of entries collected by the last poll. */
+	fswatch_change_t *changes;
+	DA_INSTANCE_FIELD(changes);
+	/* Whether list of changes describes everything that has happened. */
+	int changes_known;
+	/* Sequence number of the last poll to detect repeated events. */
+	unsigned int poll_id;
+};
+
+/* Watches of several directories. */
+struct fswatch_set_t
+{
+	inbox_t inbox; /* Events of all watches of the set. */
+	char **paths;  /* Paths of watched directories. */
+	int *wds;      /* Watch descriptors that correspond to the paths. */
+	int count;     /* Number of watched directories. */
+	trie_t *index; /* Maps paths to their positions in the arrays plus one. */
 };
 
 /* Per file statistics information. */
@@ -64,18 +113,54 @@ typedef struct
 	uint32_t ban_mask;   /* Events right before the ban. */
 	int count;           /* How many times file changed continuously in the last
 	                        several seconds. */
+	unsigned int poll_id; /* Poll during which the file was last changed. */
+	int change_idx;       /* Index of file's change during that poll. */
 }
 notif_stat_t;
 
 static FSWatchState poll_for_replacement(fswatch_t *w);
 static int update_file_stats(fswatch_t *w, const struct inotify_event *e,
 		time_t now);
+static void record_change(fswatch_t *w, const struct inotify_event *e);
+static void reset_changes(fswatch_t *w);
+static void free_set_watches(char *paths[], int wds[], int count,
+		trie_t *index);
+static int mux_acquire(inbox_t *inbox);
+static void mux_release(inbox_t *inbox);
+static int mux_subscribe(inbox_t *inbox, const char path[], uint32_t mask);
+static void mux_unsubscribe(inbox_t *inbox, int wd);
+static int mux_dispatch(void);
+static kwatch_t * find_kwatch(int wd, size_t *pos);
+static void queue_event(inbox_t *inbox, const struct inotify_event *e);
+static void clear_inbox(inbox_t *inbox);
+
+/* Maximum number of changes that are tracked individually per poll. */
+enum { MAX_CHANGES = 1024 };
+
+/* Maximum size of unprocessed events per watcher, which can accumulate if
+ * watcher isn't polled (e.g., it belongs to inactive tab). */
+enum { MAX_INBOX_SIZE = 64*1024 };
 
 /* Events we're interested in. */
 static const uint32_t EVENTS_MASK = IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE
                                   | IN_CREATE | IN_DELETE | IN_EXCL_UNLINK
                                   | IN_MOVED_FROM | IN_MOVED_TO;
 
+/* Events that change list of a directory, which is what watch sets are
+ * interested in. */
+static const uint32_t SET_EVENTS_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                      | IN_MOVED_TO | IN_ONLYDIR;
+
+/* State of the shared inotify instance. */
+static struct
+{
+	int fd;                     /* Inotify descriptor or -1. */
+	int users;                  /* Number of inboxes that use the instance. */
+	kwatch_t *watches;          /* Kernel watches sorted by descriptors. */
+	DA_INSTANCE_FIELD(watches);
+}
+mux = { .fd = -1 };
+
 fswatch_t *
 fswatch_create(const char path[])
 {
@@ -94,6 +179,11 @@ fswatch_create(const char path[])
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
 
+	w->changes = NULL;
+	DA_SIZE(w->changes) = 0U;
+	w->changes_known = 0;
+	w->poll_id = 0U;
+
 	/* Create tree to collect update frequency statistics. */
 	w->stats = trie_create(&free);
 	if(w->stats == NULL)
@@ -103,9 +193,7 @@ fswatch_create(const char path[])
 		return NULL;
 	}
 
-	/* Create inotify instance. */
-	w->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
-	if(w->fd == -1)
+	if(mux_acquire(&w->inbox) != 0)
 	{
 		trie_free(w->stats);
 		free(w);
@@ -113,10 +201,10 @@ fswatch_create(const char path[])
 	}
 
 	/* Add directory to watch. */
-	w->wd = inotify_add_watch(w->fd, path, EVENTS_MASK);
+	w->wd = mux_subscribe(&w->inbox, path, EVENTS_MASK);
 	if(w->wd == -1)
 	{
-		close(w->fd);
+		mux_release(&w->inbox);
 		trie_free(w->stats);
 		free(w);
 		return NULL;
@@ -137,9 +225,12 @@ fswatch_free(fswatch_t *w)
 {
 	if(w != NULL)
 	{
+		mux_unsubscribe(&w->inbox, w->wd);
+		mux_release(&w->inbox);
+		reset_changes(w);
+		DA_REMOVE_ALL(w->changes);
 		free(w->path);
 		trie_free(w->stats);
-		close(w->fd);
 		free(w);
 	}
 }
@@ -147,58 +238,56 @@ fswatch_free(fswatch_t *w)
 FSWatchState
 fswatch_poll(fswatch_t *w)
 {
-	enum { MAX_READS = 100 };
-	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
-
-	char buf[BUF_LEN];
-	int nread;
 	int changed = 0;
-	int nreads = 0;
 	const time_t now = time(NULL);
 
-	do
+	reset_changes(w);
+	w->changes_known = 1;
+	++w->poll_id;
+
+	if(mux_dispatch() != 0)
 	{
-		char *p;
-		struct inotify_event *e;
+		return FSWS_ERRORED;
+	}
 
-		/* Receive a package of events. */
-		nread = read(w->fd, buf, BUF_LEN);
-		if(nread < 0)
-		{
-			if(errno != EAGAIN)
-			{
-				return FSWS_ERRORED;
-			}
-			break;
-		}
+	if(w->inbox.overflow)
+	{
+		/* Some events were lost. */
+		w->changes_known = 0;
+		changed = 1;
+	}
 
-		/* And process each of them separately. */
-		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
+	const struct inotify_event *e;
+	const char *p;
+	const char *const end = w->inbox.events + w->inbox.len;
+	for(p = w->inbox.events; p < end; p += sizeof(struct inotify_event) + e->len)
+	{
+		e = (const struct inotify_event *)p;
+		if((e->mask & IN_IGNORED) != 0 && e->wd == w->wd)
 		{
-			e = (struct inotify_event *)p;
-			if((e->mask & IN_IGNORED) != 0 && e->wd == w->wd)
-			{
-				return poll_for_replacement(w);
-			}
-
-			if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
-			{
-				changed = 1;
-			}
+			clear_inbox(&w->inbox);
+			w->changes_known = 0;
+			return poll_for_replacement(w);
 		}
 
-		/* Limit maximum number of reads to ensure that we won't spend all our time
-		 * in this loop. */
-		if(++nreads > MAX_READS)
+		if((e->mask & EVENTS_MASK) != 0 && update_file_stats(w, e, now))
 		{
-			break;
+			record_change(w, e);
+			changed = 1;
 		}
 	}
-	while(nread != 0);
 
+	clear_inbox(&w->inbox);
 	return (changed ? FSWS_UPDATED : poll_for_replacement(w));
 }
 
+int
+fswatch_get_changes(const fswatch_t *w, const fswatch_change_t **changes)
+{
+	*changes = w->changes;
+	return (w->changes_known ? (int)DA_SIZE(w->changes) : -1);
+}
+
 /* Detects replacement of path's target.  Returns watcher's state. */
 static FSWatchState
 poll_for_replacement(fswatch_t *w)
@@ -217,16 +306,13 @@ poll_for_replacement(fswatch_t *w)
 	w->dev = st.st_dev;
 	w->inode = st.st_ino;
 
-	int wd = inotify_add_watch(w->fd, w->path, EVENTS_MASK);
+	int wd = mux_subscribe(&w->inbox, w->path, EVENTS_MASK);
 	if(wd == -1)
 	{
 		return FSWS_ERRORED;
 	}
 
-	/* We ignore error from this call because input should always be correct from
-	 * our side, yet watch descriptor might have been killed by the kernel.  So
-	 * checking for an error causes false positives. */
-	(void)inotify_rm_watch(w->fd, w->wd);
+	mux_unsubscribe(&w->inbox, w->wd);
 
 	w->wd = wd;
 	return FSWS_REPLACED;
@@ -257,6 +343,7 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 			stats->last_update = now;
 			stats->banned_until = 0U;
 			stats->count = 1;
+			stats->poll_id = 0U;
 			if(trie_set(w->stats, fname, stats) != 0)
 			{
 				free(stats);
@@ -298,6 +385,493 @@ update_file_stats(fswatch_t *w, const struct inotify_event *e, time_t now)
 	return 1;
 }
 
+/* Adds change described by the event to the list of changes of the current
+ * poll merging it with previous changes of the same entry. */
+static void
+record_change(fswatch_t *w, const struct inotify_event *e)
+{
+	if(!w->changes_known)
+	{
+		return;
+	}
+
+	void *data;
+	/* Changes of the directory itself can't be described per entry. */
+	if(e->len == 0U || trie_get(w->stats, e->name, &data) != 0)
+	{
+		w->changes_known = 0;
+		return;
+	}
+
+	notif_stat_t *const stats = data;
+	fswatch_change_t *change;
+	if(stats->poll_id == w->poll_id)
+	{
+		change = &w->changes[stats->change_idx];
+	}
+	else
+	{
+		if(DA_SIZE(w->changes) >= MAX_CHANGES ||
+				(change = DA_EXTEND(w->changes)) == NULL ||
+				(change->name = strdup(e->name)) == NULL)
+		{
+			w->changes_known = 0;
+			return;
+		}
+
+		change->changes = 0;
+		stats->poll_id = w->poll_id;
+		stats->change_idx = DA_SIZE(w->changes);
+		DA_COMMIT(w->changes);
+	}
+
+	if(e->mask & (IN_CREATE | IN_MOVED_TO))
+	{
+		change->changes |= FSWC_CREATED;
+	}
+	if(e->mask & (IN_DELETE | IN_MOVED_FROM))
+	{
+		change->changes |= FSWC_DELETED;
+	}
+	if(e->mask & (IN_ATTRIB | IN_MODIFY | IN_CLOSE_WRITE))
+	{
+		change->changes |= FSWC_MODIFIED;
+	}
+}
+
+/* Empties list of changes. */
+static void
+reset_changes(fswatch_t *w)
+{
+	size_t i;
+	for(i = 0U; i < DA_SIZE(w->changes); ++i)
+	{
+		free(w->changes[i].name);
+	}
+	DA_SIZE(w->changes) = 0U;
+}
+
+fswatch_set_t *
+fswatch_set_create(void)
+{
+	fswatch_set_t *const s = malloc(sizeof(*s));
+	if(s == NULL)
+	{
+		return NULL;
+	}
+
+	s->paths = NULL;
+	s->wds = NULL;
+	s->count = 0;
+
+	s->index = trie_create(/*free_func=*/NULL);
+	if(s->index == NULL)
+	{
+		free(s);
+		return NULL;
+	}
+
+	if(mux_acquire(&s->inbox) != 0)
+	{
+		trie_free(s->index);
+		free(s);
+		return NULL;
+	}
+
+	return s;
+}
+
+void
+fswatch_set_free(fswatch_set_t *s)
+{
+	if(s != NULL)
+	{
+		int i;
+		for(i = 0; i < s->count; ++i)
+		{
+			mux_unsubscribe(&s->inbox, s->wds[i]);
+		}
+		mux_release(&s->inbox);
+		free_set_watches(s->paths, s->wds, s->count, s->index);
+		free(s);
+	}
+}
+
+int
+fswatch_set_update(fswatch_set_t *s, char *paths[], int count)
+{
+	char **const new_paths = reallocarray(NULL, count, sizeof(*new_paths));
+	int *const wds = reallocarray(NULL, count, sizeof(*wds));
+	char *const used = calloc(s->count + 1, 1);
+	trie_t *const index = trie_create(/*free_func=*/NULL);
+	if((count != 0 && (new_paths == NULL || wds == NULL)) || used == NULL ||
+			index == NULL)
+	{
+		free(new_paths);
+		free(wds);
+		free(used);
+		trie_free(index);
+		return 1;
+	}
+
+	int error = 0;
+	int n = 0;
+	int i;
+	for(i = 0; i < count && !error; ++i)
+	{
+		void *data;
+		if(trie_get(index, paths[i], &data) == 0)
+		{
+			/* Skip duplicates. */
+			continue;
+		}
+
+		int wd;
+		if(trie_get(s->index, paths[i], &data) == 0)
+		{
+			const int old_pos = (intptr_t)data - 1;
+			used[old_pos] = 1;
+			wd = s->wds[old_pos];
+		}
+		else
+		{
+			wd = mux_subscribe(&s->inbox, paths[i], SET_EVENTS_MASK);
+			if(wd == -1)
+			{
+				/* Running out of watches or memory is fatal, the rest means that the
+				 * directory went away or can't be listed and thus has nothing to
+				 * watch. */
+				error = (errno == ENOSPC || errno == ENOMEM);
+				continue;
+			}
+		}
+
+		new_paths[n] = strdup(paths[i]);
+		if(new_paths[n] == NULL ||
+				trie_set(index, paths[i], (void *)(intptr_t)(n + 1)) < 0)
+		{
+			free(new_paths[n]);
+			mux_unsubscribe(&s->inbox, wd);
+			error = 1;
+			continue;
+		}
+
+		wds[n++] = wd;
+	}
+
+	for(i = 0; i < s->count; ++i)
+	{
+		if(!used[i])
+		{
+			mux_unsubscribe(&s->inbox, s->wds[i]);
+		}
+	}
+	free(used);
+
+	free_set_watches(s->paths, s->wds, s->count, s->index);
+	s->paths = new_paths;
+	s->wds = wds;
+	s->count = n;
+	s->index = index;
+
+	return error;
+}
+
+/* Frees data that describes watches of a set. */
+static void
+free_set_watches(char *paths[], int wds[], int count, trie_t *index)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(paths[i]);
+	}
+	free(paths);
+	free(wds);
+	trie_free(index);
+}
+
+FSWatchState
+fswatch_set_poll(fswatch_set_t *s)
+{
+	if(mux_dispatch() != 0)
+	{
+		return FSWS_ERRORED;
+	}
+
+	int changed = s->inbox.overflow;
+
+	const struct inotify_event *e;
+	const char *p;
+	const char *const end = s->inbox.events + s->inbox.len;
+	for(p = s->inbox.events; p < end; p += sizeof(struct inotify_event) + e->len)
+	{
+		e = (const struct inotify_event *)p;
+		/* Removal of a watch from the set isn't a change. */
+		if((e->mask & ~IN_IGNORED) != 0)
+		{
+			changed = 1;
+		}
+	}
+
+	clear_inbox(&s->inbox);
+	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
+}
+
+/* Initializes an inbox and makes sure that inotify instance exists.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+mux_acquire(inbox_t *inbox)
+{
+	if(mux.users == 0)
+	{
+		mux.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(mux.fd == -1)
+		{
+			return 1;
+		}
+	}
+
+	++mux.users;
+
+	inbox->events = NULL;
+	inbox->len = 0U;
+	inbox->capacity = 0U;
+	inbox->overflow = 0;
+	return 0;
+}
+
+/* Frees an inbox and closes inotify instance if it's not used anymore. */
+static void
+mux_release(inbox_t *inbox)
+{
+	free(inbox->events);
+
+	if(--mux.users == 0)
+	{
+		size_t i;
+		for(i = 0U; i < DA_SIZE(mux.watches); ++i)
+		{
+			DA_REMOVE_ALL(mux.watches[i].subs);
+		}
+		DA_REMOVE_ALL(mux.watches);
+
+		close(mux.fd);
+		mux.fd = -1;
+	}
+}
+
+/* Subscribes inbox to events of the path adding a kernel watch if necessary.
+ * Returns watch descriptor or -1 on error with errno set. */
+static int
+mux_subscribe(inbox_t *inbox, const char path[], uint32_t mask)
+{
+	/* Deliver events that happened so far to current subscribers only. */
+	(void)mux_dispatch();
+
+	/* Kernel watch might be shared with other subscribers, hence extending its
+	 * mask instead of overwriting it. */
+	const int wd = inotify_add_watch(mux.fd, path, mask | IN_MASK_ADD);
+	if(wd == -1)
+	{
+		return -1;
+	}
+
+	size_t pos;
+	kwatch_t *kw = find_kwatch(wd, &pos);
+	if(kw == NULL)
+	{
+		if(DA_EXTEND(mux.watches) == NULL)
+		{
+			(void)inotify_rm_watch(mux.fd, wd);
+			errno = ENOMEM;
+			return -1;
+		}
+		DA_COMMIT(mux.watches);
+
+		kw = &mux.watches[pos];
+		memmove(kw + 1, kw, sizeof(*kw)*(DA_SIZE(mux.watches) - 1U - pos));
+		memset(kw, 0, sizeof(*kw));
+		kw->wd = wd;
+	}
+
+	sub_t *const sub = DA_EXTEND(kw->subs);
+	if(sub == NULL)
+	{
+		if(DA_SIZE(kw->subs) == 0U)
+		{
+			(void)inotify_rm_watch(mux.fd, wd);
+			DA_REMOVE(mux.watches, kw);
+		}
+		errno = ENOMEM;
+		return -1;
+	}
+
+	sub->inbox = inbox;
+	sub->mask = mask;
+	DA_COMMIT(kw->subs);
+	return wd;
+}
+
+/* Removes subscription of the inbox to events of the watch descriptor and the
+ * kernel watch itself if it has no other subscribers. */
+static void
+mux_unsubscribe(inbox_t *inbox, int wd)
+{
+	kwatch_t *const kw = find_kwatch(wd, NULL);
+	if(kw == NULL)
+	{
+		return;
+	}
+
+	size_t i;
+	for(i = 0U; i < DA_SIZE(kw->subs); ++i)
+	{
+		if(kw->subs[i].inbox == inbox)
+		{
+			DA_REMOVE(kw->subs, &kw->subs[i]);
+			break;
+		}
+	}
+
+	if(DA_SIZE(kw->subs) == 0U)
+	{
+		/* We ignore error from this call because input should always be correct
+		 * from our side, yet watch descriptor might have been killed by the
+		 * kernel.  So checking for an error causes false positives. */
+		(void)inotify_rm_watch(mux.fd, wd);
+		DA_REMOVE(mux.watches, kw);
+	}
+}
+
+/* Reads events from inotify instance and puts them into inboxes of the
+ * subscribers.  Returns zero on success, otherwise non-zero is returned. */
+static int
+mux_dispatch(void)
+{
+	enum { MAX_READS = 100 };
+	enum { BUF_LEN = (10 * (sizeof(struct inotify_event) + NAME_MAX + 1)) };
+
+	char buf[BUF_LEN];
+	int nreads = 0;
+
+	/* Limit maximum number of reads to ensure that we won't spend all our time
+	 * in this loop. */
+	while(nreads++ < MAX_READS)
+	{
+		/* Receive a package of events. */
+		const int nread = read(mux.fd, buf, BUF_LEN);
+		if(nread <= 0)
+		{
+			return (nread < 0 && errno != EAGAIN);
+		}
+
+		/* And process each of them separately. */
+		const struct inotify_event *e;
+		const char *p;
+		for(p = buf; p < buf + nread; p += sizeof(struct inotify_event) + e->len)
+		{
+			e = (const struct inotify_event *)p;
+
+			size_t i, j;
+			if((e->mask & IN_Q_OVERFLOW) != 0)
+			{
+				for(i = 0U; i < DA_SIZE(mux.watches); ++i)
+				{
+					for(j = 0U; j < DA_SIZE(mux.watches[i].subs); ++j)
+					{
+						mux.watches[i].subs[j].inbox->overflow = 1;
+					}
+				}
+				continue;
+			}
+
+			const kwatch_t *const kw = find_kwatch(e->wd, NULL);
+			if(kw == NULL)
+			{
+				continue;
+			}
+
+			for(j = 0U; j < DA_SIZE(kw->subs); ++j)
+			{
+				const sub_t *const sub = &kw->subs[j];
+				if((e->mask & ((sub->mask & IN_ALL_EVENTS) | IN_IGNORED)) != 0)
+				{
+					queue_event(sub->inbox, e);
+				}
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Finds kernel watch by its descriptor.  *pos is set to position of the watch
+ * or to position at which it should be inserted, pos can be NULL.  Returns
+ * pointer to the watch or NULL if there is no such watch. */
+static kwatch_t *
+find_kwatch(int wd, size_t *pos)
+{
+	size_t l = 0U, r = DA_SIZE(mux.watches);
+	while(l < r)
+	{
+		const size_t m = l + (r - l)/2U;
+		if(mux.watches[m].wd < wd)
+		{
+			l = m + 1U;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+
+	if(pos != NULL)
+	{
+		*pos = l;
+	}
+	return (l < DA_SIZE(mux.watches) && mux.watches[l].wd == wd)
+	     ? &mux.watches[l]
+	     : NULL;
+}
+
+/* Appends event to the inbox or marks it as overflown. */
+static void
+queue_event(inbox_t *inbox, const struct inotify_event *e)
+{
+	const size_t size = sizeof(*e) + e->len;
+	if(inbox->overflow || inbox->len + size > MAX_INBOX_SIZE)
+	{
+		inbox->overflow = 1;
+		return;
+	}
+
+	if(inbox->len + size > inbox->capacity)
+	{
+		const size_t capacity = (inbox->capacity == 0U) ? 4096U
+		                                                : inbox->capacity*2U;
+		char *const events = realloc(inbox->events, capacity);
+		if(events == NULL)
+		{
+			inbox->overflow = 1;
+			return;
+		}
+		inbox->events = events;
+		inbox->capacity = capacity;
+	}
+
+	memcpy(inbox->events + inbox->len, e, size);
+	inbox->len += size;
+}
+
+/* Drops all events of the inbox. */
+static void
+clear_inbox(inbox_t *inbox)
+{
+	inbox->len = 0U;
+	inbox->overflow = 0;
+}
+
 #else
 
 #include "filemon.h"
@@ -362,6 +936,38 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+int
+fswatch_get_changes(const fswatch_t *w, const fswatch_change_t **changes)
+{
+	/* Only modification time is available. */
+	*changes = NULL;
+	return -1;
+}
+
+fswatch_set_t *
+fswatch_set_create(void)
+{
+	/* Polling each directory is what callers do without a set. */
+	return NULL;
+}
+
+void
+fswatch_set_free(fswatch_set_t *s)
+{
+}
+
+int
+fswatch_set_update(fswatch_set_t *s, char *paths[], int count)
+{
+	return 1;
+}
+
+FSWatchState
+fswatch_set_poll(fswatch_set_t *s)
+{
+	return FSWS_ERRORED;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -107,6 +107,38 @@ fswatch_poll(fswatch_t *w)
 	return (changed ? FSWS_UPDATED : FSWS_UNCHANGED);
 }
 
+int
+fswatch_get_changes(const fswatch_t *w, const fswatch_change_t **changes)
+{
+	/* Notifications don't carry names of entries. */
+	*changes = NULL;
+	return -1;
+}
+
+fswatch_set_t *
+fswatch_set_create(void)
+{
+	/* Polling each directory is what callers do without a set. */
+	return NULL;
+}
+
+void
+fswatch_set_free(fswatch_set_t *s)
+{
+}
+
+int
+fswatch_set_update(fswatch_set_t *s, char *paths[], int count)
+{
+	return 1;
+}
+
+FSWatchState
+fswatch_set_poll(fswatch_set_t *s)
+{
+	return FSWS_ERRORED;
+}
+
 /* Gets last directory modification time.  Returns non-zero on error, otherwise
  * zero is returned. */
 static int
@@ -593,6 +593,16 @@ matcher_is_full_path(const matcher_t *matcher)
 	return matcher->full_path;
 }
 
+const char *
+matcher_get_simple_globs(const matcher_t *matcher)
+{
+	if(!matcher->fglobs || matcher->negated || matcher->full_path)
+	{
+		return NULL;
+	}
+	return matcher->raw;
+}
+
 TSTATIC int
 matcher_is_fast(const matcher_t *matcher)
 {
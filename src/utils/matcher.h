@@ -66,6 +66,12 @@ int matcher_includes(const matcher_t *matcher, const matcher_t *like);
  * otherwise zero is returned. */
 int matcher_is_full_path(const matcher_t *matcher);
 
+/* Retrieves comma-separated list of globs of a matcher that isn't negated and
+ * matches file names against globs that contain at most one asterisk and no
+ * other special characters.  Returns the list or NULL if the matcher is of a
+ * different kind. */
+const char * matcher_get_simple_globs(const matcher_t *matcher);
+
 TSTATIC_DEFS(
 	int matcher_is_fast(const matcher_t *matcher);
 )
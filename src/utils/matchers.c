@@ -210,6 +210,14 @@ matchers_get_expr(const matchers_t *matchers)
 	return matchers->expr;
 }
 
+const char *
+matchers_get_simple_globs(const matchers_t *matchers)
+{
+	return (matchers->count == 1)
+	     ? matcher_get_simple_globs(matchers->list[0])
+	     : NULL;
+}
+
 int
 matchers_includes(const matchers_t *matchers, const matchers_t *like)
 {
@@ -0,0 +1,590 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "mfile.h"
+
+#ifndef _WIN32
+#include <unistd.h> /* pread() ssize_t */
+#endif
+#include <sys/stat.h> /* fstat() stat */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE SEEK_SET fclose() fileno() fread() fseek() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() */
+#include <string.h> /* memchr() memcpy() strdup() */
+
+#include "../compat/os.h"
+#include "../compat/reallocarray.h"
+#include "filemon.h"
+
+/* Offset of every CHECKPOINT_STEP-th line is stored in the index.  Lines in
+ * between are found by scanning from the closest checkpoint. */
+enum { CHECKPOINT_STEP = 64 };
+
+/* Contents of the file are read in chunks of this size and at most
+ * CACHED_CHUNKS of them are kept in memory at the same time. */
+enum { CHUNK_SIZE = 256*1024, CACHED_CHUNKS = 32 };
+
+/* Part of the file that has been read into memory. */
+typedef struct
+{
+	char *data;        /* Contents of the chunk or NULL if slot is unused. */
+	size_t index;      /* Number of the chunk within the file. */
+	size_t len;        /* Number of bytes in the chunk. */
+	unsigned int used; /* Time of the last use for eviction. */
+}
+chunk_t;
+
+/* Data of a file that's being read. */
+struct mfile_t
+{
+	char *path; /* Path to the file. */
+	FILE *fp;   /* The file, which is kept open to read it in parts. */
+
+	size_t size;    /* Size of the file. */
+	int incomplete; /* Whether the file turned out to be shorter than its size or
+	                   reading has failed. */
+
+	/* Identification of the file to detect its replacement. */
+	dev_t dev;
+	ino_t inode;
+	filemon_t mon; /* Modification time to detect rewrites of the same size. */
+
+	chunk_t chunks[CACHED_CHUNKS]; /* Cache of recently used chunks. */
+	unsigned int clock;            /* Counter of chunk uses. */
+
+	char *line_buf;      /* Copy of the last line that spans several chunks. */
+	size_t line_buf_len; /* Capacity of the line buffer. */
+
+	size_t *checkpoints; /* Offsets of every CHECKPOINT_STEP-th line. */
+	size_t ncheckpoints; /* Number of elements in checkpoints array. */
+	size_t capacity;     /* Capacity of checkpoints array. */
+
+	int nlines;         /* Number of lines indexed so far. */
+	size_t next_offset; /* Offset at which indexing continues. */
+
+	/* Position of the last looked up line to make sequential access cheap. */
+	int cached_line;
+	size_t cached_offset;
+};
+
+static int identify_file(mfile_t *mf);
+static const char * get_data(mfile_t *mf, size_t offset, size_t *len);
+static chunk_t * get_chunk(mfile_t *mf, size_t index);
+static int read_chunk(mfile_t *mf, chunk_t *chunk, size_t index);
+static int byte_at(mfile_t *mf, size_t offset);
+static void drop_partial_chunks(mfile_t *mf);
+static void unindex_last_line(mfile_t *mf);
+static int index_line(mfile_t *mf);
+static size_t find_eol(mfile_t *mf, size_t offset, size_t *next);
+
+mfile_t *
+mfile_open(const char path[])
+{
+	/* Binary mode is important on Windows. */
+	FILE *fp = os_fopen(path, "rb");
+	if(fp == NULL)
+	{
+		return NULL;
+	}
+
+	mfile_t *const mf = calloc(1, sizeof(*mf));
+	if(mf == NULL)
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	mf->fp = fp;
+	mf->path = strdup(path);
+	if(mf->path == NULL || identify_file(mf) != 0)
+	{
+		mfile_free(mf);
+		return NULL;
+	}
+
+	/* Skip byte order mark. */
+	if(byte_at(mf, 0U) == 0xef && byte_at(mf, 1U) == 0xbb &&
+			byte_at(mf, 2U) == 0xbf)
+	{
+		mf->next_offset = 3U;
+	}
+
+	mf->cached_line = -1;
+	return mf;
+}
+
+/* Remembers identity and size of the file.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+identify_file(mfile_t *mf)
+{
+	struct stat st;
+	if(fstat(fileno(mf->fp), &st) != 0)
+	{
+		return 1;
+	}
+
+	mf->dev = st.st_dev;
+	mf->inode = st.st_ino;
+	mf->size = st.st_size;
+	return filemon_from_file(mf->path, FMT_MODIFIED, &mf->mon);
+}
+
+/* Retrieves contents of the file starting at the offset up to the end of the
+ * chunk containing it.  *len is set to number of available bytes.  Returns
+ * pointer to the data, which is valid until the next read, or NULL if there is
+ * no data at the offset. */
+static const char *
+get_data(mfile_t *mf, size_t offset, size_t *len)
+{
+	if(offset >= mf->size)
+	{
+		*len = 0U;
+		return NULL;
+	}
+
+	const chunk_t *const chunk = get_chunk(mf, offset/CHUNK_SIZE);
+	const size_t chunk_offset = offset%CHUNK_SIZE;
+	if(chunk == NULL || chunk_offset >= chunk->len)
+	{
+		*len = 0U;
+		return NULL;
+	}
+
+	*len = chunk->len - chunk_offset;
+	return chunk->data + chunk_offset;
+}
+
+/* Finds chunk in the cache reading it if necessary and evicting the least
+ * recently used one if there is no room.  If the file turns out to be shorter
+ * than expected or can't be read, its size is reduced to the data that is
+ * available.  Returns the chunk or NULL on error. */
+static chunk_t *
+get_chunk(mfile_t *mf, size_t index)
+{
+	chunk_t *victim = &mf->chunks[0];
+
+	int i;
+	for(i = 0; i < CACHED_CHUNKS; ++i)
+	{
+		chunk_t *const chunk = &mf->chunks[i];
+		if(chunk->data != NULL && chunk->index == index)
+		{
+			chunk->used = ++mf->clock;
+			return chunk;
+		}
+
+		if(victim->data != NULL &&
+				(chunk->data == NULL || chunk->used < victim->used))
+		{
+			victim = chunk;
+		}
+	}
+
+	if(read_chunk(mf, victim, index) != 0)
+	{
+		const size_t available = index*CHUNK_SIZE + victim->len;
+		if(available < mf->size)
+		{
+			mf->size = available;
+			mf->incomplete = 1;
+		}
+	}
+
+	if(victim->len == 0U)
+	{
+		return NULL;
+	}
+
+	victim->used = ++mf->clock;
+	return victim;
+}
+
+/* Reads chunk of the file into a slot of the cache.  Returns zero on success,
+ * otherwise non-zero is returned and the slot contains what could be read. */
+static int
+read_chunk(mfile_t *mf, chunk_t *chunk, size_t index)
+{
+	const size_t offset = index*CHUNK_SIZE;
+	const size_t size = (mf->size - offset < CHUNK_SIZE)
+	                  ? mf->size - offset
+	                  : CHUNK_SIZE;
+
+	chunk->index = index;
+	chunk->len = 0U;
+	if(chunk->data == NULL)
+	{
+		chunk->data = malloc(CHUNK_SIZE);
+		if(chunk->data == NULL)
+		{
+			return 1;
+		}
+	}
+
+	while(chunk->len < size)
+	{
+#ifndef _WIN32
+		const ssize_t n = pread(fileno(mf->fp), chunk->data + chunk->len,
+				size - chunk->len, offset + chunk->len);
+		if(n <= 0)
+		{
+			return 1;
+		}
+#else
+		if(fseek(mf->fp, offset + chunk->len, SEEK_SET) != 0)
+		{
+			return 1;
+		}
+		const size_t n = fread(chunk->data + chunk->len, 1, size - chunk->len,
+				mf->fp);
+		if(n == 0U)
+		{
+			return 1;
+		}
+#endif
+		chunk->len += n;
+	}
+
+	return 0;
+}
+
+/* Retrieves single byte of the file.  Returns the byte or -1 if there is no
+ * byte at the offset. */
+static int
+byte_at(mfile_t *mf, size_t offset)
+{
+	size_t len;
+	const char *const data = get_data(mf, offset, &len);
+	return (data == NULL ? -1 : (unsigned char)data[0]);
+}
+
+void
+mfile_free(mfile_t *mf)
+{
+	if(mf == NULL)
+	{
+		return;
+	}
+
+	if(mf->fp != NULL)
+	{
+		fclose(mf->fp);
+	}
+
+	int i;
+	for(i = 0; i < CACHED_CHUNKS; ++i)
+	{
+		free(mf->chunks[i].data);
+	}
+
+	free(mf->line_buf);
+	free(mf->checkpoints);
+	free(mf->path);
+	free(mf);
+}
+
+int
+mfile_refresh(mfile_t *mf)
+{
+	if(mf->incomplete)
+	{
+		return -1;
+	}
+
+	/* Binary mode is important on Windows. */
+	FILE *fp = os_fopen(mf->path, "rb");
+	if(fp == NULL)
+	{
+		return -1;
+	}
+
+	struct stat st;
+	const int error = fstat(fileno(fp), &st);
+	fclose(fp);
+
+	if(error != 0 || st.st_dev != mf->dev || st.st_ino != mf->inode ||
+			(size_t)st.st_size < mf->size)
+	{
+		return -1;
+	}
+
+	filemon_t mon;
+	if(filemon_from_file(mf->path, FMT_MODIFIED, &mon) != 0)
+	{
+		return -1;
+	}
+
+	if((size_t)st.st_size == mf->size)
+	{
+		/* File of the same size might still have been overwritten. */
+		return (filemon_equal(&mon, &mf->mon) ? 0 : -1);
+	}
+
+	const int indexed = mfile_is_indexed(mf);
+	drop_partial_chunks(mf);
+	mf->size = st.st_size;
+	mf->mon = mon;
+
+	if(indexed)
+	{
+		unindex_last_line(mf);
+	}
+	return 1;
+}
+
+/* Removes chunks that might have grown from the cache. */
+static void
+drop_partial_chunks(mfile_t *mf)
+{
+	int i;
+	for(i = 0; i < CACHED_CHUNKS; ++i)
+	{
+		chunk_t *const chunk = &mf->chunks[i];
+		if(chunk->data != NULL && chunk->len < CHUNK_SIZE)
+		{
+			free(chunk->data);
+			chunk->data = NULL;
+			chunk->len = 0U;
+		}
+	}
+}
+
+/* Drops last line from the index as it might have been incomplete. */
+static void
+unindex_last_line(mfile_t *mf)
+{
+	if(mf->nlines == 0)
+	{
+		return;
+	}
+
+	mf->next_offset = mfile_line_offset(mf, mf->nlines - 1);
+	--mf->nlines;
+	if(mf->nlines%CHECKPOINT_STEP == 0)
+	{
+		--mf->ncheckpoints;
+	}
+}
+
+size_t
+mfile_size(const mfile_t *mf)
+{
+	return mf->size;
+}
+
+int
+mfile_is_indexed(const mfile_t *mf)
+{
+	return (mf->next_offset >= mf->size);
+}
+
+int
+mfile_known_lines(const mfile_t *mf)
+{
+	return mf->nlines;
+}
+
+int
+mfile_index_step(mfile_t *mf, size_t max_bytes)
+{
+	const size_t limit = mf->next_offset + max_bytes;
+	while(!mfile_is_indexed(mf) && mf->next_offset < limit)
+	{
+		if(index_line(mf) != 0)
+		{
+			break;
+		}
+	}
+	return !mfile_is_indexed(mf);
+}
+
+int
+mfile_has_line(mfile_t *mf, int line)
+{
+	while(mf->nlines <= line && !mfile_is_indexed(mf))
+	{
+		if(index_line(mf) != 0)
+		{
+			break;
+		}
+	}
+	return (line >= 0 && line < mf->nlines);
+}
+
+int
+mfile_line_count(mfile_t *mf)
+{
+	while(!mfile_is_indexed(mf))
+	{
+		if(index_line(mf) != 0)
+		{
+			break;
+		}
+	}
+	return mf->nlines;
+}
+
+const char *
+mfile_line(mfile_t *mf, int line, size_t *len)
+{
+	if(!mfile_has_line(mf, line))
+	{
+		*len = 0U;
+		return NULL;
+	}
+
+	const size_t offset = mfile_line_offset(mf, line);
+	size_t next;
+	*len = find_eol(mf, offset, &next) - offset;
+
+	size_t available;
+	const char *const data = get_data(mf, offset, &available);
+	if(available >= *len)
+	{
+		return (*len == 0U ? "" : data);
+	}
+
+	/* The line spans several chunks and needs to be assembled. */
+	if(*len > mf->line_buf_len)
+	{
+		char *const buf = realloc(mf->line_buf, *len);
+		if(buf == NULL)
+		{
+			*len = available;
+			return data;
+		}
+		mf->line_buf = buf;
+		mf->line_buf_len = *len;
+	}
+
+	size_t copied = 0U;
+	while(copied < *len)
+	{
+		const char *const part = get_data(mf, offset + copied, &available);
+		if(part == NULL)
+		{
+			break;
+		}
+		if(available > *len - copied)
+		{
+			available = *len - copied;
+		}
+		memcpy(mf->line_buf + copied, part, available);
+		copied += available;
+	}
+
+	*len = copied;
+	return mf->line_buf;
+}
+
+size_t
+mfile_line_offset(mfile_t *mf, int line)
+{
+	if(!mfile_has_line(mf, line))
+	{
+		return mf->size;
+	}
+
+	int l = line - line%CHECKPOINT_STEP;
+	size_t offset = mf->checkpoints[line/CHECKPOINT_STEP];
+	if(mf->cached_line >= l && mf->cached_line <= line)
+	{
+		l = mf->cached_line;
+		offset = mf->cached_offset;
+	}
+
+	while(l < line)
+	{
+		(void)find_eol(mf, offset, &offset);
+		++l;
+	}
+
+	mf->cached_line = line;
+	mf->cached_offset = offset;
+	return offset;
+}
+
+/* Adds next line to the index.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+index_line(mfile_t *mf)
+{
+	if(mf->nlines%CHECKPOINT_STEP == 0)
+	{
+		if(mf->ncheckpoints == mf->capacity)
+		{
+			const size_t capacity = (mf->capacity == 0U ? 64U : mf->capacity*2U);
+			size_t *const checkpoints = reallocarray(mf->checkpoints, capacity,
+					sizeof(*checkpoints));
+			if(checkpoints == NULL)
+			{
+				return 1;
+			}
+			mf->checkpoints = checkpoints;
+			mf->capacity = capacity;
+		}
+		mf->checkpoints[mf->ncheckpoints++] = mf->next_offset;
+	}
+
+	(void)find_eol(mf, mf->next_offset, &mf->next_offset);
+	++mf->nlines;
+	return 0;
+}
+
+/* Finds end of a line that starts at the offset reading more data if needed.
+ * *next is set to the offset of the next line.  Returns offset of the end of
+ * the line. */
+static size_t
+find_eol(mfile_t *mf, size_t offset, size_t *next)
+{
+	while(1)
+	{
+		size_t left;
+		const char *const begin = get_data(mf, offset, &left);
+		if(begin == NULL)
+		{
+			*next = offset;
+			return offset;
+		}
+
+		const char *nl = memchr(begin, '\n', left);
+		const size_t len = (nl == NULL ? left : (size_t)(nl - begin));
+
+		/* Carriage return on its own also terminates a line. */
+		const char *const cr = memchr(begin, '\r', len);
+		if(cr != NULL)
+		{
+			const size_t eol = offset + (cr - begin);
+			*next = eol + (byte_at(mf, eol + 1U) == '\n' ? 2U : 1U);
+			return eol;
+		}
+
+		if(nl != NULL)
+		{
+			*next = offset + len + 1U;
+			return offset + len;
+		}
+
+		/* The line continues in the next chunk. */
+		offset += len;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,79 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__MFILE_H__
+#define VIFM__UTILS__MFILE_H__
+
+#include <stddef.h> /* size_t */
+
+/* Read-only view of a file with an index of lines.  Both reading of the file
+ * and building of the index are done lazily, only as far as it was needed so
+ * far.  Only a bounded number of recently accessed parts of the file is kept in
+ * memory.  Lines are separated in the same way as read_line() does it. */
+
+/* Opaque type of a file being viewed. */
+typedef struct mfile_t mfile_t;
+
+/* Opens a file.  No lines are indexed at this point.  Returns the object or
+ * NULL on error. */
+mfile_t * mfile_open(const char path[]);
+
+/* Closes file and frees all resources.  mf can be NULL. */
+void mfile_free(mfile_t *mf);
+
+/* Makes data appended to the file since the last call available.  Only the
+ * appended part is read.  Returns positive number if file has grown, zero if
+ * it's unchanged and negative number if it has shrunk, was replaced, was
+ * modified without growing or an error has occurred.  In the last case the file
+ * should be reopened. */
+int mfile_refresh(mfile_t *mf);
+
+/* Retrieves size of the file.  Returns the size. */
+size_t mfile_size(const mfile_t *mf);
+
+/* Checks whether whole file was indexed.  Returns non-zero if so, otherwise
+ * zero is returned. */
+int mfile_is_indexed(const mfile_t *mf);
+
+/* Retrieves number of lines that were indexed so far.  Returns the number. */
+int mfile_known_lines(const mfile_t *mf);
+
+/* Indexes at most about max_bytes more bytes of the file.  Returns non-zero if
+ * there is more to index, otherwise zero is returned. */
+int mfile_index_step(mfile_t *mf, size_t max_bytes);
+
+/* Checks whether line with specified index exists indexing file up to it if
+ * necessary.  Returns non-zero if so, otherwise zero is returned. */
+int mfile_has_line(mfile_t *mf, int line);
+
+/* Indexes the whole file.  Returns number of lines in it. */
+int mfile_line_count(mfile_t *mf);
+
+/* Retrieves line by its index.  *len is set to length of the line.  Returns
+ * pointer to the line, which isn't null-terminated and is valid only until the
+ * next call, or NULL if there is no such line. */
+const char * mfile_line(mfile_t *mf, int line, size_t *len);
+
+/* Retrieves offset of the beginning of a line.  Returns the offset or size of
+ * the file if there is no such line. */
+size_t mfile_line_offset(mfile_t *mf, int line);
+
+#endif /* VIFM__UTILS__MFILE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,62 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__REACTOR_H__
+#define VIFM__UTILS__REACTOR_H__
+
+#include "selector.h"
+
+/* This unit provides a persistent set of objects to wait on for data, each
+ * with its own handler.  Unlike selector, objects are registered only once and
+ * each wait costs in proportion to the number of ready objects where the
+ * platform allows for it (epoll on Linux). */
+
+/* Opaque reactor type. */
+typedef struct reactor_t reactor_t;
+
+/* Handler of an item which has data available for reading or has reached EOF.
+ * The handler is free to remove any items from the reactor. */
+typedef void (*reactor_handler)(selector_item_t item, void *arg);
+
+/* Allocates new empty reactor.  Returns the reactor or NULL on error. */
+reactor_t * reactor_alloc(void);
+
+/* Frees the reactor.  The parameter can be NULL. */
+void reactor_free(reactor_t *reactor);
+
+/* Starts watching the item.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int reactor_add(reactor_t *reactor, selector_item_t item,
+		reactor_handler handler, void *arg);
+
+/* Stops watching the item, which must be done before the item is closed. */
+void reactor_remove(reactor_t *reactor, selector_item_t item);
+
+/* Retrieves number of items being watched.  Returns the number. */
+int reactor_size(const reactor_t *reactor);
+
+/* Waits for at least one of the items to become ready during the period of
+ * time specified by the delay in milliseconds and invokes handlers of ready
+ * items.  Returns number of invoked handlers, which is zero on error or
+ * timeout. */
+int reactor_run(reactor_t *reactor, int delay);
+
+#endif /* VIFM__UTILS__REACTOR_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
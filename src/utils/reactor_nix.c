@@ -0,0 +1,284 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "reactor.h"
+
+#ifdef __linux__
+#include <sys/epoll.h> /* EPOLL* epoll_create1() epoll_ctl() epoll_event
+                          epoll_wait() */
+#else
+#include <poll.h> /* POLLERR POLLHUP POLLIN poll() pollfd */
+#endif
+#include <unistd.h> /* close() */
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memset() */
+
+#include "../compat/reallocarray.h"
+
+/* Maximum number of ready items processed per wait. */
+enum { MAX_READY = 64 };
+
+/* Registration of a single item. */
+typedef struct
+{
+	reactor_handler handler; /* Handler of the item or NULL if not watched. */
+	void *arg;               /* Argument for the handler. */
+#ifndef __linux__
+	int pos;                 /* Position of the item in fds array. */
+#endif
+}
+entry_t;
+
+/* Reactor object. */
+struct reactor_t
+{
+	entry_t *entries; /* Registrations indexed by file descriptors. */
+	int nentries;     /* Number of elements in entries array. */
+	int size;         /* Number of watched items. */
+
+#ifdef __linux__
+	int epoll_fd; /* Descriptor of epoll instance. */
+#else
+	struct pollfd *fds; /* Watched descriptors, size elements are used. */
+	int capacity;       /* Number of allocated elements in fds array. */
+#endif
+};
+
+static int ensure_entry(reactor_t *reactor, int fd);
+static int dispatch(reactor_t *reactor, int fd);
+
+reactor_t *
+reactor_alloc(void)
+{
+	reactor_t *const reactor = calloc(1, sizeof(*reactor));
+	if(reactor == NULL)
+	{
+		return NULL;
+	}
+
+#ifdef __linux__
+	reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if(reactor->epoll_fd == -1)
+	{
+		free(reactor);
+		return NULL;
+	}
+#endif
+
+	return reactor;
+}
+
+void
+reactor_free(reactor_t *reactor)
+{
+	if(reactor == NULL)
+	{
+		return;
+	}
+
+#ifdef __linux__
+	close(reactor->epoll_fd);
+#else
+	free(reactor->fds);
+#endif
+	free(reactor->entries);
+	free(reactor);
+}
+
+int
+reactor_add(reactor_t *reactor, selector_item_t item, reactor_handler handler,
+		void *arg)
+{
+	if(item < 0 || ensure_entry(reactor, item) != 0)
+	{
+		return 1;
+	}
+
+	entry_t *const entry = &reactor->entries[item];
+	if(entry->handler != NULL)
+	{
+		return 1;
+	}
+
+#ifdef __linux__
+	struct epoll_event event = { .events = EPOLLIN, .data.fd = item };
+	if(epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, item, &event) != 0)
+	{
+		return 1;
+	}
+#else
+	if(reactor->size == reactor->capacity)
+	{
+		const int capacity = (reactor->capacity == 0 ? 8 : reactor->capacity*2);
+		struct pollfd *const fds = reallocarray(reactor->fds, capacity,
+				sizeof(*fds));
+		if(fds == NULL)
+		{
+			return 1;
+		}
+		reactor->fds = fds;
+		reactor->capacity = capacity;
+	}
+
+	entry->pos = reactor->size;
+	reactor->fds[entry->pos].fd = item;
+	reactor->fds[entry->pos].events = POLLIN;
+	reactor->fds[entry->pos].revents = 0;
+#endif
+
+	entry->handler = handler;
+	entry->arg = arg;
+	++reactor->size;
+	return 0;
+}
+
+/* Makes sure that entries array has an element for the descriptor.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+ensure_entry(reactor_t *reactor, int fd)
+{
+	if(fd < reactor->nentries)
+	{
+		return 0;
+	}
+
+	int nentries = (reactor->nentries == 0 ? 64 : reactor->nentries);
+	while(nentries <= fd)
+	{
+		nentries *= 2;
+	}
+
+	entry_t *const entries = reallocarray(reactor->entries, nentries,
+			sizeof(*entries));
+	if(entries == NULL)
+	{
+		return 1;
+	}
+
+	memset(entries + reactor->nentries, 0,
+			sizeof(*entries)*(nentries - reactor->nentries));
+	reactor->entries = entries;
+	reactor->nentries = nentries;
+	return 0;
+}
+
+void
+reactor_remove(reactor_t *reactor, selector_item_t item)
+{
+	if(item < 0 || item >= reactor->nentries)
+	{
+		return;
+	}
+
+	entry_t *const entry = &reactor->entries[item];
+	if(entry->handler == NULL)
+	{
+		return;
+	}
+
+#ifdef __linux__
+	(void)epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, item, NULL);
+#else
+	/* Move the last descriptor in place of the removed one. */
+	const int last = reactor->size - 1;
+	if(entry->pos != last)
+	{
+		reactor->fds[entry->pos] = reactor->fds[last];
+		reactor->entries[reactor->fds[entry->pos].fd].pos = entry->pos;
+	}
+#endif
+
+	entry->handler = NULL;
+	entry->arg = NULL;
+	--reactor->size;
+}
+
+int
+reactor_size(const reactor_t *reactor)
+{
+	return reactor->size;
+}
+
+int
+reactor_run(reactor_t *reactor, int delay)
+{
+	if(delay < 0)
+	{
+		delay = 0;
+	}
+
+	int ready[MAX_READY];
+	int nready = 0;
+
+#ifdef __linux__
+	struct epoll_event events[MAX_READY];
+	const int n = epoll_wait(reactor->epoll_fd, events, MAX_READY, delay);
+	for(nready = 0; nready < n; ++nready)
+	{
+		ready[nready] = events[nready].data.fd;
+	}
+#else
+	if(poll(reactor->fds, reactor->size, delay) <= 0)
+	{
+		return 0;
+	}
+
+	/* Handlers can remove items, so collect ready descriptors first. */
+	int i;
+	for(i = 0; i < reactor->size && nready < MAX_READY; ++i)
+	{
+		if(reactor->fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+		{
+			ready[nready++] = reactor->fds[i].fd;
+		}
+	}
+#endif
+
+	int ninvoked = 0;
+	int j;
+	for(j = 0; j < nready; ++j)
+	{
+		ninvoked += dispatch(reactor, ready[j]);
+	}
+	return ninvoked;
+}
+
+/* Invokes handler of the descriptor if it's still watched.  Returns non-zero if
+ * the handler was invoked, otherwise zero is returned. */
+static int
+dispatch(reactor_t *reactor, int fd)
+{
+	if(fd < 0 || fd >= reactor->nentries)
+	{
+		return 0;
+	}
+
+	const entry_t entry = reactor->entries[fd];
+	if(entry.handler == NULL)
+	{
+		return 0;
+	}
+
+	entry.handler(fd, entry.arg);
+	return 1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,162 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "reactor.h"
+
+#include <windows.h>
+
+#include <stddef.h> /* NULL */
+#include <stdlib.h> /* calloc() free() */
+
+#include "../compat/reallocarray.h"
+
+/* Reactor object. */
+struct reactor_t
+{
+	selector_item_t *items;    /* Set of items to watch. */
+	reactor_handler *handlers; /* Handlers of the items. */
+	void **args;               /* Arguments of the handlers. */
+	int size;                  /* Used amount of items. */
+	int capacity;              /* Reserved amount of items. */
+};
+
+static int find_item(const reactor_t *reactor, selector_item_t item);
+
+reactor_t *
+reactor_alloc(void)
+{
+	return calloc(1, sizeof(reactor_t));
+}
+
+void
+reactor_free(reactor_t *reactor)
+{
+	if(reactor != NULL)
+	{
+		free(reactor->items);
+		free(reactor->handlers);
+		free(reactor->args);
+		free(reactor);
+	}
+}
+
+int
+reactor_add(reactor_t *reactor, selector_item_t item, reactor_handler handler,
+		void *arg)
+{
+	if(find_item(reactor, item) != -1)
+	{
+		return 1;
+	}
+
+	if(reactor->size == reactor->capacity)
+	{
+		const int capacity = (reactor->capacity == 0 ? 4 : reactor->capacity*2);
+
+		selector_item_t *const items = reallocarray(reactor->items, capacity,
+				sizeof(*items));
+		if(items == NULL)
+		{
+			return 1;
+		}
+		reactor->items = items;
+
+		reactor_handler *const handlers = reallocarray(reactor->handlers,
+				capacity, sizeof(*handlers));
+		if(handlers == NULL)
+		{
+			return 1;
+		}
+		reactor->handlers = handlers;
+
+		void **const args = reallocarray(reactor->args, capacity, sizeof(*args));
+		if(args == NULL)
+		{
+			return 1;
+		}
+		reactor->args = args;
+
+		reactor->capacity = capacity;
+	}
+
+	reactor->items[reactor->size] = item;
+	reactor->handlers[reactor->size] = handler;
+	reactor->args[reactor->size] = arg;
+	++reactor->size;
+	return 0;
+}
+
+void
+reactor_remove(reactor_t *reactor, selector_item_t item)
+{
+	const int pos = find_item(reactor, item);
+	if(pos == -1)
+	{
+		return;
+	}
+
+	/* Move the last item in place of the removed one. */
+	const int last = --reactor->size;
+	reactor->items[pos] = reactor->items[last];
+	reactor->handlers[pos] = reactor->handlers[last];
+	reactor->args[pos] = reactor->args[last];
+}
+
+/* Looks up position of the item.  Returns the position or -1 if the item isn't
+ * watched. */
+static int
+find_item(const reactor_t *reactor, selector_item_t item)
+{
+	int i;
+	for(i = 0; i < reactor->size; ++i)
+	{
+		if(reactor->items[i] == item)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+int
+reactor_size(const reactor_t *reactor)
+{
+	return reactor->size;
+}
+
+int
+reactor_run(reactor_t *reactor, int delay)
+{
+	if(delay < 0)
+	{
+		delay = 0;
+	}
+
+	DWORD res = WaitForMultipleObjects(reactor->size, reactor->items, 0, delay);
+	if(res < WAIT_OBJECT_0 || res >= WAIT_OBJECT_0 + reactor->size)
+	{
+		return 0;
+	}
+
+	const int pos = res - WAIT_OBJECT_0;
+	reactor->handlers[pos](reactor->items[pos], reactor->args[pos]);
+	return 1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,215 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "trace.h"
+
+#include <stddef.h> /* NULL */
+#include <stdio.h> /* FILE fclose() fputs() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() */
+
+#include "../compat/os.h"
+#include "darray.h"
+#include "parson.h"
+#include "str.h"
+#include "utils.h"
+
+/* Single event of a trace. */
+typedef struct
+{
+	char *name;         /* Name of a span or NULL for end of a span. */
+	char *detail;       /* Additional information or NULL. */
+	long long time_us;  /* Monotonic time of the event in microseconds. */
+}
+trace_event_t;
+
+static void add_event(const char name[], const char detail[]);
+static long long time_in_us(void);
+static int write_trace(void);
+static void free_events(void);
+
+/* Path to the output file or NULL if tracing is disabled. */
+static char *trace_path;
+/* Recorded events in chronological order. */
+static trace_event_t *events;
+/* Declarations to enable use of DA_* on events. */
+static DA_INSTANCE(events);
+/* Number of spans that are currently open. */
+static int depth;
+
+int
+trace_start(const char path[])
+{
+	if(replace_string(&trace_path, path) != 0)
+	{
+		return 1;
+	}
+
+	free_events();
+	depth = 0;
+	return 0;
+}
+
+int
+trace_enabled(void)
+{
+	return (trace_path != NULL);
+}
+
+void
+trace_begin(const char name[], const char detail[])
+{
+	if(trace_enabled())
+	{
+		add_event(name, detail);
+		++depth;
+	}
+}
+
+void
+trace_end(void)
+{
+	if(trace_enabled() && depth > 0)
+	{
+		add_event(NULL, NULL);
+		--depth;
+	}
+}
+
+/* Appends an event to the list of events. */
+static void
+add_event(const char name[], const char detail[])
+{
+	/* Take the time first to not account for allocations. */
+	const long long time_us = time_in_us();
+
+	trace_event_t *const event = DA_EXTEND(events);
+	if(event == NULL)
+	{
+		return;
+	}
+
+	event->name = (name == NULL ? NULL : strdup(name));
+	event->detail = (detail == NULL ? NULL : strdup(detail));
+	event->time_us = time_us;
+	DA_COMMIT(events);
+}
+
+/* Retrieves current monotonic time in microseconds.  Returns the time. */
+static long long
+time_in_us(void)
+{
+	struct timespec current_time;
+	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
+	{
+		return 0;
+	}
+
+	return current_time.tv_sec*1000000LL + current_time.tv_nsec/1000;
+}
+
+void
+trace_finish(void)
+{
+	if(!trace_enabled())
+	{
+		return;
+	}
+
+	while(depth > 0)
+	{
+		trace_end();
+	}
+
+	(void)write_trace();
+
+	free_events();
+	update_string(&trace_path, NULL);
+}
+
+/* Writes recorded events to the trace file.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+write_trace(void)
+{
+	JSON_Value *root = json_value_init_object();
+	JSON_Value *events_value = json_value_init_array();
+	JSON_Array *events_array = json_array(events_value);
+	json_object_set_value(json_object(root), "traceEvents", events_value);
+
+	const unsigned int pid = get_pid();
+
+	size_t i;
+	for(i = 0U; i < DA_SIZE(events); ++i)
+	{
+		const trace_event_t *event = &events[i];
+
+		JSON_Value *value = json_value_init_object();
+		JSON_Object *obj = json_object(value);
+		if(event->name != NULL)
+		{
+			json_object_set_string(obj, "name", event->name);
+		}
+		json_object_set_string(obj, "cat", "vifm");
+		json_object_set_string(obj, "ph", event->name == NULL ? "E" : "B");
+		json_object_set_number(obj, "ts", event->time_us);
+		json_object_set_number(obj, "pid", pid);
+		json_object_set_number(obj, "tid", 1);
+		if(event->detail != NULL)
+		{
+			json_object_dotset_string(obj, "args.detail", event->detail);
+		}
+
+		json_array_append_value(events_array, value);
+	}
+
+	char *text = json_serialize_to_string(root);
+	json_value_free(root);
+	if(text == NULL)
+	{
+		return 1;
+	}
+
+	int error = 1;
+	FILE *fp = os_fopen(trace_path, "wb");
+	if(fp != NULL)
+	{
+		error = (fputs(text, fp) < 0);
+		error |= (fclose(fp) != 0);
+	}
+
+	json_free_serialized_string(text);
+	return error;
+}
+
+/* Frees all recorded events. */
+static void
+free_events(void)
+{
+	size_t i;
+	for(i = 0U; i < DA_SIZE(events); ++i)
+	{
+		free(events[i].name);
+		free(events[i].detail);
+	}
+	DA_REMOVE_ALL(events);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,48 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__TRACE_H__
+#define VIFM__UTILS__TRACE_H__
+
+/* Recording of nested time spans (e.g., phases of startup) with monotonic
+ * timestamps, which are written out in Chrome trace event format (JSON that can
+ * be opened in chrome://tracing, Perfetto or similar viewers).  All functions
+ * except for trace_start() do nothing if tracing is disabled. */
+
+/* Enables tracing that will be written to the specified file.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int trace_start(const char path[]);
+
+/* Checks whether tracing is enabled.  Returns non-zero if so, otherwise zero is
+ * returned. */
+int trace_enabled(void);
+
+/* Opens a new span, which can be nested inside of a span that's currently
+ * open.  detail can be NULL. */
+void trace_begin(const char name[], const char detail[]);
+
+/* Closes the last opened span. */
+void trace_end(void);
+
+/* Closes spans that are still open, writes trace out and disables tracing. */
+void trace_finish(void);
+
+#endif /* VIFM__UTILS__TRACE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
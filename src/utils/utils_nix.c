@@ -35,12 +35,17 @@
 #include <sys/statvfs.h> /* statvfs statvfs() */
 #include <sys/time.h> /* timeval futimens() utimes() */
 #include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() WIFSIGNALED() waitpid() */
-#include <fcntl.h> /* open() close() */
+#include <fcntl.h> /* FD_CLOEXEC F_SETFD O_CLOEXEC O_RDONLY O_RDWR fcntl()
+                      open() close() */
 #include <grp.h> /* getgrnam() getgrgid_r() */
 #include <pthread.h> /* pthread_sigmask() */
+#include <poll.h> /* POLLERR POLLPRI poll() pollfd */
 #include <pwd.h> /* getpwnam() getpwuid_r() */
-#include <unistd.h> /* X_OK chown() close() dup() dup2() getpid() isatty()
-                       pause() sysconf() ttyname() */
+#include <spawn.h> /* POSIX_SPAWN_SETSID posix_spawn_file_actions_*()
+                      posix_spawnattr_*() posix_spawnp() */
+#include <unistd.h> /* X_OK chdir() chown() close() dup() dup2() execvp()
+                       fork() getpid() isatty() pause() pipe() setsid()
+                       sysconf() ttyname() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
@@ -48,8 +53,9 @@
 #include <signal.h> /* SIG* SIG_* sigset_t kill() sigemptyset() sigfillset()
                        signal() */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE stderr fclose() fdopen() fprintf() snprintf() */
-#include <stdlib.h> /* atoi() free() */
+#include <stdio.h> /* FILE stderr fclose() fdopen() fileno() fprintf() perror()
+                     snprintf() */
+#include <stdlib.h> /* EXIT_FAILURE _Exit() atoi() free() */
 #include <string.h> /* strchr() strdup() strerror() strlen() strncmp() */
 
 #include "../cfg/config.h"
@@ -71,30 +77,43 @@
 #include "macros.h"
 #include "path.h"
 #include "str.h"
+#include "trie.h"
 #include "utils.h"
 
-/* Types of mount point information for get_mount_point_traverser_state. */
-typedef enum
-{
-	MI_MOUNT_POINT, /* Path to the mount point. */
-	MI_FS_TYPE,     /* File system name. */
-}
-mntinfo;
+/* posix_spawn_file_actions_addchdir_np() appeared in glibc 2.29. */
+#if defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define SPAWN_CAN_CHDIR 1
+#endif
 
-/* State for get_mount_point() traverser. */
+/* Cached mount table. */
 typedef struct
 {
-	mntinfo type;     /* Type of information to put into the buffer. */
-	const char *path; /* Path whose mount point we're looking for. */
-	size_t buf_len;   /* Output buffer length. */
-	char *buf;        /* Output buffer. */
-	size_t curr_len;  /* Max length among all found points (len of buf string). */
+	struct mntent *entries; /* Mount entries in the order of mounting. */
+	unsigned int nentries;  /* Number of elements in entries array. */
+	trie_t *index;          /* Mount point path -> element of entries array. */
+	int mounts_fd;          /* /proc/self/mounts for change notifications or
+	                           -1. */
+	filemon_t mtab_mon;     /* Timestamp of /etc/mtab when mounts_fd isn't
+	                           available. */
+	int loaded;             /* Whether the table was loaded at least once. */
 }
-get_mount_point_traverser_state;
+mount_table_t;
 
-static int get_mount_info_traverser(struct mntent *entry, void *arg);
+static const struct mntent * find_mount_entry(const char path[]);
+static const mount_table_t * get_mount_table(void);
+static int mount_table_changed(mount_table_t *table);
+static void index_mount_table(mount_table_t *table);
 static void process_cancel_request(pid_t pid,
 		const cancellation_t *cancellation);
+static int can_posix_spawn(const int fds[3], int new_session,
+		const char cwd[]);
+static pid_t posix_spawn_shell(char *args[], const int fds[3], int new_session,
+		const char cwd[]);
+static pid_t fork_shell(char *args[], const int fds[3], int new_session,
+		const char cwd[]);
+static void free_execv_array(char *args[], const char shell_flag[],
+		const char cmd[]);
 static void free_mnt_entries(struct mntent *entries, unsigned int nentries);
 static struct mntent * read_mnt_entries(unsigned int *nentries);
 static int clone_mnt_entry(struct mntent *lhs, const struct mntent *rhs);
@@ -260,55 +279,244 @@ get_proc_exit_status(pid_t pid, const cancellation_t *cancellation)
 	return -1;
 }
 
-void _gnuc_noreturn
-run_from_fork(int pipe[2], int err_only, int preserve_stdin, char cmd[],
-		ShellRequester by)
+pid_t
+spawn_shell(const char cmd[], ShellRequester by, int in, int out, int err,
+		int new_session, const char cwd[])
 {
-	/* Close read end of the pipe. */
-	(void)close(pipe[0]);
+	const int fds[3] = { in, out, err };
 
-	/* Redirect stderr and maybe stdout to write end of the pipe. */
-	if(dup2(pipe[1], STDERR_FILENO) == -1)
+	/* make_execv_array() might temporarily modify the command. */
+	char *const cmd_copy = strdup(cmd);
+	if(cmd_copy == NULL)
 	{
-		_Exit(EXIT_FAILURE);
+		return (pid_t)-1;
 	}
-	if(!err_only && dup2(pipe[1], STDOUT_FILENO) == -1)
+
+	char *sh_flag = (by == SHELL_BY_USER ? cfg.shell_cmd_flag : "-c");
+	char **args = make_execv_array(cfg.shell, sh_flag, cmd_copy);
+
+	const pid_t pid = can_posix_spawn(fds, new_session, cwd)
+	                ? posix_spawn_shell(args, fds, new_session, cwd)
+	                : fork_shell(args, fds, new_session, cwd);
+
+	free_execv_array(args, sh_flag, cmd_copy);
+	free(cmd_copy);
+	return pid;
+}
+
+/* Checks whether posix_spawn() can set up the child as requested.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+can_posix_spawn(const int fds[3], int new_session, const char cwd[])
+{
+#ifndef POSIX_SPAWN_SETSID
+	if(new_session)
 	{
-		_Exit(EXIT_FAILURE);
+		return 0;
 	}
+#endif
 
-	if(pipe[1] != STDERR_FILENO && pipe[1] != STDOUT_FILENO)
+#ifndef SPAWN_CAN_CHDIR
+	if(cwd != NULL)
 	{
-		/* Close write end of the pipe after it was duplicated. */
-		(void)close(pipe[1]);
+		return 0;
 	}
+#endif
 
-	const int null_fd = open("/dev/null", O_RDWR);
-	if(null_fd == -1)
+	/* Standard descriptors as sources of redirection can be overwritten by
+	 * preceding redirections and need more care than file actions provide. */
+	int i;
+	for(i = 0; i < 3; ++i)
 	{
-		_Exit(EXIT_FAILURE);
+		if(fds[i] >= 0 && fds[i] <= STDERR_FILENO)
+		{
+			return 0;
+		}
 	}
+	return 1;
+}
 
-	if(!preserve_stdin && dup2(null_fd, STDIN_FILENO) == -1)
+/* Starts the command via posix_spawn(), which doesn't copy page tables of the
+ * process.  Returns id of the child or (pid_t)-1 on error. */
+static pid_t
+posix_spawn_shell(char *args[], const int fds[3], int new_session,
+		const char cwd[])
+{
+	extern char **environ;
+
+	posix_spawn_file_actions_t actions;
+	if(posix_spawn_file_actions_init(&actions) != 0)
 	{
-		_Exit(EXIT_FAILURE);
+		return (pid_t)-1;
+	}
+
+	posix_spawnattr_t attr;
+	if(posix_spawnattr_init(&attr) != 0)
+	{
+		(void)posix_spawn_file_actions_destroy(&actions);
+		return (pid_t)-1;
+	}
+
+	int error = 0;
+
+	int i;
+	for(i = 0; i < 3; ++i)
+	{
+		if(fds[i] == SPAWN_DEVNULL)
+		{
+			error |= posix_spawn_file_actions_addopen(&actions, i, "/dev/null",
+					O_RDWR, 0);
+		}
+		else if(fds[i] != SPAWN_INHERIT)
+		{
+			error |= posix_spawn_file_actions_adddup2(&actions, fds[i], i);
+		}
+	}
+
+	for(i = 0; i < 3; ++i)
+	{
+		/* The same descriptor can be used for several streams, but it can be
+		 * closed only once. */
+		const int dup = (i > 0 && fds[i] == fds[i - 1])
+		             || (i > 1 && fds[i] == fds[i - 2]);
+		if(fds[i] >= 0 && !dup)
+		{
+			error |= posix_spawn_file_actions_addclose(&actions, fds[i]);
+		}
+	}
+
+	/* Mirrors what prepare_for_exec() does, other resources it frees are
+	 * close-on-exec. */
+	if(curr_stats.original_stdout != NULL)
+	{
+		error |= posix_spawn_file_actions_addclose(&actions,
+				fileno(curr_stats.original_stdout));
 	}
-	if(err_only && dup2(null_fd, STDOUT_FILENO) == -1)
+
+#ifdef POSIX_SPAWN_SETSID
+	if(new_session)
 	{
+		error |= posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSID);
+	}
+#endif
+
+#ifdef SPAWN_CAN_CHDIR
+	if(cwd != NULL)
+	{
+		error |= posix_spawn_file_actions_addchdir_np(&actions, cwd);
+	}
+#endif
+
+	pid_t pid = (pid_t)-1;
+	if(!error)
+	{
+		error = posix_spawnp(&pid, get_execv_path(cfg.shell), &actions, &attr,
+				args, environ);
+		if(error != 0)
+		{
+			LOG_SERROR_MSG(error, "posix_spawnp() has failed");
+			pid = (pid_t)-1;
+		}
+	}
+
+	(void)posix_spawnattr_destroy(&attr);
+	(void)posix_spawn_file_actions_destroy(&actions);
+	return pid;
+}
+
+/* Starts the command via fork(), this is the fallback for cases not supported
+ * by posix_spawn().  Returns id of the child or (pid_t)-1 on error. */
+static pid_t
+fork_shell(char *args[], const int fds[3], int new_session, const char cwd[])
+{
+	const pid_t pid = fork();
+	if(pid != 0)
+	{
+		return pid;
+	}
+
+	int i;
+	for(i = 0; i < 3; ++i)
+	{
+		if(fds[i] == SPAWN_DEVNULL)
+		{
+			const int null_fd = open("/dev/null", O_RDWR);
+			if(null_fd == -1 || dup2(null_fd, i) == -1)
+			{
+				perror("dup2 of /dev/null");
+				_Exit(EXIT_FAILURE);
+			}
+			if(null_fd != i)
+			{
+				(void)close(null_fd);
+			}
+		}
+		else if(fds[i] == i)
+		{
+			/* dup2() is a no-op in this case and won't reset close-on-exec. */
+			(void)fcntl(i, F_SETFD, 0);
+		}
+		else if(fds[i] != SPAWN_INHERIT && dup2(fds[i], i) == -1)
+		{
+			perror("dup2");
+			_Exit(EXIT_FAILURE);
+		}
+	}
+
+	for(i = 0; i < 3; ++i)
+	{
+		if(fds[i] > STDERR_FILENO)
+		{
+			(void)close(fds[i]);
+		}
+	}
+
+	/* setsid() creates process group as well and doesn't work if current
+	 * process is a group leader, so don't do setpgid(). */
+	if(new_session && setsid() == (pid_t)-1)
+	{
+		perror("setsid");
 		_Exit(EXIT_FAILURE);
 	}
 
-	if(null_fd != STDIN_FILENO && null_fd != STDOUT_FILENO)
+	if(cwd != NULL && chdir(cwd) != 0)
 	{
-		(void)close(null_fd);
+		perror("chdir");
+		_Exit(EXIT_FAILURE);
 	}
 
 	prepare_for_exec();
-	char *sh_flag = (by == SHELL_BY_USER ? cfg.shell_cmd_flag : "-c");
-	execvp(get_execv_path(cfg.shell), make_execv_array(cfg.shell, sh_flag, cmd));
+	execvp(get_execv_path(cfg.shell), args);
 	_Exit(127);
 }
 
+/* Frees array created by make_execv_array() in the parent process. */
+static void
+free_execv_array(char *args[], const char shell_flag[], const char cmd[])
+{
+	int i;
+	for(i = 0; args[i] != NULL; ++i)
+	{
+		if(args[i] == cmd)
+		{
+			/* The array references its arguments. */
+			free(args);
+			return;
+		}
+	}
+
+	/* The command was split into pieces, which are allocated along with the
+	 * command that evaluates them and follow shell flag. */
+	for(i = 0; args[i] != shell_flag; ++i)
+	{
+	}
+	for(++i; args[i] != NULL; ++i)
+	{
+		free(args[i]);
+	}
+	free(args);
+}
+
 void
 prepare_for_exec(void)
 {
@@ -474,15 +682,6 @@ refers_to_slower_fs(const char from[], const char to[])
 int
 is_on_slow_fs(const char full_path[], const char slowfs_specs[])
 {
-	char fs_name[PATH_MAX + 1];
-	get_mount_point_traverser_state state = {
-		.type = MI_FS_TYPE,
-		.path = full_path,
-		.buf_len = sizeof(fs_name),
-		.buf = fs_name,
-		.curr_len = 0UL,
-	};
-
 	/* Empty list optimization. */
 	if(slowfs_specs[0] == '\0')
 	{
@@ -497,15 +696,10 @@ is_on_slow_fs(const char full_path[], const char slowfs_specs[])
 		return 1;
 	}
 
-	if(traverse_mount_points(&get_mount_info_traverser, &state) == 0)
+	const struct mntent *const entry = find_mount_entry(full_path);
+	if(entry != NULL && starts_with_list_item(entry->mnt_type, slowfs_specs))
 	{
-		if(state.curr_len > 0)
-		{
-			if(starts_with_list_item(fs_name, slowfs_specs))
-			{
-				return 1;
-			}
-		}
+		return 1;
 	}
 
 	return find_path_prefix_index(full_path, slowfs_specs) != -1;
@@ -514,79 +708,147 @@ is_on_slow_fs(const char full_path[], const char slowfs_specs[])
 int
 get_mount_point(const char path[], size_t buf_len, char buf[])
 {
-	get_mount_point_traverser_state state = {
-		.type = MI_MOUNT_POINT,
-		.path = path,
-		.buf_len = buf_len,
-		.buf = buf,
-		.curr_len = 0UL,
-	};
-	return traverse_mount_points(&get_mount_info_traverser, &state);
+	if(get_mount_table()->nentries == 0U)
+	{
+		return 1;
+	}
+
+	const struct mntent *const entry = find_mount_entry(path);
+	if(entry != NULL)
+	{
+		copy_str(buf, buf_len, entry->mnt_dir);
+	}
+	return 0;
 }
 
-/* traverse_mount_points client that gets mount point info for a given path. */
-static int
-get_mount_info_traverser(struct mntent *entry, void *arg)
+/* Finds mount entry whose mount point is the longest prefix of the path.  When
+ * several file systems are mounted at the same place, the last one wins.
+ * Returns the entry or NULL if there is none. */
+static const struct mntent *
+find_mount_entry(const char path[])
 {
-	get_mount_point_traverser_state *const state = arg;
-	if(path_starts_with(state->path, entry->mnt_dir))
+	const mount_table_t *const table = get_mount_table();
+	if(path[0] != '/')
 	{
-		const size_t new_len = strlen(entry->mnt_dir);
-		if(new_len > state->curr_len)
+		return NULL;
+	}
+
+	char prefix[PATH_MAX + 1];
+	copy_str(prefix, sizeof(prefix), path);
+
+	while(1)
+	{
+		void *data;
+		if(trie_get(table->index, (prefix[0] == '\0' ? "/" : prefix), &data) == 0)
 		{
-			state->curr_len = new_len;
-			switch(state->type)
-			{
-				case MI_MOUNT_POINT:
-					copy_str(state->buf, state->buf_len, entry->mnt_dir);
-					break;
-				case MI_FS_TYPE:
-					copy_str(state->buf, state->buf_len, entry->mnt_type);
-					break;
-
-				default:
-					assert(0 && "Unknown mount information type.");
-					break;
-			}
+			return data;
+		}
+
+		char *const slash = strrchr(prefix, '/');
+		if(slash == NULL)
+		{
+			return NULL;
 		}
+		*slash = '\0';
 	}
-	return 0;
 }
 
 int
 traverse_mount_points(mptraverser client, void *arg)
 {
-	/* Cached mount entries, updated only when /etc/mtab changes. */
-	static filemon_t mtab_mon;
-	static struct mntent *entries;
-	static unsigned int nentries;
+	const mount_table_t *const table = get_mount_table();
+	if(table->nentries == 0U)
+	{
+		return 1;
+	}
 
-	filemon_t mon;
 	unsigned int i;
+	for(i = 0; i < table->nentries; ++i)
+	{
+		if(client(&table->entries[i], arg))
+		{
+			break;
+		}
+	}
 
-	/* Check for cache validity. */
-	if(filemon_from_file("/etc/mtab", FMT_MODIFIED, &mon) != 0 ||
-			!filemon_equal(&mon, &mtab_mon))
+	return 0;
+}
+
+/* Retrieves mount table re-reading it if it has changed since the last call.
+ * Returns pointer to the table. */
+static const mount_table_t *
+get_mount_table(void)
+{
+	static mount_table_t table = { .mounts_fd = -1 };
+
+	if(mount_table_changed(&table))
 	{
-		mtab_mon = mon;
-		free_mnt_entries(entries, nentries);
-		entries = read_mnt_entries(&nentries);
+		free_mnt_entries(table.entries, table.nentries);
+		table.entries = read_mnt_entries(&table.nentries);
+		index_mount_table(&table);
 	}
 
-	if(nentries == 0U)
+	return &table;
+}
+
+/* Checks whether mount table has changed since the last call.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+mount_table_changed(mount_table_t *table)
+{
+	const int first_time = !table->loaded;
+	table->loaded = 1;
+
+#ifdef __linux__
+	/* Kernel reports changes of mount table as an exceptional condition on any
+	 * file descriptor of /proc/self/mounts.  Timestamps of files in /proc aren't
+	 * usable for this purpose as they change on every stat() call. */
+	if(first_time)
 	{
-		return 1;
+		table->mounts_fd = open("/proc/self/mounts", O_RDONLY | O_CLOEXEC);
 	}
 
-	for(i = 0; i < nentries; ++i)
+	if(table->mounts_fd != -1)
 	{
-		if(client(&entries[i], arg))
+		struct pollfd pfd = { .fd = table->mounts_fd, .events = POLLPRI };
+		if(poll(&pfd, 1, 0) < 0)
 		{
-			break;
+			return 1;
 		}
+		return first_time || (pfd.revents & (POLLPRI | POLLERR)) != 0;
 	}
+#endif
 
-	return 0;
+	filemon_t mon;
+	if(filemon_from_file("/etc/mtab", FMT_MODIFIED, &mon) != 0 ||
+			!filemon_equal(&mon, &table->mtab_mon))
+	{
+		table->mtab_mon = mon;
+		return 1;
+	}
+	return first_time;
+}
+
+/* Builds index of mount points of the table for fast lookups of mount point of
+ * a path.  On memory allocation error, index might be incomplete. */
+static void
+index_mount_table(mount_table_t *table)
+{
+	trie_free(table->index);
+	table->index = trie_create(/*free_func=*/NULL);
+
+	unsigned int i;
+	for(i = 0U; i < table->nentries; ++i)
+	{
+		char mount_point[PATH_MAX + 1];
+		copy_str(mount_point, sizeof(mount_point), table->entries[i].mnt_dir);
+		if(!is_root_dir(mount_point))
+		{
+			chosp(mount_point);
+		}
+
+		(void)trie_set(table->index, mount_point, &table->entries[i]);
+	}
 }
 
 /* Frees array of mount entries. */
@@ -1058,29 +1320,26 @@ FILE *
 read_cmd_output(const char cmd[], int preserve_stdin)
 {
 	FILE *fp;
-	pid_t pid;
 	int out_pipe[2];
 
-	if(pipe(out_pipe) != 0)
+	if(make_cloexec_pipe(out_pipe) != 0)
 	{
 		return NULL;
 	}
 
-	pid = fork();
-	if(pid == (pid_t)-1)
-	{
-		return NULL;
-	}
+	const int in = (preserve_stdin ? SPAWN_INHERIT : SPAWN_DEVNULL);
+	const pid_t pid = spawn_shell(cmd, SHELL_BY_USER, in, out_pipe[1],
+			out_pipe[1], /*new_session=*/0, /*cwd=*/NULL);
 
-	if(pid == 0)
+	/* Close write end of pipe. */
+	close(out_pipe[1]);
+
+	if(pid == (pid_t)-1)
 	{
-		run_from_fork(out_pipe, 0, preserve_stdin, (char *)cmd, SHELL_BY_USER);
+		close(out_pipe[0]);
 		return NULL;
 	}
 
-	/* Close write end of pipe. */
-	close(out_pipe[1]);
-
 	fp = fdopen(out_pipe[0], "r");
 	if(fp == NULL)
 	{
@@ -1286,21 +1545,23 @@ get_true_inode(const dir_entry_t *entry)
 	return entry->inode;
 }
 
-void
-bind_pipe_or_die(int fd, int pipe_end, int pipe_other)
+int
+make_cloexec_pipe(int fds[2])
 {
-	if(dup2(pipe_end, fd) == -1)
+	if(pipe(fds) != 0)
 	{
-		perror("dup2");
-		_Exit(EXIT_FAILURE);
+		return 1;
 	}
 
-	/* Close original input pipe descriptors. */
-	if(pipe_end != fd)
+	if(fcntl(fds[0], F_SETFD, FD_CLOEXEC) == -1 ||
+			fcntl(fds[1], F_SETFD, FD_CLOEXEC) == -1)
 	{
-		close(pipe_end);
+		(void)close(fds[0]);
+		(void)close(fds[1]);
+		return 1;
 	}
-	close(pipe_other);
+
+	return 0;
 }
 
 int
@@ -36,11 +36,23 @@ struct cancellation_t;
  * process specified by its identifier or -1 on error. */
 int get_proc_exit_status(pid_t pid, const struct cancellation_t *cancellation);
 
-/* If err_only then use stderr and close stdin and stdout, otherwise both stdout
- * and stderr are redirected to the pipe.  Non-zero preserve_stdin prevents
- * stdin from being bound to /dev/null. */
-void _gnuc_noreturn run_from_fork(int pipe[2], int err_only, int preserve_stdin,
-		char cmd[], ShellRequester by);
+/* Special values for standard streams of spawn_shell(). */
+enum
+{
+	SPAWN_INHERIT = -1, /* Keep the stream of the current process. */
+	SPAWN_DEVNULL = -2, /* Bind the stream to /dev/null. */
+};
+
+/* Starts shell command in a child process without waiting for it.  in, out and
+ * err are file descriptors to become standard streams of the child or one of
+ * SPAWN_* values.  The descriptors are closed in the child after being
+ * duplicated, other descriptors which shouldn't be inherited must be marked as
+ * close-on-exec.  Non-zero new_session detaches the child from controlling
+ * terminal.  cwd can be NULL to inherit current directory.  Uses posix_spawn()
+ * where possible to avoid copying address space of the process.  Returns id of
+ * the child or (pid_t)-1 on error. */
+pid_t spawn_shell(const char cmd[], ShellRequester by, int in, int out, int err,
+		int new_session, const char cwd[]);
 
 /* Frees some resources before exec(), which shouldn't be inherited and remain
  * allocated in child process or it might make those resources appear busy
@@ -74,9 +86,9 @@ int status_to_exit_code(int status);
 
 int S_ISEXE(mode_t mode);
 
-/* Duplicates pipe_end file descriptor to fd and closes pipe_other.  Exists with
- * an error message on issues. */
-void bind_pipe_or_die(int fd, int pipe_end, int pipe_other);
+/* Creates a pipe whose both ends are marked as close-on-exec.  Returns zero on
+ * success, otherwise non-zero is returned. */
+int make_cloexec_pipe(int fds[2]);
 
 #endif /* VIFM__UTILS__UTILS_NIX_H__ */
 
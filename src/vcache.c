@@ -50,6 +50,10 @@ enum { MAX_RUN_TIME_S = 60 };
 /* Maximum number of seconds to wait for process to cancel. */
 enum { MAX_KILL_DELAY_S = 2 };
 
+/* Maximum number of viewers that are allowed to run simultaneously not
+ * counting those which are being previewed right now. */
+enum { MAX_ACTIVE_JOBS = 4 };
+
 /* Cached output of a specific previewer for a specific file. */
 typedef struct vcache_entry_t
 {
@@ -90,6 +94,8 @@ static int is_cache_valid(const vcache_entry_t *centry, const char path[],
 static void update_cache_entry(vcache_entry_t *centry, const char path[],
 		const char viewer[], MacroFlags flags, int max_lines, const char **error);
 static void update_sizes(vcache_entry_t *centry);
+static void schedule_jobs(const vcache_entry_t *current,
+		vcache_is_previewed_cb is_previewed);
 static int pull_async(vcache_entry_t *centry);
 static int read_async_output(vcache_entry_t *centry);
 static void cancel_job(vcache_entry_t *centry);
@@ -147,6 +153,8 @@ vcache_check(vcache_is_previewed_cb is_previewed)
 
 	/* TODO: consider doing this in a separate thread. */
 
+	schedule_jobs(NULL, is_previewed);
+
 	size_t i;
 	for(i = 0U; i < DA_SIZE(cache); ++i)
 	{
@@ -161,7 +169,8 @@ vcache_check(vcache_is_previewed_cb is_previewed)
 
 strlist_t
 vcache_lookup(const char full_path[], const char viewer[], MacroFlags flags,
-		ViewerKind kind, int max_lines, int sync, const char **error)
+		ViewerKind kind, int max_lines, int sync,
+		vcache_is_previewed_cb is_previewed, const char **error)
 {
 	*error = NULL;
 
@@ -200,6 +209,7 @@ vcache_lookup(const char full_path[], const char viewer[], MacroFlags flags,
 	}
 
 	update_cache_entry(centry, full_path, viewer, flags, max_lines, error);
+	schedule_jobs(centry, is_previewed);
 
 	if(sync)
 	{
@@ -479,6 +489,40 @@ update_sizes(vcache_entry_t *centry)
 	cache_size += centry->size;
 }
 
+/* Limits number of running viewers by cancelling jobs of least recently used
+ * entries that aren't displayed.  Current entry and entries for which
+ * is_previewed returns non-zero (if it's not NULL) are never cancelled.  This
+ * way the most recent entries are still cached opportunistically while viewers
+ * of entries that were just scrolled past don't pile up. */
+static void
+schedule_jobs(const vcache_entry_t *current,
+		vcache_is_previewed_cb is_previewed)
+{
+	int active = 0;
+
+	/* Traverse entries from the most recently used one. */
+	size_t i = DA_SIZE(cache);
+	while(i-- > 0U)
+	{
+		vcache_entry_t *centry = cache[i];
+		if(centry->job == NULL || centry->kill_timer != 0)
+		{
+			continue;
+		}
+
+		if(centry == current ||
+				(is_previewed != NULL && is_previewed(centry->path)))
+		{
+			continue;
+		}
+
+		if(++active > MAX_ACTIVE_JOBS)
+		{
+			cancel_job(centry);
+		}
+	}
+}
+
 /* Updates single entry backed by an asynchronous job.  Returns non-zero if
  * entry was updated, otherwise zero is returned. */
 static int
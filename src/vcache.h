@@ -54,12 +54,13 @@ size_t vcache_size(void);
 int vcache_check(vcache_is_previewed_cb is_previewed);
 
 /* Looks up cached output of a viewer command (no macro expansion is performed)
- * or produces and caches it.  *error is set either to NULL or an error code on
- * failure.  Returns list of strings owned and managed by the unit, don't store
- * or free it. */
+ * or produces and caches it.  Viewers of entries for which is_previewed (can
+ * be NULL) returns non-zero aren't cancelled to start a new one.  *error is set
+ * either to NULL or an error code on failure.  Returns list of strings owned
+ * and managed by the unit, don't store or free it. */
 struct strlist_t vcache_lookup(const char full_path[], const char viewer[],
 		MacroFlags flags, ViewerKind kind, int max_lines, int sync,
-		const char **error);
+		vcache_is_previewed_cb is_previewed, const char **error);
 
 TSTATIC_DEFS(
 	struct strlist_t read_lines(FILE *fp, int max_lines, int *complete);
@@ -68,6 +68,7 @@
 #include "utils/path.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/trace.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
 #include "args.h"
@@ -177,6 +178,12 @@ vifm_main(int argc, char *argv[])
 	args_parse(&vifm_args, argc, argv, dir);
 	args_process(&vifm_args, AS_GENERAL, curr_stats.ipc);
 
+	if(vifm_args.startup_profile[0] != '\0')
+	{
+		(void)trace_start(vifm_args.startup_profile);
+	}
+	trace_begin("startup", NULL);
+
 	lwin_cv = (strcmp(vifm_args.lwin_path, "-") == 0 && vifm_args.lwin_handle);
 	rwin_cv = (strcmp(vifm_args.rwin_path, "-") == 0 && vifm_args.rwin_handle);
 	if(lwin_cv || rwin_cv)
@@ -200,6 +207,7 @@ vifm_main(int argc, char *argv[])
 	/* Process --remote* parameters even before initializing configuration as it
 	 * indirectly depends on terminal initialization and IPC interaction mustn't
 	 * need a terminal. */
+	trace_begin("ipc", NULL);
 	struct ipc_t *ipc = ipc_init(vifm_args.server_name, &parse_received_arguments,
 			&eval_received_expression);
 	if(ipc_enabled() && ipc == NULL)
@@ -208,7 +216,9 @@ vifm_main(int argc, char *argv[])
 		return -1;
 	}
 	args_process(&vifm_args, AS_IPC, ipc);
+	trace_end();
 
+	trace_begin("init", NULL);
 	cfg_init();
 	init_filelists();
 	tabs_init();
@@ -239,12 +249,15 @@ vifm_main(int argc, char *argv[])
 	ft_reset(curr_stats.exec_env_type == EET_EMULATOR_WITH_X);
 
 	init_option_handlers();
+	trace_end();
 
 	if(!vifm_args.no_configs)
 	{
 		/* vifminfo must be processed this early so that it can restore last visited
 		 * directory. */
-		state_load(0);
+		trace_begin("vifminfo", NULL);
+		state_load_initial();
+		trace_end();
 	}
 
 	/* Export chosen IPC server name to parsing unit. */
@@ -277,8 +290,10 @@ vifm_main(int argc, char *argv[])
 		swap_view_roles();
 	}
 
+	trace_begin("initial directories", NULL);
 	load_initial_directory(&lwin, dir);
 	load_initial_directory(&rwin, dir);
+	trace_end();
 
 	/* Force split view when two paths are specified on command-line. */
 	if(vifm_args.lwin_path[0] != '\0' && vifm_args.rwin_path[0] != '\0')
@@ -287,6 +302,7 @@ vifm_main(int argc, char *argv[])
 	}
 
 	/* Prepare terminal for further operations. */
+	trace_begin("curses", NULL);
 	curr_stats.original_stdout = reopen_term_stdout();
 	if(curr_stats.original_stdout == NULL)
 	{
@@ -304,16 +320,24 @@ vifm_main(int argc, char *argv[])
 	un_init(&undo_perform_func, NULL, &ui_cancellation_requested,
 			&cfg.undo_levels);
 	load_view_options(curr_view);
+	trace_end();
 
 	curr_stats.load_stage = 1;
 
+	trace_begin("lua", NULL);
 	curr_stats.vlua = vlua_init();
 	curr_stats.plugs = plugs_create(curr_stats.vlua);
+	trace_end();
 
 	if(!vifm_args.no_configs)
 	{
+		trace_begin("color scheme", NULL);
 		load_scheme();
+		trace_end();
+
+		trace_begin("vifmrc", NULL);
 		cfg_load();
+		trace_end();
 	}
 
 	if(lwin_cv || rwin_cv)
@@ -332,7 +356,9 @@ vifm_main(int argc, char *argv[])
 		(void)trash_set_specs(cfg.trash_dir);
 	}
 
+	trace_begin("plugins", NULL);
 	plugs_load(curr_stats.plugs, curr_stats.plugins_dirs);
+	trace_end();
 
 	check_path_for_file(&lwin, vifm_args.lwin_path, vifm_args.lwin_handle);
 	check_path_for_file(&rwin, vifm_args.rwin_path, vifm_args.rwin_handle);
@@ -348,6 +374,7 @@ vifm_main(int argc, char *argv[])
 	flist_hist_save(&rwin);
 
 	/* Trigger auto-commands for initial directories. */
+	trace_begin("DirEnter autocommands", NULL);
 	if(!lwin_cv)
 	{
 		vle_aucmd_execute("DirEnter", flist_get_dir(&lwin), &lwin);
@@ -356,19 +383,34 @@ vifm_main(int argc, char *argv[])
 	{
 		vle_aucmd_execute("DirEnter", flist_get_dir(&rwin), &rwin);
 	}
+	trace_end();
 
+	trace_begin("first draw", NULL);
 	update_screen(UT_FULL);
 	modes_update();
+	trace_end();
+
+	/* Finish loading state postponed to draw the first frame sooner. */
+	trace_begin("vifminfo (deferred)", NULL);
+	state_load_deferred();
+	trace_end();
 
 	/* Run startup commands after loading file lists into views, so that commands
 	 * like +1 work. */
+	trace_begin("startup commands", NULL);
 	exec_startup_commands(&vifm_args);
+	trace_end();
 
 	curr_stats.load_stage = 3;
 
 	/* Update screen after startup commands while in load state 3 so CHPOS_STARTUP
 	 * has no effect and doesn't reset cursor position after `+"goto path"`. */
+	trace_begin("final draw", NULL);
 	update_screen(stats_update_fetch());
+	trace_end();
+
+	trace_end();
+	trace_finish();
 
 	event_loop(&quit, /*manage_marking=*/1);
 
@@ -563,7 +605,9 @@ exec_startup_commands(const args_t *args)
 		/* Make sure we're executing commands in correct directory. */
 		(void)vifm_chdir(flist_get_dir(curr_view));
 
+		trace_begin(args->cmds[i], "startup command");
 		(void)cmds_dispatch(args->cmds[i], curr_view, CIT_COMMAND);
+		trace_end();
 	}
 }
 
@@ -675,6 +719,9 @@ vifm_finish(const char message[])
 void _gnuc_noreturn
 vifm_exit(int exit_code)
 {
+	/* Write out trace if startup didn't finish (e.g., :quit in vifmrc). */
+	trace_finish();
+
 	vcache_finish();
 	plugs_free(curr_stats.plugs);
 	vlua_finish(curr_stats.vlua);
@@ -10,6 +10,7 @@
 
 #include "../../src/cfg/config.h"
 #include "../../src/engine/cmds.h"
+#include "../../src/ui/statusbar.h"
 #include "../../src/ui/ui.h"
 #include "../../src/utils/macros.h"
 #include "../../src/utils/str.h"
@@ -149,5 +150,38 @@ TEST(provide_input_to_bg_process, IF(have_cat))
 	view_teardown(&lwin);
 }
 
+TEST(batched_command_runs_in_background)
+{
+	assert_success(chdir(SANDBOX_PATH));
+
+	view_setup(&lwin);
+	setup_grid(&lwin, 20, 2, /*init=*/1);
+	replace_string(&lwin.dir_entry[0].name, "a");
+	replace_string(&lwin.dir_entry[1].name, "b");
+
+	lwin.dir_entry[0].marked = 1;
+	lwin.dir_entry[1].marked = 1;
+	lwin.pending_marking = 1;
+
+	assert_int_equal(0, cmds_dispatch("!echo %f%x > file &", &lwin,
+				CIT_COMMAND));
+
+	wait_for_all_bg();
+
+	const char *lines[] = { "a b" };
+	file_is("file", lines, ARRAY_LEN(lines));
+
+	remove_file("file");
+
+	view_teardown(&lwin);
+}
+
+TEST(batched_command_is_incompatible_with_some_macros)
+{
+	assert_int_equal(1, cmds_dispatch("!echo %f%x%S", &lwin, CIT_COMMAND));
+	assert_string_equal("\"%x\" macro can't be combined with \"%S\"",
+			ui_sb_last());
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
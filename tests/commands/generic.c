@@ -204,6 +204,26 @@ TEST(shell_invocation_works_in_udf)
 	assert_success(unlink("out"));
 }
 
+TEST(batched_shell_invocation_works_in_udf, IF(not_windows))
+{
+	replace_string(&cfg.shell, "/bin/sh");
+	replace_string(&cfg.shell_cmd_flag, "-c");
+
+	assert_success(chdir(SANDBOX_PATH));
+
+	assert_success(cmds_dispatch("command! udf !echo %a%x > out &", &lwin,
+				CIT_COMMAND));
+
+	curr_view = &lwin;
+
+	assert_success(cmds_dispatch("udf arg", &lwin, CIT_COMMAND));
+	wait_for_all_bg();
+
+	const char *lines[] = { "arg" };
+	file_is("out", lines, ARRAY_LEN(lines));
+	assert_success(unlink("out"));
+}
+
 TEST(envvars_of_commands_come_from_variables_unit)
 {
 	assert_success(chdir(test_data));
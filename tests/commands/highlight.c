@@ -15,6 +15,8 @@
 #include "../../src/filelist.h"
 #include "../../src/status.h"
 
+static int find_hi(const col_scheme_t *cs, const char fname[]);
+
 SETUP_ONCE()
 {
 	cmds_init();
@@ -546,5 +548,55 @@ TEST(tabs_are_allowed)
 	}
 }
 
+TEST(order_of_rules_is_respected_by_lookup)
+{
+	assert_success(cmds_dispatch("highlight /^a.*\\.c$/ cterm=bold", &lwin,
+				CIT_COMMAND));
+	assert_success(cmds_dispatch("highlight {*.c,Makefile} cterm=bold", &lwin,
+				CIT_COMMAND));
+	assert_success(cmds_dispatch("highlight {*.tar.gz} cterm=bold", &lwin,
+				CIT_COMMAND));
+	assert_success(cmds_dispatch("highlight {*.gz} cterm=bold", &lwin,
+				CIT_COMMAND));
+	assert_success(cmds_dispatch("highlight {b*} cterm=bold", &lwin,
+				CIT_COMMAND));
+
+	assert_int_equal(0, find_hi(&cfg.cs, "a.c"));
+	assert_int_equal(1, find_hi(&cfg.cs, "b.c"));
+	assert_int_equal(1, find_hi(&cfg.cs, "/some/path/b.C"));
+	assert_int_equal(1, find_hi(&cfg.cs, "MAKEFILE"));
+	assert_int_equal(2, find_hi(&cfg.cs, "x.tar.gz"));
+	assert_int_equal(2, find_hi(&cfg.cs, "c.TAR.gz"));
+	assert_int_equal(3, find_hi(&cfg.cs, "x.gz"));
+	assert_int_equal(3, find_hi(&cfg.cs, "b.gz"));
+	assert_int_equal(4, find_hi(&cfg.cs, "bcd"));
+	assert_int_equal(INT_MAX, find_hi(&cfg.cs, ".c"));
+	assert_int_equal(INT_MAX, find_hi(&cfg.cs, "Makefile.in"));
+	assert_int_equal(INT_MAX, find_hi(&cfg.cs, "dir.c/"));
+
+	/* Removal shifts rules. */
+	assert_success(cmds_dispatch("highlight clear {*.c,Makefile}", &lwin,
+				CIT_COMMAND));
+	assert_int_equal(3, find_hi(&cfg.cs, "b.c"));
+	assert_int_equal(1, find_hi(&cfg.cs, "x.tar.gz"));
+	assert_int_equal(INT_MAX, find_hi(&cfg.cs, "Makefile"));
+
+	/* Copy of a color scheme works the same way. */
+	col_scheme_t cs = {};
+	cs_assign(&cs, &cfg.cs);
+	assert_int_equal(0, find_hi(&cs, "a.c"));
+	assert_int_equal(1, find_hi(&cs, "x.tar.gz"));
+	assert_int_equal(2, find_hi(&cs, "x.gz"));
+	cs_reset(&cs);
+}
+
+static int
+find_hi(const col_scheme_t *cs, const char fname[])
+{
+	int hint = -1;
+	(void)cs_get_file_hi(cs, fname, &hint);
+	return hint;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -104,6 +104,7 @@ TEST(enter_navigates_to_found_file, IF(not_windows))
 	strcpy(lwin.curr_dir, test_data);
 
 	assert_success(cmds_dispatch("find dir1", &lwin, CIT_COMMAND));
+	wait_for_menus();
 
 	char dst[PATH_MAX + 1];
 	snprintf(dst, sizeof(dst), "%s/tree", test_data);
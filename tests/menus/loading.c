@@ -0,0 +1,201 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <stdio.h> /* remove() snprintf() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/engine/keys.h"
+#include "../../src/engine/mode.h"
+#include "../../src/menus/menus.h"
+#include "../../src/modes/menu.h"
+#include "../../src/modes/modes.h"
+#include "../../src/modes/wk.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/cmd_core.h"
+#include "../../src/status.h"
+
+static void make_script(const char body[]);
+static void start_slow_menu(void);
+static void let_script_finish(void);
+
+static char script_path[PATH_MAX + 1];
+static char go_path[PATH_MAX + 1];
+
+SETUP()
+{
+	conf_setup();
+	modes_init();
+	cmds_init();
+
+	curr_view = &lwin;
+	other_view = &rwin;
+	view_setup(&lwin);
+
+	curr_stats.load_stage = -1;
+
+	make_abs_path(script_path, sizeof(script_path), SANDBOX_PATH, "script",
+			NULL);
+	make_abs_path(go_path, sizeof(go_path), SANDBOX_PATH, "go", NULL);
+	update_string(&cfg.locate_prg, script_path);
+}
+
+TEARDOWN()
+{
+	if(vle_mode_is(MENU_MODE))
+	{
+		(void)vle_keys_exec(WK_ESC);
+	}
+	menus_drop_stash();
+
+	vle_keys_reset();
+	conf_teardown();
+
+	view_teardown(&lwin);
+	curr_view = NULL;
+	other_view = NULL;
+
+	curr_stats.load_stage = 0;
+
+	assert_success(remove(script_path));
+	(void)remove(go_path);
+}
+
+TEST(menu_is_entered_before_command_finishes)
+{
+	start_slow_menu();
+
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_true(menus_are_loading());
+	assert_int_equal(1, menu_get_current()->len);
+	assert_string_equal("first", menu_get_current()->items[0]);
+
+	/* Incomplete line doesn't become an item. */
+	menus_check_for_updates();
+	assert_int_equal(1, menu_get_current()->len);
+
+	let_script_finish();
+	wait_for_menus();
+
+	assert_false(menus_are_loading());
+	assert_int_equal(2, menu_get_current()->len);
+	assert_string_equal("second", menu_get_current()->items[1]);
+}
+
+TEST(search_matches_items_loaded_after_it)
+{
+	start_slow_menu();
+
+	(void)menus_search("sec", menu_get_current(), /*print_errors=*/0);
+	assert_int_equal(0, menus_search_matched(menu_get_current()));
+
+	let_script_finish();
+	wait_for_menus();
+
+	assert_int_equal(1, menus_search_matched(menu_get_current()));
+}
+
+TEST(ctrl_c_stops_loading_before_leaving_menu)
+{
+	start_slow_menu();
+
+	(void)vle_keys_exec(WK_C_c);
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_false(menus_are_loading());
+	assert_int_equal(1, menu_get_current()->len);
+	assert_true(ends_with(menu_get_current()->title, "(cancelled)"));
+
+	(void)vle_keys_exec(WK_C_c);
+	assert_false(vle_mode_is(MENU_MODE));
+}
+
+TEST(closed_menu_keeps_loading)
+{
+	start_slow_menu();
+
+	(void)vle_keys_exec(WK_ESC);
+	assert_false(vle_mode_is(MENU_MODE));
+	assert_true(menus_are_loading());
+
+	let_script_finish();
+	wait_for_menus();
+
+	assert_success(cmds_dispatch("copen", &lwin, CIT_COMMAND));
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_int_equal(2, menu_get_current()->len);
+}
+
+TEST(dropped_menu_stops_loading)
+{
+	start_slow_menu();
+
+	(void)vle_keys_exec(WK_ESC);
+	menus_drop_stash();
+	assert_false(menus_are_loading());
+}
+
+TEST(empty_output_is_reported_without_entering_menu)
+{
+	make_script("true");
+
+	assert_failure(cmds_dispatch("locate x", &lwin, CIT_COMMAND));
+	assert_false(vle_mode_is(MENU_MODE));
+	assert_false(menus_are_loading());
+}
+
+TEST(items_can_be_separated_by_nulls)
+{
+	make_script("printf 'a b\\0c\\0'");
+
+	assert_success(cmds_dispatch("locate x", &lwin, CIT_COMMAND));
+	wait_for_menus();
+
+	assert_int_equal(2, menu_get_current()->len);
+	assert_string_equal("a b", menu_get_current()->items[0]);
+	assert_string_equal("c", menu_get_current()->items[1]);
+}
+
+/* Makes locate script with the specified body. */
+static void
+make_script(const char body[])
+{
+	char contents[2*PATH_MAX];
+	snprintf(contents, sizeof(contents), "#!/bin/sh\n%s\n", body);
+
+	create_executable(script_path);
+	make_file(script_path, contents);
+}
+
+/* Starts menu whose command prints one item and then waits for a signal from
+ * let_script_finish() before completing the second one. */
+static void
+start_slow_menu(void)
+{
+	char body[PATH_MAX + 128];
+	snprintf(body, sizeof(body),
+			"echo first\n"
+			"printf sec\n"
+			"while [ ! -e '%s' ]; do sleep 0.01; done\n"
+			"echo ond",
+			go_path);
+	make_script(body);
+
+	assert_success(cmds_dispatch("locate x", &lwin, CIT_COMMAND));
+}
+
+/* Lets script started by start_slow_menu() finish. */
+static void
+let_script_finish(void)
+{
+	create_file(go_path);
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
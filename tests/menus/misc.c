@@ -123,6 +123,27 @@ TEST(menu_is_built_from_a_command_with_input, IF(have_cat))
 	undo_teardown();
 }
 
+TEST(menu_is_built_from_a_batched_command)
+{
+	undo_setup();
+
+	setup_grid(&lwin, 20, 2, /*init=*/1);
+	replace_string(&lwin.dir_entry[0].name, "a");
+	replace_string(&lwin.dir_entry[1].name, "b");
+	lwin.dir_entry[0].marked = 1;
+	lwin.dir_entry[1].marked = 1;
+	lwin.pending_marking = 1;
+
+	assert_success(cmds_dispatch("!echo %f %x%m", &lwin, CIT_COMMAND));
+
+	assert_int_equal(1, menu_get_current()->len);
+	assert_string_equal("a b", menu_get_current()->items[0]);
+	assert_string_equal("!echo %f %x%m", menu_get_current()->title);
+
+	(void)vle_keys_exec(WK_ESC);
+	undo_teardown();
+}
+
 TEST(menu_cmds_have_a_history)
 {
 	histories_init(5);
@@ -480,10 +501,12 @@ TEST(locate_menu_can_escape_args, IF(not_windows))
 			"for arg; do echo \"$arg\"; done\n");
 
 	assert_success(cmds_dispatch("locate a  b", &lwin, CIT_COMMAND));
+	wait_for_menus();
 	assert_int_equal(1, menu_get_current()->len);
 	assert_string_equal("a  b", menu_get_current()->items[0]);
 
 	assert_success(cmds_dispatch("locate -a  b", &lwin, CIT_COMMAND));
+	wait_for_menus();
 	assert_int_equal(2, menu_get_current()->len);
 	assert_string_equal("-a", menu_get_current()->items[0]);
 	assert_string_equal("b", menu_get_current()->items[1]);
@@ -505,11 +528,13 @@ TEST(can_start_menu_from_menus, IF(not_windows))
 
 	/* Start menu mode with a :grep. */
 	assert_success(cmds_dispatch1("grep endif", &lwin, CIT_COMMAND));
+	wait_for_menus();
 	assert_string_equal("Grep endif", menu_get_current()->title);
 	assert_int_equal(4, menu_get_current()->len);
 
 	/* Run a new :grep while in menu mode. */
 	assert_success(cmds_dispatch1("grep finish", &lwin, CIT_MENU_COMMAND));
+	wait_for_menus();
 	assert_string_equal("Grep finish", menu_get_current()->title);
 	assert_int_equal(2, menu_get_current()->len);
 
@@ -540,11 +565,13 @@ TEST(find_cmd, IF(not_windows))
 
 	/* Start menu mode with a :find. */
 	assert_success(cmds_dispatch1("find *.vifm", &lwin, CIT_COMMAND));
+	wait_for_menus();
 	assert_string_equal("Find *.vifm", menu_get_current()->title);
 	assert_int_equal(7, menu_get_current()->len);
 
 	/* Run a new good :find while in menu mode. */
 	assert_success(cmds_dispatch1("find finish-*.%c:e", &lwin, CIT_MENU_COMMAND));
+	wait_for_menus();
 	assert_string_equal("Find finish-*.vifm", menu_get_current()->title);
 	assert_int_equal(2, menu_get_current()->len);
 
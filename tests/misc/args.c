@@ -228,7 +228,21 @@ TEST(remote_expr_is_parsed, IF(with_remote_cmds))
 	char *argv[] = { "vifm", "--remote-expr", "expr", NULL };
 
 	args_parse(&args, ARRAY_LEN(argv) - 1U, argv, "/");
-	assert_string_equal("expr", args.remote_expr);
+	assert_int_equal(1, args.nremote_exprs);
+	assert_string_equal("expr", args.remote_exprs[0]);
+	args_free(&args);
+}
+
+TEST(remote_exprs_are_accumulated, IF(with_remote_cmds))
+{
+	args_t args = { };
+	char *argv[] = { "vifm", "--remote-expr", "expr1", "--remote-expr", "expr2",
+	                 NULL };
+
+	args_parse(&args, ARRAY_LEN(argv) - 1U, argv, "/");
+	assert_int_equal(2, args.nremote_exprs);
+	assert_string_equal("expr1", args.remote_exprs[0]);
+	assert_string_equal("expr2", args.remote_exprs[1]);
 	args_free(&args);
 }
 
@@ -1,6 +1,6 @@
 #include <stic.h>
 
-#include <unistd.h> /* chdir() usleep() */
+#include <unistd.h> /* F_OK access() chdir() usleep() */
 
 #include <stdio.h> /* FILE fclose() fputs() */
 #include <stdlib.h> /* free() */
@@ -8,11 +8,14 @@
 
 #include <test-utils.h>
 
+#include "../../src/compat/fs_limits.h"
 #include "../../src/compat/pthread.h"
 #include "../../src/engine/var.h"
 #include "../../src/engine/variables.h"
 #include "../../src/utils/cancellation.h"
 #include "../../src/utils/env.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/macros.h"
 #include "../../src/utils/string_array.h"
 #include "../../src/ui/ui.h"
 #include "../../src/background.h"
@@ -22,6 +25,7 @@
 static void on_job_exit(struct bg_job_t *job, void *data);
 static void task(bg_op_t *bg_op, void *arg);
 static void wait_until_locked(pthread_spinlock_t *lock);
+static void wait_for_job(bg_job_t *job);
 
 SETUP_ONCE()
 {
@@ -213,8 +217,10 @@ TEST(jobs_exit_cb_is_called)
 	int called = 0;
 	bg_job_set_exit_cb(job, &on_job_exit, &called);
 
+	/* Not checking bg_job_is_running() here, because it can reap the process
+	 * before bg_check() had a chance to invoke the callback. */
 	int counter = 0;
-	while(bg_job_is_running(job))
+	while(!called)
 	{
 		usleep(5000);
 		bg_check();
@@ -225,6 +231,7 @@ TEST(jobs_exit_cb_is_called)
 		}
 	}
 
+	assert_false(bg_job_is_running(job));
 	assert_int_equal(1, called);
 
 	bg_job_decref(job);
@@ -289,6 +296,47 @@ TEST(can_run_command_starting_with_a_dash, IF(not_windows))
 	remove_file(SANDBOX_PATH "/-script");
 }
 
+TEST(batch_runs_all_commands_in_its_directory, IF(not_windows))
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	char *cmds[] = { "echo a > a", "exit 3", "echo b > b", "echo c > c" };
+
+	assert_success(chdir(SANDBOX_PATH));
+	bg_job_t *job = bg_run_batch(cmds, ARRAY_LEN(cmds), /*max_jobs=*/2,
+			/*skip_errors=*/1, "batch");
+	assert_success(chdir(cwd));
+	assert_non_null(job);
+
+	assert_int_equal(ARRAY_LEN(cmds), job->bg_op.total);
+	wait_for_job(job);
+	assert_int_equal(ARRAY_LEN(cmds), job->bg_op.done);
+	assert_int_equal(3, job->exit_code);
+
+	bg_job_decref(job);
+
+	remove_file(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/b");
+	remove_file(SANDBOX_PATH "/c");
+}
+
+TEST(cancelled_batch_does_not_start_new_commands, IF(not_windows))
+{
+	char *cmds[] = { "exit 0", "echo > " SANDBOX_PATH "/file" };
+
+	bg_job_t *job = bg_run_batch(cmds, ARRAY_LEN(cmds), /*max_jobs=*/1,
+			/*skip_errors=*/1, "batch");
+	assert_non_null(job);
+	assert_true(bg_job_cancel(job));
+
+	wait_for_job(job);
+	assert_int_equal(1, job->bg_op.done);
+	assert_failure(access(SANDBOX_PATH "/file", F_OK));
+
+	bg_job_decref(job);
+}
+
 static void
 task(bg_op_t *bg_op, void *arg)
 {
@@ -309,5 +357,22 @@ wait_until_locked(pthread_spinlock_t *lock)
 	}
 }
 
+/* Waits for the job to finish by checking state of background jobs. */
+static void
+wait_for_job(bg_job_t *job)
+{
+	int counter = 0;
+	while(bg_job_is_running(job))
+	{
+		usleep(5000);
+		bg_check();
+		if(++counter > 200)
+		{
+			assert_fail("Waiting for too long.");
+			return;
+		}
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,142 @@
+#include <stic.h>
+
+#include <string.h> /* strcpy() */
+
+#include <test-utils.h>
+
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_sel.h"
+#include "../../src/macros.h"
+#include "../../src/status.h"
+
+#ifdef _WIN32
+#define SL "\\\\"
+#else
+#define SL "/"
+#endif
+
+static void setup_view(view_t *view, const char path[], const char prefix[],
+		int nfiles);
+
+SETUP_ONCE()
+{
+	stats_update_shell_type("/bin/sh");
+}
+
+SETUP()
+{
+	setup_view(&lwin, "/lwin", "l", 4);
+	replace_string(&lwin.dir_entry[0].name, "lfi le0");
+	replace_string(&lwin.dir_entry[2].name, "lfile\"2");
+	lwin.dir_entry[0].selected = 1;
+	lwin.dir_entry[2].selected = 1;
+	lwin.selected_files = 2;
+
+	setup_view(&rwin, "/rwin", "r", 6);
+	rwin.dir_entry[1].selected = 1;
+	rwin.dir_entry[3].selected = 1;
+	rwin.dir_entry[5].selected = 1;
+	rwin.selected_files = 3;
+
+	curr_view = &lwin;
+	other_view = &rwin;
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+}
+
+TEST(batch_expansion_splits_list_of_files)
+{
+	int jobs;
+	strlist_t cmds = expand_batched("echo %f %x end", "", MER_SHELL_OP,
+			/*limit=*/30, &jobs);
+	assert_int_equal(1, jobs);
+	assert_int_equal(1, cmds.nitems);
+	assert_string_equal("echo lfi\\ le0 lfile\\\"2  end", cmds.items[0]);
+	free_string_array(cmds.items, cmds.nitems);
+
+	cmds = expand_batched("echo %f %x4 end", "", MER_SHELL_OP, /*limit=*/20,
+			&jobs);
+	assert_int_equal(4, jobs);
+	assert_int_equal(2, cmds.nitems);
+	assert_string_equal("echo lfi\\ le0  end", cmds.items[0]);
+	assert_string_equal("echo lfile\\\"2  end", cmds.items[1]);
+	free_string_array(cmds.items, cmds.nitems);
+}
+
+TEST(batch_expansion_keeps_too_long_paths)
+{
+	int jobs;
+	strlist_t cmds = expand_batched("%x%F", "", MER_SHELL_OP, /*limit=*/1,
+			&jobs);
+	assert_int_equal(3, cmds.nitems);
+	assert_string_equal(SL "rwin" SL "rfile1", cmds.items[0]);
+	assert_string_equal(SL "rwin" SL "rfile3", cmds.items[1]);
+	assert_string_equal(SL "rwin" SL "rfile5", cmds.items[2]);
+	free_string_array(cmds.items, cmds.nitems);
+}
+
+TEST(batch_expansion_splits_only_first_list)
+{
+	int jobs;
+	strlist_t cmds = expand_batched("%x cp %f %D", "", MER_SHELL_OP,
+			/*limit=*/20, &jobs);
+	assert_int_equal(2, cmds.nitems);
+	assert_string_equal(" cp lfi\\ le0 " SL "rwin", cmds.items[0]);
+	assert_string_equal(" cp lfile\\\"2 " SL "rwin", cmds.items[1]);
+	free_string_array(cmds.items, cmds.nitems);
+
+	cmds = expand_batched("%x %l%L", "", MER_SHELL_OP, /*limit=*/1000, &jobs);
+	assert_int_equal(1, cmds.nitems);
+	assert_string_equal(" lfi\\ le0 lfile\\\"2"
+			SL "rwin" SL "rfile1 " SL "rwin" SL "rfile3 " SL "rwin" SL "rfile5",
+			cmds.items[0]);
+	free_string_array(cmds.items, cmds.nitems);
+}
+
+TEST(batch_expansion_without_files_produces_single_command)
+{
+	flist_sel_stash(&lwin);
+
+	int jobs;
+	strlist_t cmds = expand_batched("echo %x%l.", "", MER_SHELL_OP,
+			/*limit=*/1000, &jobs);
+	assert_int_equal(1, cmds.nitems);
+	assert_string_equal("echo .", cmds.items[0]);
+	free_string_array(cmds.items, cmds.nitems);
+
+	cmds = expand_batched("echo %x", "", MER_SHELL_OP, /*limit=*/1000, &jobs);
+	assert_int_equal(1, cmds.nitems);
+	assert_string_equal("echo ", cmds.items[0]);
+	free_string_array(cmds.items, cmds.nitems);
+}
+
+/* Fills the view with nfiles entries named "<prefix>file<index>". */
+static void
+setup_view(view_t *view, const char path[], const char prefix[], int nfiles)
+{
+	view_setup(view);
+	strcpy(view->curr_dir, path);
+
+	view->list_rows = nfiles;
+	view->list_pos = 0;
+	view->dir_entry = dynarray_cextend(NULL,
+			view->list_rows*sizeof(*view->dir_entry));
+
+	int i;
+	for(i = 0; i < nfiles; ++i)
+	{
+		view->dir_entry[i].name = format_str("%sfile%d", prefix, i);
+		view->dir_entry[i].origin = &view->curr_dir[0];
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -734,6 +734,16 @@ TEST(preview_direct_is_expanded_to_nothing)
 	free(expanded);
 }
 
+TEST(batch_flag_is_parsed)
+{
+	MacroFlags flags;
+	char *expanded = ma_expand("echo %x12%i", "", &flags, MER_SHELL_OP);
+	assert_string_equal("echo ", expanded);
+	assert_true(ma_flags_present(flags, MF_BATCH));
+	assert_true(ma_flags_present(flags, MF_IGNORE));
+	free(expanded);
+}
+
 TEST(flags_to_str)
 {
 	assert_string_equal("", ma_flags_to_str(MF_NONE));
@@ -754,6 +764,8 @@ TEST(flags_to_str)
 
 	assert_string_equal("%N", ma_flags_to_str(MF_KEEP_IN_FG));
 
+	assert_string_equal("%x", ma_flags_to_str(MF_BATCH));
+
 	assert_string_equal("%Pl", ma_flags_to_str(MF_PIPE_FILE_LIST));
 	assert_string_equal("%Pz", ma_flags_to_str(MF_PIPE_FILE_LIST_Z));
 
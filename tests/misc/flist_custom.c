@@ -568,6 +568,24 @@ TEST(renaming_dir_in_cv_adjust_its_children_entries)
 	assert_string_equal(path, lwin.dir_entry[1].origin);
 }
 
+TEST(entries_of_the_same_directory_share_origin)
+{
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/existing-files/a");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/existing-files/b");
+	flist_custom_add(&lwin, TEST_DATA_PATH "/read/dos-eof");
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+	assert_int_equal(3, lwin.list_rows);
+
+	assert_true(lwin.dir_entry[0].origin == lwin.dir_entry[1].origin);
+	assert_false(lwin.dir_entry[1].origin == lwin.dir_entry[2].origin);
+
+	/* Changing origin of one entry doesn't affect the other one. */
+	fentry_set_origin(&lwin.dir_entry[0], "/some/path");
+	assert_string_equal("/some/path", lwin.dir_entry[0].origin);
+	assert_true(ends_with(lwin.dir_entry[1].origin, "existing-files"));
+}
+
 TEST(symlinks_are_not_resolved_in_origins, IF(not_windows))
 {
 	char path[PATH_MAX + 1];
@@ -674,5 +674,39 @@ TEST(fentry_points_to_works, IF(not_windows))
 	remove_file(SANDBOX_PATH "/link");
 }
 
+TEST(status_of_link_target_is_determined_on_load, IF(not_windows))
+{
+	create_file(SANDBOX_PATH "/file");
+	assert_success(make_symlink("file", SANDBOX_PATH "/good"));
+	assert_success(make_symlink("no-file", SANDBOX_PATH "/bad"));
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+	load_dir_list(&lwin, 1);
+
+	assert_int_equal(3, lwin.list_rows);
+	assert_string_equal("bad", lwin.dir_entry[0].name);
+	assert_true(lwin.dir_entry[0].broken_link);
+	assert_string_equal("good", lwin.dir_entry[2].name);
+	assert_false(lwin.dir_entry[2].broken_link);
+	assert_true(S_ISREG(lwin.dir_entry[2].mode));
+
+	/* Custom view is populated while current directory is elsewhere. */
+	flist_custom_start(&lwin, "test");
+	flist_custom_add(&lwin, SANDBOX_PATH "/good");
+	flist_custom_add(&lwin, SANDBOX_PATH "/bad");
+	assert_success(flist_custom_finish(&lwin, CV_VERY, 0));
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("good", lwin.dir_entry[0].name);
+	assert_false(lwin.dir_entry[0].broken_link);
+	assert_true(S_ISREG(lwin.dir_entry[0].mode));
+	assert_string_equal("bad", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].broken_link);
+
+	remove_file(SANDBOX_PATH "/bad");
+	remove_file(SANDBOX_PATH "/good");
+	remove_file(SANDBOX_PATH "/file");
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
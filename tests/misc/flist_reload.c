@@ -12,6 +12,10 @@
 #include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
 #include "../../src/filelist.h"
+#include "../../src/filtering.h"
+#include "../../src/status.h"
+
+static int using_inotify(void);
 
 static view_t *const view = &lwin;
 
@@ -95,5 +99,150 @@ TEST(selection_is_preserved)
 	assert_int_equal(2, view->selected_files);
 }
 
+TEST(changes_of_entries_are_applied_without_reload, IF(using_inotify))
+{
+	curr_stats.load_stage = 2;
+	(void)ui_view_query_scheduled_event(view);
+
+	view->list_pos = 2;
+	view->dir_entry[1].selected = 1;
+	view->selected_files = 1;
+
+	create_file("a");
+	(void)rmdir("0");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(4, view->list_rows);
+	assert_string_equal("1", view->dir_entry[0].name);
+	assert_string_equal("2", view->dir_entry[1].name);
+	assert_string_equal("3", view->dir_entry[2].name);
+	assert_string_equal("a", view->dir_entry[3].name);
+	assert_int_equal(FT_REG, view->dir_entry[3].type);
+	assert_string_equal("2", view->dir_entry[view->list_pos].name);
+	assert_true(view->dir_entry[0].selected);
+	assert_int_equal(1, view->selected_files);
+
+	assert_success(remove("a"));
+	curr_stats.load_stage = 0;
+}
+
+TEST(filtered_out_entries_are_counted, IF(using_inotify))
+{
+	curr_stats.load_stage = 2;
+	assert_success(filter_set(&view->auto_filter, "b"));
+	(void)ui_view_query_scheduled_event(view);
+
+	create_file("b");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(4, view->list_rows);
+	assert_int_equal(1, view->filtered);
+
+	assert_success(remove("b"));
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+	assert_int_equal(4, view->list_rows);
+	assert_int_equal(0, view->filtered);
+
+	filter_clear(&view->auto_filter);
+	curr_stats.load_stage = 0;
+}
+
+TEST(new_entries_are_inserted_at_sorted_positions, IF(using_inotify))
+{
+	curr_stats.load_stage = 2;
+	(void)ui_view_query_scheduled_event(view);
+
+	view->list_pos = 3;
+
+	create_file("b");
+	create_file("a");
+	create_dir("15");
+	(void)rmdir("0");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(6, view->list_rows);
+	assert_string_equal("1", view->dir_entry[0].name);
+	assert_string_equal("15", view->dir_entry[1].name);
+	assert_string_equal("2", view->dir_entry[2].name);
+	assert_string_equal("3", view->dir_entry[3].name);
+	assert_string_equal("a", view->dir_entry[4].name);
+	assert_string_equal("b", view->dir_entry[5].name);
+	assert_string_equal("3", view->dir_entry[view->list_pos].name);
+
+	assert_success(remove("a"));
+	assert_success(remove("b"));
+	assert_success(rmdir("15"));
+	curr_stats.load_stage = 0;
+}
+
+TEST(updated_entries_are_moved_to_sorted_positions, IF(using_inotify))
+{
+	view_set_sort(view->sort, SK_BY_TIME_MODIFIED, SK_BY_NAME);
+	create_file("a");
+	create_file("b");
+	create_file("c");
+	reset_timestamp("a");
+	reset_timestamp("b");
+	reset_timestamp("c");
+	populate_dir_list(view, 1);
+
+	curr_stats.load_stage = 2;
+	(void)ui_view_query_scheduled_event(view);
+
+	assert_int_equal(7, view->list_rows);
+	assert_string_equal("a", view->dir_entry[4].name);
+	assert_string_equal("b", view->dir_entry[5].name);
+	assert_string_equal("c", view->dir_entry[6].name);
+
+	view->list_pos = 4;
+	view->dir_entry[4].selected = 1;
+	view->selected_files = 1;
+
+	make_file("b", "b");
+	make_file("a", "a");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(view));
+
+	assert_int_equal(7, view->list_rows);
+	assert_string_equal("c", view->dir_entry[4].name);
+	assert_string_equal("a", view->dir_entry[5].name);
+	assert_string_equal("b", view->dir_entry[6].name);
+	assert_int_equal(5, view->list_pos);
+	assert_true(view->dir_entry[5].selected);
+	assert_int_equal(1, view->selected_files);
+
+	assert_success(remove("a"));
+	assert_success(remove("b"));
+	assert_success(remove("c"));
+	curr_stats.load_stage = 0;
+}
+
+TEST(list_is_reloaded_if_changes_are_not_applicable, IF(using_inotify))
+{
+	curr_stats.load_stage = 1;
+	(void)ui_view_query_scheduled_event(view);
+
+	create_file("a");
+	check_if_filelist_has_changed(view);
+	assert_int_equal(UUE_RELOAD, ui_view_query_scheduled_event(view));
+	assert_int_equal(4, view->list_rows);
+
+	assert_success(remove("a"));
+	curr_stats.load_stage = 0;
+}
+
+static int
+using_inotify(void)
+{
+#ifdef HAVE_INOTIFY
+	return 1;
+#else
+	return 0;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -226,6 +226,48 @@ TEST(folds_of_custom_tree_are_not_lost_on_filtering)
 	assert_int_equal(5, lwin.list_rows);
 }
 
+TEST(several_folds_of_custom_tree_are_reapplied)
+{
+	assert_true(build_custom_view(&lwin,
+				"tree/dir1/dir2/dir3/file1",
+				"tree/dir1/dir2/dir3/file2",
+				"tree/dir1/dir2/dir4/file3",
+				"tree/dir1/file4",
+				"tree/dir5/file5",
+				(const char *)NULL) == 0);
+
+	assert_success(load_tree(&lwin, TEST_DATA_PATH, cwd));
+	assert_int_equal(11, lwin.list_rows);
+
+	/* Nested fold. */
+	lwin.list_pos = 6;
+	assert_string_equal("dir4", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(10, lwin.list_rows);
+
+	lwin.list_pos = 8;
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(9, lwin.list_rows);
+
+	lwin.list_pos = 3;
+	assert_string_equal("dir3", lwin.dir_entry[lwin.list_pos].name);
+	toggle_fold_and_update(&lwin);
+	assert_int_equal(7, lwin.list_rows);
+
+	load_view(&lwin);
+	validate_tree(&lwin);
+	assert_int_equal(7, lwin.list_rows);
+	assert_string_equal("dir3", lwin.dir_entry[3].name);
+	assert_string_equal("dir4", lwin.dir_entry[4].name);
+	assert_string_equal("file4", lwin.dir_entry[5].name);
+	assert_string_equal("dir5", lwin.dir_entry[6].name);
+	assert_int_equal(4, lwin.dir_entry[1].child_count);
+	assert_int_equal(0, lwin.dir_entry[3].child_count);
+	assert_int_equal(0, lwin.dir_entry[4].child_count);
+	assert_int_equal(0, lwin.dir_entry[6].child_count);
+}
+
 TEST(local_filter_respects_tree_folds)
 {
 	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree/dir1/dir2", cwd));
@@ -433,6 +475,115 @@ TEST(lazy_unfolding_and_filtering)
 	assert_int_equal(2, lwin.list_rows);
 }
 
+TEST(unfolding_inserts_subtree_in_place)
+{
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 0));
+	assert_int_equal(3, lwin.list_rows);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	lwin.list_pos = 0;
+	assert_string_equal("dir1", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(5, lwin.list_rows);
+	validate_tree(&lwin);
+	assert_string_equal("dir1", lwin.dir_entry[0].name);
+	assert_string_equal("dir2", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].folded);
+	assert_string_equal("file4", lwin.dir_entry[2].name);
+	assert_string_equal("dir5", lwin.dir_entry[3].name);
+	assert_int_equal(0, lwin.list_pos);
+
+	lwin.list_pos = 1;
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(7, lwin.list_rows);
+	validate_tree(&lwin);
+	assert_string_equal("dir3", lwin.dir_entry[2].name);
+	assert_string_equal("dir4", lwin.dir_entry[3].name);
+	assert_string_equal("file4", lwin.dir_entry[4].name);
+	assert_int_equal(1, lwin.list_pos);
+
+	/* Reloading produces the same tree. */
+	load_view(&lwin);
+	assert_int_equal(7, lwin.list_rows);
+	validate_tree(&lwin);
+}
+
+TEST(folding_removes_subtree_in_place)
+{
+	lwin.hide_dot = 1;
+
+	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree", cwd));
+	assert_int_equal(10, lwin.list_rows);
+	assert_int_equal(2, lwin.filtered);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	lwin.list_pos = 8;
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(9, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	validate_tree(&lwin);
+
+	lwin.list_pos = 0;
+	assert_string_equal("dir1", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	validate_tree(&lwin);
+	assert_string_equal("dir5", lwin.dir_entry[1].name);
+	assert_int_equal(0, lwin.list_pos);
+
+	/* Reloading produces the same tree. */
+	load_view(&lwin);
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	validate_tree(&lwin);
+}
+
+TEST(inserted_subtree_is_sorted)
+{
+	view_set_sort(lwin.sort, -SK_BY_NAME, SK_NONE);
+
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 1));
+	assert_int_equal(7, lwin.list_rows);
+	(void)ui_view_query_scheduled_event(&lwin);
+
+	lwin.list_pos = 4;
+	assert_string_equal("dir2", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_int_equal(UUE_REDRAW, ui_view_query_scheduled_event(&lwin));
+	assert_int_equal(9, lwin.list_rows);
+	validate_tree(&lwin);
+	assert_string_equal("dir4", lwin.dir_entry[5].name);
+	assert_string_equal("dir3", lwin.dir_entry[6].name);
+	assert_string_equal("file4", lwin.dir_entry[7].name);
+	assert_int_equal(4, lwin.list_pos);
+}
+
+TEST(new_directories_of_lazy_tree_are_folded)
+{
+	assert_success(os_mkdir(SANDBOX_PATH "/dir1", 0700));
+
+	assert_success(load_limited_tree(&lwin, SANDBOX_PATH, cwd, 0));
+	assert_int_equal(1, lwin.list_rows);
+
+	assert_success(os_mkdir(SANDBOX_PATH "/dir2", 0700));
+	create_file(SANDBOX_PATH "/dir2/file");
+	load_view(&lwin);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("dir2", lwin.dir_entry[1].name);
+	assert_true(lwin.dir_entry[1].folded);
+
+	assert_success(remove(SANDBOX_PATH "/dir2/file"));
+	assert_success(rmdir(SANDBOX_PATH "/dir2"));
+	assert_success(rmdir(SANDBOX_PATH "/dir1"));
+}
+
 TEST(folding_is_reset_on_leaving_tree)
 {
 	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd,
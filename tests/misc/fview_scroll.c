@@ -0,0 +1,259 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memcmp() memset() strdup() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/curses.h"
+#include "../../src/ui/color_scheme.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/fileview.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/status.h"
+
+/* Checks that scrolling a file list produces the same contents of a window as
+ * drawing it from scratch. */
+
+enum { WIN_ROWS = 6, WIN_COLS = 40, NFILES = 40 };
+
+static void check_scroll(int pos);
+static void snapshot(chtype shot[WIN_ROWS][WIN_COLS + 1]);
+static int is_highlighted(const chtype row[]);
+static int has_screen(void);
+
+static view_t *const view = &lwin;
+static FILE *term_out;
+static FILE *term_in;
+static SCREEN *screen;
+static WINDOW *win;
+
+SETUP_ONCE()
+{
+	term_out = fopen("/dev/null", "w");
+	term_in = fopen("/dev/null", "r");
+	if(term_out != NULL && term_in != NULL)
+	{
+		screen = newterm("xterm", term_out, term_in);
+	}
+	if(screen != NULL)
+	{
+		/* Render cache is bound to a window, so it's created only once. */
+		win = newwin(WIN_ROWS, WIN_COLS, 0, 0);
+	}
+}
+
+TEARDOWN_ONCE()
+{
+	if(screen != NULL)
+	{
+		delwin(win);
+		win = NULL;
+		endwin();
+		delscreen(screen);
+		screen = NULL;
+	}
+	if(term_out != NULL)
+	{
+		fclose(term_out);
+	}
+	if(term_in != NULL)
+	{
+		fclose(term_in);
+	}
+}
+
+SETUP()
+{
+	conf_setup();
+	cfg.extra_padding = 0;
+	cfg.scroll_off = 0;
+	cfg.dot_dirs = 0;
+	/* Make cursor visible in contents of the window. */
+	cfg.cs.color[CURR_LINE_COLOR].attr = A_REVERSE;
+
+	fview_setup();
+	view_setup(view);
+	view_setup(&rwin);
+	view->top_line = 0;
+	view->curr_line = 0;
+	curr_view = view;
+	other_view = &rwin;
+
+	update_string(&view->view_columns, "");
+	view->columns = columns_create();
+	fview_sorting_updated(view);
+
+	view->window_rows = WIN_ROWS;
+	setup_grid(view, /*column_count=*/1, NFILES, /*init=*/1);
+	view->window_cols = WIN_COLS;
+	view->ls_view = 0;
+
+	int i;
+	for(i = 0; i < NFILES; ++i)
+	{
+		char name[16];
+		snprintf(name, sizeof(name), "file%02d", i);
+		free(view->dir_entry[i].name);
+		view->dir_entry[i].name = strdup(name);
+		view->dir_entry[i].hi_num = -1;
+	}
+
+	view->win = win;
+
+	curr_stats.load_stage = 2;
+}
+
+TEARDOWN()
+{
+	curr_stats.load_stage = 0;
+	cfg.cs.color[CURR_LINE_COLOR].attr = 0;
+
+	fview_invalidate_render_cache(view);
+	view->win = NULL;
+
+	columns_free(view->columns);
+	view->columns = NULL;
+	update_string(&view->view_columns, NULL);
+
+	view_teardown(view);
+	view_teardown(&rwin);
+	columns_teardown();
+	conf_teardown();
+
+	curr_view = NULL;
+	other_view = NULL;
+}
+
+TEST(scrolling_down_matches_full_redraw, IF(has_screen))
+{
+	view->list_pos = WIN_ROWS - 1;
+	draw_dir_list(view);
+
+	check_scroll(WIN_ROWS);
+	check_scroll(WIN_ROWS + 2);
+}
+
+TEST(scrolling_up_matches_full_redraw, IF(has_screen))
+{
+	view->top_line = 10;
+	view->list_pos = 10;
+	draw_dir_list(view);
+
+	check_scroll(9);
+	check_scroll(6);
+}
+
+TEST(cursor_moved_off_last_row_is_redrawn, IF(has_screen))
+{
+	view->list_pos = WIN_ROWS - 1;
+	draw_dir_list(view);
+
+	check_scroll(WIN_ROWS);
+	assert_int_equal(WIN_ROWS - 1, view->curr_line);
+	check_scroll(0);
+	assert_int_equal(0, view->curr_line);
+}
+
+TEST(scrolling_with_padding_matches_full_redraw, IF(has_screen))
+{
+	cfg.extra_padding = 1;
+
+	view->list_pos = WIN_ROWS - 1;
+	draw_dir_list(view);
+
+	check_scroll(WIN_ROWS);
+	check_scroll(WIN_ROWS + 3);
+	check_scroll(0);
+}
+
+TEST(scrolling_ls_view_matches_full_redraw, IF(has_screen))
+{
+	view->ls_view = 1;
+
+	view->list_pos = 0;
+	draw_dir_list(view);
+	assert_true(view->column_count > 1);
+
+	const int last_visible = view->window_cells - 1;
+	check_scroll(last_visible + 1);
+	check_scroll(last_visible + view->run_size*2);
+	check_scroll(view->top_line - 1);
+}
+
+/* Moves cursor to the specified position expecting the view to be scrolled
+ * without full redraw and checks that result matches full redraw. */
+static void
+check_scroll(int pos)
+{
+	chtype scrolled[WIN_ROWS][WIN_COLS + 1];
+	chtype redrawn[WIN_ROWS][WIN_COLS + 1];
+
+	const int old_top = view->top_line;
+
+	ui_view_schedule_redraw(view);
+	view->list_pos = pos;
+	fview_position_updated(view);
+	snapshot(scrolled);
+
+	assert_true(view->top_line != old_top);
+	/* Full redraw resets this flag. */
+	assert_true(ui_view_query_scheduled_event(view) == UUE_REDRAW);
+
+	/* Only the cursor is highlighted. */
+	int i;
+	const int cursor_row = view->curr_line/view->column_count;
+	for(i = 0; i < WIN_ROWS; ++i)
+	{
+		assert_int_equal(i == cursor_row, is_highlighted(scrolled[i]));
+	}
+
+	draw_dir_list(view);
+	snapshot(redrawn);
+
+	for(i = 0; i < WIN_ROWS; ++i)
+	{
+		assert_success(memcmp(scrolled[i], redrawn[i], sizeof(redrawn[i])));
+	}
+}
+
+/* Reads contents of the window of the view including attributes. */
+static void
+snapshot(chtype shot[WIN_ROWS][WIN_COLS + 1])
+{
+	int row;
+	for(row = 0; row < WIN_ROWS; ++row)
+	{
+		memset(shot[row], 0, sizeof(shot[row]));
+		mvwinchnstr(view->win, row, 0, shot[row], WIN_COLS);
+	}
+}
+
+/* Checks whether any character of a row of a snapshot is highlighted.
+ * Returns non-zero if so. */
+static int
+is_highlighted(const chtype row[])
+{
+	int i;
+	for(i = 0; i < WIN_COLS; ++i)
+	{
+		if(row[i] & A_REVERSE)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether curses screen was created.  Returns non-zero if so. */
+static int
+has_screen(void)
+{
+	return (screen != NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -1,11 +1,21 @@
 #include <stic.h>
 
+#ifndef _WIN32
+#include <sys/socket.h> /* AF_UNIX SOCK_STREAM connect() recv() send() socket() */
+#include <sys/un.h> /* sockaddr_un */
+#endif
+#include <unistd.h> /* close() unlink() usleep() */
+
 #include <stddef.h> /* NULL */
+#include <stdint.h> /* uint32_t */
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() malloc() */
 #include <string.h> /* memset() strcmp() strdup() */
 
 #include <test-utils.h>
 
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/path.h"
 #include "../../src/utils/str.h"
 #include "../../src/utils/string_array.h"
 #include "../../src/background.h"
@@ -17,6 +27,8 @@ static void recursive_ipc_args(char *args[]);
 static char * test_ipc_eval(const char expr[]);
 static char * test_ipc_eval_error(const char expr[]);
 static void other_instance(bg_op_t *bg_op, void *arg);
+static void other_instance_batch(bg_op_t *bg_op, void *arg);
+static void serving_instance(bg_op_t *bg_op, void *arg);
 static int enabled_and_not_in_wine(void);
 static int enabled_and_not_windows(void);
 
@@ -26,6 +38,8 @@ static char *message;
 static int nmessages2;
 static char *message2;
 static ipc_t *recursive_ipc;
+static int npkgs;
+static volatile int stop_serving;
 
 TEARDOWN()
 {
@@ -203,6 +217,125 @@ TEST(eval_error_is_handled, IF(enabled_and_not_in_wine))
 	free(result);
 }
 
+TEST(batch_of_exprs_is_evaluated, IF(enabled_and_not_in_wine))
+{
+	char *exprs[] = { "good expression", "bad expression", "good expression" };
+	char *results[3];
+
+	ipc_t *const ipc1 = ipc_init(NAME, &test_ipc_args, &test_ipc_eval);
+	ipc_t *const ipc2 = ipc_init(NAME, &test_ipc_args2, &test_ipc_eval);
+
+	npkgs = 3;
+	assert_success(bg_execute("", "", 0, 1, &other_instance_batch, ipc2));
+
+	assert_failure(ipc_eval_batch(ipc1, ipc_get_name(ipc2), exprs, 3, results));
+
+	wait_for_bg();
+
+	/* Connection is reused for subsequent requests. */
+	npkgs = 1;
+	assert_success(bg_execute("", "", 0, 1, &other_instance_batch, ipc2));
+	char *result = ipc_eval(ipc1, ipc_get_name(ipc2), "good expression");
+	wait_for_bg();
+
+	ipc_free(ipc1);
+	ipc_free(ipc2);
+
+	assert_string_equal("good result", results[0]);
+	assert_string_equal(NULL, results[1]);
+	assert_string_equal("good result", results[2]);
+	assert_string_equal("good result", result);
+	free(results[0]);
+	free(results[2]);
+	free(result);
+}
+
+TEST(big_batch_of_exprs_does_not_stall, IF(enabled_and_not_windows))
+{
+	enum { N = 20000 };
+	static char *exprs[N];
+	static char *results[N];
+
+	int i;
+	for(i = 0; i < N; ++i)
+	{
+		exprs[i] = "good expression";
+	}
+
+	ipc_t *const ipc1 = ipc_init(NAME, &test_ipc_args, &test_ipc_eval);
+	ipc_t *const ipc2 = ipc_init(NAME, &test_ipc_args2, &test_ipc_eval);
+
+	stop_serving = 0;
+	assert_success(bg_execute("", "", 0, 1, &serving_instance, ipc2));
+
+	assert_success(ipc_eval_batch(ipc1, ipc_get_name(ipc2), exprs, N, results));
+
+	stop_serving = 1;
+	wait_for_bg();
+
+	ipc_free(ipc1);
+	ipc_free(ipc2);
+
+	for(i = 0; i < N; ++i)
+	{
+		assert_string_equal("good result", results[i]);
+		free(results[i]);
+	}
+}
+
+TEST(connection_is_closed_on_too_big_frame, IF(enabled_and_not_windows))
+{
+	ipc_t *const ipc = ipc_init(NAME, &test_ipc_args, &test_ipc_eval);
+
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/vifm-sock-%s",
+			get_tmpdir(), ipc_get_name(ipc));
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert_true(fd != -1);
+	assert_success(connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+
+	const uint32_t header[2] = { 0xffffffffU, 1U };
+	assert_int_equal(sizeof(header), send(fd, header, sizeof(header), 0));
+
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		assert_false(ipc_check(ipc));
+		usleep(1000);
+	}
+
+	char c;
+	assert_int_equal(0, recv(fd, &c, 1, 0));
+
+	close(fd);
+	ipc_free(ipc);
+}
+
+TEST(pipe_is_used_without_socket, IF(enabled_and_not_windows))
+{
+	char msg[] = "test message";
+	char *data[] = { msg, NULL };
+
+	ipc_t *const ipc1 = ipc_init(NAME, &test_ipc_args, &test_ipc_eval);
+	ipc_t *const ipc2 = ipc_init(NAME, &test_ipc_args2, &test_ipc_eval);
+
+	char sock_path[PATH_MAX + 1];
+	snprintf(sock_path, sizeof(sock_path), "%s/vifm-sock-%s", get_tmpdir(),
+			ipc_get_name(ipc2));
+	assert_success(unlink(sock_path));
+
+	assert_success(ipc_send(ipc1, ipc_get_name(ipc2), data));
+	assert_true(ipc_check(ipc2));
+	assert_false(ipc_check(ipc2));
+
+	ipc_free(ipc1);
+	ipc_free(ipc2);
+
+	assert_int_equal(2, nmessages2);
+	assert_string_equal(msg, message2);
+}
+
 TEST(checking_ipc_from_ipc_handler_is_noop, IF(enabled_and_not_windows))
 {
 	char msg[] = "test message";
@@ -297,6 +430,29 @@ other_instance(bg_op_t *bg_op, void *arg)
 	}
 }
 
+static void
+other_instance_batch(bg_op_t *bg_op, void *arg)
+{
+	ipc_t *const ipc = arg;
+	while(npkgs > 0)
+	{
+		npkgs -= ipc_check(ipc);
+	}
+}
+
+static void
+serving_instance(bg_op_t *bg_op, void *arg)
+{
+	ipc_t *const ipc = arg;
+	while(!stop_serving)
+	{
+		if(!ipc_check(ipc))
+		{
+			usleep(1000);
+		}
+	}
+}
+
 static int
 enabled_and_not_in_wine(void)
 {
@@ -4,6 +4,7 @@
 
 #include <stddef.h> /* wchar_t */
 
+#include "../../src/utils/macros.h"
 #include "../../src/utils/string_array.h"
 #include "../../src/registers.h"
 
@@ -130,6 +131,55 @@ TEST(registers_are_listed)
 	free_string_array(list, len);
 }
 
+TEST(appending_many_files_merges_them)
+{
+	const reg_t *reg = regs_find('a');
+
+	regs_append('a', "/b");
+	regs_append('a', "/d");
+
+	char *files[] = { "/e", "/b", "/a", "/c", "/a" };
+	assert_int_equal(3, regs_append_files('a', files, ARRAY_LEN(files)));
+
+	assert_int_equal(5, reg->nfiles);
+	assert_string_equal("/a", reg->files[0]);
+	assert_string_equal("/b", reg->files[1]);
+	assert_string_equal("/c", reg->files[2]);
+	assert_string_equal("/d", reg->files[3]);
+	assert_string_equal("/e", reg->files[4]);
+
+	assert_int_equal(0, regs_append_files('a', files, ARRAY_LEN(files)));
+	assert_int_equal(0, regs_append_files('a', files, 0));
+	assert_int_equal(5, reg->nfiles);
+
+	assert_int_equal(0, regs_append_files('#', files, ARRAY_LEN(files)));
+	assert_int_equal(5, regs_append_files('_', files, ARRAY_LEN(files)));
+}
+
+TEST(renaming_keeps_registers_sorted)
+{
+	const reg_t *reg = regs_find('a');
+
+	regs_append('a', "/a");
+	regs_append('a', "/b");
+	regs_append('a', "/c");
+
+	regs_rename_contents("/a", "/d");
+	assert_int_equal(3, reg->nfiles);
+	assert_string_equal("/b", reg->files[0]);
+	assert_string_equal("/c", reg->files[1]);
+	assert_string_equal("/d", reg->files[2]);
+
+	/* Renaming to a path that's already in the register. */
+	regs_rename_contents("/b", "/c");
+	assert_int_equal(2, reg->nfiles);
+	assert_string_equal("/c", reg->files[0]);
+	assert_string_equal("/d", reg->files[1]);
+
+	assert_success(regs_append('a', "/a"));
+	assert_failure(regs_append('a', "/d"));
+}
+
 static void
 suggest_cb(const wchar_t text[], const wchar_t value[], const char d[])
 {
@@ -302,6 +302,32 @@ TEST(chg_halve_allocation, IF(not_wine))
 	check_is_initial(1, TEST_REGISTERS_MINUS_DEFG);
 }
 
+TEST(only_changed_registers_are_written, IF(not_wine))
+{
+	/* Both instances change a register without reading changes of the other
+	 * one. */
+	send_query(0, "set,h,newh\n");
+	send_query(1, "set,i,newi\n");
+	send_query(0, "sync_to\n");
+	receive_ack(0);
+	send_query(1, "sync_to\n");
+	receive_ack(1);
+
+	sync_from(0);
+	sync_from(1);
+
+	check_register_contents(0, 'h', "h,1,newh,");
+	check_register_contents(0, 'i', "i,1,newi,");
+	check_register_contents(1, 'h', "h,1,newh,");
+	check_register_contents(1, 'i', "i,1,newi,");
+
+	/* Restore original values. */
+	send_query(0, "set,h,_initialh,ih1,ih2,ih3\n");
+	send_query(0, "set,i,_initiali,ii1,ii2,ii3\n");
+	sync_to_from(0);
+	check_is_initial(1, TEST_REGISTERS_MINUS_DEFG);
+}
+
 TEST(handover, IF(not_wine))
 {
 	/* Open third instance. */
@@ -333,6 +333,38 @@ TEST(sorting_uses_dcache_for_dirs)
 	assert_string_equal("read", lwin.dir_entry[1].name);
 }
 
+TEST(numeric_sorting_is_stable_and_keeps_parent_dir_first)
+{
+	view_teardown(&lwin);
+	view_setup(&lwin);
+
+	set_file_list(&lwin, FT_REG, "a", "b", "..", "c", "d", NULL);
+	lwin.dir_entry[2].type = FT_DIR;
+	lwin.dir_entry[0].mtime = 5;
+	lwin.dir_entry[1].mtime = -1;
+	lwin.dir_entry[2].mtime = -10;
+	lwin.dir_entry[3].mtime = 5;
+	lwin.dir_entry[4].mtime = 0;
+
+	view_set_sort(lwin.sort, -SK_BY_TIME_MODIFIED, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+	assert_string_equal("c", lwin.dir_entry[2].name);
+	assert_string_equal("d", lwin.dir_entry[3].name);
+	assert_string_equal("b", lwin.dir_entry[4].name);
+
+	view_set_sort(lwin.sort, SK_BY_TIME_MODIFIED, SK_NONE);
+	sort_view(&lwin);
+
+	assert_string_equal("..", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+	assert_string_equal("d", lwin.dir_entry[2].name);
+	assert_string_equal("a", lwin.dir_entry[3].name);
+	assert_string_equal("c", lwin.dir_entry[4].name);
+}
+
 TEST(nitems_sorting_works)
 {
 	view_teardown(&lwin);
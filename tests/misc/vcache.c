@@ -3,6 +3,7 @@
 #include <sys/stat.h> /* chmod() */
 #include <unistd.h> /* usleep() */
 
+#include <stdio.h> /* snprintf() */
 #include <string.h> /* strlen() */
 
 #include <test-utils.h>
@@ -19,7 +20,10 @@
 #include "../lua/asserts.h"
 
 static int wait_for_cache(void);
+static int wait_for_all_jobs(void);
+static int count_active_jobs(void);
 static int is_previewed(const char path[]);
+static int is_not_previewed(const char path[]);
 
 static const char *error;
 
@@ -49,7 +53,7 @@ TEARDOWN()
 TEST(missing_file_is_handled)
 {
 	strlist_t lines = vcache_lookup(SANDBOX_PATH "/no-file", NULL, MF_NONE,
-			VK_TEXTUAL, 10, VC_SYNC, &error);
+			VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal("Failed to read file's contents", error);
 	assert_int_equal(0, lines.nitems);
 }
@@ -60,7 +64,7 @@ TEST(non_existing_file_with_a_viewer)
 {
 	const char *viewer = "echo aaa";
 	strlist_t lines = vcache_lookup(SANDBOX_PATH "/no-file", viewer, MF_NONE,
-			VK_TEXTUAL, /*max_lines=*/10, VC_ASYNC, &error);
+			VK_TEXTUAL, /*max_lines=*/10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
@@ -68,7 +72,7 @@ TEST(non_existing_file_with_a_viewer)
 	assert_true(wait_for_cache());
 
 	lines = vcache_lookup(SANDBOX_PATH "/no-file", viewer, MF_NONE, VK_TEXTUAL,
-			/*max_lines=*/10, VC_ASYNC, &error);
+			/*max_lines=*/10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("aaa", lines.items[0]);
@@ -80,7 +84,7 @@ TEST(unreadable_directory_file_is_handled, IF(regular_unix_user))
 	assert_success(chmod(SANDBOX_PATH "/dir", 0000));
 
 	strlist_t lines = vcache_lookup(SANDBOX_PATH "/dir", NULL, MF_NONE,
-			VK_TEXTUAL, 10, VC_SYNC, &error);
+			VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal("Failed to list directory's contents", error);
 	assert_int_equal(0, lines.nitems);
 
@@ -90,7 +94,7 @@ TEST(unreadable_directory_file_is_handled, IF(regular_unix_user))
 TEST(can_view_full_file)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", NULL,
-			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, lines.nitems);
 	assert_string_equal("1st line", lines.items[0]);
@@ -108,7 +112,7 @@ TEST(can_view_via_plugin)
 
 	/* Also test that output of graphical viewers is preserved in full. */
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines",
-			"#vifmtest#vcache", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, &error);
+			"#vifmtest#vcache", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, lines.nitems);
 	assert_string_equal("line1", lines.items[0]);
@@ -121,7 +125,7 @@ TEST(can_view_via_plugin)
 TEST(can_view_partial_file)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", NULL,
-			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("1st line", lines.items[0]);
@@ -130,7 +134,7 @@ TEST(can_view_partial_file)
 TEST(can_view_directory)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/rename", NULL, MF_NONE,
-			VK_TEXTUAL, 10, VC_SYNC, &error);
+			VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(6, lines.nitems);
 	assert_string_equal("rename/", lines.items[0]);
@@ -144,7 +148,7 @@ TEST(can_view_directory)
 TEST(can_use_custom_viewer)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/", "echo text", MF_NONE,
-			VK_TEXTUAL, 1, VC_SYNC, &error);
+			VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("text", lines.items[0]);
@@ -155,7 +159,7 @@ TEST(can_run_viewer_in_current_session)
 	/* Not sure how to test that session hasn't changed without writing a test
 	 * program. */
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/", "echo text",
-			MF_KEEP_IN_FG, VK_TEXTUAL, 1, VC_SYNC, &error);
+			MF_KEEP_IN_FG, VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("text", lines.items[0]);
@@ -167,7 +171,7 @@ TEST(single_file_data_is_cached)
 
 	/* Two lines are cached. */
 	lines1 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL, MF_NONE,
-			VK_TEXTUAL, 2, VC_SYNC, &error);
+			VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, lines1.nitems);
 	assert_string_equal("first line", lines1.items[0]);
@@ -175,7 +179,7 @@ TEST(single_file_data_is_cached)
 
 	/* Previously cached data is returned. */
 	lines2 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, lines2.nitems);
 	assert_true(lines1.items[0] == lines2.items[0]);
@@ -189,7 +193,7 @@ TEST(multiple_files_data_is_cached)
 
 	/* Two lines are cached. */
 	f1lines1 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, f1lines1.nitems);
 	assert_string_equal("first line", f1lines1.items[0]);
@@ -197,7 +201,7 @@ TEST(multiple_files_data_is_cached)
 
 	/* Two lines are cached. */
 	f2lines1 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, f2lines1.nitems);
 	assert_string_equal("first line", f2lines1.items[0]);
@@ -205,7 +209,7 @@ TEST(multiple_files_data_is_cached)
 
 	/* Previously cached data is returned. */
 	f1lines2 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, f1lines2.nitems);
 	assert_true(f1lines1.items[0] == f1lines2.items[0]);
@@ -213,7 +217,7 @@ TEST(multiple_files_data_is_cached)
 
 	/* Previously cached data is returned. */
 	f2lines2 = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, f2lines2.nitems);
 	assert_true(f2lines1.items[0] == f2lines2.items[0]);
@@ -224,7 +228,7 @@ TEST(failure_to_allocate_cache_entry_is_handled)
 {
 	vcache_reset(0);
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal("Failed to allocate cache entry", error);
 	assert_int_equal(0, lines.nitems);
 }
@@ -235,7 +239,7 @@ TEST(cache_entries_are_reused)
 
 	/* Two lines are cached. */
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL,
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(2, lines.nitems);
 	assert_string_equal("first line", lines.items[0]);
@@ -243,18 +247,18 @@ TEST(cache_entries_are_reused)
 
 	/* Push cached data out of the cache. */
 	lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", "echo a",
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", "echo b",
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", "echo c",
-			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 2, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 
 	/* Previously cached data is not returned. */
 	lines = vcache_lookup(TEST_DATA_PATH "/read/dos-line-endings", NULL, MF_NONE,
-			VK_TEXTUAL, 1, VC_SYNC, &error);
+			VK_TEXTUAL, 1, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("first line", lines.items[0]);
@@ -263,13 +267,13 @@ TEST(cache_entries_are_reused)
 TEST(viewers_are_cached_independently)
 {
 	strlist_t lines1 = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
-			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines1.nitems);
 	assert_string_equal("aaa", lines1.items[0]);
 
 	strlist_t lines2 = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo bbb",
-			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines2.nitems);
 	assert_string_equal("bbb", lines2.items[0]);
@@ -280,7 +284,7 @@ TEST(file_modification_is_detected)
 	make_file(SANDBOX_PATH "/file", "old line");
 
 	strlist_t lines = vcache_lookup(SANDBOX_PATH "/file", NULL, MF_NONE,
-			VK_TEXTUAL, 10, VC_SYNC, &error);
+			VK_TEXTUAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("old line", lines.items[0]);
@@ -289,7 +293,7 @@ TEST(file_modification_is_detected)
 	reset_timestamp(SANDBOX_PATH "/file");
 
 	lines = vcache_lookup(SANDBOX_PATH "/file", NULL, MF_NONE, VK_TEXTUAL, 10,
-			VC_SYNC, &error);
+			VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("new line", lines.items[0]);
@@ -303,14 +307,14 @@ TEST(graphics_is_not_cached)
 	curr_stats.preview_hint = &parea;
 
 	strlist_t lines1 = vcache_lookup(TEST_DATA_PATH "/read/two-lines",
-			"echo this", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, &error);
+			"echo this", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines1.nitems);
 	assert_string_equal("this", lines1.items[0]);
 	lines1.items = copy_string_array(lines1.items, lines1.nitems);
 
 	strlist_t lines2 = vcache_lookup(TEST_DATA_PATH "/read/two-lines",
-			"echo this", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, &error);
+			"echo this", MF_NONE, VK_GRAPHICAL, 10, VC_SYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines2.nitems);
 	assert_string_equal("this", lines1.items[0]);
@@ -324,7 +328,7 @@ TEST(graphics_is_not_cached)
 TEST(asynchronous_viewer)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
-			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
@@ -334,7 +338,7 @@ TEST(asynchronous_viewer)
 	{
 		usleep(10);
 		lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa", MF_NONE,
-				VK_TEXTUAL, 10, VC_ASYNC, &error);
+				VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	}
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
@@ -345,7 +349,7 @@ TEST(asynchronous_data_can_have_torn_lines, IF(not_windows))
 {
 	const char *viewer = "printf aaa; printf bbb; echo ccc";
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer,
-			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
@@ -355,7 +359,7 @@ TEST(asynchronous_data_can_have_torn_lines, IF(not_windows))
 	{
 		usleep(10);
 		lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer, MF_NONE,
-				VK_TEXTUAL, 10, VC_ASYNC, &error);
+				VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	}
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
@@ -366,13 +370,13 @@ TEST(asynchronous_jobs_can_be_cancelled)
 {
 	const char *viewer = "echo aaa; echo bbb; echo ccc; echo ddd; echo eee";
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer,
-			MF_NONE, VK_TEXTUAL, 0, VC_ASYNC, &error);
+			MF_NONE, VK_TEXTUAL, 0, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
 
 	lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer, MF_NONE,
-			VK_TEXTUAL, 0, VC_ASYNC, &error);
+			VK_TEXTUAL, 0, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(0, lines.nitems);
 }
@@ -380,7 +384,7 @@ TEST(asynchronous_jobs_can_be_cancelled)
 TEST(vcache_check_reports_correct_status)
 {
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "echo aaa",
-			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
@@ -399,7 +403,7 @@ TEST(kill_all_async_previews_on_exit, IF(not_windows))
 	var_free(var);
 
 	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/read/two-lines", "sleep 100",
-			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, &error);
+			MF_NONE, VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
 	assert_string_equal(NULL, error);
 	assert_int_equal(1, lines.nitems);
 	assert_string_equal("[...]", lines.items[0]);
@@ -419,6 +423,55 @@ TEST(kill_all_async_previews_on_exit, IF(not_windows))
 	}
 }
 
+TEST(number_of_running_viewers_is_limited, IF(not_windows))
+{
+	vcache_reset(1024*1024);
+
+	char viewer[32];
+	int i;
+	for(i = 0; i < 6; ++i)
+	{
+		snprintf(viewer, sizeof(viewer), "sleep 100 # %d", i);
+		(void)vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer, MF_NONE,
+				VK_TEXTUAL, 10, VC_ASYNC, NULL, &error);
+		assert_string_equal(NULL, error);
+	}
+
+	/* Least recently used viewer is over the limit, current one isn't counted. */
+	assert_int_equal(5, count_active_jobs());
+
+	/* Previewed entries aren't cancelled. */
+	assert_false(vcache_check(&is_previewed));
+	assert_int_equal(5, count_active_jobs());
+
+	/* Without previewed entries the limit applies to all of them. */
+	assert_false(vcache_check(&is_not_previewed));
+	assert_int_equal(4, count_active_jobs());
+
+	vcache_finish();
+	assert_true(wait_for_all_jobs());
+}
+
+TEST(previewed_viewers_are_not_cancelled_on_lookup, IF(not_windows))
+{
+	vcache_reset(1024*1024);
+
+	char viewer[32];
+	int i;
+	for(i = 0; i < 6; ++i)
+	{
+		snprintf(viewer, sizeof(viewer), "sleep 100 # %d", i);
+		(void)vcache_lookup(TEST_DATA_PATH "/read/two-lines", viewer, MF_NONE,
+				VK_TEXTUAL, 10, VC_ASYNC, &is_previewed, &error);
+		assert_string_equal(NULL, error);
+	}
+
+	assert_int_equal(6, count_active_jobs());
+
+	vcache_finish();
+	assert_true(wait_for_all_jobs());
+}
+
 static int
 wait_for_cache(void)
 {
@@ -430,11 +483,45 @@ wait_for_cache(void)
 	return (i < 10000);
 }
 
+static int
+wait_for_all_jobs(void)
+{
+	int counter = 0;
+	while(bg_jobs != NULL)
+	{
+		usleep(5000);
+		bg_check();
+		if(++counter > 100)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int
+count_active_jobs(void)
+{
+	int count = 0;
+	bg_job_t *job;
+	for(job = bg_jobs; job != NULL; job = job->next)
+	{
+		count += (bg_job_cancelled(job) == 0);
+	}
+	return count;
+}
+
 static int
 is_previewed(const char path[])
 {
 	return 1;
 }
 
+static int
+is_not_previewed(const char path[])
+{
+	return 0;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
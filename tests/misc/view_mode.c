@@ -1,5 +1,7 @@
 #include <stic.h>
 
+#include <stdio.h> /* FILE fclose() fopen() fprintf() */
+
 #include <test-utils.h>
 
 #include "../../src/cfg/config.h"
@@ -237,6 +239,141 @@ TEST(searching_in_view_mode)
 	remove_file(SANDBOX_PATH "/file");
 }
 
+TEST(search_in_large_file_is_done_in_steps)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 20000; ++i)
+	{
+		fprintf(fp, "%s\n", (i == 5 || i == 19000) ? "match" : "line");
+	}
+	fclose(fp);
+
+	lwin.window_cols = 10;
+	assert_true(start_view_mode("*", NULL, SANDBOX_PATH, ""));
+
+	(void)vle_keys_exec_timed_out(L"/match");
+	(void)vle_keys_exec_timed_out(WK_CR);
+	assert_int_equal(5, modview_current_line(lwin.vi));
+
+	/* Second match wasn't scanned yet, so jump is postponed. */
+	(void)vle_keys_exec_timed_out(WK_n);
+	assert_int_equal(5, modview_current_line(lwin.vi));
+
+	modview_continue_search();
+	assert_int_equal(19000, modview_current_line(lwin.vi));
+
+	/* Index of matches is reused. */
+	(void)vle_keys_exec_timed_out(WK_N);
+	assert_int_equal(5, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(L"/match");
+	(void)vle_keys_exec_timed_out(WK_CR);
+	assert_int_equal(19000, modview_current_line(lwin.vi));
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(search_can_be_cancelled)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 20000; ++i)
+	{
+		fprintf(fp, "%s\n", (i == 19000) ? "match" : "line");
+	}
+	fclose(fp);
+
+	lwin.window_cols = 10;
+	assert_true(start_view_mode("*", NULL, SANDBOX_PATH, ""));
+
+	(void)vle_keys_exec_timed_out(L"/match");
+	(void)vle_keys_exec_timed_out(WK_CR);
+	assert_int_equal(0, modview_current_line(lwin.vi));
+
+	(void)vle_keys_exec_timed_out(WK_C_c);
+	modview_continue_search();
+	modview_continue_search();
+	modview_continue_search();
+	assert_int_equal(0, modview_current_line(lwin.vi));
+
+	/* Search is resumed by the next jump. */
+	(void)vle_keys_exec_timed_out(WK_n);
+	modview_continue_search();
+	modview_continue_search();
+	assert_int_equal(19000, modview_current_line(lwin.vi));
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(wrapped_lines_are_navigated_by_screen_lines)
+{
+	cfg.wrap_quick_view = 1;
+	lwin.window_rows = 2;
+	lwin.window_cols = 4;
+
+	make_file(SANDBOX_PATH "/file", "aaaabbbbcc\nshort\nddddeeee");
+	assert_true(start_view_mode("*", NULL, SANDBOX_PATH, ""));
+
+	(void)vle_keys_exec_timed_out(WK_j);
+	assert_int_equal(0, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(L"2" WK_j);
+	assert_int_equal(1, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(L"2" WK_k);
+	assert_int_equal(0, modview_current_line(lwin.vi));
+
+	(void)vle_keys_exec_timed_out(WK_G);
+	assert_int_equal(2, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(WK_g);
+	assert_int_equal(0, modview_current_line(lwin.vi));
+
+	(void)vle_keys_exec_timed_out(L"50" WK_PERCENT);
+	assert_int_equal(1, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(WK_g);
+
+	(void)vle_keys_exec_timed_out(L"/eeee");
+	(void)vle_keys_exec_timed_out(WK_CR);
+	assert_int_equal(2, modview_current_line(lwin.vi));
+	(void)vle_keys_exec_timed_out(L"?bbbb");
+	(void)vle_keys_exec_timed_out(WK_CR);
+	assert_int_equal(0, modview_current_line(lwin.vi));
+
+	cfg.wrap_quick_view = 0;
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(auto_forwarding_follows_the_file)
+{
+	lwin.window_rows = 2;
+
+	make_file(SANDBOX_PATH "/file", "1\n2\n3");
+	assert_true(start_view_mode("*", NULL, SANDBOX_PATH, ""));
+
+	(void)vle_keys_exec_timed_out(WK_F);
+	assert_int_equal(1, modview_current_line(lwin.vi));
+
+	FILE *fp = fopen(SANDBOX_PATH "/file", "a");
+	fprintf(fp, "4\n5\n");
+	fclose(fp);
+
+	modview_check_for_updates();
+	strlist_t lines = modview_lines(lwin.vi);
+	assert_int_equal(4, lines.nitems);
+	assert_string_equal("34", lines.items[2]);
+	assert_string_equal("5", lines.items[3]);
+	assert_int_equal(2, modview_current_line(lwin.vi));
+
+	/* Truncation causes full reload. */
+	make_file(SANDBOX_PATH "/file", "a\nb\n");
+	modview_check_for_updates();
+	lines = modview_lines(lwin.vi);
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("a", lines.items[0]);
+	assert_int_equal(1, modview_current_line(lwin.vi));
+
+	(void)vle_keys_exec_timed_out(WK_F);
+	remove_file(SANDBOX_PATH "/file");
+}
+
 TEST(operations_with_empty_output)
 {
 	assert_true(start_view_mode("*", "true", TEST_DATA_PATH, "read"));
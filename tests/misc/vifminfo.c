@@ -15,6 +15,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/matcher.h"
 #include "../../src/utils/matchers.h"
+#include "../../src/utils/fs.h"
 #include "../../src/utils/parson.h"
 #include "../../src/utils/str.h"
 #include "../../src/cmd_core.h"
@@ -308,6 +309,129 @@ TEST(histories_are_merged_correctly)
 	assert_success(remove(SANDBOX_PATH "/vifminfo.json"));
 }
 
+TEST(subsequent_writes_are_appended_to_journal)
+{
+	cfg.vifm_info = VINFO_CHISTORY;
+
+	hist_add(&curr_stats.cmd_hist, "command0", 0);
+	hist_add(&curr_stats.cmd_hist, "command1", 1);
+	write_info_file();
+	assert_false(path_exists(SANDBOX_PATH "/vifminfo.journal", NODEREF));
+
+	hist_add(&curr_stats.cmd_hist, "command2", 2);
+	hist_add(&curr_stats.cmd_hist, "command0", 3);
+	write_info_file();
+	assert_true(path_exists(SANDBOX_PATH "/vifminfo.journal", NODEREF));
+
+	cfg_resize_histories(0);
+	cfg_resize_histories(10);
+	state_load(0);
+
+	assert_int_equal(3, curr_stats.cmd_hist.size);
+	assert_string_equal("command0", curr_stats.cmd_hist.items[0].text);
+	assert_int_equal(3, curr_stats.cmd_hist.items[0].timestamp);
+	assert_string_equal("command2", curr_stats.cmd_hist.items[1].text);
+	assert_string_equal("command1", curr_stats.cmd_hist.items[2].text);
+
+	/* Journal is merged into the file when it's changed by someone else. */
+	hist_add(&curr_stats.cmd_hist, "command3", 4);
+	reset_timestamp(SANDBOX_PATH "/vifminfo.json");
+	write_info_file();
+	assert_false(path_exists(SANDBOX_PATH "/vifminfo.journal", NODEREF));
+
+	cfg_resize_histories(0);
+	cfg_resize_histories(10);
+	state_load(0);
+
+	assert_int_equal(4, curr_stats.cmd_hist.size);
+	assert_string_equal("command3", curr_stats.cmd_hist.items[0].text);
+	assert_string_equal("command0", curr_stats.cmd_hist.items[1].text);
+
+	assert_success(remove(SANDBOX_PATH "/vifminfo.json"));
+}
+
+TEST(journal_of_replaced_file_is_ignored)
+{
+	cfg.vifm_info = VINFO_CHISTORY;
+
+	hist_add(&curr_stats.cmd_hist, "command0", 0);
+	write_info_file();
+	hist_add(&curr_stats.cmd_hist, "command1", 1);
+	write_info_file();
+	assert_true(path_exists(SANDBOX_PATH "/vifminfo.journal", NODEREF));
+
+	make_file(SANDBOX_PATH "/vifminfo.json",
+			"{\"cmd-hist\":[{\"text\":\"other\",\"ts\":5}]}");
+
+	cfg_resize_histories(0);
+	cfg_resize_histories(10);
+	state_load(0);
+
+	assert_int_equal(1, curr_stats.cmd_hist.size);
+	assert_string_equal("other", curr_stats.cmd_hist.items[0].text);
+
+	/* Stale journal is removed on writing. */
+	write_info_file();
+	assert_false(path_exists(SANDBOX_PATH "/vifminfo.journal", NODEREF));
+
+	assert_success(remove(SANDBOX_PATH "/vifminfo.json"));
+}
+
+TEST(histories_can_be_loaded_after_the_rest_of_state)
+{
+	cfg.vifm_info = VINFO_CHISTORY | VINFO_SAVEDIRS;
+
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), "/ldir");
+	hist_add(&curr_stats.cmd_hist, "command0", 0);
+	hist_add(&curr_stats.cmd_hist, "command1", 1);
+	hist_add(&curr_stats.cmd_hist, "command2", 2);
+	write_info_file();
+
+	lwin.curr_dir[0] = '\0';
+	cfg_resize_histories(0);
+	cfg_resize_histories(2);
+
+	state_load_initial();
+	assert_string_equal("/ldir", lwin.curr_dir);
+	assert_int_equal(0, curr_stats.cmd_hist.size);
+
+	/* History isn't extended to fit all items. */
+	state_load_deferred();
+	assert_int_equal(2, cfg.history_len);
+	assert_int_equal(2, curr_stats.cmd_hist.size);
+	assert_string_equal("command2", curr_stats.cmd_hist.items[0].text);
+	assert_string_equal("command1", curr_stats.cmd_hist.items[1].text);
+
+	cfg_resize_histories(0);
+	cfg_resize_histories(2);
+
+	/* Nothing is loaded the second time. */
+	state_load_deferred();
+	assert_int_equal(0, curr_stats.cmd_hist.size);
+
+	assert_success(remove(SANDBOX_PATH "/vifminfo.json"));
+}
+
+TEST(deferred_state_is_loaded_before_storing)
+{
+	cfg.vifm_info = VINFO_CHISTORY;
+
+	hist_add(&curr_stats.cmd_hist, "command0", 0);
+	write_info_file();
+
+	cfg_resize_histories(0);
+	cfg_resize_histories(10);
+
+	state_load_initial();
+	state_store();
+
+	state_load(0);
+	assert_int_equal(1, curr_stats.cmd_hist.size);
+	assert_string_equal("command0", curr_stats.cmd_hist.items[0].text);
+
+	assert_success(remove(SANDBOX_PATH "/vifminfo.json"));
+}
+
 TEST(view_sorting_round_trip)
 {
 	cfg.vifm_info = VINFO_TUI;
@@ -23,6 +23,7 @@
 #include "../../src/engine/options.h"
 #include "../../src/engine/var.h"
 #include "../../src/engine/variables.h"
+#include "../../src/menus/menus.h"
 #include "../../src/ui/color_manager.h"
 #include "../../src/ui/column_view.h"
 #include "../../src/ui/ui.h"
@@ -715,6 +716,25 @@ wait_for_all_bg(void)
 	}
 }
 
+void
+wait_for_menus(void)
+{
+	int counter = 0;
+
+	menus_check_for_updates();
+	while(menus_are_loading())
+	{
+		if(++counter > 100)
+		{
+			assert_fail("Waiting for too long.");
+			break;
+		}
+
+		usleep(5000);
+		menus_check_for_updates();
+	}
+}
+
 void
 file_is(const char path[], const char *lines[], int nlines)
 {
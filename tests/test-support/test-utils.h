@@ -159,6 +159,9 @@ void wait_for_bg(void);
 /* Waits termination of all background jobs including external applications. */
 void wait_for_all_bg(void);
 
+/* Waits for all menus to finish loading their items. */
+void wait_for_menus(void);
+
 /* Verifies that file at specified path consists of specified list of lines. */
 void file_is(const char path[], const char *lines[], int nlines);
 
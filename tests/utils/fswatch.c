@@ -2,6 +2,8 @@
 
 #include <stdio.h> /* remove() snprintf() */
 
+#include <test-utils.h>
+
 #include "../../src/compat/fs_limits.h"
 #include "../../src/compat/os.h"
 #include "../../src/utils/fs.h"
@@ -45,6 +47,50 @@ TEST(two_watches_for_the_same_directory)
 	fswatch_free(watch1);
 }
 
+TEST(watches_of_the_same_directory_share_events, IF(using_inotify))
+{
+	fswatch_t *watch1, *watch2;
+
+	assert_non_null(watch1 = fswatch_create(sandbox));
+	assert_non_null(watch2 = fswatch_create(sandbox));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch1));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch1));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch2));
+
+	/* Removing one of the watches doesn't affect the other one. */
+	fswatch_free(watch1);
+	assert_success(remove(SANDBOX_PATH "/testdir"));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch2));
+
+	fswatch_free(watch2);
+}
+
+TEST(events_are_filtered_per_watch, IF(using_inotify))
+{
+	char *paths[] = { sandbox };
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+	fswatch_set_t *set;
+	assert_non_null(set = fswatch_set_create());
+	assert_success(fswatch_set_update(set, paths, 1));
+
+	create_file(SANDBOX_PATH "/new-file");
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_int_equal(FSWS_UPDATED, fswatch_set_poll(set));
+
+	assert_success(os_chmod(SANDBOX_PATH "/new-file", 0600));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+
+	fswatch_set_free(set);
+	fswatch_free(watch);
+
+	assert_success(remove(SANDBOX_PATH "/new-file"));
+}
+
 TEST(events_are_accumulated, IF(using_inotify))
 {
 	fswatch_t *watch;
@@ -182,6 +228,82 @@ TEST(file_recreation_removes_ban, IF(using_inotify))
 	assert_success(remove(SANDBOX_PATH "/testdir"));
 }
 
+TEST(changes_of_entries_are_reported, IF(using_inotify))
+{
+	const fswatch_change_t *changes;
+
+	fswatch_t *watch;
+	assert_non_null(watch = fswatch_create(sandbox));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_poll(watch));
+	assert_int_equal(0, fswatch_get_changes(watch, &changes));
+
+	assert_success(os_mkdir(SANDBOX_PATH "/testdir", 0700));
+	assert_success(os_chmod(SANDBOX_PATH "/testdir", 0777));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_int_equal(1, fswatch_get_changes(watch, &changes));
+	assert_string_equal("testdir", changes[0].name);
+	assert_int_equal(FSWC_CREATED | FSWC_MODIFIED, changes[0].changes);
+
+	assert_success(os_rename(SANDBOX_PATH "/testdir", SANDBOX_PATH "/newdir"));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_int_equal(2, fswatch_get_changes(watch, &changes));
+	assert_string_equal("testdir", changes[0].name);
+	assert_int_equal(FSWC_DELETED, changes[0].changes);
+	assert_string_equal("newdir", changes[1].name);
+	assert_int_equal(FSWC_CREATED, changes[1].changes);
+
+	assert_success(remove(SANDBOX_PATH "/newdir"));
+	assert_int_equal(FSWS_UPDATED, fswatch_poll(watch));
+	assert_int_equal(1, fswatch_get_changes(watch, &changes));
+	assert_int_equal(FSWC_DELETED, changes[0].changes);
+
+	fswatch_free(watch);
+}
+
+TEST(set_reports_changes_in_its_directories, IF(using_inotify))
+{
+	char *paths[] = { SANDBOX_PATH "/dir1", SANDBOX_PATH "/dir2" };
+	assert_success(os_mkdir(paths[0], 0700));
+	assert_success(os_mkdir(paths[1], 0700));
+
+	fswatch_set_t *set;
+	assert_non_null(set = fswatch_set_create());
+	assert_success(fswatch_set_update(set, paths, 2));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+
+	create_file(SANDBOX_PATH "/dir2/file");
+	assert_int_equal(FSWS_UPDATED, fswatch_set_poll(set));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+
+	/* Only changes of lists of files are reported. */
+	assert_success(os_chmod(SANDBOX_PATH "/dir2/file", 0600));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+
+	/* Changes outside of the set aren't reported. */
+	assert_success(fswatch_set_update(set, paths, 1));
+	assert_success(remove(SANDBOX_PATH "/dir2/file"));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+
+	assert_success(os_rename(paths[1], SANDBOX_PATH "/dir1/dir2"));
+	assert_int_equal(FSWS_UPDATED, fswatch_set_poll(set));
+
+	fswatch_set_free(set);
+
+	assert_success(remove(SANDBOX_PATH "/dir1/dir2"));
+	assert_success(remove(SANDBOX_PATH "/dir1"));
+}
+
+TEST(set_skips_missing_directories, IF(using_inotify))
+{
+	char *paths[] = { SANDBOX_PATH "/no-such-dir" };
+
+	fswatch_set_t *set;
+	assert_non_null(set = fswatch_set_create());
+	assert_success(fswatch_set_update(set, paths, 1));
+	assert_int_equal(FSWS_UNCHANGED, fswatch_set_poll(set));
+	fswatch_set_free(set);
+}
+
 static int
 using_inotify(void)
 {
@@ -368,6 +368,32 @@ TEST(fast_globs)
 	matcher_free(m);
 }
 
+TEST(simple_globs_are_exposed)
+{
+	char *error;
+	matcher_t *m;
+
+	assert_non_null(m = matcher_alloc("{*.c,Makefile}", 0, 1, "", &error));
+	assert_string_equal("*.c,Makefile", matcher_get_simple_globs(m));
+	matcher_free(m);
+
+	assert_non_null(m = matcher_alloc("!{*.c}", 0, 1, "", &error));
+	assert_null(matcher_get_simple_globs(m));
+	matcher_free(m);
+
+	assert_non_null(m = matcher_alloc("{{*.c}}", 0, 1, "", &error));
+	assert_null(matcher_get_simple_globs(m));
+	matcher_free(m);
+
+	assert_non_null(m = matcher_alloc("{*.[ch]}", 0, 1, "", &error));
+	assert_null(matcher_get_simple_globs(m));
+	matcher_free(m);
+
+	assert_non_null(m = matcher_alloc("/.*\\.c/", 0, 1, "", &error));
+	assert_null(matcher_get_simple_globs(m));
+	matcher_free(m);
+}
+
 TEST(regexps_are_cloned)
 {
 	char *error;
@@ -0,0 +1,270 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() fprintf() rename() */
+#include <string.h> /* strlen() strncmp() */
+
+#include <test-utils.h>
+
+#include "../../src/utils/mfile.h"
+
+static int line_is(mfile_t *mf, int line, const char expected[]);
+
+TEST(missing_file_is_not_opened)
+{
+	assert_null(mfile_open(SANDBOX_PATH "/no-such-file"));
+}
+
+TEST(empty_file_has_no_lines)
+{
+	create_file(SANDBOX_PATH "/empty");
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/empty");
+	assert_non_null(mf);
+	assert_true(mfile_is_indexed(mf));
+	assert_int_equal(0, mfile_line_count(mf));
+	assert_false(mfile_has_line(mf, 0));
+	mfile_free(mf);
+
+	remove_file(SANDBOX_PATH "/empty");
+}
+
+TEST(lines_are_split_as_by_read_line)
+{
+	mfile_t *mf = mfile_open(TEST_DATA_PATH "/read/dos-line-endings");
+	assert_non_null(mf);
+	assert_int_equal(3, mfile_line_count(mf));
+	assert_true(line_is(mf, 0, "first line"));
+	assert_true(line_is(mf, 1, "second line"));
+	assert_true(line_is(mf, 2, "third line"));
+	mfile_free(mf);
+
+	make_file(SANDBOX_PATH "/file", "a\rb\n\nc");
+	mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(4, mfile_line_count(mf));
+	assert_true(line_is(mf, 0, "a"));
+	assert_true(line_is(mf, 1, "b"));
+	assert_true(line_is(mf, 2, ""));
+	assert_true(line_is(mf, 3, "c"));
+	mfile_free(mf);
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(bom_is_skipped)
+{
+	mfile_t *mf = mfile_open(TEST_DATA_PATH "/read/utf8-bom");
+	assert_non_null(mf);
+	assert_true(line_is(mf, 0, "1"));
+	mfile_free(mf);
+}
+
+TEST(lines_are_indexed_lazily)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 1000; ++i)
+	{
+		fprintf(fp, "line %d\n", i);
+	}
+	fclose(fp);
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(0, mfile_known_lines(mf));
+
+	assert_true(mfile_has_line(mf, 99));
+	assert_int_equal(100, mfile_known_lines(mf));
+	assert_false(mfile_is_indexed(mf));
+
+	/* Random access with lookups going in both directions. */
+	assert_true(line_is(mf, 70, "line 70"));
+	assert_true(line_is(mf, 65, "line 65"));
+	assert_true(line_is(mf, 99, "line 99"));
+	assert_true(line_is(mf, 0, "line 0"));
+
+	/* Indexing in steps. */
+	while(mfile_index_step(mf, 100))
+	{
+		assert_true(mfile_known_lines(mf) < 1000);
+	}
+	assert_true(mfile_is_indexed(mf));
+	assert_int_equal(1000, mfile_known_lines(mf));
+
+	assert_true(line_is(mf, 999, "line 999"));
+	assert_true(line_is(mf, 128, "line 128"));
+	assert_false(mfile_has_line(mf, 1000));
+	assert_int_equal(mfile_size(mf), mfile_line_offset(mf, 1000));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(long_lines_are_assembled)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 100000; ++i)
+	{
+		fprintf(fp, "long line");
+	}
+	fprintf(fp, "\r\nshort line\n");
+	fclose(fp);
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(2, mfile_line_count(mf));
+
+	size_t len;
+	const char *text = mfile_line(mf, 0, &len);
+	assert_non_null(text);
+	assert_int_equal(100000*strlen("long line"), len);
+	assert_int_equal(0, strncmp(text + len - 9, "long line", 9));
+	assert_true(line_is(mf, 1, "short line"));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(file_bigger_than_cache_is_read_in_parts)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 1500000; ++i)
+	{
+		fprintf(fp, "line %d\n", i);
+	}
+	fclose(fp);
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(1500000, mfile_line_count(mf));
+
+	assert_true(line_is(mf, 1499999, "line 1499999"));
+	assert_true(line_is(mf, 0, "line 0"));
+	assert_true(line_is(mf, 777777, "line 777777"));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(appended_data_is_picked_up)
+{
+	make_file(SANDBOX_PATH "/file", "a\nb");
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(0, mfile_refresh(mf));
+	assert_int_equal(2, mfile_line_count(mf));
+
+	FILE *fp = fopen(SANDBOX_PATH "/file", "a");
+	fprintf(fp, "c\nd");
+	fclose(fp);
+
+	assert_int_equal(1, mfile_refresh(mf));
+	assert_int_equal(3, mfile_line_count(mf));
+	assert_true(line_is(mf, 0, "a"));
+	assert_true(line_is(mf, 1, "bc"));
+	assert_true(line_is(mf, 2, "d"));
+	assert_int_equal(0, mfile_refresh(mf));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(appending_after_checkpoint_works)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 128; ++i)
+	{
+		fprintf(fp, "line %d\n", i);
+	}
+	fprintf(fp, "line");
+	fclose(fp);
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_int_equal(129, mfile_line_count(mf));
+
+	fp = fopen(SANDBOX_PATH "/file", "a");
+	fprintf(fp, " 128\nline 129\n");
+	fclose(fp);
+
+	assert_int_equal(1, mfile_refresh(mf));
+	assert_int_equal(130, mfile_line_count(mf));
+	assert_true(line_is(mf, 127, "line 127"));
+	assert_true(line_is(mf, 128, "line 128"));
+	assert_true(line_is(mf, 129, "line 129"));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(truncation_and_replacement_are_detected)
+{
+	make_file(SANDBOX_PATH "/file", "abc\n");
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	make_file(SANDBOX_PATH "/file", "a\n");
+	assert_int_equal(-1, mfile_refresh(mf));
+	mfile_free(mf);
+
+	mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	make_file(SANDBOX_PATH "/file2", "a\nb\n");
+	assert_success(rename(SANDBOX_PATH "/file2", SANDBOX_PATH "/file"));
+	assert_int_equal(-1, mfile_refresh(mf));
+	mfile_free(mf);
+
+	mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	make_file(SANDBOX_PATH "/file", "b\nc\n");
+	reset_timestamp(SANDBOX_PATH "/file");
+	assert_int_equal(-1, mfile_refresh(mf));
+	mfile_free(mf);
+
+	mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	remove_file(SANDBOX_PATH "/file");
+	assert_int_equal(-1, mfile_refresh(mf));
+	mfile_free(mf);
+}
+
+TEST(truncation_while_reading_is_handled)
+{
+	FILE *fp = fopen(SANDBOX_PATH "/file", "w");
+	int i;
+	for(i = 0; i < 100000; ++i)
+	{
+		fprintf(fp, "line %d\n", i);
+	}
+	fclose(fp);
+
+	mfile_t *mf = mfile_open(SANDBOX_PATH "/file");
+	assert_non_null(mf);
+	assert_true(line_is(mf, 0, "line 0"));
+
+	make_file(SANDBOX_PATH "/file", "a\n");
+
+	assert_true(mfile_line_count(mf) < 100000);
+	assert_true(mfile_is_indexed(mf));
+	assert_int_equal(-1, mfile_refresh(mf));
+
+	mfile_free(mf);
+	remove_file(SANDBOX_PATH "/file");
+}
+
+static int
+line_is(mfile_t *mf, int line, const char expected[])
+{
+	size_t len;
+	const char *text = mfile_line(mf, line, &len);
+	return text != NULL
+	    && len == strlen(expected)
+	    && strncmp(text, expected, len) == 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,103 @@
+#include <stic.h>
+
+#include <string.h> /* strlen() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/mntent.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
+
+/* State of mount point lookup by traversal of all mount points. */
+typedef struct
+{
+	const char *path;         /* Path whose mount point we're looking for. */
+	char found[PATH_MAX + 1]; /* Mount point found so far. */
+	size_t found_len;         /* Length of found path. */
+}
+lookup_t;
+
+static void check_mount_point(const char path[]);
+static int lookup_traverser(struct mntent *entry, void *arg);
+static int have_mount_table(void);
+
+TEST(root_is_a_mount_point, IF(have_mount_table))
+{
+	char mount_point[PATH_MAX + 1];
+	assert_success(get_mount_point("/", sizeof(mount_point), mount_point));
+	assert_string_equal("/", mount_point);
+}
+
+TEST(lookup_agrees_with_traversal, IF(have_mount_table))
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	char sandbox[PATH_MAX + 1];
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
+
+	check_mount_point(sandbox);
+	check_mount_point("/");
+	check_mount_point("/proc/self");
+	check_mount_point("/dev/null");
+	check_mount_point("/no/such/path/");
+}
+
+TEST(lookup_is_repeatable, IF(have_mount_table))
+{
+	char first[PATH_MAX + 1], second[PATH_MAX + 1];
+	assert_success(get_mount_point("/proc", sizeof(first), first));
+	assert_success(get_mount_point("/proc", sizeof(second), second));
+	assert_string_equal(first, second);
+}
+
+TEST(slowfs_matches_by_type_of_mount_point, IF(have_mount_table))
+{
+	lookup_t lookup = { .path = "/", .found_len = 0U };
+	assert_success(traverse_mount_points(&lookup_traverser, &lookup));
+	assert_true(lookup.found_len > 0U);
+
+	assert_false(is_on_slow_fs("/", ""));
+	assert_true(is_on_slow_fs("/", "*"));
+	assert_false(is_on_slow_fs("/", "no-such-fs-type"));
+	assert_true(is_on_slow_fs("/no-such-dir/file", "/no-such-dir"));
+}
+
+/* Compares result of get_mount_point() with a lookup over all mount points. */
+static void
+check_mount_point(const char path[])
+{
+	lookup_t lookup = { .path = path, .found_len = 0U };
+	assert_success(traverse_mount_points(&lookup_traverser, &lookup));
+
+	char mount_point[PATH_MAX + 1];
+	assert_success(get_mount_point(path, sizeof(mount_point), mount_point));
+	assert_string_equal(lookup.found, mount_point);
+}
+
+/* traverse_mount_points() client that finds the last longest mount point. */
+static int
+lookup_traverser(struct mntent *entry, void *arg)
+{
+	lookup_t *const lookup = arg;
+	const size_t len = strlen(entry->mnt_dir);
+	if(path_starts_with(lookup->path, entry->mnt_dir) && len >= lookup->found_len)
+	{
+		copy_str(lookup->found, sizeof(lookup->found), entry->mnt_dir);
+		lookup->found_len = len;
+	}
+	return 0;
+}
+
+static int
+have_mount_table(void)
+{
+	char mount_point[PATH_MAX + 1];
+	return not_windows()
+	    && get_mount_point("/", sizeof(mount_point), mount_point) == 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,123 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <unistd.h> /* close() pipe() read() write() */
+
+#include "../../src/utils/reactor.h"
+
+static void read_handler(selector_item_t item, void *arg);
+static void remove_handler(selector_item_t item, void *arg);
+
+static reactor_t *reactor;
+static int pipe_a[2], pipe_b[2];
+static int ncalls;
+
+SETUP()
+{
+	reactor = reactor_alloc();
+	assert_non_null(reactor);
+	assert_success(pipe(pipe_a));
+	assert_success(pipe(pipe_b));
+	ncalls = 0;
+}
+
+TEARDOWN()
+{
+	reactor_free(reactor);
+	close(pipe_a[0]);
+	close(pipe_a[1]);
+	close(pipe_b[0]);
+	close(pipe_b[1]);
+}
+
+TEST(timeout_is_reported)
+{
+	assert_success(reactor_add(reactor, pipe_a[0], &read_handler, &ncalls));
+	assert_int_equal(0, reactor_run(reactor, 0));
+	assert_int_equal(0, ncalls);
+}
+
+TEST(only_ready_items_are_handled)
+{
+	int ncalls2 = 0;
+	assert_success(reactor_add(reactor, pipe_a[0], &read_handler, &ncalls));
+	assert_success(reactor_add(reactor, pipe_b[0], &read_handler, &ncalls2));
+	assert_int_equal(2, reactor_size(reactor));
+
+	assert_int_equal(1, write(pipe_b[1], "x", 1));
+	assert_int_equal(1, reactor_run(reactor, 1000));
+	assert_int_equal(0, ncalls);
+	assert_int_equal(1, ncalls2);
+
+	/* Data was consumed by the handler. */
+	assert_int_equal(0, reactor_run(reactor, 0));
+}
+
+TEST(item_can_not_be_added_twice)
+{
+	assert_success(reactor_add(reactor, pipe_a[0], &read_handler, &ncalls));
+	assert_failure(reactor_add(reactor, pipe_a[0], &read_handler, &ncalls));
+	assert_int_equal(1, reactor_size(reactor));
+}
+
+TEST(removed_items_are_not_handled)
+{
+	assert_success(reactor_add(reactor, pipe_a[0], &read_handler, &ncalls));
+	assert_success(reactor_add(reactor, pipe_b[0], &read_handler, &ncalls));
+	reactor_remove(reactor, pipe_a[0]);
+	assert_int_equal(1, reactor_size(reactor));
+
+	assert_int_equal(1, write(pipe_a[1], "x", 1));
+	assert_int_equal(0, reactor_run(reactor, 0));
+	assert_int_equal(0, ncalls);
+
+	assert_int_equal(1, write(pipe_b[1], "x", 1));
+	assert_int_equal(1, reactor_run(reactor, 1000));
+	assert_int_equal(1, ncalls);
+}
+
+TEST(handler_can_remove_items)
+{
+	/* Both handlers remove both items, so only one of them gets to run. */
+	assert_success(reactor_add(reactor, pipe_a[0], &remove_handler, NULL));
+	assert_success(reactor_add(reactor, pipe_b[0], &remove_handler, NULL));
+
+	assert_int_equal(1, write(pipe_a[1], "x", 1));
+	assert_int_equal(1, write(pipe_b[1], "x", 1));
+	assert_int_equal(1, reactor_run(reactor, 1000));
+	assert_int_equal(1, ncalls);
+	assert_int_equal(0, reactor_size(reactor));
+}
+
+TEST(end_of_stream_is_handled)
+{
+	assert_success(reactor_add(reactor, pipe_a[0], &remove_handler, NULL));
+	close(pipe_a[1]);
+	pipe_a[1] = -1;
+
+	assert_int_equal(1, reactor_run(reactor, 1000));
+	assert_int_equal(1, ncalls);
+	assert_int_equal(0, reactor_size(reactor));
+}
+
+static void
+read_handler(selector_item_t item, void *arg)
+{
+	char c;
+	assert_int_equal(1, read(item, &c, 1));
+	++*(int *)arg;
+}
+
+static void
+remove_handler(selector_item_t item, void *arg)
+{
+	reactor_remove(reactor, pipe_a[0]);
+	reactor_remove(reactor, pipe_b[0]);
+	++ncalls;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
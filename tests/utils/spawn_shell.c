@@ -0,0 +1,132 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <unistd.h> /* close() read() write() */
+
+#include <stdlib.h> /* atoi() free() malloc() */
+#include <string.h> /* memset() strcpy() strlen() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
+#include "../../src/utils/utils_nix.h"
+
+static int run_and_read(const char cmd[], int in, const char cwd[], char buf[],
+		size_t buf_len);
+
+SETUP()
+{
+	conf_setup();
+}
+
+TEARDOWN()
+{
+	conf_teardown();
+}
+
+TEST(output_and_errors_are_redirected)
+{
+	char buf[64];
+	assert_int_equal(0, run_and_read("echo out; echo err >&2", SPAWN_DEVNULL,
+				/*cwd=*/NULL, buf, sizeof(buf)));
+	assert_string_equal("out\nerr\n", buf);
+}
+
+TEST(input_can_be_bound_to_devnull)
+{
+	char buf[64];
+	assert_int_equal(0, run_and_read("cat", SPAWN_DEVNULL, /*cwd=*/NULL, buf,
+				sizeof(buf)));
+	assert_string_equal("", buf);
+}
+
+TEST(input_is_redirected)
+{
+	int in_pipe[2];
+	assert_success(make_cloexec_pipe(in_pipe));
+	assert_int_equal(5, write(in_pipe[1], "input", 5));
+	close(in_pipe[1]);
+
+	char buf[64];
+	assert_int_equal(0, run_and_read("cat", in_pipe[0], /*cwd=*/NULL, buf,
+				sizeof(buf)));
+	assert_string_equal("input", buf);
+
+	close(in_pipe[0]);
+}
+
+TEST(command_runs_in_specified_directory)
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	char sandbox[PATH_MAX + 1];
+	make_abs_path(sandbox, sizeof(sandbox), SANDBOX_PATH, "", cwd);
+
+	char buf[PATH_MAX + 1];
+	assert_int_equal(0, run_and_read("pwd", SPAWN_DEVNULL, sandbox, buf,
+				sizeof(buf)));
+	chomp(buf);
+	assert_true(paths_are_equal(sandbox, buf));
+}
+
+TEST(exit_code_is_available)
+{
+	char buf[64];
+	assert_int_equal(3, run_and_read("exit 3", SPAWN_DEVNULL, /*cwd=*/NULL, buf,
+				sizeof(buf)));
+}
+
+TEST(very_long_command_is_run)
+{
+	/* Length exceeds limit on size of a single argument on Linux. */
+	enum { NCHARS = 300*1024 };
+
+	char *const cmd = malloc(NCHARS + 64);
+	strcpy(cmd, "printf %s ");
+	memset(cmd + strlen(cmd), 'x', NCHARS);
+	strcpy(cmd + strlen("printf %s ") + NCHARS, " | wc -c");
+
+	char buf[64];
+	assert_int_equal(0, run_and_read(cmd, SPAWN_DEVNULL, /*cwd=*/NULL, buf,
+				sizeof(buf)));
+	assert_int_equal(NCHARS, atoi(buf));
+
+	free(cmd);
+}
+
+/* Runs the command capturing its output and errors into the buffer.  Returns
+ * exit code of the command. */
+static int
+run_and_read(const char cmd[], int in, const char cwd[], char buf[],
+		size_t buf_len)
+{
+	int out_pipe[2];
+	assert_success(make_cloexec_pipe(out_pipe));
+
+	const pid_t pid = spawn_shell(cmd, SHELL_BY_APP, in, out_pipe[1],
+			out_pipe[1], /*new_session=*/1, cwd);
+	close(out_pipe[1]);
+	assert_true(pid != (pid_t)-1);
+
+	size_t len = 0U;
+	ssize_t nread;
+	while((nread = read(out_pipe[0], buf + len, buf_len - 1U - len)) > 0)
+	{
+		len += nread;
+	}
+	buf[len] = '\0';
+	close(out_pipe[0]);
+
+	return status_to_exit_code(get_proc_exit_status(pid, &no_cancellation));
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
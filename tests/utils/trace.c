@@ -0,0 +1,91 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+
+#include <test-utils.h>
+
+#include "../../src/utils/fs.h"
+#include "../../src/utils/parson.h"
+#include "../../src/utils/trace.h"
+
+static JSON_Array * load_events(JSON_Value **root);
+
+TEST(nothing_is_recorded_when_disabled)
+{
+	assert_false(trace_enabled());
+	trace_begin("span", NULL);
+	trace_end();
+	trace_finish();
+	assert_false(path_exists(SANDBOX_PATH "/trace", NODEREF));
+}
+
+TEST(spans_are_written_in_order)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace"));
+	assert_true(trace_enabled());
+
+	trace_begin("outer", NULL);
+	trace_begin("inner", "detail");
+	trace_end();
+	trace_end();
+	/* Unmatched end is ignored. */
+	trace_end();
+
+	trace_finish();
+	assert_false(trace_enabled());
+
+	JSON_Value *root;
+	JSON_Array *events = load_events(&root);
+	assert_int_equal(4, json_array_get_count(events));
+
+	JSON_Object *e0 = json_array_get_object(events, 0);
+	JSON_Object *e1 = json_array_get_object(events, 1);
+	JSON_Object *e2 = json_array_get_object(events, 2);
+	JSON_Object *e3 = json_array_get_object(events, 3);
+
+	assert_string_equal("outer", json_object_get_string(e0, "name"));
+	assert_string_equal("B", json_object_get_string(e0, "ph"));
+	assert_string_equal("inner", json_object_get_string(e1, "name"));
+	assert_string_equal("detail",
+			json_object_dotget_string(e1, "args.detail"));
+	assert_string_equal("E", json_object_get_string(e2, "ph"));
+	assert_string_equal("E", json_object_get_string(e3, "ph"));
+
+	assert_true(json_object_get_number(e0, "ts") <=
+			json_object_get_number(e1, "ts"));
+	assert_true(json_object_get_number(e2, "ts") <=
+			json_object_get_number(e3, "ts"));
+
+	json_value_free(root);
+	remove_file(SANDBOX_PATH "/trace");
+}
+
+TEST(open_spans_are_closed_on_finish)
+{
+	assert_success(trace_start(SANDBOX_PATH "/trace"));
+	trace_begin("outer", NULL);
+	trace_begin("inner", NULL);
+	trace_finish();
+
+	JSON_Value *root;
+	JSON_Array *events = load_events(&root);
+	assert_int_equal(4, json_array_get_count(events));
+	assert_string_equal("E",
+			json_object_get_string(json_array_get_object(events, 3), "ph"));
+
+	json_value_free(root);
+	remove_file(SANDBOX_PATH "/trace");
+}
+
+/* Parses trace file.  *root is set to the parsed value.  Returns array of
+ * events. */
+static JSON_Array *
+load_events(JSON_Value **root)
+{
+	*root = json_parse_file(SANDBOX_PATH "/trace");
+	assert_non_null(*root);
+	return json_object_get_array(json_object(*root), "traceEvents");
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */